@@ -0,0 +1,42 @@
+// Character scanning micro-benchmark: walking 16 KB ASCII and Persian
+// strings with charCodeAt and [i], as tokenizers and text layout code do.
+print("------bench charcode-------");
+
+function build(piece, n) {
+    var s = "";
+    while (s.length < n)
+        s += piece;
+    return s;
+}
+
+function scan(s) {
+    var sum = 0;
+    for (var i = 0; i < s.length; i++)
+        sum += s.charCodeAt(i);
+    return sum;
+}
+
+function scanIndex(s) {
+    var spaces = 0;
+    for (var i = 0; i < s.length; i++)
+        if (s[i] === " ")
+            spaces++;
+    return spaces;
+}
+
+var ascii = build("temperature 23.5 humidity 41 ok; ", 16 * 1024);
+var persian = build("دمای هوا ۲۳ درجه و رطوبت ۴۱ درصد؛ ", 16 * 1024);
+
+var t0 = Date.now();
+var check = scan(ascii) + scanIndex(ascii);
+var t1 = Date.now();
+check += scan(persian) + scanIndex(persian);
+var t2 = Date.now();
+check += persian.slice(8000, 8100).length + persian.substring(12000, 12010).charCodeAt(3);
+var t3 = Date.now();
+
+print("checksum: " + check);
+print("ascii scan: " + (t1 - t0) + " ms");
+print("persian scan: " + (t2 - t1) + " ms");
+print("slice: " + (t3 - t2) + " ms");
+print("------end of bench charcode-------");
@@ -0,0 +1,38 @@
+// Closure micro-benchmark: callbacks that capture state from their
+// enclosing function, as in timer.js and closure.js.
+print("------bench closure-------");
+
+function makeCounter(step) {
+    var count = 0;
+    return function () {
+        count += step;
+        return count;
+    };
+}
+
+function makeTicker(period) {
+    var ticks = 0;
+    var last = 0;
+    return function (now) {
+        if (now - last >= period) {
+            last = now;
+            ticks++;
+        }
+        return ticks;
+    };
+}
+
+var t0 = Date.now();
+var sum = 0;
+var counter = makeCounter(2);
+var ticker = makeTicker(10);
+for (var n = 0; n < 1000000; n++) {
+    sum += counter();
+    sum += ticker(n);
+    sum += makeCounter(n)();
+}
+var t1 = Date.now();
+
+print("checksum: " + sum);
+print("time: " + (t1 - t0) + " ms");
+print("------end of bench closure-------");
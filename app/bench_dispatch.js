@@ -0,0 +1,46 @@
+// Interpreter dispatch micro-benchmark: tight loops over locals and method
+// calls, where the cost is in the bytecode loop itself rather than in
+// property lookup or allocation.
+print("------bench dispatch-------");
+
+function sumTo(n) {
+    var s = 0;
+    for (var i = 0; i < n; i++)
+        s = s + i;
+    return s;
+}
+
+function fib(n) {
+    if (n < 2)
+        return n;
+    return fib(n - 1) + fib(n - 2);
+}
+
+function scale(points, k) {
+    var out = 0;
+    for (var i = 0; i < 100; i++) {
+        var p = points[i % 10];
+        out += Math.floor(p * k) + p;
+    }
+    return out;
+}
+
+var pts = [ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 ];
+
+var t0 = Date.now();
+var a = 0;
+for (var r = 0; r < 20; r++)
+    a += sumTo(100000);
+var t1 = Date.now();
+var b = fib(27);
+var t2 = Date.now();
+var c = 0;
+for (var r = 0; r < 5000; r++)
+    c += scale(pts, 1.5);
+var t3 = Date.now();
+
+print("checksum: " + a + " " + b + " " + c);
+print("loop: " + (t1 - t0) + " ms");
+print("calls: " + (t2 - t1) + " ms");
+print("methods: " + (t3 - t2) + " ms");
+print("------end of bench dispatch-------");
@@ -0,0 +1,48 @@
+// JSON throughput on a ~1 MB document shaped like app config and sensor
+// logs: many small objects with repeated keys, numbers, escaped strings.
+print("------bench json-------");
+
+var records = [];
+for (var i = 0; i < 7500; i++) {
+    records.push({
+        id: i,
+        name: "sensor-" + i,
+        enabled: i % 3 != 0,
+        value: i * 0.25 - 100,
+        unit: i % 2 ? "C" : "%",
+        tags: ["room" + (i % 12), "floor" + (i % 4)],
+        note: i % 10 ? null : "line1\nline2 \"quoted\" é",
+        pos: { x: i % 320, y: (i * 7) % 240 }
+    });
+}
+var doc = { version: 3, device: "esp32-s3", records: records };
+var text = JSON.stringify(doc);
+var mb = text.length / (1024 * 1024);
+print("document: " + text.length + " bytes");
+
+function rate(ms) {
+    return ms > 0 ? (mb / (ms / 1000)).toFixed(2) + " MB/s" : "-";
+}
+
+var runs = 5, t0, t, parsed, out;
+
+t0 = Date.now();
+for (var r = 0; r < runs; r++)
+    parsed = JSON.parse(text);
+t = (Date.now() - t0) / runs;
+print("parse: " + t + " ms, " + rate(t));
+
+t0 = Date.now();
+for (var r = 0; r < runs; r++)
+    out = JSON.stringify(parsed);
+t = (Date.now() - t0) / runs;
+print("stringify: " + t + " ms, " + rate(t));
+
+t0 = Date.now();
+out = JSON.stringify(parsed, null, 2);
+t = Date.now() - t0;
+print("stringify indented: " + t + " ms, " + out.length + " bytes");
+
+print("round trip: " + (JSON.stringify(parsed) === text));
+print("checksum: " + parsed.records.length + ":" + parsed.records[4321].name + ":" + parsed.records[10].note.length);
+print("------end of bench json-------");
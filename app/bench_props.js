@@ -0,0 +1,39 @@
+// Property access micro-benchmark: module-style lookups (lvgl.xxx) and
+// object fields updated in a render loop, as in clock*.js.
+print("------bench props-------");
+
+var mod = {};
+for (var i = 0; i < 120; i++)
+    mod["fn_" + i] = i;
+mod.ALIGN_CENTER = 9;
+mod.COLOR_WHITE = 0xffffff;
+mod.obj_set_pos = function (o, x, y) { o.x = x; o.y = y; };
+
+function Hand(len) {
+    this.len = len;
+    this.angle = 0;
+    this.x = 0;
+    this.y = 0;
+}
+Hand.prototype.step = function (d) {
+    this.angle = (this.angle + d) % 3600;
+    return this.angle;
+};
+
+var hands = [ new Hand(30), new Hand(40), new Hand(50) ];
+
+var t0 = Date.now();
+var sum = 0;
+for (var n = 0; n < 200000; n++) {
+    for (var h = 0; h < 3; h++) {
+        var hand = hands[h];
+        hand.step(6 * (h + 1));
+        mod.obj_set_pos(hand, hand.angle % 160, hand.len);
+        sum += hand.x + hand.y + mod.ALIGN_CENTER + mod.fn_100;
+    }
+}
+var t1 = Date.now();
+
+print("checksum: " + sum);
+print("time: " + (t1 - t0) + " ms");
+print("------end of bench props-------");
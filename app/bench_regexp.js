@@ -0,0 +1,82 @@
+// Regular expression micro-benchmark: typical patterns (tokenizing, split,
+// replace, validation) and pathological ones that make a backtracking
+// matcher exponential or blow its recursion limit.
+print("------bench regexp-------");
+
+function repeat(s, n) {
+    var r = "";
+    while (n-- > 0)
+        r += s;
+    return r;
+}
+
+var log = repeat("2024-05-01 12:34:56 INFO sensor=temp value=23.5 unit=C ok\n", 200);
+var csv = repeat("alpha,beta,gamma,delta,epsilon,", 400);
+var html = repeat("<div class=\"row\"><span>item</span> <b>42</b></div>\n", 200);
+
+var typical = [
+    ["log fields", function () {
+        var re = /(\w+)=([\w.]+)/g, m, n = 0;
+        while ((m = re.exec(log)) !== null)
+            n += m[2].length;
+        return n;
+    }],
+    ["split", function () {
+        return csv.split(/,/).length + log.split(/\s+/).length;
+    }],
+    ["replace tags", function () {
+        return html.replace(/<[^>]+>/g, "").length;
+    }],
+    ["literal search", function () {
+        var n = 0;
+        for (var i = 0; i < 200; i++)
+            n += log.search(/value=23\.5 unit=F/);
+        return n;
+    }],
+    ["anchored test", function () {
+        var n = 0;
+        for (var i = 0; i < 200; i++)
+            n += /^\d{4}-\d\d-\d\d/.test(log) ? 1 : 0;
+        return n;
+    }],
+    ["validate", function () {
+        var n = 0;
+        var emails = ["user@example.com", "a.b-c@d.org", "bad@", "no at sign", "x@y.z"];
+        for (var i = 0; i < 2000; i++)
+            n += /^[\w.-]+@[\w-]+(\.[\w-]+)+$/.test(emails[i % emails.length]) ? 1 : 0;
+        return n;
+    }],
+];
+
+// Each of these takes time exponential in n, or recursion depth linear in n, when backtracking
+var pathological = [
+    ["(a|aa)*c", /(a|aa)*c/, repeat("a", 24)],
+    ["(a|b)*c long", /(a|b)*c/, repeat("ab", 3000)],
+    ["(x+x+)+y", /(x+x+)+y/, repeat("x", 18)],
+    ["\\s*$ trailing", /\s*$/, repeat(" ", 2000) + "x"],
+    [".*.*=.*;", /.*.*=.*;/, repeat("a=", 60)],
+];
+
+var total = 0;
+
+for (var i = 0; i < typical.length; i++) {
+    var t0 = Date.now();
+    var r = typical[i][1]();
+    total += r;
+    print(typical[i][0] + ": " + r + " in " + (Date.now() - t0) + " ms");
+}
+
+for (var i = 0; i < pathological.length; i++) {
+    var t0 = Date.now();
+    var r;
+    try {
+        var m = pathological[i][1].exec(pathological[i][2]);
+        r = m ? m.index + ":" + m[0].length : "no match";
+    } catch (e) {
+        r = "error: " + e.message;
+    }
+    print(pathological[i][0] + ": " + r + " in " + (Date.now() - t0) + " ms");
+}
+
+print("checksum: " + total);
+print("------end of bench regexp-------");
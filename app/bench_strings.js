@@ -0,0 +1,31 @@
+// String building micro-benchmark: growing a 100 KB string with s += x,
+// as log and JSON-building apps do, then reading it back.
+print("------bench strings-------");
+
+var piece = "tick 12:34:56 ok;";
+var target = 100 * 1024;
+
+var t0 = Date.now();
+var s = "";
+while (s.length < target)
+    s += piece;
+var t1 = Date.now();
+
+var json = "[";
+for (var i = 0; json.length < target; i++) {
+    if (i > 0)
+        json += ",";
+    json += '{"id":' + i + ',"name":"item' + i + '"}';
+}
+json += "]";
+var t2 = Date.now();
+
+var parsed = JSON.parse(json);
+var check = s.length + json.length + parsed.length + s.charCodeAt(s.length - 2);
+var t3 = Date.now();
+
+print("checksum: " + check);
+print("append: " + (t1 - t0) + " ms");
+print("json build: " + (t2 - t1) + " ms");
+print("read back: " + (t3 - t2) + " ms");
+print("------end of bench strings-------");
@@ -0,0 +1,36 @@
+// Value layout micro-benchmark: arrays of samples, small records and an
+// arithmetic loop, to compare builds with and without JS_NANBOX. The host
+// shell (components/mujs/main.c) also reports the heap in use.
+print("------bench values-------");
+
+function heap() {
+    return typeof memstats === "function" ? memstats().bytes : 0;
+}
+
+var h0 = heap();
+var t0 = Date.now();
+var samples = [];
+for (var i = 0; i < 20000; i++)
+    samples.push((i * 37) % 1000 / 10);
+
+var records = [];
+for (var i = 0; i < 2000; i++)
+    records.push({ id: i, temp: i / 4, ok: i % 2 == 0, name: "s" + (i % 100) });
+var t1 = Date.now();
+var h1 = heap();
+
+var sum = 0;
+for (var n = 0; n < 20; n++) {
+    for (var i = 0; i < samples.length; i++)
+        sum += samples[i] * 0.5 + (samples[i] > 50 ? 1 : 0);
+    for (var i = 0; i < records.length; i++)
+        if (records[i].ok)
+            sum += records[i].temp;
+}
+var t2 = Date.now();
+
+print("checksum: " + sum);
+print("heap: " + (h1 - h0) + " bytes");
+print("build: " + (t1 - t0) + " ms");
+print("loop: " + (t2 - t1) + " ms");
+print("------end of bench values-------");
@@ -678,8 +678,8 @@ create_analog_clock_with_images();
 
 
 static void disp_driver_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p) {
+    // lv_disp_flush_ready بعد از پایان DMA در lcd101 صدا زده می‌شود
     lcd101_flush(disp_drv, area, color_p);
-    lv_disp_flush_ready(disp_drv);
 }
 
 // تعریف constants برای سازگاری با LVGL v8
@@ -704,6 +704,7 @@ static void guiTask(void *pvParameter) {
         vTaskDelete(NULL);
         return;
     }
+    evm_lvgl_set_gui_mutex(xGuiSemaphore);
     
     // Initialize LVGL
     lv_init();
@@ -775,6 +776,8 @@ static void guiTask(void *pvParameter) {
         lv_tick_inc(10);
         
         if (xSemaphoreTake(xGuiSemaphore, (TickType_t)10) == pdTRUE) {
+            // تغییرات JS دسته به دسته، قبل از رندر این دور
+            evm_lvgl_apply_pending();
             lv_task_handler();
             xSemaphoreGive(xGuiSemaphore);
         }
@@ -0,0 +1,342 @@
+#include "evm_js_arena.h"
+#include <string.h>
+
+// کلاس‌های اندازه؛ js_Property، js_Object، js_Environment و رشته‌های کوتاه
+// MuJS روی 32 و 64 بیت در همین بازه‌ها می‌افتند
+static const uint16_t class_size[EVM_JS_ARENA_CLASSES] = {
+    16, 24, 32, 40, 48, 64, 80, 96, 128, 160, 192, 256,
+};
+
+// سرآیند ابتدای هر صفحه slab
+typedef struct arena_page {
+    struct arena_page *next, *prev;     // صفحه‌های کلاس که جای خالی دارند
+    void *free;                         // لیست بلاک‌های آزاد شده
+    uint16_t cls;
+    uint16_t used;
+    uint16_t carved;                    // بلاک‌هایی که تا حالا از صفحه برداشته شده
+    uint16_t capacity;
+} arena_page_t;
+
+// سرآیند هر بلاک بزرگ، برای آزادسازی یک‌جا در destroy
+typedef struct arena_large {
+    struct arena_large *next, *prev;
+    size_t size;
+} arena_large_t;
+
+#define PAGE_HDR    ((sizeof(arena_page_t) + 15) & ~(size_t)15)
+#define LARGE_HDR   ((sizeof(arena_large_t) + 15) & ~(size_t)15)
+#define PAGE_OF(p)  ((arena_page_t *)((uintptr_t)(p) & ~(uintptr_t)(EVM_JS_ARENA_PAGE - 1)))
+
+struct evm_js_arena {
+    evm_js_arena_port_t port;
+    bool teardown;
+
+    uint8_t size_class[EVM_JS_ARENA_MAX_SMALL / 8 + 1];     // (size + 7) / 8 -> کلاس
+    arena_page_t *partial[EVM_JS_ARENA_CLASSES];
+    evm_js_arena_class_stats_t classes[EVM_JS_ARENA_CLASSES];
+
+    // مجموعه آدرس صفحه‌ها (open addressing) برای تشخیص بلاک کوچک از بزرگ
+    uintptr_t *pageset;
+    uint32_t pageset_cap;
+    uint32_t pages;
+
+    arena_large_t *large;
+    uint32_t large_count;
+    size_t large_bytes;
+};
+
+// ==================== مجموعه صفحه‌ها ====================
+
+static inline uint32_t page_hash(uintptr_t page) {
+    return (uint32_t)(page / EVM_JS_ARENA_PAGE) * 2654435761u;
+}
+
+static bool pageset_contains(const evm_js_arena_t *a, uintptr_t page) {
+    if (!a->pageset_cap) return false;
+    uint32_t mask = a->pageset_cap - 1;
+    for (uint32_t i = page_hash(page) & mask; a->pageset[i]; i = (i + 1) & mask) {
+        if (a->pageset[i] == page) return true;
+    }
+    return false;
+}
+
+static void pageset_put(uintptr_t *set, uint32_t cap, uintptr_t page) {
+    uint32_t mask = cap - 1;
+    uint32_t i = page_hash(page) & mask;
+    while (set[i]) {
+        i = (i + 1) & mask;
+    }
+    set[i] = page;
+}
+
+static bool pageset_add(evm_js_arena_t *a, uintptr_t page) {
+    if ((a->pages + 1) * 2 > a->pageset_cap) {
+        uint32_t cap = a->pageset_cap ? a->pageset_cap * 2 : 64;
+        uintptr_t *set = a->port.heap_realloc(a->port.ctx, NULL, cap * sizeof *set);
+        if (!set) return false;
+        memset(set, 0, cap * sizeof *set);
+        for (uint32_t i = 0; i < a->pageset_cap; i++) {
+            if (a->pageset[i]) pageset_put(set, cap, a->pageset[i]);
+        }
+        if (a->pageset) a->port.heap_realloc(a->port.ctx, a->pageset, 0);
+        a->pageset = set;
+        a->pageset_cap = cap;
+    }
+    pageset_put(a->pageset, a->pageset_cap, page);
+    a->pages++;
+    return true;
+}
+
+// حذف با جابه‌جایی عقب‌رو تا زنجیره‌های جستجو نشکنند
+static void pageset_remove(evm_js_arena_t *a, uintptr_t page) {
+    uint32_t mask = a->pageset_cap - 1;
+    uint32_t i = page_hash(page) & mask;
+    while (a->pageset[i] != page) {
+        i = (i + 1) & mask;
+    }
+    uint32_t j = i;
+    for (;;) {
+        a->pageset[i] = 0;
+        for (;;) {
+            j = (j + 1) & mask;
+            if (!a->pageset[j]) {
+                a->pages--;
+                return;
+            }
+            uint32_t k = page_hash(a->pageset[j]) & mask;
+            // اگر k بین (i, j] نیست، عنصر j می‌تواند به i برود
+            if (i <= j ? (i >= k || k > j) : (i >= k && k > j)) break;
+        }
+        a->pageset[i] = a->pageset[j];
+        i = j;
+    }
+}
+
+// ==================== صفحه‌های slab ====================
+
+static void page_link(evm_js_arena_t *a, arena_page_t *pg) {
+    pg->prev = NULL;
+    pg->next = a->partial[pg->cls];
+    if (pg->next) pg->next->prev = pg;
+    a->partial[pg->cls] = pg;
+}
+
+static void page_unlink(evm_js_arena_t *a, arena_page_t *pg) {
+    if (pg->prev) pg->prev->next = pg->next;
+    else a->partial[pg->cls] = pg->next;
+    if (pg->next) pg->next->prev = pg->prev;
+    pg->next = pg->prev = NULL;
+}
+
+static arena_page_t *page_new(evm_js_arena_t *a, int cls) {
+    arena_page_t *pg = a->port.page_alloc(a->port.ctx);
+    if (!pg) return NULL;
+    if (!pageset_add(a, (uintptr_t)pg)) {
+        a->port.page_free(a->port.ctx, pg);
+        return NULL;
+    }
+    pg->free = NULL;
+    pg->cls = (uint16_t)cls;
+    pg->used = 0;
+    pg->carved = 0;
+    pg->capacity = (uint16_t)((EVM_JS_ARENA_PAGE - PAGE_HDR) / class_size[cls]);
+    page_link(a, pg);
+    a->classes[cls].pages++;
+    a->classes[cls].capacity += pg->capacity;
+    return pg;
+}
+
+static void page_release(evm_js_arena_t *a, arena_page_t *pg) {
+    page_unlink(a, pg);
+    pageset_remove(a, (uintptr_t)pg);
+    a->classes[pg->cls].pages--;
+    a->classes[pg->cls].capacity -= pg->capacity;
+    a->port.page_free(a->port.ctx, pg);
+}
+
+static void *small_alloc(evm_js_arena_t *a, int cls) {
+    arena_page_t *pg = a->partial[cls];
+    if (!pg) {
+        pg = page_new(a, cls);
+        if (!pg) return NULL;
+    }
+
+    void *p;
+    if (pg->free) {
+        p = pg->free;
+        memcpy(&pg->free, p, sizeof(void *));
+    } else {
+        p = (uint8_t *)pg + PAGE_HDR + (size_t)pg->carved * class_size[cls];
+        pg->carved++;
+    }
+
+    pg->used++;
+    if (pg->used == pg->capacity) {
+        page_unlink(a, pg);
+    }
+    a->classes[cls].used++;
+    a->classes[cls].allocs++;
+    return p;
+}
+
+static void small_free(evm_js_arena_t *a, arena_page_t *pg, void *p) {
+    int cls = pg->cls;
+    if (pg->used == pg->capacity) {
+        page_link(a, pg);
+    }
+    memcpy(p, &pg->free, sizeof(void *));
+    pg->free = p;
+    pg->used--;
+    a->classes[cls].used--;
+
+    // صفحه خالی برمی‌گردد، مگر تنها صفحه کلاس باشد (جلوگیری از رفت‌وبرگشت)
+    if (pg->used == 0 && (pg->next || pg->prev)) {
+        page_release(a, pg);
+    }
+}
+
+// ==================== بلاک‌های بزرگ ====================
+
+static void large_link(evm_js_arena_t *a, arena_large_t *h) {
+    h->prev = NULL;
+    h->next = a->large;
+    if (h->next) h->next->prev = h;
+    a->large = h;
+}
+
+static void large_unlink(evm_js_arena_t *a, arena_large_t *h) {
+    if (h->prev) h->prev->next = h->next;
+    else a->large = h->next;
+    if (h->next) h->next->prev = h->prev;
+}
+
+static void *large_alloc(evm_js_arena_t *a, size_t size) {
+    arena_large_t *h = a->port.heap_realloc(a->port.ctx, NULL, LARGE_HDR + size);
+    if (!h) return NULL;
+    h->size = size;
+    large_link(a, h);
+    a->large_count++;
+    a->large_bytes += size;
+    return (uint8_t *)h + LARGE_HDR;
+}
+
+static void large_free(evm_js_arena_t *a, arena_large_t *h) {
+    large_unlink(a, h);
+    a->large_count--;
+    a->large_bytes -= h->size;
+    a->port.heap_realloc(a->port.ctx, h, 0);
+}
+
+static void *large_realloc(evm_js_arena_t *a, arena_large_t *h, size_t size) {
+    size_t old = h->size;
+    large_unlink(a, h);
+    arena_large_t *n = a->port.heap_realloc(a->port.ctx, h, LARGE_HDR + size);
+    if (!n) {
+        large_link(a, h);
+        return NULL;
+    }
+    n->size = size;
+    large_link(a, n);
+    a->large_bytes += size - old;
+    return (uint8_t *)n + LARGE_HDR;
+}
+
+// ==================== API ====================
+
+evm_js_arena_t *evm_js_arena_create(const evm_js_arena_port_t *port) {
+    evm_js_arena_t *a = port->heap_realloc(port->ctx, NULL, sizeof *a);
+    if (!a) return NULL;
+    memset(a, 0, sizeof *a);
+    a->port = *port;
+
+    int cls = 0;
+    for (int i = 0; i <= EVM_JS_ARENA_MAX_SMALL / 8; i++) {
+        while (class_size[cls] < i * 8) cls++;
+        a->size_class[i] = (uint8_t)cls;
+    }
+    for (int i = 0; i < EVM_JS_ARENA_CLASSES; i++) {
+        a->classes[i].size = class_size[i];
+    }
+    return a;
+}
+
+void evm_js_arena_destroy(evm_js_arena_t *a) {
+    if (!a) return;
+
+    for (uint32_t i = 0; i < a->pageset_cap; i++) {
+        if (a->pageset[i]) a->port.page_free(a->port.ctx, (void *)a->pageset[i]);
+    }
+    if (a->pageset) a->port.heap_realloc(a->port.ctx, a->pageset, 0);
+
+    arena_large_t *h = a->large;
+    while (h) {
+        arena_large_t *next = h->next;
+        a->port.heap_realloc(a->port.ctx, h, 0);
+        h = next;
+    }
+
+    a->port.heap_realloc(a->port.ctx, a, 0);
+}
+
+void evm_js_arena_begin_teardown(evm_js_arena_t *a) {
+    a->teardown = true;
+}
+
+void *evm_js_arena_alloc(void *actx, void *ptr, int size) {
+    evm_js_arena_t *a = actx;
+    arena_page_t *pg = NULL;
+
+    if (ptr && pageset_contains(a, (uintptr_t)PAGE_OF(ptr))) {
+        pg = PAGE_OF(ptr);
+    }
+
+    if (size <= 0) {
+        if (!ptr || a->teardown) return NULL;
+        if (pg) small_free(a, pg, ptr);
+        else large_free(a, (arena_large_t *)((uint8_t *)ptr - LARGE_HDR));
+        return NULL;
+    }
+
+    int cls = size <= EVM_JS_ARENA_MAX_SMALL ? a->size_class[(size + 7) / 8] : -1;
+
+    if (!ptr) {
+        return cls >= 0 ? small_alloc(a, cls) : large_alloc(a, (size_t)size);
+    }
+
+    size_t old;
+    if (pg) {
+        if (cls == pg->cls) return ptr;
+        old = class_size[pg->cls];
+    } else {
+        arena_large_t *h = (arena_large_t *)((uint8_t *)ptr - LARGE_HDR);
+        if (cls < 0) return large_realloc(a, h, (size_t)size);
+        old = h->size;
+    }
+
+    // جابه‌جایی بین کلاس‌ها یا بین کوچک و بزرگ
+    void *p = cls >= 0 ? small_alloc(a, cls) : large_alloc(a, (size_t)size);
+    if (!p) return NULL;
+    memcpy(p, ptr, old < (size_t)size ? old : (size_t)size);
+    if (pg) small_free(a, pg, ptr);
+    else large_free(a, (arena_large_t *)((uint8_t *)ptr - LARGE_HDR));
+    return p;
+}
+
+void evm_js_arena_get_stats(const evm_js_arena_t *a, evm_js_arena_stats_t *stats) {
+    memset(stats, 0, sizeof *stats);
+    memcpy(stats->classes, a->classes, sizeof stats->classes);
+
+    for (int i = 0; i < EVM_JS_ARENA_CLASSES; i++) {
+        stats->small_used += (size_t)a->classes[i].used * a->classes[i].size;
+    }
+    stats->pages = a->pages;
+    stats->large_count = a->large_count;
+    stats->large_bytes = a->large_bytes;
+    stats->footprint = (size_t)a->pages * EVM_JS_ARENA_PAGE
+        + a->large_bytes + (size_t)a->large_count * LARGE_HDR
+        + a->pageset_cap * sizeof(uintptr_t) + sizeof *a;
+
+    if (a->pages) {
+        stats->fragmentation = 1.0f - (float)stats->small_used / ((float)a->pages * EVM_JS_ARENA_PAGE);
+    }
+}
@@ -1,4 +1,5 @@
 #include "evm_loader.h"
+#include "evm_js_arena.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
@@ -9,6 +10,7 @@
 #include "driver/gpio.h"
 #include <string.h>
 #include <stdio.h>
+#include <sys/stat.h>
 
 
 #include <ctype.h>
@@ -18,6 +20,7 @@
 #include "evm_module.h"
 #include "evm_module_gpio.h"
 #include "evm_module_timer.h"
+#include "evm_event_loop.h"
 #include "evm_module_fs.h"
 #include "evm_module_console.h"
 #include "evm_module_process.h"
@@ -32,6 +35,14 @@
 
 static const char *TAG = "evm_loader";
 
+// GC افزایشی برای جلوگیری از مکث‌های طولانی در انیمیشن‌ها
+#define EVM_JS_FLAGS (JS_STRICT | JS_GCINCREMENTAL)
+
+// کش بایت‌کد: فایل .evmc کنار فایل .js تا در اجرای بعدی کامپایل تکرار نشود
+#ifndef EVM_BYTECODE_CACHE
+#define EVM_BYTECODE_CACHE 1
+#endif
+
 // ==================== متغیرهای global ====================
 
 static TaskHandle_t app_core_task = NULL;
@@ -40,6 +51,10 @@ static evm_execution_context_t current_evm_context;
 // وضعیت MuJS
 static bool mujs_running = false;
 static js_State* mujs_state = NULL;
+static evm_js_arena_t* mujs_arena = NULL;
+// template با همه ماژول‌های ثبت‌شده؛ stateها از روی آن کپی می‌شوند (js_newstatefrom)
+static js_State* mujs_template = NULL;
+static evm_js_arena_t* mujs_template_arena = NULL;
 
 // وضعیت برنامه
 volatile bool app_core_running = false;
@@ -47,26 +62,127 @@ volatile bool app_stop_requested = false;
 volatile bool app_has_active_loop = false;
 volatile uint32_t app_loop_counter = 0;
 
+// حلقه رویداد برنامه: تایمرها و رویدادها روی تسک APP CPU اجرا می‌شوند
+static evm_event_loop_t app_event_loop;
+static volatile bool app_event_loop_active = false;
+
+// ==================== پورت حلقه رویداد برای FreeRTOS ====================
+
+static evm_time_t app_loop_now(void *ctx) {
+    return esp_timer_get_time() / 1000;
+}
+
+// خواب تا سررسید تایمر بعدی یا تا notify از تسک/ISR دیگر
+static void app_loop_wait(void *ctx, evm_time_t timeout) {
+    TickType_t ticks = portMAX_DELAY;
+    if (timeout >= 0) {
+        ticks = (TickType_t)((timeout * configTICK_RATE_HZ + 999) / 1000);
+    }
+    ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+static void app_loop_wakeup(void *ctx) {
+    TaskHandle_t task = (TaskHandle_t)ctx;
+    if (!task) return;
+
+    if (xPortInIsrContext()) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(task, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xTaskNotifyGive(task);
+    }
+}
+
 // ==================== مدیریت حافظه PSRAM ====================
 
-// تابع allocator مخصوص MuJS با PSRAM (با signature صحیح)
-static void* mujs_alloc(void *ctx, void *ptr, size_t size) {
+// هر js_State یک arena اختصاصی دارد (evm_js_arena.h): بلاک‌های کوچک MuJS
+// از صفحه‌های 4KB در PSRAM برداشته می‌شوند و با آزادسازی state همه صفحه‌ها
+// یک‌جا برمی‌گردند، پس heap بین اجرای برنامه‌ها تکه‌تکه نمی‌شود.
+
+static void* arena_page_alloc(void *ctx) {
+    return heap_caps_aligned_alloc(EVM_JS_ARENA_PAGE, EVM_JS_ARENA_PAGE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+static void arena_page_free(void *ctx, void *page) {
+    heap_caps_free(page);
+}
+
+static void* arena_heap_realloc(void *ctx, void *ptr, size_t size) {
     if (size == 0) {
         if (ptr) {
             heap_caps_free(ptr);
         }
         return NULL;
     }
-    
-    if (ptr == NULL) {
-        // تخصیص جدید از PSRAM
-        return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    }
-    
-    // تغییر اندازه از PSRAM
     return heap_caps_realloc(ptr, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
 }
 
+static const evm_js_arena_port_t mujs_arena_port = {
+    .page_alloc = arena_page_alloc,
+    .page_free = arena_page_free,
+    .heap_realloc = arena_heap_realloc,
+    .ctx = NULL,
+};
+
+// ساخت state با arena تازه؛ arena در *arena برمی‌گردد
+static js_State* mujs_newstate(int flags, evm_js_arena_t **arena) {
+    *arena = evm_js_arena_create(&mujs_arena_port);
+    if (!*arena) {
+        return NULL;
+    }
+    js_State *J = js_newstate(evm_js_arena_alloc, *arena, flags);
+    if (!J) {
+        evm_js_arena_destroy(*arena);
+        *arena = NULL;
+    }
+    return J;
+}
+
+// کپی template در arena تازه؛ بدون ثبت دوباره builtinها و ماژول‌ها
+static js_State* mujs_newstatefrom(int flags, evm_js_arena_t **arena) {
+    *arena = evm_js_arena_create(&mujs_arena_port);
+    if (!*arena) {
+        return NULL;
+    }
+    js_State *J = js_newstatefrom(mujs_template, evm_js_arena_alloc, *arena, flags);
+    if (!J) {
+        evm_js_arena_destroy(*arena);
+        *arena = NULL;
+    }
+    return J;
+}
+
+// finalizerها اجرا می‌شوند ولی free تک‌تک بلاک‌ها رد می‌شود؛ بعد arena یک‌جا آزاد می‌شود
+static void mujs_freestate(js_State *J, evm_js_arena_t **arena) {
+    if (J) {
+        evm_js_arena_begin_teardown(*arena);
+        js_freestate(J);
+    }
+    evm_js_arena_destroy(*arena);
+    *arena = NULL;
+}
+
+// گزارش آمار arena در لاگ
+static void mujs_log_arena_stats(evm_js_arena_t *arena) {
+    if (!arena) return;
+
+    evm_js_arena_stats_t stats;
+    evm_js_arena_get_stats(arena, &stats);
+
+    ESP_LOGI(TAG, "🧮 JS arena: %u pages, %u large blocks (%u bytes), footprint %u bytes, fragmentation %.1f%%",
+             (unsigned)stats.pages, (unsigned)stats.large_count, (unsigned)stats.large_bytes,
+             (unsigned)stats.footprint, stats.fragmentation * 100.0f);
+    for (int i = 0; i < EVM_JS_ARENA_CLASSES; i++) {
+        const evm_js_arena_class_stats_t *c = &stats.classes[i];
+        if (c->pages) {
+            ESP_LOGD(TAG, "   %3u B: %u pages, %u/%u used, %u allocs",
+                     (unsigned)c->size, (unsigned)c->pages, (unsigned)c->used,
+                     (unsigned)c->capacity, (unsigned)c->allocs);
+        }
+    }
+}
+
 // تابع کمکی برای تخصیص بلاک داده از PSRAM
 static void* psram_malloc(size_t size) {
     return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
@@ -101,7 +217,7 @@ static void js_print(js_State *J) {
 // تابع delay
 static void js_delay(js_State *J) {
     int ms = js_toint32(J, 1);
-    vTaskDelay(pdMS_TO_TICKS(ms));
+    evm_timer_delay(ms);
     esp_task_wdt_reset();
     js_pushundefined(J);
 }
@@ -228,6 +344,184 @@ static void evm_cleanup_state(js_State *J) {
     }
 }
 
+// ==================== کش بایت‌کد (.evmc) ====================
+
+#if EVM_BYTECODE_CACHE
+
+#define EVMC_MAGIC   0x434d5645  // "EVMC"
+#define EVMC_VERSION 1
+
+// هدر فایل .evmc؛ بعد از آن بایت‌کد MuJS می‌آید
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t src_size;
+    uint32_t src_mtime;
+    uint32_t src_hash;
+    uint32_t code_size;
+    uint32_t code_hash;
+} evmc_header_t;
+
+typedef struct {
+    FILE* file;
+    uint32_t size;
+    uint32_t hash;
+    bool error;
+} evmc_writer_t;
+
+// FNV-1a
+static uint32_t evmc_hash(uint32_t hash, const void* data, size_t size) {
+    const uint8_t* p = data;
+    while (size--) {
+        hash ^= *p++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+#define EVMC_HASH_INIT 2166136261u
+
+// app.js -> app.evmc
+static bool evmc_cache_path(const char* file_path, char* out, size_t out_size) {
+    const char* dot = strrchr(file_path, '.');
+    const char* slash = strrchr(file_path, '/');
+    size_t base_len = (dot && (!slash || dot > slash)) ? (size_t)(dot - file_path) : strlen(file_path);
+
+    if (base_len + sizeof(".evmc") > out_size) {
+        return false;
+    }
+    memcpy(out, file_path, base_len);
+    strcpy(out + base_len, ".evmc");
+    return true;
+}
+
+static void evmc_write(void* data, const void* buf, int size) {
+    evmc_writer_t* w = data;
+    if (w->error) {
+        return;
+    }
+    if (fwrite(buf, 1, size, w->file) != (size_t)size) {
+        w->error = true;
+        return;
+    }
+    w->size += size;
+    w->hash = evmc_hash(w->hash, buf, size);
+}
+
+// اگر کش معتبر باشد تابع اسکریپت روی stack قرار می‌گیرد
+static bool evmc_load(js_State* J, const char* cache_path, const char* file_path, const evmc_header_t* expect) {
+    evmc_header_t hdr;
+    bool loaded = false;
+
+    FILE* file = fopen(cache_path, "rb");
+    if (!file) {
+        return false;
+    }
+
+    if (fread(&hdr, 1, sizeof(hdr), file) != sizeof(hdr) ||
+        hdr.magic != EVMC_MAGIC || hdr.version != EVMC_VERSION ||
+        hdr.src_size != expect->src_size || hdr.src_mtime != expect->src_mtime ||
+        hdr.src_hash != expect->src_hash || hdr.code_size == 0 || hdr.code_size > INT32_MAX) {
+        fclose(file);
+        ESP_LOGI(TAG, "🔄 Bytecode cache is stale: %s", cache_path);
+        return false;
+    }
+
+    uint8_t* code = psram_malloc(hdr.code_size);
+    if (!code) {
+        fclose(file);
+        return false;
+    }
+
+    size_t bytes_read = fread(code, 1, hdr.code_size, file);
+    fclose(file);
+
+    if (bytes_read == hdr.code_size && evmc_hash(EVMC_HASH_INIT, code, bytes_read) == hdr.code_hash) {
+        if (js_try(J)) {
+            ESP_LOGW(TAG, "⚠️ Bytecode cache rejected: %s", js_trystring(J, -1, "Error"));
+            js_pop(J, 1);
+        } else {
+            js_loadbytecode(J, file_path, code, hdr.code_size);
+            js_endtry(J);
+            loaded = true;
+        }
+    } else {
+        ESP_LOGW(TAG, "⚠️ Bytecode cache is corrupt: %s", cache_path);
+    }
+
+    psram_free(code);
+    return loaded;
+}
+
+// ذخیره تابع اسکریپت بالای stack در فایل کش
+static void evmc_save(js_State* J, const char* cache_path, evmc_header_t* hdr) {
+    evmc_writer_t w = { 0 };
+
+    w.file = fopen(cache_path, "wb");
+    if (!w.file) {
+        ESP_LOGW(TAG, "⚠️ Cannot create bytecode cache: %s", cache_path);
+        return;
+    }
+    w.hash = EVMC_HASH_INIT;
+
+    hdr->magic = EVMC_MAGIC;
+    hdr->version = EVMC_VERSION;
+    hdr->code_size = 0; // تا کامل نوشته نشده نامعتبر بماند
+    hdr->code_hash = 0;
+    w.error = fwrite(hdr, 1, sizeof(*hdr), w.file) != sizeof(*hdr);
+
+    if (js_try(J)) {
+        ESP_LOGW(TAG, "⚠️ Bytecode save failed: %s", js_trystring(J, -1, "Error"));
+        js_pop(J, 1);
+        w.error = true;
+    } else {
+        js_savebytecode(J, -1, evmc_write, &w);
+        js_endtry(J);
+    }
+
+    if (!w.error) {
+        hdr->code_size = w.size;
+        hdr->code_hash = w.hash;
+        w.error = fseek(w.file, 0, SEEK_SET) != 0 ||
+                  fwrite(hdr, 1, sizeof(*hdr), w.file) != sizeof(*hdr);
+    }
+
+    if (fclose(w.file) != 0 || w.error) {
+        ESP_LOGW(TAG, "⚠️ Bytecode cache write failed: %s", cache_path);
+        remove(cache_path);
+        return;
+    }
+
+    ESP_LOGI(TAG, "💾 Bytecode cache saved: %s (%"PRIu32" bytes)", cache_path, hdr->code_size);
+}
+
+#endif // EVM_BYTECODE_CACHE
+
+// بارگذاری اسکریپت: از کش .evmc در صورت اعتبار، وگرنه کامپایل از سورس
+static void evm_load_script(js_State* J, const char* file_path, const char* source, size_t size) {
+#if EVM_BYTECODE_CACHE
+    char cache_path[256];
+    evmc_header_t hdr = { 0 };
+    struct stat st;
+
+    if (evmc_cache_path(file_path, cache_path, sizeof(cache_path)) && stat(file_path, &st) == 0) {
+        hdr.src_size = size;
+        hdr.src_mtime = (uint32_t)st.st_mtime;
+        hdr.src_hash = evmc_hash(EVMC_HASH_INIT, source, size);
+
+        if (evmc_load(J, cache_path, file_path, &hdr)) {
+            ESP_LOGI(TAG, "⚡ Loaded from bytecode cache: %s", cache_path);
+            return;
+        }
+
+        js_loadstring(J, file_path, source);
+        evmc_save(J, cache_path, &hdr);
+        return;
+    }
+#endif
+    js_loadstring(J, file_path, source);
+}
+
 // ==================== اجرای برنامه‌های JavaScript ====================
 
 // اجرای مستقیم کد JavaScript
@@ -320,7 +614,7 @@ esp_err_t evm_load_and_execute(const char* file_path) {
     }
 
     // اجرای کد در بلوک try
-    js_loadstring(mujs_state, file_path, file_content);
+    evm_load_script(mujs_state, file_path, file_content, bytes_read);
     js_pushundefined(mujs_state); // this
     js_call(mujs_state, 0); // اجرای تابع
     
@@ -347,51 +641,65 @@ esp_err_t evm_loader_init(void) {
         ESP_LOGW(TAG, "⚠️ PSRAM not available, using internal RAM");
     }
 
-    // ایجاد state MuJS با allocator سفارشی PSRAM
-    mujs_state = js_newstate(mujs_alloc, NULL, JS_STRICT);
-    if (!mujs_state) {
+    // template: builtinها و ماژول‌ها فقط یک بار اینجا ثبت می‌شوند
+    int64_t start_us = esp_timer_get_time();
+    mujs_template = mujs_newstate(EVM_JS_FLAGS, &mujs_template_arena);
+    if (!mujs_template) {
         ESP_LOGE(TAG, "Failed to create MuJS state");
         return ESP_FAIL;
     }
 
     // توابع پایه
-    js_newcfunction(mujs_state, js_print, "print", 0);
-    js_setglobal(mujs_state, "print");
+    js_newcfunction(mujs_template, js_print, "print", 0);
+    js_setglobal(mujs_template, "print");
 
-    js_newcfunction(mujs_state, js_delay, "delay", 1);
-    js_setglobal(mujs_state, "delay");
+    js_newcfunction(mujs_template, js_delay, "delay", 1);
+    js_setglobal(mujs_template, "delay");
 
-    js_newcfunction(mujs_state, js_debug, "debug", 0);
-    js_setglobal(mujs_state, "debug");
+    js_newcfunction(mujs_template, js_debug, "debug", 0);
+    js_setglobal(mujs_template, "debug");
 
-    js_newcfunction(mujs_state, js_memory_info, "memory_info", 0);
-    js_setglobal(mujs_state, "memory_info");
+    js_newcfunction(mujs_template, js_memory_info, "memory_info", 0);
+    js_setglobal(mujs_template, "memory_info");
 
     // شیء system
-    js_newobject(mujs_state);
-    js_pushstring(mujs_state, "ESP32");
-    js_setproperty(mujs_state, -2, "platform");
+    js_newobject(mujs_template);
+    js_pushstring(mujs_template, "ESP32");
+    js_setproperty(mujs_template, -2, "platform");
     
-    js_pushnumber(mujs_state, esp_get_free_heap_size());
-    js_setproperty(mujs_state, -2, "freeMemory");
+    js_pushnumber(mujs_template, esp_get_free_heap_size());
+    js_setproperty(mujs_template, -2, "freeMemory");
     
-    js_pushboolean(mujs_state, heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0);
-    js_setproperty(mujs_state, -2, "hasPSRAM");
+    js_pushboolean(mujs_template, heap_caps_get_free_size(MALLOC_CAP_SPIRAM) > 0);
+    js_setproperty(mujs_template, -2, "hasPSRAM");
     
-    js_setglobal(mujs_state, "system");
+    js_setglobal(mujs_template, "system");
 
     // ثبت ماژول‌ها
     ESP_LOGI(TAG, "Registering EVM Modules...");
 
-    evm_gpio_register_js(mujs_state);
-    evm_timer_register_js(mujs_state);
-    evm_fs_register_js(mujs_state);
-    evm_process_register_js(mujs_state);
-    evm_console_register_js(mujs_state);
-    evm_lvgl_register_js_mujs(mujs_state);
-    //evm_mongoose_register_js(mujs_state);
-    evm_module_wifi_register(mujs_state);  // این تابع register است نه init
-    evm_ftp_register_js_mujs(mujs_state);
+    evm_gpio_register_js(mujs_template);
+    evm_timer_register_js(mujs_template);
+    evm_fs_register_js(mujs_template);
+    evm_process_register_js(mujs_template);
+    evm_console_register_js(mujs_template);
+    evm_lvgl_register_js_mujs(mujs_template);
+    //evm_mongoose_register_js(mujs_template);
+    evm_module_wifi_register(mujs_template);  // این تابع register است نه init
+    evm_ftp_register_js_mujs(mujs_template);
+    int64_t template_us = esp_timer_get_time() - start_us;
+
+    // state اجرایی کپی template است
+    start_us = esp_timer_get_time();
+    mujs_state = mujs_newstatefrom(EVM_JS_FLAGS, &mujs_arena);
+    if (!mujs_state) {
+        ESP_LOGE(TAG, "Failed to create MuJS state from template");
+        mujs_freestate(mujs_template, &mujs_template_arena);
+        mujs_template = NULL;
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "⏱️ JS state: template %lld us, copy %lld us",
+             (long long)template_us, (long long)(esp_timer_get_time() - start_us));
 
     mujs_running = false;
     memset(&current_evm_context, 0, sizeof(current_evm_context));
@@ -432,9 +740,16 @@ esp_err_t evm_loader_deinit(void) {
     
     // آزادسازی MuJS
     if (mujs_state) {
-        js_freestate(mujs_state);
+        mujs_log_arena_stats(mujs_arena);
+        mujs_freestate(mujs_state, &mujs_arena);
         mujs_state = NULL;
     }
+    // template آخر از همه: داده native کپی‌ها متعلق به آن است
+    if (mujs_template) {
+        mujs_freestate(mujs_template, &mujs_template_arena);
+        mujs_template = NULL;
+    }
+    evm_lvgl_flush(); // RELEASEهای finalizerها
     
     // ریست کردن متغیرها
     mujs_running = false;
@@ -480,25 +795,27 @@ static void evm_app_task_func(void *params) {
     // 3. بررسی سلامت state قبل از اجرا
     if (!evm_check_state_health(mujs_state)) {
         ESP_LOGW(TAG, "⚠️ State is unhealthy, recreating...");
-        if (mujs_state) {
-            js_freestate(mujs_state);
+        if (mujs_arena) {
+            mujs_freestate(mujs_state, &mujs_arena);
         }
-        mujs_state = js_newstate(mujs_alloc, NULL, JS_STRICT);
-        // دوباره ثبت ماژول‌ها
+        // کپی تازه از template: توابع پایه و همه ماژول‌های JS از قبل ثبت شده‌اند
+        mujs_state = mujs_newstatefrom(EVM_JS_FLAGS, &mujs_arena);
         safe_evm_modules_init();
-        
-        // 🔥 ثبت مجدد توابع JavaScript
-        js_newcfunction(mujs_state, js_print, "print", 0);
-        js_setglobal(mujs_state, "print");
-        js_newcfunction(mujs_state, js_delay, "delay", 1);
-        js_setglobal(mujs_state, "delay");
-        js_newcfunction(mujs_state, js_debug, "debug", 0);
-        js_setglobal(mujs_state, "debug");
-        js_newcfunction(mujs_state, js_memory_info, "memory_info", 0);
-        js_setglobal(mujs_state, "memory_info");
-    }
-
-    // 4. اجرای برنامه اصلی
+    }
+
+    // 4. راه‌اندازی حلقه رویداد روی همین تسک
+    evm_event_loop_port_t loop_port = {
+        .now = app_loop_now,
+        .wait = app_loop_wait,
+        .wakeup = app_loop_wakeup,
+        .ctx = xTaskGetCurrentTaskHandle(),
+    };
+    evm_event_loop_init(&app_event_loop, &loop_port);
+    evm_timer_set_event_loop(&app_event_loop);
+    evm_app_loop_attach(&app_event_loop);
+    app_event_loop_active = true;
+
+    // 5. اجرای برنامه اصلی
     const char *filename = strrchr(app_path, '/');
     if (filename) filename++;
     else filename = app_path;
@@ -506,6 +823,7 @@ static void evm_app_task_func(void *params) {
     ESP_LOGI(TAG, "🚀 Executing application: %s", filename);
     
     esp_err_t result = evm_load_and_execute(app_path);
+    evm_lvgl_commit();
     
     if (result == ESP_OK) {
         ESP_LOGI(TAG, "✅ Application executed successfully");
@@ -515,9 +833,9 @@ static void evm_app_task_func(void *params) {
         evm_cleanup_state(mujs_state);
     }
 
-    // 5. مدیریت لوپ
+    // 6. حلقه رویداد: اجرای callbackها تا درخواست توقف
     if (app_core_running && !app_stop_requested) {
-        ESP_LOGI(TAG, "🔄 Application has active loop, monitoring for stop...");
+        ESP_LOGI(TAG, "🔄 Application has active loop, running event loop...");
         app_has_active_loop = true;
         
         while (evm_should_continue_loop()) {
@@ -525,21 +843,38 @@ static void evm_app_task_func(void *params) {
                 esp_task_wdt_reset();
             }
             
+            // حداکثر 100ms خواب تا WDT و درخواست توقف بررسی شوند
+            int ran = evm_event_loop_run_once(&app_event_loop, 100);
+            evm_lvgl_commit(); // هر دور حلقه یک دسته فرمان LVGL
+            
             app_loop_counter++;
-            if (app_loop_counter % 100 == 0) {
-                ESP_LOGD(TAG, "🔄 App loop running... (%"PRIu32")", app_loop_counter);
-                js_gc(mujs_state, 0); // GC دوره‌ای
+            if (ran == 0) {
+                // زمان بیکاری: یک گام GC تدریجی، فقط اگر چرخه‌ای در جریان است
+                // یا بدهی تخصیص آن را خواسته؛ GC کامل اینجا pause را برمی‌گرداند
+                js_gcstep(mujs_state);
+                if (app_loop_counter % 10 == 0) {
+                    ESP_LOGD(TAG, "🔄 App loop idle... (%"PRIu32", timers: %d)",
+                             app_loop_counter, evm_event_loop_timer_count(&app_event_loop));
+                }
             }
-            
-            vTaskDelay(pdMS_TO_TICKS(10));
         }
     }
 
-    // 6. پاک‌سازی نهایی
+    // 7. پاک‌سازی نهایی
     ESP_LOGI(TAG, "🧹 Cleaning up after application...");
 
+    // لغو تایمرها و بستن حلقه رویداد
+    // ابتدا فرستنده‌های بیرونی (ISRها) جدا شوند، سپس صف تخلیه و وقفه‌ها برداشته شوند
+    app_event_loop_active = false;
+    evm_app_loop_detach();
+    evm_timer_cleanup();
+    evm_gpio_cleanup();
+    evm_fs_cleanup();
+    evm_lvgl_flush();
+
     // پاک‌سازی state (بدون حذف کامل)
     evm_cleanup_state(mujs_state);
+    mujs_log_arena_stats(mujs_arena);
 
     // رهاسازی سخت‌افزار
     if (hardware_acquired) {
@@ -660,6 +995,10 @@ const char* evm_get_version(void) {
 
 void evm_request_app_stop(void) {
     app_stop_requested = true;
+    // بیدار کردن حلقه رویداد اگر در حال خواب است
+    if (app_event_loop_active) {
+        evm_event_loop_wakeup(&app_event_loop);
+    }
     ESP_LOGI(TAG, "🛑 Stop requested for running application");
 }
 
@@ -705,7 +1044,8 @@ static esp_err_t evm_validate_syntax(const char* js_code, const char* context) {
     ESP_LOGI(TAG, "🔍 Validating JavaScript syntax: %s", context);
 
     // ایجاد state موقت برای بررسی syntax
-    js_State* temp_state = js_newstate(mujs_alloc, NULL, JS_STRICT);
+    evm_js_arena_t* temp_arena = NULL;
+    js_State* temp_state = mujs_newstatefrom(JS_STRICT, &temp_arena);
     if (!temp_state) {
         ESP_LOGE(TAG, "❌ Failed to create temporary state for syntax check");
         return ESP_FAIL;
@@ -727,7 +1067,7 @@ static esp_err_t evm_validate_syntax(const char* js_code, const char* context) {
     }
 
     // پاک‌سازی state موقت
-    js_freestate(temp_state);
+    mujs_freestate(temp_state, &temp_arena);
     return result;
 }
 
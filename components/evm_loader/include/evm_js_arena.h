@@ -0,0 +1,73 @@
+#ifndef EVM_JS_ARENA_H
+#define EVM_JS_ARENA_H
+
+// حافظه اختصاصی یک js_State: slabهای اندازه‌ثابت برای بلاک‌های کوچک
+//
+// MuJS هر property، object، environment و رشته کوتاه را جدا تخصیص می‌دهد.
+// این arena بلاک‌های کوچک (تا EVM_JS_ARENA_MAX_SMALL بایت) را از صفحه‌های
+// EVM_JS_ARENA_PAGE بایتی هم‌تراز برمی‌دارد؛ هر صفحه فقط یک کلاس اندازه دارد
+// و صفحه هر اشاره‌گر با پوشاندن بیت‌های پایین پیدا می‌شود. بلاک‌های بزرگ
+// (پشته، کد، آرایه‌ها) مستقیم از heap گرفته می‌شوند ولی در arena ثبت می‌شوند.
+// با destroy همه صفحه‌ها و بلاک‌ها یک‌جا آزاد می‌شوند.
+//
+// arena قفل ندارد: فقط تسکی که state را اجرا می‌کند از آن استفاده کند.
+// این فایل به ESP-IDF وابسته نیست تا روی host تست شود.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVM_JS_ARENA_PAGE       4096    // اندازه و هم‌ترازی صفحه‌های slab
+#define EVM_JS_ARENA_MAX_SMALL  256     // بزرگ‌ترین بلاک slab
+#define EVM_JS_ARENA_CLASSES    12
+
+// منبع حافظه arena (روی ESP32 همان PSRAM)
+typedef struct {
+    void *(*page_alloc)(void *ctx);                             // EVM_JS_ARENA_PAGE بایت، هم‌تراز
+    void (*page_free)(void *ctx, void *page);
+    void *(*heap_realloc)(void *ctx, void *ptr, size_t size);   // مثل realloc؛ size صفر یعنی free
+    void *ctx;
+} evm_js_arena_port_t;
+
+typedef struct {
+    uint32_t size;          // اندازه بلاک این کلاس
+    uint32_t pages;
+    uint32_t used;          // بلاک‌های در حال استفاده
+    uint32_t capacity;      // کل بلاک‌های صفحه‌ها
+    uint32_t allocs;        // تعداد کل تخصیص‌ها
+} evm_js_arena_class_stats_t;
+
+typedef struct {
+    evm_js_arena_class_stats_t classes[EVM_JS_ARENA_CLASSES];
+    uint32_t pages;             // صفحه‌های slab
+    size_t small_used;          // بایت بلاک‌های کوچک در حال استفاده
+    uint32_t large_count;
+    size_t large_bytes;
+    size_t footprint;           // کل حافظه گرفته شده از port
+    float fragmentation;        // سهم فضای بی‌استفاده صفحه‌ها (0..1)
+} evm_js_arena_stats_t;
+
+typedef struct evm_js_arena evm_js_arena_t;
+
+evm_js_arena_t *evm_js_arena_create(const evm_js_arena_port_t *port);
+
+// آزادسازی همه صفحه‌ها و بلاک‌های بزرگ؛ اشاره‌گرهای arena دیگر معتبر نیستند
+void evm_js_arena_destroy(evm_js_arena_t *arena);
+
+// از این به بعد free کاری نمی‌کند؛ برای js_freestate درست قبل از destroy
+void evm_js_arena_begin_teardown(evm_js_arena_t *arena);
+
+// allocator سازگار با js_Alloc؛ actx همان arena است
+void *evm_js_arena_alloc(void *actx, void *ptr, int size);
+
+void evm_js_arena_get_stats(const evm_js_arena_t *arena, evm_js_arena_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVM_JS_ARENA_H
@@ -0,0 +1,153 @@
+// مقایسه arena با allocator فعلی (realloc جدا برای هر بلاک) روی host
+//   ./bench_evm_js_arena ../../../app/bench_*.js
+// هر اسکریپت چند بار در state تازه اجرا می‌شود؛ زمان شامل js_freestate است.
+#include "evm_js_arena.h"
+#include "mujs.h"
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RUNS 5
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// ==================== allocator فعلی (مثل mujs_alloc) ====================
+
+static size_t heap_live, heap_peak, heap_blocks, heap_peak_blocks;
+
+static void *heap_alloc(void *actx, void *ptr, int size) {
+    (void)actx;
+    if (ptr) {
+        heap_live -= malloc_usable_size(ptr);
+        heap_blocks--;
+    }
+    if (size <= 0) {
+        free(ptr);
+        return NULL;
+    }
+    void *p = realloc(ptr, size);
+    if (p) {
+        heap_live += malloc_usable_size(p);
+        heap_blocks++;
+        if (heap_live > heap_peak) heap_peak = heap_live;
+        if (heap_blocks > heap_peak_blocks) heap_peak_blocks = heap_blocks;
+    }
+    return p;
+}
+
+// ==================== arena ====================
+
+static size_t arena_peak;
+static int arena_peak_pages;
+static int arena_pages;
+
+static void *host_page_alloc(void *ctx) {
+    (void)ctx;
+    arena_pages++;
+    if (arena_pages > arena_peak_pages) arena_peak_pages = arena_pages;
+    return aligned_alloc(EVM_JS_ARENA_PAGE, EVM_JS_ARENA_PAGE);
+}
+
+static void host_page_free(void *ctx, void *page) {
+    (void)ctx;
+    arena_pages--;
+    free(page);
+}
+
+static void *host_heap_realloc(void *ctx, void *ptr, size_t size) {
+    (void)ctx;
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    return realloc(ptr, size);
+}
+
+static const evm_js_arena_port_t host_port = {
+    .page_alloc = host_page_alloc,
+    .page_free = host_page_free,
+    .heap_realloc = host_heap_realloc,
+};
+
+// ==================== اجرا ====================
+
+static void js_quiet(js_State *J) {
+    js_pushundefined(J);
+}
+
+static int run_script(js_State *J, const char *path) {
+    js_newcfunction(J, js_quiet, "print", 0);
+    js_setglobal(J, "print");
+    return js_dofile(J, path);
+}
+
+static double bench_heap(const char *path) {
+    double best = 1e30;
+    for (int i = 0; i < RUNS; i++) {
+        double t0 = now_ms();
+        js_State *J = js_newstate(heap_alloc, NULL, JS_GCINCREMENTAL);
+        run_script(J, path);
+        js_freestate(J);
+        double t = now_ms() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+static double bench_arena(const char *path, evm_js_arena_stats_t *last) {
+    double best = 1e30;
+    for (int i = 0; i < RUNS; i++) {
+        double t0 = now_ms();
+        evm_js_arena_t *a = evm_js_arena_create(&host_port);
+        js_State *J = js_newstate(evm_js_arena_alloc, a, JS_GCINCREMENTAL);
+        run_script(J, path);
+        evm_js_arena_get_stats(a, last);
+        if (last->footprint > arena_peak) arena_peak = last->footprint;
+        evm_js_arena_begin_teardown(a);
+        js_freestate(J);
+        evm_js_arena_destroy(a);
+        double t = now_ms() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+static void print_stats(const evm_js_arena_stats_t *st) {
+    printf("    class  pages   used/capacity     allocs\n");
+    for (int i = 0; i < EVM_JS_ARENA_CLASSES; i++) {
+        const evm_js_arena_class_stats_t *c = &st->classes[i];
+        if (!c->allocs) continue;
+        printf("    %5u  %5u  %7u/%-8u %10u\n", c->size, c->pages, c->used, c->capacity, c->allocs);
+    }
+    printf("    pages %u, large %u (%zu bytes), fragmentation %.1f%%\n",
+           st->pages, st->large_count, st->large_bytes, st->fragmentation * 100.0f);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s script.js...\n", argv[0]);
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        evm_js_arena_stats_t st;
+        heap_peak = heap_peak_blocks = 0;
+        arena_peak = 0;
+        arena_peak_pages = 0;
+
+        double th = bench_heap(argv[i]);
+        double ta = bench_arena(argv[i], &st);
+
+        printf("%s\n", argv[i]);
+        printf("  heap : %8.1f ms  peak %zu bytes in %zu blocks\n", th, heap_peak, heap_peak_blocks);
+        printf("  arena: %8.1f ms  peak %d pages, end footprint %zu bytes\n", ta, arena_peak_pages, st.footprint);
+        print_stats(&st);
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+// زمان راه‌اندازی state روی host: js_newstate + ثبت ماژول‌ها در برابر js_newstatefrom
+//   ./bench_evm_js_snapshot
+// ماژول‌ها شبیه‌سازی شده‌اند: چند شیء با تعداد زیادی تابع C، مثل شیء lvgl
+#include "evm_js_arena.h"
+#include "mujs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RUNS 200
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void *host_page_alloc(void *ctx) {
+    (void)ctx;
+    return aligned_alloc(EVM_JS_ARENA_PAGE, EVM_JS_ARENA_PAGE);
+}
+
+static void host_page_free(void *ctx, void *page) {
+    (void)ctx;
+    free(page);
+}
+
+static void *host_heap_realloc(void *ctx, void *ptr, size_t size) {
+    (void)ctx;
+    if (size == 0) {
+        free(ptr);
+        return NULL;
+    }
+    return realloc(ptr, size);
+}
+
+static const evm_js_arena_port_t host_port = {
+    .page_alloc = host_page_alloc,
+    .page_free = host_page_free,
+    .heap_realloc = host_heap_realloc,
+};
+
+// ==================== ماژول‌های نمونه ====================
+
+static void js_stub(js_State *J) {
+    js_pushundefined(J);
+}
+
+static const struct { const char *name; int functions; int constants; } modules[] = {
+    { "gpio", 12, 8 },
+    { "timer", 6, 0 },
+    { "fs", 14, 4 },
+    { "process", 8, 2 },
+    { "console", 5, 0 },
+    { "lvgl", 180, 120 },
+    { "wifi", 10, 6 },
+    { "ftp", 6, 0 },
+};
+
+static void register_modules(js_State *J) {
+    char name[32];
+    for (size_t m = 0; m < sizeof modules / sizeof modules[0]; m++) {
+        js_newobject(J);
+        for (int i = 0; i < modules[m].functions; i++) {
+            snprintf(name, sizeof name, "%s_fn_%d", modules[m].name, i);
+            js_newcfunction(J, js_stub, name, 1);
+            js_setproperty(J, -2, name);
+        }
+        for (int i = 0; i < modules[m].constants; i++) {
+            snprintf(name, sizeof name, "%s_CONST_%d", modules[m].name, i);
+            js_pushnumber(J, i);
+            js_defproperty(J, -2, name, JS_READONLY | JS_DONTCONF);
+        }
+        js_setglobal(J, modules[m].name);
+    }
+}
+
+static js_State *new_registered_state(js_Alloc alloc, void *actx) {
+    js_State *J = js_newstate(alloc, actx, JS_STRICT);
+    register_modules(J);
+    return J;
+}
+
+// ==================== اجرا ====================
+
+static double bench(js_State *T, int use_arena, size_t *footprint) {
+    double best = 1e30;
+    for (int run = 0; run < 5; run++) {
+        double t0 = now_ms();
+        for (int i = 0; i < RUNS; i++) {
+            evm_js_arena_t *a = use_arena ? evm_js_arena_create(&host_port) : NULL;
+            js_State *J = T ? js_newstatefrom(T, use_arena ? evm_js_arena_alloc : NULL, a, JS_STRICT)
+                            : new_registered_state(use_arena ? evm_js_arena_alloc : NULL, a);
+            if (a) {
+                evm_js_arena_stats_t st;
+                evm_js_arena_get_stats(a, &st);
+                *footprint = st.footprint;
+                evm_js_arena_begin_teardown(a);
+            }
+            js_freestate(J);
+            evm_js_arena_destroy(a);
+        }
+        double t = (now_ms() - t0) * 1000.0 / RUNS;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(void) {
+    js_State *T = new_registered_state(NULL, NULL);
+    size_t fresh_bytes = 0, copy_bytes = 0;
+
+    double fresh = bench(NULL, 0, NULL);
+    double copy = bench(T, 0, NULL);
+    double fresh_arena = bench(NULL, 1, &fresh_bytes);
+    double copy_arena = bench(T, 1, &copy_bytes);
+
+    printf("state startup, best of 5 x %d (us per state, including js_freestate)\n", RUNS);
+    printf("  heap : js_newstate + modules %8.1f   js_newstatefrom %8.1f   (%.1fx)\n",
+           fresh, copy, fresh / copy);
+    printf("  arena: js_newstate + modules %8.1f   js_newstatefrom %8.1f   (%.1fx)\n",
+           fresh_arena, copy_arena, fresh_arena / copy_arena);
+    printf("  arena footprint: %zu bytes fresh, %zu bytes copy\n", fresh_bytes, copy_bytes);
+
+    js_freestate(T);
+    return 0;
+}
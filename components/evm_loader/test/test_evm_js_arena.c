@@ -0,0 +1,233 @@
+// تست‌های arena حافظه MuJS روی host: بلاک‌های تصادفی با الگو و یک state واقعی
+#include "evm_js_arena.h"
+#include "mujs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// ==================== port شمارنده ====================
+
+typedef struct {
+    int pages;
+    int blocks;
+} counting_port_t;
+
+static void *host_page_alloc(void *ctx) {
+    counting_port_t *c = ctx;
+    void *p = aligned_alloc(EVM_JS_ARENA_PAGE, EVM_JS_ARENA_PAGE);
+    if (p) c->pages++;
+    return p;
+}
+
+static void host_page_free(void *ctx, void *page) {
+    counting_port_t *c = ctx;
+    c->pages--;
+    free(page);
+}
+
+static void *host_heap_realloc(void *ctx, void *ptr, size_t size) {
+    counting_port_t *c = ctx;
+    if (size == 0) {
+        if (ptr) c->blocks--;
+        free(ptr);
+        return NULL;
+    }
+    void *p = realloc(ptr, size);
+    if (p && !ptr) c->blocks++;
+    return p;
+}
+
+static evm_js_arena_t *new_arena(counting_port_t *c) {
+    memset(c, 0, sizeof *c);
+    evm_js_arena_port_t port = {
+        .page_alloc = host_page_alloc,
+        .page_free = host_page_free,
+        .heap_realloc = host_heap_realloc,
+        .ctx = c,
+    };
+    return evm_js_arena_create(&port);
+}
+
+// ==================== بلاک‌های تصادفی ====================
+
+#define SLOTS 4000
+
+typedef struct {
+    unsigned char *p;
+    int size;
+    unsigned char fill;
+} slot_t;
+
+static unsigned int rng = 12345;
+static unsigned int next_rand(void) {
+    rng = rng * 1103515245 + 12345;
+    return rng >> 8;
+}
+
+static int random_size(void) {
+    unsigned int r = next_rand() % 100;
+    if (r < 80) return 1 + next_rand() % 64;
+    if (r < 95) return 1 + next_rand() % 256;
+    return 257 + next_rand() % 8000;
+}
+
+static bool slot_intact(const slot_t *s) {
+    for (int i = 0; i < s->size; i++) {
+        if (s->p[i] != s->fill) return false;
+    }
+    return true;
+}
+
+static void test_random_blocks(void) {
+    counting_port_t c;
+    evm_js_arena_t *a = new_arena(&c);
+    static slot_t slots[SLOTS];
+    memset(slots, 0, sizeof slots);
+
+    int corrupt = 0;
+    for (int round = 0; round < 200000; round++) {
+        slot_t *s = &slots[next_rand() % SLOTS];
+        unsigned int op = next_rand() % 3;
+        if (s->p && !slot_intact(s)) corrupt++;
+
+        if (!s->p) {
+            s->size = random_size();
+            s->p = evm_js_arena_alloc(a, NULL, s->size);
+        } else if (op == 0) {
+            evm_js_arena_alloc(a, s->p, 0);
+            s->p = NULL;
+            continue;
+        } else {
+            // realloc: محتوای مشترک باید بماند
+            int size = random_size();
+            unsigned char *p = evm_js_arena_alloc(a, s->p, size);
+            int keep = size < s->size ? size : s->size;
+            for (int i = 0; i < keep; i++) {
+                if (p[i] != s->fill) {
+                    corrupt++;
+                    break;
+                }
+            }
+            s->p = p;
+            s->size = size;
+        }
+        CHECK(s->p != NULL);
+        s->fill = (unsigned char)next_rand();
+        memset(s->p, s->fill, s->size);
+    }
+    CHECK(corrupt == 0);
+
+    evm_js_arena_stats_t st;
+    evm_js_arena_get_stats(a, &st);
+    uint32_t used = 0, capacity = 0, pages = 0;
+    for (int i = 0; i < EVM_JS_ARENA_CLASSES; i++) {
+        used += st.classes[i].used;
+        capacity += st.classes[i].capacity;
+        pages += st.classes[i].pages;
+        CHECK(st.classes[i].used <= st.classes[i].capacity);
+    }
+    CHECK(pages == st.pages);
+    CHECK((int)st.pages == c.pages);
+    CHECK(used > 0 && used <= capacity);
+    CHECK(st.fragmentation >= 0.0f && st.fragmentation < 1.0f);
+
+    // آزاد کردن همه: حداکثر یک صفحه برای هر کلاس می‌ماند
+    for (int i = 0; i < SLOTS; i++) {
+        if (slots[i].p) {
+            CHECK(slot_intact(&slots[i]));
+            evm_js_arena_alloc(a, slots[i].p, 0);
+        }
+    }
+    evm_js_arena_get_stats(a, &st);
+    CHECK(st.small_used == 0);
+    CHECK(st.large_count == 0 && st.large_bytes == 0);
+    CHECK(st.pages <= EVM_JS_ARENA_CLASSES);
+
+    evm_js_arena_destroy(a);
+    CHECK(c.pages == 0);
+    CHECK(c.blocks == 0);
+}
+
+// ==================== teardown ====================
+
+static void test_teardown(void) {
+    counting_port_t c;
+    evm_js_arena_t *a = new_arena(&c);
+
+    for (int i = 0; i < 5000; i++) {
+        CHECK(evm_js_arena_alloc(a, NULL, 1 + i % 300) != NULL);
+    }
+    void *big = evm_js_arena_alloc(a, NULL, 100000);
+    CHECK(big != NULL);
+    CHECK(c.pages > 0);
+
+    evm_js_arena_stats_t before, after;
+    evm_js_arena_get_stats(a, &before);
+    evm_js_arena_begin_teardown(a);
+    CHECK(evm_js_arena_alloc(a, big, 0) == NULL);
+    evm_js_arena_get_stats(a, &after);
+    CHECK(after.large_count == before.large_count);     // free در teardown کاری نمی‌کند
+
+    evm_js_arena_destroy(a);
+    CHECK(c.pages == 0);
+    CHECK(c.blocks == 0);
+}
+
+// ==================== state واقعی MuJS ====================
+
+static const char *script =
+    "var objs = [];\n"
+    "for (var i = 0; i < 20000; i++) {\n"
+    "    var o = { id: i, name: 'item' + i, tags: [i, i * 2] };\n"
+    "    o['k' + (i % 50)] = function () { return this.id; };\n"
+    "    if (i % 3) objs.push(o);\n"
+    "}\n"
+    "var s = '';\n"
+    "for (var j = 0; j < 2000; j++) s += objs[j].name.charAt(0);\n"
+    "var r = objs.length + ':' + s.length + ':' + objs[100].k1();\n";
+
+static void test_mujs_state(void) {
+    counting_port_t c;
+    evm_js_arena_t *a = new_arena(&c);
+
+    js_State *J = js_newstate(evm_js_arena_alloc, a, JS_STRICT | JS_GCINCREMENTAL);
+    CHECK(J != NULL);
+    CHECK(js_dostring(J, script) == 0);
+    js_getglobal(J, "r");
+    CHECK(strcmp(js_tostring(J, -1), "13333:2000:151") == 0);
+    js_pop(J, 1);
+    js_gc(J, 0);
+
+    evm_js_arena_stats_t st;
+    evm_js_arena_get_stats(a, &st);
+    CHECK(st.pages > 0);
+    CHECK(st.large_count > 0);      // پشته و خود state
+
+    evm_js_arena_begin_teardown(a);
+    js_freestate(J);
+    evm_js_arena_destroy(a);
+    CHECK(c.pages == 0);
+    CHECK(c.blocks == 0);
+}
+
+int main(void) {
+    test_random_blocks();
+    test_teardown();
+    test_mujs_state();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all evm_js_arena tests passed\n");
+    return 0;
+}
@@ -0,0 +1,218 @@
+// تست‌های snapshot حالت سراسری MuJS روی host: کپی‌ها باید مثل state تازه رفتار کنند
+#include "evm_js_arena.h"
+#include "mujs.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// ==================== port شمارنده ====================
+
+typedef struct {
+    int pages;
+    int blocks;
+} counting_port_t;
+
+static void *host_page_alloc(void *ctx) {
+    counting_port_t *c = ctx;
+    void *p = aligned_alloc(EVM_JS_ARENA_PAGE, EVM_JS_ARENA_PAGE);
+    if (p) c->pages++;
+    return p;
+}
+
+static void host_page_free(void *ctx, void *page) {
+    counting_port_t *c = ctx;
+    c->pages--;
+    free(page);
+}
+
+static void *host_heap_realloc(void *ctx, void *ptr, size_t size) {
+    counting_port_t *c = ctx;
+    if (size == 0) {
+        if (ptr) c->blocks--;
+        free(ptr);
+        return NULL;
+    }
+    void *p = realloc(ptr, size);
+    if (p && !ptr) c->blocks++;
+    return p;
+}
+
+static evm_js_arena_t *new_arena(counting_port_t *c) {
+    memset(c, 0, sizeof *c);
+    evm_js_arena_port_t port = {
+        .page_alloc = host_page_alloc,
+        .page_free = host_page_free,
+        .heap_realloc = host_heap_realloc,
+        .ctx = c,
+    };
+    return evm_js_arena_create(&port);
+}
+
+// ==================== template ====================
+
+static int finalized = 0;
+
+static void native_finalize(js_State *J, void *data) {
+    (void)J;
+    (void)data;
+    finalized++;
+}
+
+static void native_answer(js_State *J) {
+    js_pushnumber(J, 42);
+}
+
+// مثل ماژول‌های EVM: تابع C، شیء با prototype در registry و کد JS
+static const char *template_script =
+    "var counter = { n: 0, bump: function () { return ++this.n; } };\n"
+    "var words = ['alpha', 'beta', 'gamma'.toUpperCase() + '-' + 7];\n"
+    "var long = ''; for (var i = 0; i < 40; i++) long += 'rope-piece-' + i + ';';\n"
+    "var re = /b(e+)ta/i;\n"
+    "var boxed = new String('boxed ' + 'string');\n"
+    "function makeAdder(k) { return function (x) { return x + k; }; }\n"
+    "var add5 = makeAdder(5);\n"
+    "Object.defineProperty(counter, 'hidden', { get: function () { return 'getter'; } });\n";
+
+static js_State *new_template(void) {
+    js_State *T = js_newstate(NULL, NULL, JS_STRICT);
+
+    js_newcfunction(T, native_answer, "answer", 0);
+    js_setglobal(T, "answer");
+
+    js_newobject(T);
+    js_newcfunctionx(T, native_answer, "proto_answer", 0, (void *)"data", native_finalize);
+    js_setproperty(T, -2, "answer");
+    js_setregistry(T, "test_proto");
+
+    js_getregistry(T, "test_proto");
+    js_newuserdata(T, "native", (void *)"native", native_finalize);
+    js_setglobal(T, "native");
+
+    CHECK(js_dostring(T, template_script) == 0);
+    return T;
+}
+
+static const char *eval_string(js_State *J, const char *source, char *buf, size_t size) {
+    buf[0] = 0;
+    if (js_ploadstring(J, "[test]", source) == 0) {
+        js_pushundefined(J);
+        if (js_pcall(J, 0) == 0)
+            snprintf(buf, size, "%s", js_tostring(J, -1));
+        else
+            snprintf(buf, size, "error: %s", js_trystring(J, -1, "?"));
+    } else {
+        snprintf(buf, size, "error: %s", js_trystring(J, -1, "?"));
+    }
+    js_pop(J, 1);
+    return buf;
+}
+
+#define CHECK_EVAL(J, source, expect) do { \
+    char buf_[512]; \
+    const char *got_ = eval_string(J, source, buf_, sizeof buf_); \
+    if (strcmp(got_, expect) != 0) { \
+        printf("%s:%d: %s => '%s', expected '%s'\n", __FILE__, __LINE__, source, got_, expect); \
+        failures++; \
+    } \
+} while (0)
+
+// ==================== تست‌ها ====================
+
+static void test_copy_behaves_like_template(js_State *T) {
+    js_State *J = js_newstatefrom(T, NULL, NULL, JS_STRICT);
+    CHECK(J != NULL);
+
+    CHECK_EVAL(J, "answer() + native.answer()", "84");
+    CHECK_EVAL(J, "counter.bump() + counter.bump()", "3");
+    CHECK_EVAL(J, "words.join(',') + ':' + words.length", "alpha,beta,GAMMA-7:3");
+    CHECK_EVAL(J, "long.length + ':' + long.slice(-14)", "550:rope-piece-39;");
+    CHECK_EVAL(J, "re.exec('xBEEta')[1] + re.source + re.ignoreCase", "EEb(e+)tatrue");
+    CHECK_EVAL(J, "boxed.length + boxed.charAt(7) + typeof boxed", "12tobject");
+    CHECK_EVAL(J, "add5(10) + makeAdder(1)(1)", "17");
+    CHECK_EVAL(J, "counter.hidden", "getter");
+    CHECK_EVAL(J, "[3,1,2].sort().concat([4]).map(function (x) { return x * 2; }).join()", "2,4,6,8");
+    CHECK_EVAL(J, "JSON.stringify({ a: [1, 'x'], b: Math.max(1, 2) })", "{\"a\":[1,\"x\"],\"b\":2}");
+    CHECK_EVAL(J, "new Date(0).getTime() + ':' + (new Error('e') instanceof Error)", "0:true");
+    CHECK_EVAL(J, "Object.getPrototypeOf([]) === Array.prototype && [] instanceof Array", "true");
+    CHECK_EVAL(J, "'use strict'; undeclared = 1", "error: ReferenceError: assignment to undeclared variable 'undeclared'");
+
+    // registry کپی شده است
+    js_getregistry(J, "test_proto");
+    CHECK(js_isobject(J, -1));
+    js_pop(J, 1);
+
+    // تغییرات کپی به template نمی‌رسد
+    CHECK_EVAL(J, "counter.extra = 'x'; Array.prototype.custom = 1; words.push('delta'); words.length", "4");
+    CHECK_EVAL(T, "counter.n + ':' + counter.extra + ':' + [].custom + ':' + words.length", "0:undefined:undefined:3");
+
+    // رشته‌های تازه در جدول خود کپی intern می‌شوند
+    CHECK_EVAL(J, "var o = {}; o['fresh_' + 1] = 2; Object.keys(o)[0]", "fresh_1");
+
+    js_gc(J, 0);
+    CHECK_EVAL(J, "counter.n + words.length + add5(0)", "11");
+    js_freestate(J);
+
+    // finalizer داده native فقط متعلق به template است
+    CHECK(finalized == 0);
+}
+
+static void test_copy_of_copy(js_State *T) {
+    js_State *A = js_newstatefrom(T, NULL, NULL, 0);
+    CHECK(A != NULL);
+    CHECK_EVAL(A, "var fromA = 'a' + 1; fromA", "a1");
+
+    js_State *B = js_newstatefrom(A, NULL, NULL, 0);
+    CHECK(B != NULL);
+    CHECK_EVAL(B, "fromA + answer() + add5(1)", "a1426");
+
+    js_freestate(B);
+    js_freestate(A);
+}
+
+static void test_copy_in_arena(js_State *T) {
+    counting_port_t c;
+    evm_js_arena_t *a = new_arena(&c);
+
+    js_State *J = js_newstatefrom(T, evm_js_arena_alloc, a, JS_STRICT | JS_GCINCREMENTAL);
+    CHECK(J != NULL);
+    CHECK_EVAL(J, "var s = 0; for (var i = 0; i < 20000; i++) s += add5(i) % 7; s", "60002");
+    js_gc(J, 0);
+
+    // بدون teardown: هر بلاک باید آزاد شود
+    js_freestate(J);
+    evm_js_arena_stats_t st;
+    evm_js_arena_get_stats(a, &st);
+    CHECK(st.small_used == 0);
+    CHECK(st.large_count == 0);
+
+    evm_js_arena_destroy(a);
+    CHECK(c.pages == 0);
+    CHECK(c.blocks == 0);
+}
+
+int main(void) {
+    js_State *T = new_template();
+
+    test_copy_behaves_like_template(T);
+    test_copy_of_copy(T);
+    test_copy_in_arena(T);
+
+    js_freestate(T);
+    CHECK(finalized == 2);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all evm_js_snapshot tests passed\n");
+    return 0;
+}
@@ -0,0 +1,362 @@
+#include "evm_event_loop.h"
+#include <stdlib.h>
+#include <string.h>
+
+// شناسه تایمر: بیت‌های پایین شماره خانه + 1، بیت‌های بالا نسل خانه
+#define TIMER_SLOT_BITS 20
+#define TIMER_SLOT_MASK ((1u << TIMER_SLOT_BITS) - 1)
+#define TIMER_MAX_SLOTS ((int)TIMER_SLOT_MASK)
+
+// ==================== صف MPSC ====================
+
+static void queue_push(evm_event_loop_t *loop, evm_event_t *event) {
+    atomic_store_explicit(&event->next, NULL, memory_order_relaxed);
+    evm_event_t *prev = atomic_exchange_explicit(&loop->head, event, memory_order_acq_rel);
+    atomic_store_explicit(&prev->next, event, memory_order_release);
+}
+
+// فقط تسک صاحب حلقه؛ اگر فرستنده‌ای وسط push باشد NULL برمی‌گرداند و
+// بعد از wakeup دوباره امتحان می‌شود
+static evm_event_t *queue_pop(evm_event_loop_t *loop) {
+    evm_event_t *tail = loop->tail;
+    evm_event_t *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+
+    if (tail == &loop->stub) {
+        if (!next) {
+            return NULL;
+        }
+        loop->tail = next;
+        tail = next;
+        next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    }
+
+    if (next) {
+        loop->tail = next;
+        return tail;
+    }
+
+    if (tail != atomic_load_explicit(&loop->head, memory_order_acquire)) {
+        return NULL;
+    }
+
+    queue_push(loop, &loop->stub);
+    next = atomic_load_explicit(&tail->next, memory_order_acquire);
+    if (next) {
+        loop->tail = next;
+        return tail;
+    }
+    return NULL;
+}
+
+// ==================== min-heap تایمرها ====================
+
+static bool timer_before(const evm_loop_timer_t *a, const evm_loop_timer_t *b) {
+    if (a->deadline != b->deadline) {
+        return a->deadline < b->deadline;
+    }
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static void heap_set(evm_event_loop_t *loop, int index, int slot) {
+    loop->heap[index] = slot;
+    loop->timers[slot].heap_index = index;
+}
+
+static void heap_up(evm_event_loop_t *loop, int index) {
+    int slot = loop->heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!timer_before(&loop->timers[slot], &loop->timers[loop->heap[parent]])) {
+            break;
+        }
+        heap_set(loop, index, loop->heap[parent]);
+        index = parent;
+    }
+    heap_set(loop, index, slot);
+}
+
+static void heap_down(evm_event_loop_t *loop, int index) {
+    int slot = loop->heap[index];
+    for (;;) {
+        int child = index * 2 + 1;
+        if (child >= loop->heap_len) {
+            break;
+        }
+        if (child + 1 < loop->heap_len &&
+            timer_before(&loop->timers[loop->heap[child + 1]], &loop->timers[loop->heap[child]])) {
+            child++;
+        }
+        if (!timer_before(&loop->timers[loop->heap[child]], &loop->timers[slot])) {
+            break;
+        }
+        heap_set(loop, index, loop->heap[child]);
+        index = child;
+    }
+    heap_set(loop, index, slot);
+}
+
+static void heap_remove(evm_event_loop_t *loop, int index) {
+    int last = loop->heap[--loop->heap_len];
+    if (index < loop->heap_len) {
+        heap_set(loop, index, last);
+        heap_down(loop, index);
+        heap_up(loop, loop->timers[last].heap_index);
+    }
+}
+
+// ==================== خانه‌های تایمر ====================
+
+static bool timers_grow(evm_event_loop_t *loop) {
+    int cap = loop->timer_cap ? loop->timer_cap * 2 : 16;
+    if (cap > TIMER_MAX_SLOTS) {
+        cap = TIMER_MAX_SLOTS;
+    }
+    if (cap <= loop->timer_cap) {
+        return false;
+    }
+
+    evm_loop_timer_t *timers = realloc(loop->timers, cap * sizeof(*timers));
+    if (!timers) {
+        return false;
+    }
+    loop->timers = timers;
+
+    int *heap = realloc(loop->heap, cap * sizeof(*heap));
+    if (!heap) {
+        return false;
+    }
+    loop->heap = heap;
+
+    // خانه‌های جدید به ابتدای لیست آزاد
+    for (int i = cap - 1; i >= loop->timer_cap; i--) {
+        timers[i].id = (uint32_t)(i + 1);
+        timers[i].heap_index = -1;
+        timers[i].next_free = loop->free_slot;
+        loop->free_slot = i;
+    }
+    loop->timer_cap = cap;
+    return true;
+}
+
+static void timer_free(evm_event_loop_t *loop, int slot) {
+    evm_loop_timer_t *t = &loop->timers[slot];
+    t->heap_index = -1;
+    t->fn = NULL;
+    t->data = NULL;
+    // نسل جدید تا شناسه قبلی دیگر معتبر نباشد
+    t->id = (t->id & TIMER_SLOT_MASK) | ((t->id & ~TIMER_SLOT_MASK) + (1u << TIMER_SLOT_BITS));
+    t->next_free = loop->free_slot;
+    loop->free_slot = slot;
+}
+
+static int timer_lookup(const evm_event_loop_t *loop, uint32_t id) {
+    int slot = (int)(id & TIMER_SLOT_MASK) - 1;
+    if (slot < 0 || slot >= loop->timer_cap) {
+        return -1;
+    }
+    if (loop->timers[slot].id != id || loop->timers[slot].heap_index < 0) {
+        return -1;
+    }
+    return slot;
+}
+
+// ==================== API ====================
+
+void evm_event_loop_init(evm_event_loop_t *loop, const evm_event_loop_port_t *port) {
+    memset(loop, 0, sizeof(*loop));
+    loop->port = *port;
+    loop->free_slot = -1;
+    atomic_store(&loop->stub.next, NULL);
+    atomic_store(&loop->head, &loop->stub);
+    loop->tail = &loop->stub;
+}
+
+void evm_event_loop_deinit(evm_event_loop_t *loop, void (*dispose)(void *data)) {
+    for (int i = 0; i < loop->heap_len; i++) {
+        evm_loop_timer_t *t = &loop->timers[loop->heap[i]];
+        if (dispose) {
+            dispose(t->data);
+        }
+    }
+
+    evm_event_t *event;
+    while ((event = queue_pop(loop)) != NULL) {
+        event->handler(event);
+    }
+
+    free(loop->timers);
+    free(loop->heap);
+    loop->timers = NULL;
+    loop->heap = NULL;
+    loop->timer_cap = 0;
+    loop->heap_len = 0;
+    loop->free_slot = -1;
+}
+
+uint32_t evm_event_loop_add_timer(evm_event_loop_t *loop, evm_time_t delay, int32_t interval,
+                                  evm_timer_fn fn, void *data) {
+    if (loop->free_slot < 0 && !timers_grow(loop)) {
+        return 0;
+    }
+
+    int slot = loop->free_slot;
+    evm_loop_timer_t *t = &loop->timers[slot];
+    loop->free_slot = t->next_free;
+
+    if (delay < 0) {
+        delay = 0;
+    }
+    t->deadline = loop->port.now(loop->port.ctx) + delay;
+    t->interval = interval > 0 ? interval : 0;
+    t->seq = loop->seq++;
+    t->fn = fn;
+    t->data = data;
+
+    loop->heap[loop->heap_len++] = slot;
+    heap_up(loop, loop->heap_len - 1);
+    return t->id;
+}
+
+void *evm_event_loop_cancel_timer(evm_event_loop_t *loop, uint32_t id) {
+    int slot = timer_lookup(loop, id);
+    if (slot < 0) {
+        return NULL;
+    }
+
+    void *data = loop->timers[slot].data;
+    heap_remove(loop, loop->timers[slot].heap_index);
+    timer_free(loop, slot);
+    return data;
+}
+
+void evm_event_loop_post(evm_event_loop_t *loop, evm_event_t *event) {
+    queue_push(loop, event);
+    loop->port.wakeup(loop->port.ctx);
+}
+
+void evm_event_loop_wakeup(evm_event_loop_t *loop) {
+    loop->port.wakeup(loop->port.ctx);
+}
+
+// ==================== حلقه برنامه ====================
+
+static _Atomic(evm_event_loop_t *) app_loop;
+static atomic_int app_posters; // فرستنده‌هایی که اشاره‌گر app_loop را خوانده‌اند
+
+void evm_app_loop_attach(evm_event_loop_t *loop) {
+    atomic_store(&app_loop, loop);
+}
+
+void evm_app_loop_detach(void) {
+    evm_event_loop_t *loop = atomic_exchange(&app_loop, NULL);
+    if (!loop) {
+        return;
+    }
+    // فرستنده‌ای که حلقه را قبل از NULL شدن دیده push را تمام کند؛ با wait
+    // (نه spin) تا تسک فرستنده با اولویت پایین‌تر هم اجرا شود
+    while (atomic_load(&app_posters) > 0) {
+        loop->port.wait(loop->port.ctx, 1);
+    }
+}
+
+bool evm_app_loop_post(evm_event_t *event) {
+    atomic_fetch_add(&app_posters, 1);
+    evm_event_loop_t *loop = atomic_load(&app_loop);
+    if (loop) {
+        evm_event_loop_post(loop, event);
+    }
+    atomic_fetch_sub(&app_posters, 1);
+    return loop != NULL;
+}
+
+int evm_event_loop_timer_count(const evm_event_loop_t *loop) {
+    return loop->heap_len;
+}
+
+evm_time_t evm_event_loop_next_timeout(evm_event_loop_t *loop) {
+    if (loop->heap_len == 0) {
+        return -1;
+    }
+    evm_time_t timeout = loop->timers[loop->heap[0]].deadline - loop->port.now(loop->port.ctx);
+    return timeout > 0 ? timeout : 0;
+}
+
+static int run_timers(evm_event_loop_t *loop) {
+    evm_time_t now = loop->port.now(loop->port.ctx);
+    // تایمرهایی که در همین دور اضافه یا تکرار می‌شوند به دور بعد می‌روند
+    uint32_t seq_limit = loop->seq;
+    int count = 0;
+
+    while (loop->heap_len > 0 && !loop->stop) {
+        int slot = loop->heap[0];
+        evm_loop_timer_t *t = &loop->timers[slot];
+        if (t->deadline > now || (int32_t)(t->seq - seq_limit) >= 0) {
+            break;
+        }
+
+        evm_timer_fn fn = t->fn;
+        void *data = t->data;
+        uint32_t id = t->id;
+
+        if (t->interval > 0) {
+            t->deadline += t->interval;
+            if (t->deadline <= now) {
+                t->deadline = now + t->interval; // عقب‌ماندگی را جبران نکن
+            }
+            t->seq = loop->seq++;
+            heap_down(loop, 0);
+        } else {
+            heap_remove(loop, 0);
+            timer_free(loop, slot);
+        }
+
+        fn(data, id);
+        count++;
+    }
+    return count;
+}
+
+static int run_events(evm_event_loop_t *loop) {
+    evm_event_t *event;
+    int count = 0;
+    while (!loop->stop && (event = queue_pop(loop)) != NULL) {
+        event->handler(event);
+        count++;
+    }
+    return count;
+}
+
+int evm_event_loop_run_once(evm_event_loop_t *loop, evm_time_t max_wait) {
+    int count = 0;
+    // اجرای تو در تو ممنوع: interval کوتاه‌تر از delay درون callback خودش
+    // بی‌پایان بازگشت می‌کرد
+    if (!loop->dispatching) {
+        loop->dispatching = true;
+        count = run_timers(loop);
+        count += run_events(loop);
+        loop->dispatching = false;
+    }
+
+    if (count == 0 && !loop->stop && max_wait != 0) {
+        evm_time_t timeout = loop->dispatching ? -1 : evm_event_loop_next_timeout(loop);
+        if (timeout < 0 || (max_wait > 0 && timeout > max_wait)) {
+            timeout = max_wait;
+        }
+        if (timeout != 0) {
+            loop->port.wait(loop->port.ctx, timeout);
+        }
+    }
+    return count;
+}
+
+void evm_event_loop_run(evm_event_loop_t *loop) {
+    loop->stop = false;
+    while (!loop->stop && loop->heap_len > 0) {
+        evm_event_loop_run_once(loop, -1);
+    }
+}
+
+void evm_event_loop_stop(evm_event_loop_t *loop) {
+    loop->stop = true;
+    loop->port.wakeup(loop->port.ctx);
+}
@@ -0,0 +1,291 @@
+#include "evm_fs_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+// شماره‌ها از 3 شروع می‌شوند (مثل POSIX بعد از stdin/stdout/stderr)
+// تا fd هیچ‌وقت 0 و در JavaScript falsy نباشد
+#define FD_BASE 3
+
+typedef enum {
+    LAST_NONE,
+    LAST_READ,
+    LAST_WRITE,
+} last_op_t;
+
+typedef struct {
+    FILE *file;
+    char *buffer;           // بافر stdio همین فایل (setvbuf)
+    size_t buffer_size;
+    last_op_t last_op;
+} evm_fs_file_t;
+
+static evm_fs_file_t files[EVM_FS_MAX_OPEN];
+
+static evm_fs_file_t *file_get(int fd) {
+    int slot = fd - FD_BASE;
+    if (slot < 0 || slot >= EVM_FS_MAX_OPEN || !files[slot].file) {
+        return NULL;
+    }
+    return &files[slot];
+}
+
+// فقط حالت‌های fopen استاندارد؛ b در هر جا مجاز است و همیشه اضافه می‌شود
+static bool make_mode(const char *flags, char mode[4]) {
+    if (!flags || !*flags) flags = "r";
+    if (flags[0] != 'r' && flags[0] != 'w' && flags[0] != 'a') {
+        return false;
+    }
+
+    bool plus = false;
+    for (const char *p = flags + 1; *p; p++) {
+        if (*p == '+' && !plus) plus = true;
+        else if (*p != 'b') return false;
+    }
+
+    int n = 0;
+    mode[n++] = flags[0];
+    if (plus) mode[n++] = '+';
+    mode[n++] = 'b';
+    mode[n] = '\0';
+    return true;
+}
+
+int evm_fs_open(const char *path, const char *flags, size_t buffer_size) {
+    char mode[4];
+    if (!path || !make_mode(flags, mode)) {
+        return -EINVAL;
+    }
+
+    int slot = 0;
+    while (slot < EVM_FS_MAX_OPEN && files[slot].file) slot++;
+    if (slot == EVM_FS_MAX_OPEN) {
+        return -EMFILE;
+    }
+
+    if (buffer_size == 0) buffer_size = EVM_FS_DEFAULT_BUFFER;
+    if (buffer_size < EVM_FS_MIN_BUFFER) buffer_size = EVM_FS_MIN_BUFFER;
+    if (buffer_size > EVM_FS_MAX_BUFFER) buffer_size = EVM_FS_MAX_BUFFER;
+
+    char *buffer = malloc(buffer_size);
+    if (!buffer) {
+        return -ENOMEM;
+    }
+
+    FILE *f = fopen(path, mode);
+    if (!f) {
+        int err = errno ? errno : EIO;
+        free(buffer);
+        return -err;
+    }
+    setvbuf(f, buffer, _IOFBF, buffer_size);
+
+    files[slot].file = f;
+    files[slot].buffer = buffer;
+    files[slot].buffer_size = buffer_size;
+    files[slot].last_op = LAST_NONE;
+    return slot + FD_BASE;
+}
+
+// در حالت "+" بین خواندن و نوشتن باید seek یا flush انجام شود (C11 7.21.5.3)
+static void file_switch(evm_fs_file_t *file, last_op_t op) {
+    if (file->last_op != LAST_NONE && file->last_op != op) {
+        fseek(file->file, 0, SEEK_CUR);
+    }
+    file->last_op = op;
+}
+
+ssize_t evm_fs_read(int fd, void *buf, size_t len) {
+    evm_fs_file_t *file = file_get(fd);
+    if (!file) {
+        return -EBADF;
+    }
+
+    file_switch(file, LAST_READ);
+    size_t n = fread(buf, 1, len, file->file);
+    if (n == 0 && ferror(file->file)) {
+        clearerr(file->file);
+        return -(errno ? errno : EIO);
+    }
+    return (ssize_t)n;
+}
+
+ssize_t evm_fs_read_text(int fd, void *buf, size_t len) {
+    ssize_t n = evm_fs_read(fd, buf, len);
+    if (n <= 0 || (size_t)n < len) {
+        return n; // انتهای فایل: بایت‌های ناقص همان‌طور تحویل می‌شوند
+    }
+
+    size_t tail = evm_fs_utf8_tail(buf, n);
+    if (tail > 0 && tail < (size_t)n &&
+        fseek(file_get(fd)->file, -(long)tail, SEEK_CUR) == 0) {
+        n -= tail;
+    }
+    return n;
+}
+
+ssize_t evm_fs_write(int fd, const void *data, size_t len) {
+    evm_fs_file_t *file = file_get(fd);
+    if (!file) {
+        return -EBADF;
+    }
+
+    file_switch(file, LAST_WRITE);
+    size_t n = fwrite(data, 1, len, file->file);
+    if (n < len) {
+        clearerr(file->file);
+        if (n == 0) {
+            return -(errno ? errno : EIO);
+        }
+    }
+    return (ssize_t)n;
+}
+
+int evm_fs_flush(int fd, bool sync) {
+    evm_fs_file_t *file = file_get(fd);
+    if (!file) {
+        return -EBADF;
+    }
+
+    if (fflush(file->file) != 0) {
+        return -(errno ? errno : EIO);
+    }
+    if (sync && fsync(fileno(file->file)) != 0) {
+        return -(errno ? errno : EIO);
+    }
+    return 0;
+}
+
+int evm_fs_close(int fd) {
+    evm_fs_file_t *file = file_get(fd);
+    if (!file) {
+        return -EBADF;
+    }
+
+    // fclose بافر را خالی می‌کند؛ بافر setvbuf فقط بعد از آن آزاد می‌شود
+    int ret = fclose(file->file) == 0 ? 0 : -(errno ? errno : EIO);
+    free(file->buffer);
+    memset(file, 0, sizeof(*file));
+    return ret;
+}
+
+int evm_fs_close_all(void) {
+    int closed = 0;
+    for (int slot = 0; slot < EVM_FS_MAX_OPEN; slot++) {
+        if (files[slot].file) {
+            evm_fs_close(slot + FD_BASE);
+            closed++;
+        }
+    }
+    return closed;
+}
+
+int evm_fs_open_count(void) {
+    int count = 0;
+    for (int slot = 0; slot < EVM_FS_MAX_OPEN; slot++) {
+        if (files[slot].file) count++;
+    }
+    return count;
+}
+
+size_t evm_fs_buffer_bytes(void) {
+    size_t total = 0;
+    for (int slot = 0; slot < EVM_FS_MAX_OPEN; slot++) {
+        if (files[slot].file) total += files[slot].buffer_size;
+    }
+    return total;
+}
+
+size_t evm_fs_utf8_tail(const void *buf, size_t len) {
+    const unsigned char *s = buf;
+
+    // آخرین بایت آغازین (غیر از 10xxxxxx) در چهار بایت آخر
+    size_t i = len;
+    while (i > 0 && len - i < 4) {
+        unsigned char c = s[--i];
+        if ((c & 0xC0) == 0x80) {
+            continue;
+        }
+
+        size_t need;
+        if (c < 0x80) need = 1;
+        else if ((c & 0xE0) == 0xC0) need = 2;
+        else if ((c & 0xF0) == 0xE0) need = 3;
+        else if ((c & 0xF8) == 0xF0) need = 4;
+        else return 0; // بایت نامعتبر: همان‌طور تحویل بده
+
+        return len - i < need ? len - i : 0;
+    }
+    return 0;
+}
+
+static bool deliver_line(evm_fs_line_fn fn, void *ctx, const char *line, size_t len) {
+    if (len > 0 && line[len - 1] == '\r') len--;
+    return fn(ctx, line, len);
+}
+
+long evm_fs_read_lines(const char *path, size_t max_line, evm_fs_line_fn fn, void *ctx) {
+    if (!path || !fn) {
+        return -EINVAL;
+    }
+    if (max_line == 0) max_line = EVM_FS_MAX_LINE;
+    if (max_line < EVM_FS_MIN_BUFFER) max_line = EVM_FS_MIN_BUFFER;
+    if (max_line > EVM_FS_MAX_BUFFER) max_line = EVM_FS_MAX_BUFFER;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return -(errno ? errno : EIO);
+    }
+    // fread مستقیم در بافر خط می‌خواند؛ بافر دوم stdio لازم نیست
+    setvbuf(f, NULL, _IONBF, 0);
+
+    char *buf = malloc(max_line);
+    if (!buf) {
+        fclose(f);
+        return -ENOMEM;
+    }
+
+    long lines = 0;
+    size_t len = 0;
+    bool stop = false;
+
+    while (!stop) {
+        size_t n = fread(buf + len, 1, max_line - len, f);
+        if (n == 0) {
+            break;
+        }
+        len += n;
+
+        char *start = buf;
+        char *end = buf + len;
+        char *nl;
+        while (!stop && (nl = memchr(start, '\n', end - start))) {
+            lines++;
+            stop = !deliver_line(fn, ctx, start, nl - start);
+            start = nl + 1;
+        }
+
+        len = end - start;
+        if (!stop && len == max_line) {
+            // خط بلندتر از بافر: همین تکه تحویل می‌شود
+            lines++;
+            stop = !deliver_line(fn, ctx, buf, len);
+            len = 0;
+        } else if (start != buf) {
+            memmove(buf, start, len);
+        }
+    }
+
+    if (!stop && len > 0) {
+        // خط آخر بدون '\n'
+        lines++;
+        deliver_line(fn, ctx, buf, len);
+    }
+
+    long ret = ferror(f) ? -(errno ? errno : EIO) : lines;
+    free(buf);
+    fclose(f);
+    return ret;
+}
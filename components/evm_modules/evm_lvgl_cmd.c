@@ -0,0 +1,124 @@
+#include "evm_lvgl_cmd.h"
+#include <string.h>
+
+// قالب هر فرمان در بافر (هم‌تراز 4 بایت):
+//   op(1) argc(1) str_len(2) target(اشاره‌گر) args(4 * argc) str(str_len + 1)
+// هر فرمان پیوسته است؛ اگر تا انتهای بافر جا نباشد یک WRAP نوشته می‌شود
+// و فرمان از ابتدای بافر شروع می‌شود، تا str مستقیم به بافر اشاره کند.
+#define CMD_HEADER_SIZE (4 + sizeof(void *))
+#define CMD_ALIGN(n)    (((n) + 3) & ~(size_t)3)
+
+void evm_lvgl_cmdbuf_init(evm_lvgl_cmdbuf_t *cb, void *mem, size_t size) {
+    cb->buf = mem;
+    cb->size = size & ~(size_t)3;
+    cb->write = 0;
+    atomic_store(&cb->head, 0);
+    atomic_store(&cb->tail, 0);
+}
+
+size_t evm_lvgl_cmdbuf_encoded_size(const evm_lvgl_cmd_t *cmd) {
+    size_t n = CMD_HEADER_SIZE + (size_t)cmd->argc * sizeof(int32_t);
+    if (cmd->str_len) {
+        n += (size_t)cmd->str_len + 1;
+    }
+    return CMD_ALIGN(n);
+}
+
+// جای n بایت پیوسته؛ یک خانه همیشه خالی می‌ماند تا پر و خالی از هم جدا باشند
+static uint8_t *cmdbuf_reserve(evm_lvgl_cmdbuf_t *cb, size_t n) {
+    size_t tail = atomic_load_explicit(&cb->tail, memory_order_acquire);
+    size_t write = cb->write;
+
+    if (write >= tail) {
+        // فضای آزاد: [write, size) و [0, tail)
+        if (cb->size - write > n || (tail > 0 && cb->size - write == n)) {
+            return cb->buf + write;
+        }
+        if (tail > n) {
+            cb->buf[write] = EVM_LVGL_CMD_WRAP;
+            cb->write = 0;
+            return cb->buf;
+        }
+        return NULL;
+    }
+
+    // فضای آزاد: [write, tail)
+    if (tail - write > n) {
+        return cb->buf + write;
+    }
+    return NULL;
+}
+
+bool evm_lvgl_cmdbuf_push(evm_lvgl_cmdbuf_t *cb, const evm_lvgl_cmd_t *cmd) {
+    if (cmd->op == EVM_LVGL_CMD_WRAP || cmd->argc > EVM_LVGL_CMD_MAX_ARGS) {
+        return false;
+    }
+
+    size_t n = evm_lvgl_cmdbuf_encoded_size(cmd);
+    uint8_t *p = cmdbuf_reserve(cb, n);
+    if (!p) {
+        return false;
+    }
+
+    p[0] = cmd->op;
+    p[1] = cmd->argc;
+    memcpy(p + 2, &cmd->str_len, sizeof(uint16_t));
+    memcpy(p + 4, &cmd->target, sizeof(void *));
+
+    uint8_t *q = p + CMD_HEADER_SIZE;
+    if (cmd->argc) {
+        memcpy(q, cmd->args, (size_t)cmd->argc * sizeof(int32_t));
+        q += (size_t)cmd->argc * sizeof(int32_t);
+    }
+    if (cmd->str_len) {
+        memcpy(q, cmd->str, cmd->str_len);
+        q[cmd->str_len] = '\0';
+    }
+
+    cb->write = (size_t)(p - cb->buf) + n;
+    if (cb->write == cb->size) {
+        cb->write = 0;
+    }
+    return true;
+}
+
+void evm_lvgl_cmdbuf_commit(evm_lvgl_cmdbuf_t *cb) {
+    atomic_store_explicit(&cb->head, cb->write, memory_order_release);
+}
+
+size_t evm_lvgl_cmdbuf_apply(evm_lvgl_cmdbuf_t *cb, evm_lvgl_cmd_fn fn, void *ctx) {
+    size_t head = atomic_load_explicit(&cb->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&cb->tail, memory_order_relaxed);
+    size_t count = 0;
+
+    while (tail != head) {
+        const uint8_t *p = cb->buf + tail;
+        if (p[0] == EVM_LVGL_CMD_WRAP) {
+            tail = 0;
+            continue;
+        }
+
+        evm_lvgl_cmd_t cmd;
+        cmd.op = p[0];
+        cmd.argc = p[1];
+        memcpy(&cmd.str_len, p + 2, sizeof(uint16_t));
+        memcpy(&cmd.target, p + 4, sizeof(void *));
+
+        const uint8_t *q = p + CMD_HEADER_SIZE;
+        if (cmd.argc) {
+            memcpy(cmd.args, q, (size_t)cmd.argc * sizeof(int32_t));
+            q += (size_t)cmd.argc * sizeof(int32_t);
+        }
+        cmd.str = cmd.str_len ? (const char *)q : NULL;
+
+        fn(ctx, &cmd);
+        count++;
+
+        tail += evm_lvgl_cmdbuf_encoded_size(&cmd);
+        if (tail == cb->size) {
+            tail = 0;
+        }
+        atomic_store_explicit(&cb->tail, tail, memory_order_release);
+    }
+    return count;
+}
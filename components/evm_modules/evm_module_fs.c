@@ -1,7 +1,9 @@
 #include "evm_module_fs.h"
+#include "evm_fs_stream.h"
 #include "esp_log.h"
 #include "esp_vfs_fat.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <dirent.h>
@@ -73,26 +75,16 @@ static void js_fs_writeFileSync(js_State *J) {
         return;
     }
 
-    // کپی امن محتوا
+    // رشته MuJS تا پایان تابع معتبر است؛ کپی دوم لازم نیست
     size_t len = strlen(js_content);
-    char *content = malloc(len + 1);
-    if (!content) {
-        js_pushboolean(J, 0);
-        return;
-    }
-    strcpy(content, js_content);
-
-    // حالا بنویس!
     FILE *f = fopen(filename, "wb");
     if (!f) {
-        free(content);
         js_pushboolean(J, 0);
         return;
     }
 
-    size_t written = fwrite(content, 1, len, f);
+    size_t written = fwrite(js_content, 1, len, f);
     fclose(f);
-    free(content);
 
     js_pushboolean(J, written == len);
 }
@@ -148,7 +140,12 @@ static void js_fs_readFileSync(js_State *J) {
     
     content[bytes_read] = '\0';
     ESP_LOGI(TAG, "✅ Read SUCCESS: %zu bytes from %s", bytes_read, filename);
+    if (js_try(J)) {
+        free(content);
+        js_throw(J);
+    }
     js_pushstring(J, content);
+    js_endtry(J);
     free(content);
 }
 
@@ -326,6 +323,189 @@ static void js_fs_rmdir(js_State *J) {
     js_pushboolean(J, success ? 1 : 0);
 }
 
+// ==================== فایل‌های باز (stream) ====================
+
+// نوشتن فقط زیر /sdcard/ مجاز است (مثل writeFileSync)
+static bool is_write_flags(const char *flags) {
+    return flags[0] != 'r' || strchr(flags, '+') != NULL;
+}
+
+// fs.openSync(path, flags = "r", bufferSize = 4096) -> fd یا null
+static void js_fs_openSync(js_State *J) {
+    const char *path = js_tostring(J, 1);
+    const char *flags = js_isdefined(J, 2) ? js_tostring(J, 2) : "r";
+    int buffer_size = js_isdefined(J, 3) ? js_toint32(J, 3) : 0;
+
+    if (!hardware_is_sd_mounted()) {
+        js_pushnull(J);
+        return;
+    }
+    if (is_write_flags(flags) && strncmp(path, "/sdcard/", 8) != 0) {
+        ESP_LOGE(TAG, "❌ Write outside /sdcard/ not allowed: '%s'", path);
+        js_pushnull(J);
+        return;
+    }
+    if (is_write_flags(flags) && !ensure_parent_directory(path)) {
+        js_pushnull(J);
+        return;
+    }
+
+    int fd = evm_fs_open(path, flags, buffer_size > 0 ? (size_t)buffer_size : 0);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "❌ Cannot open '%s' (%s): %s", path, flags, strerror(-fd));
+        js_pushnull(J);
+        return;
+    }
+
+    ESP_LOGD(TAG, "📂 Opened '%s' (%s) as fd %d", path, flags, fd);
+    js_pushnumber(J, fd);
+}
+
+// fs.readSync(fd, length = 4096) -> رشته تا length بایت، یا null در انتهای فایل
+static void js_fs_readSync(js_State *J) {
+    int fd = js_toint32(J, 1);
+    int length = js_isdefined(J, 2) ? js_toint32(J, 2) : EVM_FS_DEFAULT_BUFFER;
+    if (length < 4) length = 4; // یک کاراکتر UTF-8 کامل
+    if (length > EVM_FS_MAX_BUFFER) length = EVM_FS_MAX_BUFFER;
+
+    char *buf = malloc(length);
+    if (!buf) {
+        js_pushnull(J);
+        return;
+    }
+
+    ssize_t n = evm_fs_read_text(fd, buf, length);
+    if (n < 0) {
+        ESP_LOGE(TAG, "❌ Read failed on fd %d: %s", fd, strerror(-n));
+    }
+    if (n <= 0) {
+        free(buf);
+        js_pushnull(J);
+        return;
+    }
+
+    // js_pushlstring در کمبود حافظه throw می‌کند؛ buf نباید نشت کند
+    if (js_try(J)) {
+        free(buf);
+        js_throw(J);
+    }
+    js_pushlstring(J, buf, n);
+    js_endtry(J);
+    free(buf);
+}
+
+// fs.writeSync(fd, data) -> تعداد بایت نوشته شده یا -1
+static void js_fs_writeSync(js_State *J) {
+    int fd = js_toint32(J, 1);
+    const char *data = js_tostring(J, 2);
+
+    ssize_t n = evm_fs_write(fd, data, strlen(data));
+    if (n < 0) {
+        ESP_LOGE(TAG, "❌ Write failed on fd %d: %s", fd, strerror(-n));
+        n = -1;
+    }
+    js_pushnumber(J, n);
+}
+
+// fs.fsyncSync(fd): بافر را خالی و روی کارت ثبت می‌کند
+static void js_fs_fsyncSync(js_State *J) {
+    js_pushboolean(J, evm_fs_flush(js_toint32(J, 1), true) == 0);
+}
+
+static void js_fs_closeSync(js_State *J) {
+    int fd = js_toint32(J, 1);
+    int ret = evm_fs_close(fd);
+    if (ret < 0) {
+        ESP_LOGE(TAG, "❌ Close failed on fd %d: %s", fd, strerror(-ret));
+    }
+    js_pushboolean(J, ret == 0);
+}
+
+// fs.appendFileSync(path, data): بدون خواندن یا بافر کردن کل فایل
+static void js_fs_appendFileSync(js_State *J) {
+    const char *path = js_tostring(J, 1);
+    const char *data = js_tostring(J, 2);
+
+    if (strncmp(path, "/sdcard/", 8) != 0 || !ensure_parent_directory(path)) {
+        js_pushboolean(J, 0);
+        return;
+    }
+
+    size_t len = strlen(data);
+    FILE *f = fopen(path, "ab");
+    if (!f) {
+        ESP_LOGE(TAG, "❌ Cannot append to '%s' (errno: %d - %s)", path, errno, strerror(errno));
+        js_pushboolean(J, 0);
+        return;
+    }
+
+    size_t written = fwrite(data, 1, len, f);
+    bool ok = fclose(f) == 0 && written == len;
+    js_pushboolean(J, ok);
+}
+
+typedef struct {
+    js_State *J;
+    long index;
+    bool failed;    // خطای callback روی پشته است
+} read_lines_ctx_t;
+
+static bool read_lines_cb(void *ctx, const char *line, size_t len) {
+    read_lines_ctx_t *rl = ctx;
+    js_State *J = rl->J;
+
+    js_copy(J, 2);
+    js_pushundefined(J);
+    js_pushlstring(J, line, len);
+    js_pushnumber(J, rl->index++);
+
+    // خطا نباید با longjmp از روی فایل باز بپرد؛ بعد از بستن دوباره پرتاب می‌شود
+    if (js_pcall(J, 2)) {
+        rl->failed = true;
+        return false;
+    }
+
+    bool stop = js_isboolean(J, -1) && !js_toboolean(J, -1);
+    js_pop(J, 1);
+    return !stop;
+}
+
+// fs.readLines(path, callback(line, index), maxLine = 4096) -> تعداد خط‌ها یا null.
+// اگر callback مقدار false برگرداند خواندن متوقف می‌شود.
+static void js_fs_readLines(js_State *J) {
+    const char *path = js_tostring(J, 1);
+    if (!js_iscallable(J, 2)) {
+        js_typeerror(J, "fs.readLines: callback is not a function");
+    }
+    int max_line = js_isdefined(J, 3) ? js_toint32(J, 3) : 0;
+
+    if (!hardware_is_sd_mounted()) {
+        js_pushnull(J);
+        return;
+    }
+
+    read_lines_ctx_t rl = { J, 0, false };
+    long lines = evm_fs_read_lines(path, max_line > 0 ? (size_t)max_line : 0, read_lines_cb, &rl);
+    if (rl.failed) {
+        js_throw(J);
+    }
+    if (lines < 0) {
+        ESP_LOGE(TAG, "❌ Cannot read lines from '%s': %s", path, strerror(-lines));
+        js_pushnull(J);
+        return;
+    }
+
+    js_pushnumber(J, lines);
+}
+
+// پایان برنامه: فایل‌هایی که JavaScript نبسته، بسته و flush می‌شوند
+void evm_fs_cleanup(void) {
+    int closed = evm_fs_close_all();
+    if (closed > 0) {
+        ESP_LOGW(TAG, "⚠️ Closed %d file(s) left open by the app", closed);
+    }
+}
+
 // 🔥 تابع جدید برای بررسی وضعیت دقیق
 static void js_fs_getStatus(js_State *J) {
     js_newobject(J);
@@ -404,6 +584,28 @@ esp_err_t evm_fs_register_js(js_State *J) {
     js_newcfunction(J, js_fs_rmdir, "rmdir", 1);
     js_setproperty(J, -2, "rmdir");
     
+    // فایل‌های باز: خواندن و نوشتن تکه به تکه
+    js_newcfunction(J, js_fs_openSync, "openSync", 3);
+    js_setproperty(J, -2, "openSync");
+
+    js_newcfunction(J, js_fs_readSync, "readSync", 2);
+    js_setproperty(J, -2, "readSync");
+
+    js_newcfunction(J, js_fs_writeSync, "writeSync", 2);
+    js_setproperty(J, -2, "writeSync");
+
+    js_newcfunction(J, js_fs_fsyncSync, "fsyncSync", 1);
+    js_setproperty(J, -2, "fsyncSync");
+
+    js_newcfunction(J, js_fs_closeSync, "closeSync", 1);
+    js_setproperty(J, -2, "closeSync");
+
+    js_newcfunction(J, js_fs_appendFileSync, "appendFileSync", 2);
+    js_setproperty(J, -2, "appendFileSync");
+
+    js_newcfunction(J, js_fs_readLines, "readLines", 3);
+    js_setproperty(J, -2, "readLines");
+
     // 🔥 توابع جدید برای دیباگ
     js_newcfunction(J, js_fs_getStatus, "getStatus", 0);
     js_setproperty(J, -2, "getStatus");
@@ -418,6 +620,6 @@ esp_err_t evm_fs_register_js(js_State *J) {
     
     js_setglobal(J, "fs");
     
-    ESP_LOGI(TAG, "✅ Filesystem module registered with %d functions", 11);
+    ESP_LOGI(TAG, "✅ Filesystem module registered with %d functions", 18);
     return ESP_OK;
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "esp_log.h"
 #include "driver/gpio.h"
 #include "shared_hardware.h"
+#include "evm_event_loop.h"
+#include <stdlib.h>
 
 static const char *TAG = "evm_gpio";
 
@@ -120,6 +122,131 @@ static void js_gpio_get_available_pins(js_State *J) {
     }
 }
 
+// ==================== وقفه‌های GPIO ====================
+// ISR فقط رویداد از پیش ساخته شده پین را به حلقه برنامه می‌فرستد و
+// callback جاوااسکریپت روی تسک حلقه اجرا می‌شود
+
+typedef struct {
+    evm_event_t event;          // باید اولین عضو باشد
+    int pin;
+    atomic_bool pending;        // رویداد در صف است و handler هنوز اجرا نشده
+    js_State *js_state;
+    const char *callback_ref;   // NULL یعنی unwatch شده و handler آن را آزاد می‌کند
+} gpio_watch_t;
+
+static gpio_watch_t *gpio_watches[GPIO_NUM_MAX];
+static bool gpio_isr_installed = false;
+
+static void gpio_watch_isr(void *arg) {
+    gpio_watch_t *watch = arg;
+    // تا اجرای handler یک رویداد کافی است؛ لبه‌های بعدی در آن جمع می‌شوند
+    if (!atomic_exchange(&watch->pending, true)) {
+        if (!evm_app_loop_post(&watch->event)) {
+            atomic_store(&watch->pending, false);
+        }
+    }
+}
+
+static void gpio_watch_event(evm_event_t *event) {
+    gpio_watch_t *watch = (gpio_watch_t *)event;
+    atomic_store(&watch->pending, false);
+
+    if (!watch->callback_ref) {
+        free(watch);
+        return;
+    }
+
+    js_State *J = watch->js_state;
+    js_getregistry(J, watch->callback_ref);
+    js_pushundefined(J); // this
+    js_pushnumber(J, gpio_get_level(watch->pin));
+    if (js_pcall(J, 1)) {
+        ESP_LOGE(TAG, "❌ GPIO %d callback error: %s", watch->pin, js_trystring(J, -1, "Error"));
+    }
+    js_pop(J, 1);
+}
+
+static void gpio_watch_remove(int pin) {
+    gpio_watch_t *watch = gpio_watches[pin];
+    if (!watch) {
+        return;
+    }
+    gpio_intr_disable(pin);
+    gpio_isr_handler_remove(pin);
+    gpio_watches[pin] = NULL;
+
+    js_unref(watch->js_state, watch->callback_ref);
+    watch->callback_ref = NULL;
+    // رویدادی که هنوز در صف است حافظه را نگه می‌دارد
+    if (!atomic_load(&watch->pending)) {
+        free(watch);
+    }
+}
+
+// gpio.watch(pin, callback): callback(level) در هر تغییر سطح پین
+static void js_gpio_watch(js_State *J) {
+    int pin = js_toint32(J, 1);
+
+    if (js_gettop(J) < 3 || !js_iscallable(J, 2)) {
+        js_error(J, "gpio.watch requires a pin and a callback function");
+        return;
+    }
+    if (!GPIO_IS_VALID_GPIO(pin) || !is_pin_allowed(pin)) {
+        js_pushboolean(J, 0);
+        return;
+    }
+
+    if (!gpio_isr_installed) {
+        esp_err_t err = gpio_install_isr_service(0);
+        // ESP_ERR_INVALID_STATE: سرویس را بخش دیگری نصب کرده است
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "❌ GPIO ISR service install failed: %s", esp_err_to_name(err));
+            js_pushboolean(J, 0);
+            return;
+        }
+        gpio_isr_installed = true;
+    }
+
+    gpio_watch_remove(pin);
+
+    js_copy(J, 2);
+    const char *callback_ref = js_ref(J);
+
+    gpio_watch_t *watch = malloc(sizeof(gpio_watch_t));
+    if (!watch) {
+        js_unref(J, callback_ref);
+        js_error(J, "Out of memory for GPIO watch");
+        return;
+    }
+    watch->event.handler = gpio_watch_event;
+    watch->pin = pin;
+    atomic_init(&watch->pending, false);
+    watch->js_state = J;
+    watch->callback_ref = callback_ref;
+    gpio_watches[pin] = watch;
+
+    gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+    gpio_isr_handler_add(pin, gpio_watch_isr, watch);
+    gpio_intr_enable(pin);
+
+    ESP_LOGI(TAG, "👀 Watching GPIO %d", pin);
+    js_pushboolean(J, 1);
+}
+
+static void js_gpio_unwatch(js_State *J) {
+    int pin = js_toint32(J, 1);
+    if (GPIO_IS_VALID_GPIO(pin)) {
+        gpio_watch_remove(pin);
+    }
+    js_pushundefined(J);
+}
+
+void evm_gpio_cleanup(void) {
+    for (int pin = 0; pin < GPIO_NUM_MAX; pin++) {
+        gpio_watch_remove(pin);
+    }
+}
+
 esp_err_t evm_gpio_init(void) {
     ESP_LOGI(TAG, "🔌 Initializing EVM GPIO Module");
     ESP_LOGI(TAG, "✅ EVM GPIO Module initialized");
@@ -150,6 +277,13 @@ esp_err_t evm_gpio_register_js(js_State *J) {
     js_newcfunction(J, js_gpio_get_available_pins, "getAvailablePins", 0);
     js_setproperty(J, -2, "getAvailablePins");
     
+    // وقفه تغییر سطح پین
+    js_newcfunction(J, js_gpio_watch, "watch", 2);
+    js_setproperty(J, -2, "watch");
+    
+    js_newcfunction(J, js_gpio_unwatch, "unwatch", 1);
+    js_setproperty(J, -2, "unwatch");
+    
     // اضافه کردن ثابت‌ها
     js_pushnumber(J, 0); // INPUT
     js_setproperty(J, -2, "INPUT");
@@ -11,8 +11,7 @@
 #include <sys/stat.h>        // برای stat, mkdir
 
 #include "lvgl.h"
-
-#include "lvgl.h"
+#include "evm_lvgl_cmd.h"
 
 #ifndef LV_ALIGN_DEFAULT
 #define LV_ALIGN_DEFAULT LV_ALIGN_TOP_LEFT
@@ -37,26 +36,27 @@ static lv_obj_t *app_screen = NULL;
 
 lv_obj_t *permanent_launcher_screen = NULL;
 
-// مدیریت اشیاء برنامه
-static lv_obj_t *app_objects[100];
-static int app_object_count = 0;
-
 // ==================== مدیریت حافظه پیشرفته ====================
 
-typedef struct {
-    lv_obj_t *obj;
-    char *type;
+// هر آبجکت LVGL که از JS دیده شده یک رکورد دارد که در user_data خود
+// آبجکت نگه‌داری می‌شود، پس پیدا کردن، ثبت و حذف آن O(1) است.
+// رکورد تا وقتی هم آبجکت LVGL حذف شده (LV_EVENT_DELETE) و هم همه
+// wrapperهای JS آن جمع‌آوری شده‌اند (finalizer) زنده می‌ماند.
+typedef struct lvgl_object {
+    lv_obj_t *obj;              // NULL بعد از حذف آبجکت LVGL
+    const char *type;
     size_t memory_usage;
-    bool managed;
-    void *user_data;
     uint32_t timestamp;
     const char *creator;
+    int js_refs;                // تعداد wrapperهای JS زنده
+    bool app_owned;             // در لیست اشیاء برنامه است
+    struct lvgl_object *prev;
+    struct lvgl_object *next;
 } lvgl_object_t;
 
 typedef struct {
-    lvgl_object_t **object_pool;
+    lvgl_object_t *head;        // اشیاء برنامه (لیست دوطرفه)
     size_t pool_size;
-    size_t pool_capacity;
     SemaphoreHandle_t mutex;
     size_t total_allocated;
     size_t peak_memory;
@@ -91,19 +91,11 @@ static esp_err_t lvgl_memory_init(bool thread_safe) {
     ESP_LOGI(TAG, "🔧 Initializing Advanced LVGL Memory Manager");
     
     memset(&memory_manager, 0, sizeof(memory_manager));
-    memory_manager.pool_capacity = 32;
-    memory_manager.object_pool = malloc(memory_manager.pool_capacity * sizeof(lvgl_object_t*));
-    
-    if (!memory_manager.object_pool) {
-        ESP_LOGE(TAG, "❌ Failed to allocate object pool");
-        return ESP_ERR_NO_MEM;
-    }
     
     memory_manager.thread_safe = thread_safe;
     if (thread_safe) {
         memory_manager.mutex = xSemaphoreCreateMutex();
         if (!memory_manager.mutex) {
-            free(memory_manager.object_pool);
             return ESP_FAIL;
         }
     }
@@ -112,93 +104,99 @@ static esp_err_t lvgl_memory_init(bool thread_safe) {
     return ESP_OK;
 }
 
-// ثبت آبجکت در سیستم مدیریت حافظه پیشرفته
-static bool lvgl_register_object_advanced(lv_obj_t *obj, const char *type, const char *creator) {
-    if (!obj || !type) return false;
-    
-    if (memory_manager.thread_safe) {
+static void lvgl_memory_lock(void) {
+    if (memory_manager.thread_safe && memory_manager.mutex) {
         xSemaphoreTake(memory_manager.mutex, portMAX_DELAY);
     }
+}
+
+static void lvgl_memory_unlock(void) {
+    if (memory_manager.thread_safe && memory_manager.mutex) {
+        xSemaphoreGive(memory_manager.mutex);
+    }
+}
+
+// حذف از لیست اشیاء برنامه
+static void lvgl_unlink_object(lvgl_object_t *record) {
+    if (!record->app_owned) return;
     
-    if (memory_manager.pool_size >= memory_manager.pool_capacity) {
-        size_t new_capacity = memory_manager.pool_capacity * 2;
-        lvgl_object_t **new_pool = realloc(memory_manager.object_pool, 
-                                         new_capacity * sizeof(lvgl_object_t*));
-        if (!new_pool) {
-            if (memory_manager.thread_safe) xSemaphoreGive(memory_manager.mutex);
-            return false;
-        }
-        memory_manager.object_pool = new_pool;
-        memory_manager.pool_capacity = new_capacity;
+    lvgl_memory_lock();
+    if (record->prev) {
+        record->prev->next = record->next;
+    } else {
+        memory_manager.head = record->next;
+    }
+    if (record->next) {
+        record->next->prev = record->prev;
+    }
+    record->prev = record->next = NULL;
+    record->app_owned = false;
+    memory_manager.pool_size--;
+    memory_manager.total_allocated -= record->memory_usage;
+    lvgl_memory_unlock();
+}
+
+// LV_EVENT_DELETE: آبجکت LVGL (مستقیم یا همراه والدش) حذف شد
+static void lvgl_object_delete_cb(lv_event_t *e) {
+    lvgl_object_t *record = lv_event_get_user_data(e);
+    
+    lvgl_unlink_object(record);
+    record->obj = NULL;
+    if (record->js_refs == 0) {
+        free(record);
+    }
+}
+
+// رکورد آبجکت را پیدا یا ایجاد می‌کند
+static lvgl_object_t *lvgl_object_get(lv_obj_t *obj, const char *type, const char *creator) {
+    lvgl_object_t *record = lv_obj_get_user_data(obj);
+    if (record) {
+        return record;
     }
     
-    lvgl_object_t *record = malloc(sizeof(lvgl_object_t));
+    record = calloc(1, sizeof(lvgl_object_t));
     if (!record) {
-        if (memory_manager.thread_safe) xSemaphoreGive(memory_manager.mutex);
-        return false;
+        return NULL;
     }
     
     record->obj = obj;
-    record->type = strdup(type);
+    record->type = type;
     record->memory_usage = estimate_memory_usage(type);
-    record->managed = true;
-    record->user_data = NULL;
     record->timestamp = esp_timer_get_time() / 1000;
-    record->creator = creator ? strdup(creator) : NULL;
+    record->creator = creator;
     
-    memory_manager.object_pool[memory_manager.pool_size++] = record;
-    memory_manager.total_allocated += record->memory_usage;
-    
-    if (memory_manager.total_allocated > memory_manager.peak_memory) {
-        memory_manager.peak_memory = memory_manager.total_allocated;
-    }
-    
-    if (memory_manager.thread_safe) {
-        xSemaphoreGive(memory_manager.mutex);
-    }
-    
-    ESP_LOGD(TAG, "📝 Advanced Registered %s (mem: %zu bytes, total: %zu)", 
-             type, record->memory_usage, memory_manager.pool_size);
-    return true;
+    lv_obj_set_user_data(obj, record);
+    lv_obj_add_event_cb(obj, lvgl_object_delete_cb, LV_EVENT_DELETE, record);
+    return record;
 }
 
-// حذف آبجکت از سیستم مدیریت حافظه پیشرفته
-static bool lvgl_unregister_object_advanced(lv_obj_t *obj) {
-    if (!obj || memory_manager.pool_size == 0) return false;
-    
-    if (memory_manager.thread_safe) {
-        xSemaphoreTake(memory_manager.mutex, portMAX_DELAY);
-    }
+// ثبت آبجکت در سیستم مدیریت حافظه پیشرفته
+static lvgl_object_t *lvgl_register_object_advanced(lv_obj_t *obj, const char *type, const char *creator) {
+    if (!obj || !type) return NULL;
     
-    bool found = false;
-    for (size_t i = 0; i < memory_manager.pool_size; i++) {
-        lvgl_object_t *record = memory_manager.object_pool[i];
-        if (record && record->obj == obj) {
-            memory_manager.total_allocated -= record->memory_usage;
-            free(record->type);
-            if (record->creator) free((char*)record->creator);
-            free(record);
-            memory_manager.object_pool[i] = NULL;
-            found = true;
-            break;
-        }
+    lvgl_object_t *record = lvgl_object_get(obj, type, creator);
+    if (!record || record->app_owned) {
+        return record;
     }
     
-    if (found) {
-        size_t new_index = 0;
-        for (size_t i = 0; i < memory_manager.pool_size; i++) {
-            if (memory_manager.object_pool[i]) {
-                memory_manager.object_pool[new_index++] = memory_manager.object_pool[i];
-            }
-        }
-        memory_manager.pool_size = new_index;
+    lvgl_memory_lock();
+    record->app_owned = true;
+    record->next = memory_manager.head;
+    if (memory_manager.head) {
+        memory_manager.head->prev = record;
     }
+    memory_manager.head = record;
+    memory_manager.pool_size++;
+    memory_manager.total_allocated += record->memory_usage;
     
-    if (memory_manager.thread_safe) {
-        xSemaphoreGive(memory_manager.mutex);
+    if (memory_manager.total_allocated > memory_manager.peak_memory) {
+        memory_manager.peak_memory = memory_manager.total_allocated;
     }
+    lvgl_memory_unlock();
     
-    return found;
+    ESP_LOGD(TAG, "📝 Advanced Registered %s (mem: %zu bytes, total: %zu)", 
+             type, record->memory_usage, memory_manager.pool_size);
+    return record;
 }
 
 // ==================== توابع جدید برای مدیریت صفحه مجزا ====================
@@ -241,98 +239,447 @@ void evm_lvgl_cleanup_app_screen(void) {
     }
 }
 
+// ==================== بافر فرمان به guiTask ====================
+
+// تغییرات ویجت‌ها از تسک برنامه مستقیم روی LVGL اجرا نمی‌شوند؛ به صورت
+// فرمان در cmd_buf نوشته می‌شوند و guiTask در هر دور، زیر xGuiSemaphore
+// و قبل از lv_task_handler، دسته‌های commit شده را اجرا می‌کند. commit در
+// پایان هر callback، قبل از delay و در پایان lvgl.batch(fn) انجام می‌شود.
+// کارهایی که جواب فوری لازم دارند (ساخت ویجت و ...) اول همه فرمان‌ها را
+// اجرا می‌کنند و سپس خودشان زیر قفل انجام می‌شوند.
+#define EVM_LVGL_CMD_BUF_SIZE (8 * 1024)
+
+enum {
+    LV_CMD_RELEASE = 1,         // wrapper جمع‌آوری شد (finalizer)
+    LV_CMD_OBJ_SET_SIZE,
+    LV_CMD_OBJ_SET_POS,
+    LV_CMD_OBJ_ALIGN,
+    LV_CMD_OBJ_DEL,
+    LV_CMD_LABEL_SET_TEXT,
+    LV_CMD_LABEL_SET_ALIGN,
+    LV_CMD_STYLE_BG_COLOR,
+    LV_CMD_STYLE_BG_OPA,
+    LV_CMD_STYLE_RADIUS,
+    LV_CMD_STYLE_BORDER_WIDTH,
+    LV_CMD_STYLE_BORDER_COLOR,
+    LV_CMD_STYLE_TEXT_COLOR,
+    LV_CMD_STYLE_TRANSFORM_ANGLE,
+    LV_CMD_STYLE_TRANSFORM_PIVOT_X,
+    LV_CMD_STYLE_TRANSFORM_PIVOT_Y,
+    LV_CMD_IMG_SET_SRC,
+    LV_CMD_IMG_SET_SRC_FILE,
+    LV_CMD_IMG_SET_ANGLE,
+    LV_CMD_IMG_SET_PIVOT,
+    LV_CMD_IMG_SET_ZOOM,
+    LV_CMD_IMG_SET_STYLE,
+    LV_CMD_BAR_SET_VALUE,
+    LV_CMD_BAR_SET_RANGE,
+    LV_CMD_SLIDER_SET_VALUE,
+    LV_CMD_SWITCH_SET_STATE,
+    LV_CMD_SCR_LOAD,
+};
+
+static evm_lvgl_cmdbuf_t cmd_buf;
+static SemaphoreHandle_t gui_mutex = NULL;
+static int batch_depth = 0;
+
+static lv_color_t cmd_color(int32_t value) {
+    lv_color_t color;
+    color.full = value;
+    return color;
+}
+
+static void lvgl_apply_img_style(lv_obj_t *img, const int32_t *a) {
+    lv_style_prop_t prop = a[0];
+    lv_style_selector_t selector = a[2];
+    
+    // در LVGL v8 از lv_obj_set_style استفاده می‌شود
+    switch (prop) {
+        case LV_STYLE_BG_COLOR:
+            lv_obj_set_style_bg_color(img, cmd_color(a[1]), selector);
+            break;
+        case LV_STYLE_BG_OPA:
+            lv_obj_set_style_bg_opa(img, (lv_opa_t)a[1], selector);
+            break;
+        case LV_STYLE_BORDER_COLOR:
+            lv_obj_set_style_border_color(img, cmd_color(a[1]), selector);
+            break;
+        case LV_STYLE_BORDER_WIDTH:
+            lv_obj_set_style_border_width(img, (lv_coord_t)a[1], selector);
+            break;
+        case LV_STYLE_RADIUS:
+            lv_obj_set_style_radius(img, (lv_coord_t)a[1], selector);
+            break;
+        case LV_STYLE_TEXT_COLOR:
+            lv_obj_set_style_text_color(img, cmd_color(a[1]), selector);
+            break;
+        default:
+            ESP_LOGW(TAG, "Unsupported style property: %d", prop);
+            break;
+    }
+}
+
+// اجرای یک فرمان؛ فقط زیر قفل GUI
+static void lvgl_apply_cmd(void *ctx, const evm_lvgl_cmd_t *cmd) {
+    lvgl_object_t *record = cmd->target;
+    const int32_t *a = cmd->args;
+    (void)ctx;
+    
+    if (cmd->op == LV_CMD_RELEASE) {
+        if (--record->js_refs == 0 && record->obj == NULL) {
+            free(record);
+        }
+        return;
+    }
+    
+    lv_obj_t *obj = record->obj;
+    if (!obj) {
+        return; // آبجکت قبلاً حذف شده
+    }
+    
+    switch (cmd->op) {
+        case LV_CMD_OBJ_SET_SIZE:
+            lv_obj_set_size(obj, a[0], a[1]);
+            break;
+        case LV_CMD_OBJ_SET_POS:
+            lv_obj_set_pos(obj, a[0], a[1]);
+            break;
+        case LV_CMD_OBJ_ALIGN:
+            lv_obj_align(obj, a[0], a[1], a[2]);
+            break;
+        case LV_CMD_OBJ_DEL:
+            // رکورد آبجکت در LV_EVENT_DELETE از لیست برنامه حذف می‌شود
+            lv_obj_del(obj);
+            break;
+        case LV_CMD_LABEL_SET_TEXT:
+            lv_label_set_text(obj, cmd->str ? cmd->str : "");
+            break;
+        case LV_CMD_LABEL_SET_ALIGN:
+            lv_obj_set_style_text_align(obj, a[0], 0);
+            break;
+        case LV_CMD_STYLE_BG_COLOR:
+            lv_obj_set_style_bg_color(obj, cmd_color(a[0]), a[1]);
+            break;
+        case LV_CMD_STYLE_BG_OPA:
+            lv_obj_set_style_bg_opa(obj, a[0], a[1]);
+            break;
+        case LV_CMD_STYLE_RADIUS:
+            lv_obj_set_style_radius(obj, a[0], a[1]);
+            break;
+        case LV_CMD_STYLE_BORDER_WIDTH:
+            lv_obj_set_style_border_width(obj, a[0], a[1]);
+            break;
+        case LV_CMD_STYLE_BORDER_COLOR:
+            lv_obj_set_style_border_color(obj, cmd_color(a[0]), a[1]);
+            break;
+        case LV_CMD_STYLE_TEXT_COLOR:
+            lv_obj_set_style_text_color(obj, cmd_color(a[0]), a[1]);
+            break;
+        case LV_CMD_STYLE_TRANSFORM_ANGLE:
+            lv_obj_set_style_transform_angle(obj, a[0], a[1]);
+            break;
+        case LV_CMD_STYLE_TRANSFORM_PIVOT_X:
+            lv_obj_set_style_transform_pivot_x(obj, a[0], a[1]);
+            break;
+        case LV_CMD_STYLE_TRANSFORM_PIVOT_Y:
+            lv_obj_set_style_transform_pivot_y(obj, a[0], a[1]);
+            break;
+        case LV_CMD_IMG_SET_SRC:
+            lv_img_set_src(obj, cmd->str);
+            break;
+        case LV_CMD_IMG_SET_SRC_FILE:
+            lv_img_set_src(obj, cmd->str);
+            if (lv_img_get_src(obj) == NULL) {
+                ESP_LOGW(TAG, "❌ Failed to set image source: %s", cmd->str);
+                lv_img_set_src(obj, "A:0,0,black_50x50");
+            }
+            break;
+        case LV_CMD_IMG_SET_ANGLE:
+            lv_img_set_angle(obj, a[0]);
+            break;
+        case LV_CMD_IMG_SET_PIVOT:
+            lv_img_set_pivot(obj, a[0], a[1]);
+            break;
+        case LV_CMD_IMG_SET_ZOOM:
+            lv_img_set_zoom(obj, a[0]);
+            break;
+        case LV_CMD_IMG_SET_STYLE:
+            lvgl_apply_img_style(obj, a);
+            break;
+        case LV_CMD_BAR_SET_VALUE:
+            lv_bar_set_value(obj, a[0], a[1]);
+            break;
+        case LV_CMD_BAR_SET_RANGE:
+            lv_bar_set_range(obj, a[0], a[1]);
+            break;
+        case LV_CMD_SLIDER_SET_VALUE:
+            lv_slider_set_value(obj, a[0], a[1]);
+            break;
+        case LV_CMD_SWITCH_SET_STATE:
+            if (a[0]) {
+                lv_obj_add_state(obj, LV_STATE_CHECKED);
+            } else {
+                lv_obj_clear_state(obj, LV_STATE_CHECKED);
+            }
+            break;
+        case LV_CMD_SCR_LOAD:
+            lv_scr_load(obj);
+            break;
+        default:
+            ESP_LOGW(TAG, "Unknown LVGL command: %d", cmd->op);
+            break;
+    }
+}
+
+static void gui_lock(void) {
+    if (gui_mutex) {
+        xSemaphoreTake(gui_mutex, portMAX_DELAY);
+    }
+}
+
+static void gui_unlock(void) {
+    if (gui_mutex) {
+        xSemaphoreGive(gui_mutex);
+    }
+}
+
+void evm_lvgl_set_gui_mutex(SemaphoreHandle_t mutex) {
+    gui_mutex = mutex;
+}
+
+void evm_lvgl_apply_pending(void) {
+    evm_lvgl_cmdbuf_apply(&cmd_buf, lvgl_apply_cmd, NULL);
+}
+
+void evm_lvgl_commit(void) {
+    if (batch_depth > 0) {
+        return;
+    }
+    evm_lvgl_cmdbuf_commit(&cmd_buf);
+    if (!gui_mutex) {
+        evm_lvgl_apply_pending(); // هنوز guiTask نیست
+    }
+}
+
+void evm_lvgl_flush(void) {
+    evm_lvgl_cmdbuf_commit(&cmd_buf);
+    gui_lock();
+    evm_lvgl_apply_pending();
+    gui_unlock();
+}
+
+// شروع کار همگام با LVGL از تسک برنامه: فرمان‌های قبلی (حتی وسط یک
+// batch) اجرا می‌شوند تا ترتیب حفظ شود، و قفل GUI گرفته می‌شود.
+// بین begin و end نباید حافظه MuJS گرفته شود چون finalizerها فرمان می‌نویسند.
+static void gui_sync_begin(void) {
+    evm_lvgl_cmdbuf_commit(&cmd_buf);
+    gui_lock();
+    evm_lvgl_apply_pending();
+}
+
+static void gui_sync_end(void) {
+    gui_unlock();
+}
+
+static void lvgl_cmd_push(evm_lvgl_cmd_t *cmd) {
+    if (!cmd->target) {
+        return;
+    }
+    if (evm_lvgl_cmdbuf_push(&cmd_buf, cmd)) {
+        return;
+    }
+    
+    // بافر پر است: دسته فعلی زودتر اجرا می‌شود
+    evm_lvgl_flush();
+    if (evm_lvgl_cmdbuf_push(&cmd_buf, cmd)) {
+        return;
+    }
+    
+    // بزرگ‌تر از کل بافر (متن خیلی طولانی): مستقیم زیر قفل
+    gui_lock();
+    lvgl_apply_cmd(NULL, cmd);
+    gui_unlock();
+}
+
+static void lvgl_cmd(uint8_t op, lvgl_object_t *target, int argc, int32_t a0, int32_t a1, int32_t a2) {
+    evm_lvgl_cmd_t cmd = {
+        .op = op,
+        .argc = (uint8_t)argc,
+        .target = target,
+        .args = { a0, a1, a2 },
+    };
+    lvgl_cmd_push(&cmd);
+}
+
+static void lvgl_cmd_str(uint8_t op, lvgl_object_t *target, const char *str) {
+    size_t len = str ? strlen(str) : 0;
+    if (len > UINT16_MAX) {
+        len = UINT16_MAX;
+    }
+    evm_lvgl_cmd_t cmd = {
+        .op = op,
+        .target = target,
+        .str_len = (uint16_t)len,
+        .str = str,
+    };
+    lvgl_cmd_push(&cmd);
+}
+
+// ==================== wrapper آبجکت‌ها برای JavaScript ====================
+
+// آبجکت‌های LVGL به صورت userdata با پروتوتایپ lv.Obj / lv.Label / lv.Img
+// به JS داده می‌شوند، نه به صورت عدد. پروتوتایپ‌ها در registry هستند.
+#define LV_OBJ_TAG      "lv_obj"
+#define LV_OBJ_PROTO    "lv.Obj"
+#define LV_LABEL_PROTO  "lv.Label"
+#define LV_IMG_PROTO    "lv.Img"
+
+// رکورد با js_refs تا guiTask فرمان RELEASE را اجرا کند زنده می‌ماند، پس
+// فرمان‌هایی که قبل از آن در صف هستند هنوز رکورد معتبر دارند
+static void js_lv_finalize(js_State *J, void *data) {
+    lvgl_cmd(LV_CMD_RELEASE, data, 0, 0, 0, 0);
+}
+
+// رکورد و یک ارجاع برای wrapper جدید؛ فقط زیر قفل GUI
+static lvgl_object_t *js_lv_ref(lv_obj_t *obj, const char *type, bool app_object) {
+    if (!obj) {
+        return NULL;
+    }
+    
+    lvgl_object_t *record = app_object ? lvgl_register_object_advanced(obj, type, "js")
+                                       : lvgl_object_get(obj, type, NULL);
+    if (record) {
+        record->js_refs++;
+    }
+    return record;
+}
+
+// ساخت wrapper (null برای NULL)؛ بعد از آزاد کردن قفل GUI.
+// اگر ساخت userdata (کمبود حافظه) خطا بدهد finalizer هرگز اجرا نمی‌شود،
+// پس ارجاع js_lv_ref همین‌جا پس داده می‌شود
+static void js_lv_wrap(js_State *J, lvgl_object_t *record, const char *proto) {
+    if (!record) {
+        js_pushnull(J);
+        return;
+    }
+    
+    if (js_try(J)) {
+        lvgl_cmd(LV_CMD_RELEASE, record, 0, 0, 0, 0);
+        js_throw(J);
+    }
+    js_getregistry(J, proto);
+    js_newuserdata(J, LV_OBJ_TAG, record, js_lv_finalize);
+    js_endtry(J);
+}
+
+static lvgl_object_t *js_lv_torecord(js_State *J, int idx) {
+    if (!js_isuserdata(J, idx, LV_OBJ_TAG)) {
+        return NULL;
+    }
+    return js_touserdata(J, idx, LV_OBJ_TAG);
+}
+
+// آبجکت LVGL یک wrapper؛ برای مقدار دیگر یا آبجکت حذف شده NULL.
+// obj فقط زیر قفل GUI خوانده شود
+static lv_obj_t *js_lv_toobj(js_State *J, int idx) {
+    lvgl_object_t *record = js_lv_torecord(J, idx);
+    return record ? record->obj : NULL;
+}
+
+// آبجکت هدف: this در فراخوانی متد (label.setText("hi")) یا آرگومان اول در
+// توابع lvgl.* (lvgl.label_set_text(label, "hi")). اندیس آرگومان بعدی در *arg
+static lvgl_object_t *js_lv_target(js_State *J, int *arg) {
+    if (js_isuserdata(J, 0, LV_OBJ_TAG)) {
+        *arg = 1;
+        return js_lv_torecord(J, 0);
+    }
+    *arg = 2;
+    return js_lv_torecord(J, 1);
+}
+
 // ==================== توابع پایه LVGL v8 ====================
 
 // تابع برای ایجاد آبجکت LVGL - نسخه v8
 static void js_lv_obj_create(js_State *J) {
-    lv_obj_t *parent = NULL;
-    
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        parent = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    } else {
+    gui_sync_begin();
+    lv_obj_t *parent = js_lv_toobj(J, 1);
+    if (!parent) {
         parent = evm_lvgl_create_app_screen();
     }
     
     lv_obj_t *obj = lv_obj_create(parent); // LVGL v8: فقط parent
-    evm_lvgl_register_app_object(obj);
-    js_pushnumber(J, (intptr_t)obj);
+    lvgl_object_t *record = js_lv_ref(obj, "object", true);
+    gui_sync_end();
+    
+    js_lv_wrap(J, record, LV_OBJ_PROTO);
 }
 
 // تابع برای تنظیم سایز
 static void js_lv_obj_set_size(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_size requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_coord_t width = js_toint32(J, 2);
-    lv_coord_t height = js_toint32(J, 3);
+    lv_coord_t width = js_toint32(J, arg);
+    lv_coord_t height = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_size(obj, width, height);
-    }
+    lvgl_cmd(LV_CMD_OBJ_SET_SIZE, obj, 2, width, height, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم موقعیت
 static void js_lv_obj_set_pos(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_pos requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_coord_t x = js_toint32(J, 2);
-    lv_coord_t y = js_toint32(J, 3);
+    lv_coord_t x = js_toint32(J, arg);
+    lv_coord_t y = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_pos(obj, x, y);
-    }
+    lvgl_cmd(LV_CMD_OBJ_SET_POS, obj, 2, x, y, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم تراز - نسخه v8
 static void js_lv_obj_align(js_State *J) {
-    if (js_gettop(J) < 4) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 3) {
         js_error(J, "lv_obj_align requires 4 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_align_t align = js_toint32(J, 2);
-    lv_coord_t x_ofs = js_toint32(J, 3);
-    lv_coord_t y_ofs = js_toint32(J, 4);
+    lv_align_t align = js_toint32(J, arg);
+    lv_coord_t x_ofs = js_toint32(J, arg + 1);
+    lv_coord_t y_ofs = js_toint32(J, arg + 2);
     
-    if (obj) {
-        lv_obj_align(obj, align, x_ofs, y_ofs);
-    }
+    lvgl_cmd(LV_CMD_OBJ_ALIGN, obj, 3, align, x_ofs, y_ofs);
     
     js_pushundefined(J);
 }
 
 // تابع برای حذف آبجکت
 static void js_lv_obj_del(js_State *J) {
-    if (js_gettop(J) < 1) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg) {
         js_error(J, "lv_obj_del requires 1 argument");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    
-    if (obj) {
-        for (int i = 0; i < app_object_count; i++) {
-            if (app_objects[i] == obj) {
-                app_objects[i] = NULL;
-                break;
-            }
-        }
-        
-        lvgl_unregister_object_advanced(obj);
-        lv_obj_del(obj);
-    }
+    lvgl_cmd(LV_CMD_OBJ_DEL, obj, 0, 0, 0, 0);
     
     js_pushundefined(J);
 }
@@ -341,173 +688,174 @@ static void js_lv_obj_del(js_State *J) {
 
 // تابع برای ایجاد لیبل - نسخه v8
 static void js_lv_label_create(js_State *J) {
-    lv_obj_t *parent = evm_lvgl_create_app_screen();
-    
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        parent = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
+    gui_sync_begin();
+    lv_obj_t *parent = js_lv_toobj(J, 1);
+    if (!parent) {
+        parent = evm_lvgl_create_app_screen();
     }
     
     lv_obj_t *label = lv_label_create(parent); // LVGL v8: فقط parent
-    evm_lvgl_register_app_object(label);
-    js_pushnumber(J, (intptr_t)label);
+    lvgl_object_t *record = js_lv_ref(label, "label", true);
+    gui_sync_end();
+    
+    js_lv_wrap(J, record, LV_LABEL_PROTO);
 }
 
 // تابع برای تنظیم متن
 static void js_lv_label_set_text(js_State *J) {
-    if (js_gettop(J) < 2) {
+    int arg;
+    lvgl_object_t *label = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 1) {
         js_error(J, "lv_label_set_text requires 2 arguments");
         return;
     }
     
-    lv_obj_t *label = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    const char *text = js_tostring(J, 2);
+    const char *text = js_tostring(J, arg);
     
-    if (label && text) {
-        lv_label_set_text(label, text);
-    }
+    lvgl_cmd_str(LV_CMD_LABEL_SET_TEXT, label, text);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم تراز متن - نسخه v8
 static void js_lv_label_set_align(js_State *J) {
-    if (js_gettop(J) < 2) {
+    int arg;
+    lvgl_object_t *label = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 1) {
         js_error(J, "lv_label_set_text_align requires 2 arguments");
         return;
     }
     
-    lv_obj_t *label = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_text_align_t align = js_toint32(J, 2);
+    lv_text_align_t align = js_toint32(J, arg);
     
-    if (label) {
-        lv_obj_set_style_text_align(label, align, 0);
-    }
+    lvgl_cmd(LV_CMD_LABEL_SET_ALIGN, label, 1, align, 0, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای ایجاد دکمه - نسخه v8
 static void js_lv_btn_create(js_State *J) {
-    lv_obj_t *parent = evm_lvgl_create_app_screen();
-    
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        parent = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
+    gui_sync_begin();
+    lv_obj_t *parent = js_lv_toobj(J, 1);
+    if (!parent) {
+        parent = evm_lvgl_create_app_screen();
     }
     
     lv_obj_t *btn = lv_btn_create(parent); // LVGL v8: فقط parent
-    evm_lvgl_register_app_object(btn);
-    js_pushnumber(J, (intptr_t)btn);
+    lvgl_object_t *record = js_lv_ref(btn, "button", true);
+    gui_sync_end();
+    
+    js_lv_wrap(J, record, LV_OBJ_PROTO);
 }
 
 // ==================== مدیریت استایل LVGL v8 ====================
 
 // تابع برای تنظیم رنگ پس‌زمینه - نسخه v8
 static void js_lv_obj_set_style_bg_color(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_style_bg_color requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_color_t color;
-    color.full = js_toint32(J, 2);
-    lv_style_selector_t selector = js_toint32(J, 3);
+    int32_t color = js_toint32(J, arg);
+    lv_style_selector_t selector = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_style_bg_color(obj, color, selector);
-    }
+    lvgl_cmd(LV_CMD_STYLE_BG_COLOR, obj, 2, color, selector, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم شفافیت پس‌زمینه - نسخه v8
 static void js_lv_obj_set_style_bg_opa(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_style_bg_opa requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_opa_t opa = js_toint32(J, 2);
-    lv_style_selector_t selector = js_toint32(J, 3);
+    lv_opa_t opa = js_toint32(J, arg);
+    lv_style_selector_t selector = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_style_bg_opa(obj, opa, selector);
-    }
+    lvgl_cmd(LV_CMD_STYLE_BG_OPA, obj, 2, opa, selector, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم شعاع گوشه - نسخه v8
 static void js_lv_obj_set_style_radius(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_style_radius requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_coord_t radius = js_toint32(J, 2);
-    lv_style_selector_t selector = js_toint32(J, 3);
+    lv_coord_t radius = js_toint32(J, arg);
+    lv_style_selector_t selector = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_style_radius(obj, radius, selector);
-    }
+    lvgl_cmd(LV_CMD_STYLE_RADIUS, obj, 2, radius, selector, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم عرض حاشیه - نسخه v8
 static void js_lv_obj_set_style_border_width(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_style_border_width requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_coord_t width = js_toint32(J, 2);
-    lv_style_selector_t selector = js_toint32(J, 3);
+    lv_coord_t width = js_toint32(J, arg);
+    lv_style_selector_t selector = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_style_border_width(obj, width, selector);
-    }
+    lvgl_cmd(LV_CMD_STYLE_BORDER_WIDTH, obj, 2, width, selector, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم رنگ حاشیه - نسخه v8
 static void js_lv_obj_set_style_border_color(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_style_border_color requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_color_t color;
-    color.full = js_toint32(J, 2);
-    lv_style_selector_t selector = js_toint32(J, 3);
+    int32_t color = js_toint32(J, arg);
+    lv_style_selector_t selector = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_style_border_color(obj, color, selector);
-    }
+    lvgl_cmd(LV_CMD_STYLE_BORDER_COLOR, obj, 2, color, selector, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم رنگ متن - نسخه v8
 static void js_lv_obj_set_style_text_color(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_style_text_color requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_color_t color;
-    color.full = js_toint32(J, 2);
-    lv_style_selector_t selector = js_toint32(J, 3);
+    int32_t color = js_toint32(J, arg);
+    lv_style_selector_t selector = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_style_text_color(obj, color, selector);
-    }
+    lvgl_cmd(LV_CMD_STYLE_TEXT_COLOR, obj, 2, color, selector, 0);
     
     js_pushundefined(J);
 }
@@ -516,79 +864,83 @@ static void js_lv_obj_set_style_text_color(js_State *J) {
 
 // تابع برای ایجاد تصویر - نسخه v8
 static void js_lv_img_create(js_State *J) {
-    lv_obj_t *parent = lv_scr_act();
-    
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        parent = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
+    gui_sync_begin();
+    lv_obj_t *parent = js_lv_toobj(J, 1);
+    if (!parent) {
+        parent = lv_scr_act();
     }
     
     lv_obj_t *img = lv_img_create(parent);
-    evm_lvgl_register_app_object(img);
-    js_pushnumber(J, (intptr_t)img);
+    lvgl_object_t *record = js_lv_ref(img, "img", true);
+    gui_sync_end();
+    
+    js_lv_wrap(J, record, LV_IMG_PROTO);
 }
 
 // تابع برای تنظیم منبع تصویر
 static void js_lv_img_set_src(js_State *J) {
-    if (js_gettop(J) < 2) {
+    int arg;
+    lvgl_object_t *img = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 1) {
         js_error(J, "lv_img_set_src requires 2 arguments");
         return;
     }
     
-    lv_obj_t *img = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    const char *src = js_tostring(J, 2);
+    const char *src = js_tostring(J, arg);
     
-    if (img && src) {
-        lv_img_set_src(img, src);
-    }
+    lvgl_cmd_str(LV_CMD_IMG_SET_SRC, img, src);
     
     js_pushundefined(J);
 }
 
 // تابع برای ایجاد بار پیشرفت - نسخه v8
 static void js_lv_bar_create(js_State *J) {
-    lv_obj_t *parent = lv_scr_act();
-    
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        parent = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
+    gui_sync_begin();
+    lv_obj_t *parent = js_lv_toobj(J, 1);
+    if (!parent) {
+        parent = lv_scr_act();
     }
     
     lv_obj_t *bar = lv_bar_create(parent);
-    evm_lvgl_register_app_object(bar);
-    js_pushnumber(J, (intptr_t)bar);
+    lvgl_object_t *record = js_lv_ref(bar, "bar", true);
+    gui_sync_end();
+    
+    js_lv_wrap(J, record, LV_OBJ_PROTO);
 }
 
 // تابع برای تنظیم مقدار بار
 static void js_lv_bar_set_value(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *bar = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_bar_set_value requires 3 arguments");
         return;
     }
     
-    lv_obj_t *bar = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    int32_t value = js_toint32(J, 2);
-    lv_anim_enable_t anim = js_toint32(J, 3);
+    int32_t value = js_toint32(J, arg);
+    lv_anim_enable_t anim = js_toint32(J, arg + 1);
     
-    if (bar) {
-        lv_bar_set_value(bar, value, anim);
-    }
+    lvgl_cmd(LV_CMD_BAR_SET_VALUE, bar, 2, value, anim, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم محدوده بار
 static void js_lv_bar_set_range(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *bar = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_bar_set_range requires 3 arguments");
         return;
     }
     
-    lv_obj_t *bar = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    int32_t min = js_toint32(J, 2);
-    int32_t max = js_toint32(J, 3);
+    int32_t min = js_toint32(J, arg);
+    int32_t max = js_toint32(J, arg + 1);
     
-    if (bar) {
-        lv_bar_set_range(bar, min, max);
-    }
+    lvgl_cmd(LV_CMD_BAR_SET_RANGE, bar, 2, min, max, 0);
     
     js_pushundefined(J);
 }
@@ -638,73 +990,76 @@ static void js_lv_disp_get_ver_res(js_State *J) {
 
 // تابع برای گرفتن صفحه اصلی
 static void js_lv_scr_act(js_State *J) {
-    lv_obj_t *screen = lv_scr_act();
-    js_pushnumber(J, (intptr_t)screen);
+    gui_sync_begin();
+    lvgl_object_t *record = js_lv_ref(lv_scr_act(), "object", false);
+    gui_sync_end();
+    
+    js_lv_wrap(J, record, LV_OBJ_PROTO);
 }
 
 // ==================== توابع جدید LVGL v8 ====================
 
 // تابع برای ایجاد سوئیچ - ویجت جدید در v8
 static void js_lv_switch_create(js_State *J) {
-    lv_obj_t *parent = evm_lvgl_create_app_screen();
-    
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        parent = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
+    gui_sync_begin();
+    lv_obj_t *parent = js_lv_toobj(J, 1);
+    if (!parent) {
+        parent = evm_lvgl_create_app_screen();
     }
     
     lv_obj_t *sw = lv_switch_create(parent);
-    evm_lvgl_register_app_object(sw);
-    js_pushnumber(J, (intptr_t)sw);
+    lvgl_object_t *record = js_lv_ref(sw, "switch", true);
+    gui_sync_end();
+    
+    js_lv_wrap(J, record, LV_OBJ_PROTO);
 }
 
 // تابع برای تنظیم وضعیت سوئیچ
 static void js_lv_switch_set_state(js_State *J) {
-    if (js_gettop(J) < 2) {
+    int arg;
+    lvgl_object_t *sw = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 1) {
         js_error(J, "lv_switch_set_state requires 2 arguments");
         return;
     }
     
-    lv_obj_t *sw = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    bool state = js_toboolean(J, 2);
+    bool state = js_toboolean(J, arg);
     
-    if (sw) {
-        if (state) {
-            lv_obj_add_state(sw, LV_STATE_CHECKED);
-        } else {
-            lv_obj_clear_state(sw, LV_STATE_CHECKED);
-        }
-    }
+    lvgl_cmd(LV_CMD_SWITCH_SET_STATE, sw, 1, state, 0, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای ایجاد اسلایدر - ویجت جدید در v8
 static void js_lv_slider_create(js_State *J) {
-    lv_obj_t *parent = evm_lvgl_create_app_screen();
-    
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        parent = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
+    gui_sync_begin();
+    lv_obj_t *parent = js_lv_toobj(J, 1);
+    if (!parent) {
+        parent = evm_lvgl_create_app_screen();
     }
     
     lv_obj_t *slider = lv_slider_create(parent);
-    evm_lvgl_register_app_object(slider);
-    js_pushnumber(J, (intptr_t)slider);
+    lvgl_object_t *record = js_lv_ref(slider, "slider", true);
+    gui_sync_end();
+    
+    js_lv_wrap(J, record, LV_OBJ_PROTO);
 }
 
 // تابع برای تنظیم مقدار اسلایدر
 static void js_lv_slider_set_value(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *slider = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_slider_set_value requires 3 arguments");
         return;
     }
     
-    lv_obj_t *slider = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    int32_t value = js_toint32(J, 2);
-    lv_anim_enable_t anim = js_toint32(J, 3);
+    int32_t value = js_toint32(J, arg);
+    lv_anim_enable_t anim = js_toint32(J, arg + 1);
     
-    if (slider) {
-        lv_slider_set_value(slider, value, anim);
-    }
+    lvgl_cmd(LV_CMD_SLIDER_SET_VALUE, slider, 2, value, anim, 0);
     
     js_pushundefined(J);
 }
@@ -712,20 +1067,13 @@ static void js_lv_slider_set_value(js_State *J) {
 // ==================== توابع مدیریت حافظه ====================
 
 void evm_lvgl_register_app_object(void* obj) {
-    lv_obj_t *lv_obj = (lv_obj_t*)obj;
-    
-    if (app_object_count < 100 && lv_obj != NULL) {
-        app_objects[app_object_count++] = lv_obj;
-        ESP_LOGD(TAG, "📝 Registered LVGL object %p (total: %d)", lv_obj, app_object_count);
-    }
-    
-    lvgl_register_object_advanced(lv_obj, "object", "evm_lvgl_register_app_object");
+    lvgl_register_object_advanced((lv_obj_t*)obj, "object", "evm_lvgl_register_app_object");
 }
 
 void evm_lvgl_cleanup_app_objects(void) {
-    ESP_LOGI(TAG, "🧹 Cleaning up %d LVGL app objects", app_object_count);
+    ESP_LOGI(TAG, "🧹 Cleaning up %zu LVGL app objects", memory_manager.pool_size);
     
-    if (app_object_count == 0) {
+    if (memory_manager.pool_size == 0) {
         ESP_LOGI(TAG, "✅ No objects to clean up");
         return;
     }
@@ -733,24 +1081,15 @@ void evm_lvgl_cleanup_app_objects(void) {
     ESP_LOGI(TAG, "🔄 Using SCREEN cleanup method");
     evm_lvgl_cleanup_app_screen();
     
-    for (int i = 0; i < app_object_count; i++) {
-        app_objects[i] = NULL;
-    }
-    app_object_count = 0;
-    
-    if (memory_manager.object_pool) {
-        for (size_t i = 0; i < memory_manager.pool_size; i++) {
-            if (memory_manager.object_pool[i]) {
-                free(memory_manager.object_pool[i]->type);
-                if (memory_manager.object_pool[i]->creator) {
-                    free((char*)memory_manager.object_pool[i]->creator);
-                }
-                free(memory_manager.object_pool[i]);
-                memory_manager.object_pool[i] = NULL;
-            }
+    // اشیایی که روی صفحه دیگری ساخته شده‌اند؛ هر حذف (همراه فرزندانش)
+    // رکوردها را از طریق LV_EVENT_DELETE از لیست برمی‌دارد
+    while (memory_manager.head) {
+        lv_obj_t *obj = memory_manager.head->obj;
+        if (obj) {
+            lv_obj_del(obj);
+        } else {
+            lvgl_unlink_object(memory_manager.head);
         }
-        memory_manager.pool_size = 0;
-        memory_manager.total_allocated = 0;
     }
     
     ESP_LOGI(TAG, "✅ LVGL cleanup completed using screen method");
@@ -760,10 +1099,19 @@ void evm_lvgl_cleanup_app_objects(void) {
 
 esp_err_t evm_lvgl_init(void) {
     ESP_LOGI(TAG, "🔧 Initializing LVGL Module");
-    app_object_count = 0;
-    memset(app_objects, 0, sizeof(app_objects));
-    
     lvgl_memory_init(true);
+    
+    if (!cmd_buf.buf) {
+        void *mem = heap_caps_malloc(EVM_LVGL_CMD_BUF_SIZE, MALLOC_CAP_SPIRAM);
+        if (!mem) {
+            mem = malloc(EVM_LVGL_CMD_BUF_SIZE);
+        }
+        if (!mem) {
+            ESP_LOGE(TAG, "❌ Failed to allocate LVGL command buffer");
+            return ESP_ERR_NO_MEM;
+        }
+        evm_lvgl_cmdbuf_init(&cmd_buf, mem, EVM_LVGL_CMD_BUF_SIZE);
+    }
     return ESP_OK;
 }
 
@@ -771,12 +1119,37 @@ esp_err_t evm_lvgl_init(void) {
 
 // تابع برای گرفتن تعداد اشیاء ثبت شده
 static void js_lvgl_get_object_count(js_State *J) {
-    js_pushnumber(J, app_object_count);
+    gui_sync_begin();
+    size_t count = memory_manager.pool_size;
+    gui_sync_end();
+    
+    js_pushnumber(J, count);
+}
+
+// lvgl.batch(fn): همه تغییرات داخل fn با هم در یک فریم دیده می‌شوند
+static void js_lvgl_batch(js_State *J) {
+    if (!js_iscallable(J, 1)) {
+        js_error(J, "lvgl.batch requires a function");
+        return;
+    }
+    
+    batch_depth++;
+    js_copy(J, 1);
+    js_pushundefined(J);
+    int failed = js_pcall(J, 0);
+    batch_depth--;
+    
+    evm_lvgl_commit();
+    if (failed) {
+        js_throw(J);
+    }
 }
 
 // تابع cleanup برای JavaScript
 static void js_cleanup_app(js_State *J) {
+    gui_sync_begin();
     evm_lvgl_cleanup_app_objects();
+    gui_sync_end();
     js_pushundefined(J);
 }
 
@@ -788,40 +1161,70 @@ static void js_cleanup_app(js_State *J) {
 // تابع برای تنظیم زاویه تصویر (برای عقربه‌ها)
 // تابع تنظیم زاویه تصویر - استفاده از API اصلی LVGL
 static void js_lv_img_set_angle(js_State *J) {
-    if (js_gettop(J) < 2) {
+    int arg;
+    lvgl_object_t *img = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 1) {
         js_error(J, "lv_img_set_angle requires 2 arguments");
         return;
     }
     
-    lv_obj_t *img = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    int16_t angle = js_toint32(J, 2);
+    int16_t angle = js_toint32(J, arg);
     
-    if (img) {
-        // استفاده از تابع اصلی LVGL که در کد C شما کار می‌کند
-        lv_img_set_angle(img, angle);
-        ESP_LOGD(TAG, "🔄 Set image angle to %d", angle);
-    }
+    lvgl_cmd(LV_CMD_IMG_SET_ANGLE, img, 1, angle, 0, 0);
+    ESP_LOGD(TAG, "🔄 Set image angle to %d", angle);
     
     js_pushundefined(J);
 }
 
 
+// آمار کش تصویر LVGL (برای بررسی decode دوباره PNG عقربه‌ها)
+static void js_lv_img_cache_stats(js_State *J) {
+    lv_img_cache_stats_t stats;
+    gui_sync_begin();
+    lv_img_cache_get_stats(&stats);
+    gui_sync_end();
+
+    js_newobject(J);
+    js_pushnumber(J, stats.hits);
+    js_setproperty(J, -2, "hits");
+    js_pushnumber(J, stats.misses);
+    js_setproperty(J, -2, "misses");
+    js_pushnumber(J, stats.evictions);
+    js_setproperty(J, -2, "evictions");
+    js_pushnumber(J, stats.entries);
+    js_setproperty(J, -2, "entries");
+    js_pushnumber(J, stats.mem_used);
+    js_setproperty(J, -2, "memUsed");
+    js_pushnumber(J, stats.mem_max);
+    js_setproperty(J, -2, "memMax");
+}
+
+// تنظیم بودجه حافظه کش تصویر (بایت)
+static void js_lv_img_cache_set_mem_size(js_State *J) {
+    size_t size = js_touint32(J, 1);
+    
+    gui_sync_begin();
+    lv_img_cache_set_mem_size(size);
+    gui_sync_end();
+    js_pushundefined(J);
+}
+
 // تابع تنظیم pivot - استفاده از API اصلی LVGL
 static void js_lv_img_set_pivot(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *img = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_img_set_pivot requires 3 arguments");
         return;
     }
     
-    lv_obj_t *img = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_coord_t x = js_toint32(J, 2);
-    lv_coord_t y = js_toint32(J, 3);
+    lv_coord_t x = js_toint32(J, arg);
+    lv_coord_t y = js_toint32(J, arg + 1);
     
-    if (img) {
-        // استفاده از تابع اصلی LVGL
-        lv_img_set_pivot(img, x, y);
-        ESP_LOGD(TAG, "🎯 Set image pivot to (%d, %d)", x, y);
-    }
+    lvgl_cmd(LV_CMD_IMG_SET_PIVOT, img, 2, x, y, 0);
+    ESP_LOGD(TAG, "🎯 Set image pivot to (%d, %d)", x, y);
     
     js_pushundefined(J);
 }
@@ -830,19 +1233,18 @@ static void js_lv_img_set_pivot(js_State *J) {
 // تابع برای تنظیم بزرگنمایی تصویر
 // تابع تنظیم zoom - استفاده از API اصلی LVGL
 static void js_lv_img_set_zoom(js_State *J) {
-    if (js_gettop(J) < 2) {
+    int arg;
+    lvgl_object_t *img = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 1) {
         js_error(J, "lv_img_set_zoom requires 2 arguments");
         return;
     }
     
-    lv_obj_t *img = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    uint16_t zoom = js_toint32(J, 2);
+    uint16_t zoom = js_toint32(J, arg);
     
-    if (img) {
-        // استفاده از تابع اصلی LVGL
-        lv_img_set_zoom(img, zoom);
-        ESP_LOGD(TAG, "🔍 Set image zoom to %d", zoom);
-    }
+    lvgl_cmd(LV_CMD_IMG_SET_ZOOM, img, 1, zoom, 0, 0);
+    ESP_LOGD(TAG, "🔍 Set image zoom to %d", zoom);
     
     js_pushundefined(J);
 }
@@ -850,43 +1252,19 @@ static void js_lv_img_set_zoom(js_State *J) {
 
 // تابع برای تنظیم استایل تصویر
 static void js_lv_img_set_style(js_State *J) {
-    if (js_gettop(J) < 4) {
+    int arg;
+    lvgl_object_t *img = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 3) {
         js_error(J, "lv_img_set_style requires 4 arguments");
         return;
     }
     
-    lv_obj_t *img = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_style_prop_t prop = js_toint32(J, 2);
-    lv_style_value_t value;
-    value.num = js_toint32(J, 3);
-    lv_style_selector_t selector = js_toint32(J, 4);
+    int32_t prop = js_toint32(J, arg);
+    int32_t value = js_toint32(J, arg + 1);
+    int32_t selector = js_toint32(J, arg + 2);
     
-    if (img) {
-        // در LVGL v8 از lv_obj_set_style استفاده می‌شود
-        switch (prop) {
-            case LV_STYLE_BG_COLOR:
-                lv_obj_set_style_bg_color(img, *((lv_color_t*)&value.num), selector);
-                break;
-            case LV_STYLE_BG_OPA:
-                lv_obj_set_style_bg_opa(img, (lv_opa_t)value.num, selector);
-                break;
-            case LV_STYLE_BORDER_COLOR:
-                lv_obj_set_style_border_color(img, *((lv_color_t*)&value.num), selector);
-                break;
-            case LV_STYLE_BORDER_WIDTH:
-                lv_obj_set_style_border_width(img, (lv_coord_t)value.num, selector);
-                break;
-            case LV_STYLE_RADIUS:
-                lv_obj_set_style_radius(img, (lv_coord_t)value.num, selector);
-                break;
-            case LV_STYLE_TEXT_COLOR:
-                lv_obj_set_style_text_color(img, *((lv_color_t*)&value.num), selector);
-                break;
-            default:
-                ESP_LOGW(TAG, "Unsupported style property: %d", prop);
-                break;
-        }
-    }
+    lvgl_cmd(LV_CMD_IMG_SET_STYLE, img, 3, prop, value, selector);
     
     js_pushundefined(J);
 }
@@ -944,19 +1322,20 @@ static void js_file_exists(js_State *J) {
 
 // تابع برای بارگذاری تصویر از فایل
 static void js_img_create_from_file(js_State *J) {
-    lv_obj_t *parent = lv_scr_act();
     const char *path = NULL;
     
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        parent = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    }
-    
     if (js_gettop(J) > 1 && js_isstring(J, 2)) {
         path = js_tostring(J, 2);
     }
     
+    gui_sync_begin();
+    lv_obj_t *parent = js_lv_toobj(J, 1);
+    if (!parent) {
+        parent = lv_scr_act();
+    }
+    
     lv_obj_t *img = lv_img_create(parent);
-    evm_lvgl_register_app_object(img);
+    lvgl_object_t *record = js_lv_ref(img, "img", true);
     
     if (path && strlen(path) > 0) {
         ESP_LOGI(TAG, "📁 Loading image: %s", path);
@@ -969,50 +1348,29 @@ static void js_img_create_from_file(js_State *J) {
             ESP_LOGI(TAG, "✅ Image loaded successfully");
         }
     }
+    gui_sync_end();
     
-    js_pushnumber(J, (intptr_t)img);
+    js_lv_wrap(J, record, LV_IMG_PROTO);
 }
 
 // تابع بارگذاری تصویر از فایل - نسخه ایمن
 static void js_lv_img_create_from_file(js_State *J) {
-    lv_obj_t *parent = lv_scr_act();
     const char *path = NULL;
-    
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        parent = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    }
+    bool readable = false;
     
     if (js_gettop(J) > 1 && js_isstring(J, 2)) {
         path = js_tostring(J, 2);
     }
     
-    lv_obj_t *img = lv_img_create(parent);
-    if (!img) {
-        ESP_LOGE(TAG, "❌ Failed to create image object");
-        js_pushnumber(J, 0);
-        return;
-    }
-    
-    evm_lvgl_register_app_object(img);
-    
+    // بررسی وجود فایل قبل از گرفتن قفل GUI
     if (path && strlen(path) > 0) {
         ESP_LOGI(TAG, "🖼️ Loading image from: %s", path);
         
-        // بررسی وجود فایل
         FILE *test_file = fopen(path, "r");
         if (test_file) {
             fclose(test_file);
+            readable = true;
             ESP_LOGI(TAG, "✅ File verified, setting source...");
-            
-            // بارگذاری تصویر
-            lv_img_set_src(img, path);
-            
-            // بررسی موفقیت
-            if (lv_img_get_src(img) == NULL) {
-                ESP_LOGE(TAG, "❌ lv_img_set_src failed for: %s", path);
-            } else {
-                ESP_LOGI(TAG, "✅ Image source set successfully");
-            }
         } else {
             ESP_LOGE(TAG, "❌ Cannot open file: %s", path);
         }
@@ -1020,7 +1378,32 @@ static void js_lv_img_create_from_file(js_State *J) {
         ESP_LOGW(TAG, "⚠️ No path provided, creating empty image");
     }
     
-    js_pushnumber(J, (intptr_t)img);
+    gui_sync_begin();
+    lv_obj_t *parent = js_lv_toobj(J, 1);
+    if (!parent) {
+        parent = lv_scr_act();
+    }
+    
+    lv_obj_t *img = lv_img_create(parent);
+    lvgl_object_t *record = js_lv_ref(img, "img", true);
+    
+    if (img && readable) {
+        // بارگذاری تصویر
+        lv_img_set_src(img, path);
+        
+        // بررسی موفقیت
+        if (lv_img_get_src(img) == NULL) {
+            ESP_LOGE(TAG, "❌ lv_img_set_src failed for: %s", path);
+        } else {
+            ESP_LOGI(TAG, "✅ Image source set successfully");
+        }
+    }
+    gui_sync_end();
+    
+    if (!img) {
+        ESP_LOGE(TAG, "❌ Failed to create image object");
+    }
+    js_lv_wrap(J, record, LV_IMG_PROTO);
 }
 
 // تابع جدید: لیست فایل‌های یک دایرکتوری
@@ -1069,27 +1452,20 @@ static void js_list_files(js_State *J) {
 
 // تابع برای بارگذاری تصویر از مسیر فایل - نسخه اصلاح شده
 static void js_lv_img_set_src_file(js_State *J) {
-    if (js_gettop(J) < 2) {
+    int arg;
+    lvgl_object_t *img = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 1) {
         js_error(J, "lv_img_set_src_file requires 2 arguments");
         return;
     }
     
-    lv_obj_t *img = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    const char *path = js_tostring(J, 2);
+    const char *path = js_tostring(J, arg);
     
-    if (img && path) {
+    if (img) {
         ESP_LOGI(TAG, "📁 Setting image source: %s", path);
-        
-        // استفاده مستقیم از lv_img_set_src
-        lv_img_set_src(img, path);
-        
-        // بررسی موفقیت
-        if (lv_img_get_src(img) == NULL) {
-            ESP_LOGW(TAG, "❌ Failed to set image source: %s", path);
-            lv_img_set_src(img, "A:0,0,black_50x50");
-        } else {
-            ESP_LOGI(TAG, "✅ Image source set successfully");
-        }
+        // اگر تصویر باز نشود guiTask منبع پیش‌فرض را می‌گذارد
+        lvgl_cmd_str(LV_CMD_IMG_SET_SRC_FILE, img, path);
     }
     
     js_pushundefined(J);
@@ -1097,19 +1473,19 @@ static void js_lv_img_set_src_file(js_State *J) {
 
 // تابع برای تنظیم pivot پیش‌فرض برای عقربه‌های ساعت
 static void js_lv_img_set_hand_pivot(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *img = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_img_set_hand_pivot requires 3 arguments");
         return;
     }
     
-    lv_obj_t *img = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_coord_t x = js_toint32(J, 2);
-    lv_coord_t y = js_toint32(J, 3);
+    lv_coord_t x = js_toint32(J, arg);
+    lv_coord_t y = js_toint32(J, arg + 1);
     
-    if (img) {
-        lv_img_set_pivot(img, x, y);
-        ESP_LOGD(TAG, "🎯 Set pivot to (%d, %d)", x, y);
-    }
+    lvgl_cmd(LV_CMD_IMG_SET_PIVOT, img, 2, x, y, 0);
+    ESP_LOGD(TAG, "🎯 Set pivot to (%d, %d)", x, y);
     
     js_pushundefined(J);
 }
@@ -1120,83 +1496,79 @@ static void js_lv_img_set_hand_pivot(js_State *J) {
 
 // تابع برای تنظیم زاویه transform
 static void js_lv_obj_set_style_transform_angle(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_style_transform_angle requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    int32_t angle = js_toint32(J, 2);
-    lv_style_selector_t selector = js_toint32(J, 3);
+    int32_t angle = js_toint32(J, arg);
+    lv_style_selector_t selector = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_style_transform_angle(obj, angle, selector);
-    }
+    lvgl_cmd(LV_CMD_STYLE_TRANSFORM_ANGLE, obj, 2, angle, selector, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم pivot X
 static void js_lv_obj_set_style_transform_pivot_x(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_style_transform_pivot_x requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_coord_t pivot_x = js_toint32(J, 2);
-    lv_style_selector_t selector = js_toint32(J, 3);
+    lv_coord_t pivot_x = js_toint32(J, arg);
+    lv_style_selector_t selector = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_style_transform_pivot_x(obj, pivot_x, selector);
-    }
+    lvgl_cmd(LV_CMD_STYLE_TRANSFORM_PIVOT_X, obj, 2, pivot_x, selector, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای تنظیم pivot Y
 static void js_lv_obj_set_style_transform_pivot_y(js_State *J) {
-    if (js_gettop(J) < 3) {
+    int arg;
+    lvgl_object_t *obj = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg + 2) {
         js_error(J, "lv_obj_set_style_transform_pivot_y requires 3 arguments");
         return;
     }
     
-    lv_obj_t *obj = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    lv_coord_t pivot_y = js_toint32(J, 2);
-    lv_style_selector_t selector = js_toint32(J, 3);
+    lv_coord_t pivot_y = js_toint32(J, arg);
+    lv_style_selector_t selector = js_toint32(J, arg + 1);
     
-    if (obj) {
-        lv_obj_set_style_transform_pivot_y(obj, pivot_y, selector);
-    }
+    lvgl_cmd(LV_CMD_STYLE_TRANSFORM_PIVOT_Y, obj, 2, pivot_y, selector, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای بارگذاری صفحه
 static void js_lv_scr_load(js_State *J) {
-    if (js_gettop(J) < 1) {
+    int arg;
+    lvgl_object_t *screen = js_lv_target(J, &arg);
+    
+    if (js_gettop(J) < arg) {
         js_error(J, "lv_scr_load requires 1 argument");
         return;
     }
     
-    lv_obj_t *screen = (lv_obj_t*)(intptr_t)js_tonumber(J, 1);
-    
-    if (screen) {
-        lv_scr_load(screen);
-    }
+    lvgl_cmd(LV_CMD_SCR_LOAD, screen, 0, 0, 0, 0);
     
     js_pushundefined(J);
 }
 
 // تابع برای رندر فوری
 static void js_lv_refr_now(js_State *J) {
-    lv_disp_t *disp = NULL;
-    
-    if (js_gettop(J) > 0 && js_isnumber(J, 1)) {
-        disp = (lv_disp_t*)(intptr_t)js_tonumber(J, 1);
-    }
-    
-    lv_refr_now(disp);
+    // فقط نمایشگر پیش‌فرض؛ اشاره‌گر از JS پذیرفته نمی‌شود
+    gui_sync_begin();
+    lv_refr_now(NULL);
+    gui_sync_end();
     js_pushundefined(J);
 }
 
@@ -1214,10 +1586,80 @@ static void js_lv_tick_inc(js_State *J) {
 
 // تابع برای مدیریت task
 static void js_lv_task_handler(js_State *J) {
+    gui_sync_begin();
     lv_task_handler();
+    gui_sync_end();
     js_pushundefined(J);
 }
 
+// تابع برای بررسی زنده بودن آبجکت (false بعد از حذف یا پاکسازی برنامه)
+static void js_lv_obj_is_valid(js_State *J) {
+    int arg;
+    lvgl_object_t *record = js_lv_target(J, &arg);
+    
+    gui_sync_begin();
+    bool valid = record && record->obj;
+    gui_sync_end();
+    
+    js_pushboolean(J, valid);
+}
+
+static void js_lv_define_method(js_State *J, js_CFunction fn, const char *name, int length) {
+    js_newcfunction(J, fn, name, length);
+    js_defproperty(J, -2, name, JS_DONTENUM);
+}
+
+// کلاس‌های lv.Obj، lv.Label و lv.Img؛ متدها همان توابع lvgl.* هستند که
+// آبجکت را از this می‌گیرند: new lv.Label(parent).setText("hi")
+static void js_lv_register_classes(js_State *J) {
+    js_newobject(J);
+    
+    // lv.Obj
+    js_newobject(J);
+    js_lv_define_method(J, js_lv_obj_set_size, "setSize", 2);
+    js_lv_define_method(J, js_lv_obj_set_pos, "setPos", 2);
+    js_lv_define_method(J, js_lv_obj_align, "align", 3);
+    js_lv_define_method(J, js_lv_obj_del, "del", 0);
+    js_lv_define_method(J, js_lv_obj_is_valid, "isValid", 0);
+    js_lv_define_method(J, js_lv_obj_set_style_bg_color, "setStyleBgColor", 2);
+    js_lv_define_method(J, js_lv_obj_set_style_bg_opa, "setStyleBgOpa", 2);
+    js_lv_define_method(J, js_lv_obj_set_style_radius, "setStyleRadius", 2);
+    js_lv_define_method(J, js_lv_obj_set_style_border_width, "setStyleBorderWidth", 2);
+    js_lv_define_method(J, js_lv_obj_set_style_border_color, "setStyleBorderColor", 2);
+    js_lv_define_method(J, js_lv_obj_set_style_text_color, "setStyleTextColor", 2);
+    js_lv_define_method(J, js_lv_obj_set_style_transform_angle, "setStyleTransformAngle", 2);
+    js_lv_define_method(J, js_lv_obj_set_style_transform_pivot_x, "setStyleTransformPivotX", 2);
+    js_lv_define_method(J, js_lv_obj_set_style_transform_pivot_y, "setStyleTransformPivotY", 2);
+    js_copy(J, -1);
+    js_setregistry(J, LV_OBJ_PROTO);
+    js_newcconstructor(J, js_lv_obj_create, js_lv_obj_create, "Obj", 1);
+    js_setproperty(J, -2, "Obj");
+    
+    // lv.Label
+    js_getregistry(J, LV_OBJ_PROTO);
+    js_newobjectx(J);
+    js_lv_define_method(J, js_lv_label_set_text, "setText", 1);
+    js_lv_define_method(J, js_lv_label_set_align, "setTextAlign", 1);
+    js_copy(J, -1);
+    js_setregistry(J, LV_LABEL_PROTO);
+    js_newcconstructor(J, js_lv_label_create, js_lv_label_create, "Label", 1);
+    js_setproperty(J, -2, "Label");
+    
+    // lv.Img
+    js_getregistry(J, LV_OBJ_PROTO);
+    js_newobjectx(J);
+    js_lv_define_method(J, js_lv_img_set_src_file, "setSrc", 1);
+    js_lv_define_method(J, js_lv_img_set_angle, "setAngle", 1);
+    js_lv_define_method(J, js_lv_img_set_pivot, "setPivot", 2);
+    js_lv_define_method(J, js_lv_img_set_zoom, "setZoom", 1);
+    js_copy(J, -1);
+    js_setregistry(J, LV_IMG_PROTO);
+    js_newcconstructor(J, js_lv_img_create, js_lv_img_create, "Img", 1);
+    js_setproperty(J, -2, "Img");
+    
+    js_setglobal(J, "lv");
+}
+
 // ==================== تابع اصلی ثبت ماژول LVGL v8 ====================
 
 esp_err_t evm_lvgl_register_js_mujs(js_State *J) {
@@ -1228,6 +1670,8 @@ esp_err_t evm_lvgl_register_js_mujs(js_State *J) {
     
     ESP_LOGI(TAG, "📦 Registering LVGL v8 module in MuJS");
     
+    js_lv_register_classes(J);
+    
     // ایجاد object lvgl
     js_newobject(J);
     
@@ -1330,6 +1774,12 @@ esp_err_t evm_lvgl_register_js_mujs(js_State *J) {
     
     js_newcfunction(J, js_lvgl_get_object_count, "get_object_count", 0);
     js_setproperty(J, -2, "get_object_count");
+
+    js_newcfunction(J, js_lv_img_cache_stats, "img_cache_stats", 0);
+    js_setproperty(J, -2, "img_cache_stats");
+
+    js_newcfunction(J, js_lv_img_cache_set_mem_size, "img_cache_set_mem_size", 1);
+    js_setproperty(J, -2, "img_cache_set_mem_size");
     
     // 📋 گروه ۷: ثابت‌های LVGL v8 (به‌روزشده)
     
@@ -1616,6 +2066,9 @@ js_setproperty(J, -2, "tick_inc");
 js_newcfunction(J, js_lv_task_handler, "task_handler", 0);
 js_setproperty(J, -2, "task_handler");
 
+js_newcfunction(J, js_lvgl_batch, "batch", 1);
+js_setproperty(J, -2, "batch");
+
     // تنظیم به عنوان global
     js_setglobal(J, "lvgl");
     
@@ -1626,11 +2079,6 @@ js_setproperty(J, -2, "task_handler");
 void evm_lvgl_cleanup(void) {
     evm_lvgl_cleanup_app_objects();
     
-    if (memory_manager.object_pool) {
-        free(memory_manager.object_pool);
-        memory_manager.object_pool = NULL;
-    }
-    
     if (memory_manager.mutex) {
         vSemaphoreDelete(memory_manager.mutex);
         memory_manager.mutex = NULL;
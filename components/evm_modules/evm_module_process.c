@@ -6,6 +6,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
+#include <stdlib.h>
 #include "sdkconfig.h"
 
 static const char *TAG = "evm_process";
@@ -189,6 +190,89 @@ static void js_process_heapStats(js_State *J) {
     js_setproperty(J, -2, "minEverFree");
 }
 
+// تابع برای process.gcStats() - آمار GC و زمان مکث‌ها (میلی‌ثانیه)
+static void js_process_gcStats(js_State *J) {
+    js_GCStats stats;
+    js_getgcstats(J, &stats);
+
+    js_newobject(J);
+
+    js_pushnumber(J, stats.cycles);
+    js_setproperty(J, -2, "cycles");
+
+    js_pushnumber(J, stats.steps);
+    js_setproperty(J, -2, "steps");
+
+    js_pushnumber(J, stats.lastpause);
+    js_setproperty(J, -2, "lastPause");
+
+    js_pushnumber(J, stats.maxpause);
+    js_setproperty(J, -2, "maxPause");
+
+    js_pushnumber(J, stats.totalpause);
+    js_setproperty(J, -2, "totalPause");
+}
+
+// بافر متنی برای خروجی پروفایلر
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+} profile_text_t;
+
+#define PROFILE_DEFAULT_INTERVAL 1000   // دستور بین دو نمونه
+#define PROFILE_DEFAULT_SAMPLES  256    // ظرفیت حلقه نمونه‌ها
+
+static void profile_text_write(void *data, const void *buf, int size) {
+    profile_text_t *t = data;
+    if (t->len + size > t->cap) {
+        size_t cap = (t->len + size) * 2;
+        char *p = realloc(t->buf, cap);
+        if (!p) {
+            return;
+        }
+        t->buf = p;
+        t->cap = cap;
+    }
+    memcpy(t->buf + t->len, buf, size);
+    t->len += size;
+}
+
+// تابع برای process.profile() - پروفایلر نمونه‌برداری MuJS
+//   process.profile(interval, samples) شروع؛ هر interval دستور یک نمونه از پشته
+//   process.profile() توقف و برگرداندن پشته‌ها به فرمت folded (برای flamegraph.pl)
+//   process.profile("counts") تعداد دستورهای اجرا شده هر تابع
+static void js_process_profile(js_State *J) {
+    profile_text_t text = {0};
+
+    if (js_isnumber(J, 1)) {
+        int interval = js_tointeger(J, 1);
+        int samples = js_isdefined(J, 2) ? js_tointeger(J, 2) : PROFILE_DEFAULT_SAMPLES;
+        if (interval <= 0) {
+            interval = PROFILE_DEFAULT_INTERVAL;
+        }
+        js_profilestart(J, interval, samples);
+        ESP_LOGI(TAG, "📊 Profiling every %d instructions (%d samples)", interval, samples);
+        js_pushundefined(J);
+        return;
+    }
+
+    if (js_isstring(J, 1) && strcmp(js_tostring(J, 1), "counts") == 0) {
+        js_profiledump(J, JS_PROFILECOUNTS, profile_text_write, &text);
+    } else {
+        js_profilestop(J);
+        js_profiledump(J, JS_PROFILEFOLDED, profile_text_write, &text);
+    }
+
+    if (js_try(J)) {
+        free(text.buf);
+        js_throw(J);
+    }
+    js_pushlstring(J, text.buf ? text.buf : "", (int)text.len);
+    js_endtry(J);
+    free(text.buf);
+}
+
 // تابع برای process.restart() - راه‌اندازی مجدد
 static void js_process_restart(js_State *J) {
     ESP_LOGI(TAG, "🔄 System restart requested");
@@ -298,7 +382,13 @@ esp_err_t evm_process_register_js(js_State *J) {
     
     js_newcfunction(J, js_process_heapStats, "heapStats", 0);
     js_setproperty(J, -2, "heapStats");
+
+    js_newcfunction(J, js_process_gcStats, "gcStats", 0);
+    js_setproperty(J, -2, "gcStats");
     
+    js_newcfunction(J, js_process_profile, "profile", 2);
+    js_setproperty(J, -2, "profile");
+
     js_newcfunction(J, js_process_restart, "restart", 0);
     js_setproperty(J, -2, "restart");
     
@@ -3,47 +3,68 @@
 #include "mujs.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/timers.h"
+#include "evm_event_loop.h"
+#include "evm_module_lvgl.h"
+#include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 
 static const char *TAG = "evm_timer";
 
-// ساختار برای مدیریت تایمرها
+// تایمرهای JavaScript روی حلقه رویداد تسک APP CPU اجرا می‌شوند
+static evm_event_loop_t *timer_loop = NULL;
+
+// داده هر تایمر: تابع callback در registry
 typedef struct {
-    TimerHandle_t timer_handle;
     js_State *js_state;
+    const char *callback_ref;
     bool is_interval;
-    int callback_ref;
-    char *name;
 } timer_context_t;
 
-static timer_context_t *active_timers[10] = {0};
-static int timer_count = 0;
+static void timer_context_free(void *data) {
+    timer_context_t *context = data;
+    js_unref(context->js_state, context->callback_ref);
+    free(context);
+}
 
-// تابع callback برای تایمرها
-static void timer_callback(TimerHandle_t xTimer) {
-    timer_context_t *context = (timer_context_t *)pvTimerGetTimerID(xTimer);
-    
-    if (context && context->js_state && context->callback_ref != 0) {
-        ESP_LOGD(TAG, "Timer callback: %s", context->name);
-        
-        // فراخوانی تابع JavaScript
-        js_getregistry(context->js_state, context->callback_ref);
-        if (js_iscallable(context->js_state, -1)) {
-            js_call(context->js_state, 0);
-        }
-        js_pop(context->js_state, 1);
-        
-        // اگر interval نیست، تایمر را حذف کن
-        if (!context->is_interval) {
-            for (int i = 0; i < timer_count; i++) {
-                if (active_timers[i] == context) {
-                    active_timers[i] = NULL;
-                    break;
-                }
-            }
-            free(context->name);
-            free(context);
+// اجرای callback روی تسک حلقه (run-to-completion)
+static void timer_callback(void *data, uint32_t id) {
+    timer_context_t *context = data;
+    js_State *J = context->js_state;
+    bool is_interval = context->is_interval;
+
+    ESP_LOGD(TAG, "Timer callback: %"PRIu32, id);
+
+    // تایمر یک‌باره قبل از اجرا از حلقه حذف شده است
+    js_getregistry(J, context->callback_ref);
+    if (!is_interval) {
+        timer_context_free(context);
+    }
+
+    js_pushundefined(J); // this
+    if (js_pcall(J, 0)) {
+        ESP_LOGE(TAG, "❌ Timer callback error: %s", js_trystring(J, -1, "Error"));
+    }
+    js_pop(J, 1);
+}
+
+void evm_timer_set_event_loop(evm_event_loop_t *loop) {
+    timer_loop = loop;
+}
+
+void evm_timer_delay(int ms) {
+    evm_lvgl_commit(); // تغییرات قبل از delay نمایش داده شوند
+    if (!timer_loop) {
+        vTaskDelay(pdMS_TO_TICKS(ms));
+        return;
+    }
+
+    // تایمرها و رویدادها در طول delay روی همین تسک اجرا می‌شوند
+    evm_time_t deadline = esp_timer_get_time() / 1000 + ms;
+    evm_time_t remaining;
+    while ((remaining = deadline - esp_timer_get_time() / 1000) > 0) {
+        if (evm_event_loop_run_once(timer_loop, remaining) > 0) {
+            evm_lvgl_commit();
         }
     }
 }
@@ -53,7 +74,7 @@ static void js_timer_delay(js_State *J) {
     int ms = js_toint32(J, 1);
     if (ms < 1 || ms > 30000) ms = 100;  // محدود کردن به 30 ثانیه
    // ESP_LOGI(TAG, "Timer.delay(%d ms)", ms);
-    vTaskDelay(pdMS_TO_TICKS(ms));
+    evm_timer_delay(ms);
     js_pushundefined(J);
 }
 
@@ -63,81 +84,50 @@ static void js_timer_gettime(js_State *J) {
     js_pushnumber(J, time_us / 1000);
 }
 
-// تابع setTimeout
-static void js_timer_settimeout(js_State *J) {
-    if (js_gettop(J) < 2 || !js_iscallable(J, 1)) {
-        js_error(J, "setTimeout requires a callback function and delay");
+// ایجاد تایمر روی حلقه رویداد
+static void timer_create(js_State *J, const char *name, int delay_ms, bool is_interval) {
+    if (!timer_loop) {
+        js_error(J, "%s: event loop is not running", name);
         return;
     }
-    
-    int delay_ms = js_toint32(J, 2);
-    if (delay_ms < 1 || delay_ms > 30000) delay_ms = 1000;
-    
-    // پیدا کردن جای خالی در آرایه تایمرها
-    int index = -1;
-    for (int i = 0; i < 10; i++) {
-        if (active_timers[i] == NULL) {
-            index = i;
-            break;
-        }
-    }
-    
-    if (index == -1) {
-        js_error(J, "Maximum timers reached");
-        return;
-    }
-    
-    // ایجاد context جدید
+
     timer_context_t *context = malloc(sizeof(timer_context_t));
     if (!context) {
         js_error(J, "Out of memory for timer");
         return;
     }
-    
-    // 🔥 مقداردهی اولیه همه فیلدها
-    memset(context, 0, sizeof(timer_context_t));
+
     context->js_state = J;
-    context->is_interval = false;
-    context->name = strdup("setTimeout");
-    context->callback_ref = 0;
-    context->timer_handle = NULL;
-    
+    context->is_interval = is_interval;
+
     // ذخیره callback در registry
-    js_copy(J, 1); // کپی کردن تابع callback
+    js_copy(J, 1);
     context->callback_ref = js_ref(J);
-    
-    // ایجاد تایمر FreeRTOS
-    context->timer_handle = xTimerCreate(
-        "js_timeout",
-        pdMS_TO_TICKS(delay_ms),
-        pdFALSE,  // one-shot
-        (void *)context,
-        timer_callback
-    );
-    
-    if (context->timer_handle == NULL) {
-        free(context->name);
-        free(context);
-        js_error(J, "Failed to create timer");
+
+    uint32_t id = evm_event_loop_add_timer(timer_loop, delay_ms, is_interval ? delay_ms : 0,
+                                           timer_callback, context);
+    if (id == 0) {
+        timer_context_free(context);
+        js_error(J, "Out of memory for timer");
         return;
     }
-    
-    // شروع تایمر
-    if (xTimerStart(context->timer_handle, 0) != pdPASS) {
-        xTimerDelete(context->timer_handle, 0);
-        free(context->name);
-        free(context);
-        js_error(J, "Failed to start timer");
+
+    js_pushnumber(J, id);  // بازگرداندن ID تایمر
+    ESP_LOGD(TAG, "%s created: %d ms, ID: %"PRIu32, name, delay_ms, id);
+}
+
+// تابع setTimeout
+static void js_timer_settimeout(js_State *J) {
+    if (js_gettop(J) < 2 || !js_iscallable(J, 1)) {
+        js_error(J, "setTimeout requires a callback function and delay");
         return;
     }
-    
-    active_timers[index] = context;
-    timer_count++;
-    
-    js_pushnumber(J, index);  // بازگرداندن ID تایمر
-    ESP_LOGI(TAG, "setTimeout created: %d ms, ID: %d", delay_ms, index);
-}
 
+    int delay_ms = js_toint32(J, 2);
+    if (delay_ms < 0) delay_ms = 0;
+
+    timer_create(J, "setTimeout", delay_ms, false);
+}
 
 // تابع setInterval
 static void js_timer_setinterval(js_State *J) {
@@ -145,120 +135,39 @@ static void js_timer_setinterval(js_State *J) {
         js_error(J, "setInterval requires a callback function and interval");
         return;
     }
-    
+
     int interval_ms = js_toint32(J, 2);
-    if (interval_ms < 10 || interval_ms > 30000) interval_ms = 1000;
-    
-    // پیدا کردن جای خالی
-    int index = -1;
-    for (int i = 0; i < 10; i++) {
-        if (active_timers[i] == NULL) {
-            index = i;
-            break;
-        }
-    }
-    
-    if (index == -1) {
-        js_error(J, "Maximum timers reached");
-        return;
-    }
-    
-    // ایجاد context جدید
-    timer_context_t *context = malloc(sizeof(timer_context_t));
-    if (!context) {
-        js_error(J, "Out of memory for timer");
-        return;
-    }
-    
-    context->js_state = J;
-    context->is_interval = true;
-    context->name = strdup("setInterval");
-    
-    // ذخیره callback در registry
-    context->callback_ref = js_ref(J);
-    
-    // ایجاد تایمر FreeRTOS
-    context->timer_handle = xTimerCreate(
-        "js_interval",
-        pdMS_TO_TICKS(interval_ms),
-        pdTRUE,  // auto-reload
-        (void *)context,
-        timer_callback
-    );
-    
-    if (context->timer_handle == NULL) {
-        free(context->name);
-        free(context);
-        js_error(J, "Failed to create timer");
-        return;
-    }
-    
-    // شروع تایمر
-    if (xTimerStart(context->timer_handle, 0) != pdPASS) {
-        free(context->name);
-        free(context);
-        js_error(J, "Failed to start timer");
-        return;
-    }
-    
-    active_timers[index] = context;
-    timer_count++;
-    
-    js_pushnumber(J, index);  // بازگرداندن ID تایمر
-    ESP_LOGI(TAG, "setInterval created: %d ms, ID: %d", interval_ms, index);
+    if (interval_ms < 10) interval_ms = 10;  // جلوگیری از اشغال کامل حلقه
+
+    timer_create(J, "setInterval", interval_ms, true);
 }
 
 // تابع clearInterval/clearTimeout
 static void js_timer_clear(js_State *J) {
-    int timer_id = js_toint32(J, 1);
-    
-    if (timer_id < 0 || timer_id >= 10 || active_timers[timer_id] == NULL) {
-        js_pushundefined(J);
-        return;
+    uint32_t timer_id = js_touint32(J, 1);
+
+    if (timer_loop) {
+        timer_context_t *context = evm_event_loop_cancel_timer(timer_loop, timer_id);
+        if (context) {
+            timer_context_free(context);
+            ESP_LOGD(TAG, "Timer cleared: ID %"PRIu32, timer_id);
+        }
     }
-    
-    timer_context_t *context = active_timers[timer_id];
-    
-    // توقف تایمر
-    xTimerStop(context->timer_handle, 0);
-    xTimerDelete(context->timer_handle, 0);
-    
-    // آزادسازی منابع
-    js_unref(context->js_state, context->callback_ref);
-    free(context->name);
-    free(context);
-    
-    active_timers[timer_id] = NULL;
-    timer_count--;
-    
+
     js_pushundefined(J);
-    ESP_LOGI(TAG, "Timer cleared: ID %d", timer_id);
 }
 
-// تابع پاک‌سازی همه تایمرها
-static void cleanup_all_timers(void) {
-    for (int i = 0; i < 10; i++) {
-        if (active_timers[i] != NULL) {
-            timer_context_t *context = active_timers[i];
-            
-            xTimerStop(context->timer_handle, 0);
-            xTimerDelete(context->timer_handle, 0);
-            
-            js_unref(context->js_state, context->callback_ref);
-            free(context->name);
-            free(context);
-            
-            active_timers[i] = NULL;
-        }
+// پاک‌سازی همه تایمرها هنگام توقف برنامه
+void evm_timer_cleanup(void) {
+    if (timer_loop) {
+        evm_event_loop_deinit(timer_loop, timer_context_free);
+        timer_loop = NULL;
     }
-    timer_count = 0;
     ESP_LOGI(TAG, "All timers cleaned up");
 }
 
 esp_err_t evm_timer_init(void) {
     ESP_LOGI(TAG, "Initializing EVM Timer Module");
-    timer_count = 0;
-    memset(active_timers, 0, sizeof(active_timers));
     return ESP_OK;
 }
 
@@ -445,8 +354,3 @@ esp_err_t evm_timer_register_js(js_State *J) {
     ESP_LOGI(TAG, "✅ Timer module registered with REAL TIME functions");
     return ESP_OK;
 }
-
-// تابع پاک‌سازی هنگام توقف برنامه
-void evm_timer_cleanup(void) {
-    cleanup_all_timers();
-}
\ No newline at end of file
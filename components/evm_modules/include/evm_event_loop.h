@@ -0,0 +1,121 @@
+#ifndef EVM_EVENT_LOOP_H
+#define EVM_EVENT_LOOP_H
+
+// حلقه رویداد تک‌نخی برای اجرای callbackهای JavaScript
+//
+// همه callbackها (تایمرها و رویدادها) فقط روی تسک صاحب حلقه و تا انتها
+// (run-to-completion) اجرا می‌شوند. تایمرها در یک min-heap نگه‌داری
+// می‌شوند و رویدادهای تسک‌های دیگر یا ISR از طریق صف lock-free
+// (MPSC) ارسال می‌شوند. این فایل به ESP-IDF وابسته نیست و ساعت و
+// خواب/بیدارباش از طریق evm_event_loop_port_t داده می‌شوند، تا روی
+// host با ساعت جعلی تست شود.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int64_t evm_time_t; // میلی‌ثانیه
+
+typedef struct evm_event evm_event_t;
+typedef void (*evm_event_fn)(evm_event_t *event);
+
+// گره رویداد (intrusive): فرستنده آن را درون ساختار خودش قرار می‌دهد.
+// تا قبل از اجرای handler نباید دوباره ارسال شود.
+struct evm_event {
+    _Atomic(evm_event_t *) next;
+    evm_event_fn handler;
+};
+
+typedef void (*evm_timer_fn)(void *data, uint32_t id);
+
+// رابط پلتفرم
+typedef struct {
+    evm_time_t (*now)(void *ctx);
+    // تا timeout میلی‌ثانیه یا تا wakeup صبر کن؛ timeout < 0 یعنی بی‌نهایت
+    void (*wait)(void *ctx, evm_time_t timeout);
+    // از هر تسک یا ISR قابل فراخوانی است
+    void (*wakeup)(void *ctx);
+    void *ctx;
+} evm_event_loop_port_t;
+
+typedef struct {
+    evm_time_t deadline;
+    int32_t interval;   // 0 برای تایمر یک‌باره
+    uint32_t id;
+    uint32_t seq;       // ترتیب FIFO برای deadlineهای برابر
+    int heap_index;     // -1 یعنی خانه آزاد
+    int next_free;
+    evm_timer_fn fn;
+    void *data;
+} evm_loop_timer_t;
+
+typedef struct {
+    evm_event_loop_port_t port;
+
+    // تایمرها: خانه‌ها با شناسه (slot + نسل) و heap از اندیس خانه‌ها
+    evm_loop_timer_t *timers;
+    int timer_cap;
+    int free_slot;
+    int *heap;
+    int heap_len;
+    uint32_t seq;
+
+    // صف MPSC (Vyukov)
+    _Atomic(evm_event_t *) head;
+    evm_event_t *tail;
+    evm_event_t stub;
+
+    volatile bool stop;
+    bool dispatching;   // یک callback حلقه در حال اجراست
+} evm_event_loop_t;
+
+void evm_event_loop_init(evm_event_loop_t *loop, const evm_event_loop_port_t *port);
+
+// تایمرهای باقی‌مانده را با dispose(data) رها می‌کند و رویدادهای مانده را اجرا می‌کند
+void evm_event_loop_deinit(evm_event_loop_t *loop, void (*dispose)(void *data));
+
+// شناسه تایمر (هرگز صفر نیست) یا 0 در صورت کمبود حافظه
+uint32_t evm_event_loop_add_timer(evm_event_loop_t *loop, evm_time_t delay, int32_t interval,
+                                  evm_timer_fn fn, void *data);
+
+// data تایمر لغو شده را برمی‌گرداند، یا NULL اگر شناسه معتبر نباشد
+void *evm_event_loop_cancel_timer(evm_event_loop_t *loop, uint32_t id);
+
+// ارسال رویداد از هر تسک یا ISR
+void evm_event_loop_post(evm_event_loop_t *loop, evm_event_t *event);
+void evm_event_loop_wakeup(evm_event_loop_t *loop);
+
+// تایمرهای سررسیده و رویدادهای موجود را اجرا می‌کند؛ اگر کاری نبود
+// حداکثر max_wait میلی‌ثانیه (یا تا سررسید بعدی) می‌خوابد.
+// تعداد callbackهای اجرا شده را برمی‌گرداند. اگر از داخل یک callback
+// فراخوانی شود (delay همگام) چیزی اجرا نمی‌کند و فقط max_wait می‌خوابد.
+int evm_event_loop_run_once(evm_event_loop_t *loop, evm_time_t max_wait);
+
+// تا زمانی که تایمری باقی است و stop درخواست نشده اجرا می‌کند
+void evm_event_loop_run(evm_event_loop_t *loop);
+void evm_event_loop_stop(evm_event_loop_t *loop);
+
+// ==================== حلقه برنامه ====================
+// فرستنده‌هایی که حلقه را نمی‌شناسند (ISRهای GPIO، تسک‌های شبکه) رویداد را
+// به حلقه برنامه در حال اجرا می‌فرستند؛ evm_loader آن را هنگام شروع برنامه
+// attach و هنگام توقف، قبل از deinit، detach می‌کند.
+
+void evm_app_loop_attach(evm_event_loop_t *loop);
+// بعد از بازگشت، هیچ evm_app_loop_post در حال اجرایی به حلقه قبلی نمی‌نویسد
+void evm_app_loop_detach(void);
+// از هر تسک یا ISR؛ اگر برنامه‌ای در حال اجرا نیست false و رویداد ارسال نمی‌شود
+bool evm_app_loop_post(evm_event_t *event);
+
+int evm_event_loop_timer_count(const evm_event_loop_t *loop);
+// زمان تا سررسید بعدی، یا -1 اگر تایمری نیست
+evm_time_t evm_event_loop_next_timeout(evm_event_loop_t *loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVM_EVENT_LOOP_H
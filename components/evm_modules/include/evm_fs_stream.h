@@ -0,0 +1,62 @@
+#ifndef EVM_FS_STREAM_H
+#define EVM_FS_STREAM_H
+
+// فایل‌های باز برای fs.openSync/readSync/writeSync/closeSync و fs.readLines
+//
+// به جای خواندن کل فایل در یک بافر، فایل تکه به تکه با بافری به اندازه
+// دلخواه فراخواننده خوانده و نوشته می‌شود؛ پس مصرف حافظه به اندازه فایل
+// بستگی ندارد. هر فایل باز یک شماره (fd) کوچک در جدول ثابت این ماژول
+// است و بافر stdio آن (setvbuf) با اندازه داده شده ساخته می‌شود، که برای
+// نوشتن append یعنی تعداد دفعات دسترسی به SD قابل تنظیم است.
+// این فایل به ESP-IDF و MuJS وابسته نیست تا روی host تست شود.
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVM_FS_MAX_OPEN        8
+#define EVM_FS_DEFAULT_BUFFER  4096
+#define EVM_FS_MIN_BUFFER      128
+#define EVM_FS_MAX_BUFFER      (64 * 1024)
+#define EVM_FS_MAX_LINE        4096
+
+// باز کردن با حالت‌های fopen ("r", "w", "a" و نسخه‌های "+")؛ b خودکار اضافه می‌شود.
+// buffer_size صفر یعنی EVM_FS_DEFAULT_BUFFER. خروجی fd یا -errno است.
+int evm_fs_open(const char *path, const char *flags, size_t buffer_size);
+
+// تا len بایت؛ 0 یعنی انتهای فایل، منفی یعنی -errno
+ssize_t evm_fs_read(int fd, void *buf, size_t len);
+// مثل evm_fs_read، ولی کاراکتر UTF-8 ناقص انتهای تکه برای خواندن بعدی می‌ماند
+ssize_t evm_fs_read_text(int fd, void *buf, size_t len);
+ssize_t evm_fs_write(int fd, const void *data, size_t len);
+
+// خالی کردن بافر stdio؛ با sync داده تا خود کارت هم نوشته می‌شود
+int evm_fs_flush(int fd, bool sync);
+int evm_fs_close(int fd);
+
+// بستن همه فایل‌های باز (پایان برنامه)؛ خروجی تعداد فایل‌های بسته شده
+int evm_fs_close_all(void);
+int evm_fs_open_count(void);
+
+// حافظه بافرهای فایل‌های باز، برای لاگ و benchmark
+size_t evm_fs_buffer_bytes(void);
+
+// تعداد بایت‌های انتهای buf که یک کاراکتر UTF-8 ناقص هستند (0 تا 3)
+size_t evm_fs_utf8_tail(const void *buf, size_t len);
+
+// callback خط: بدون '\n' و '\r' انتهایی؛ false یعنی توقف
+typedef bool (*evm_fs_line_fn)(void *ctx, const char *line, size_t len);
+
+// خواندن خط به خط با یک بافر max_line بایتی (صفر یعنی EVM_FS_MAX_LINE).
+// خط بلندتر از بافر در چند تکه تحویل می‌شود. خروجی تعداد خط‌ها یا -errno.
+long evm_fs_read_lines(const char *path, size_t max_line, evm_fs_line_fn fn, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
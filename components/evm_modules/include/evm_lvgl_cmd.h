@@ -0,0 +1,70 @@
+#ifndef EVM_LVGL_CMD_H
+#define EVM_LVGL_CMD_H
+
+// بافر حلقوی فرمان‌های LVGL بین تسک برنامه و guiTask
+//
+// تسک برنامه (تنها تولیدکننده) تغییرات ویجت‌ها را به صورت فرمان‌های
+// فشرده می‌نویسد و فقط با commit آن‌ها را منتشر می‌کند. guiTask (تنها
+// مصرف‌کننده) در هر دور، زیر قفل GUI، همه دسته‌های commit شده را پشت
+// سر هم اجرا می‌کند؛ پس تغییرات مرتبط (مثلاً متن لیبل و مقدار bar) هیچ‌وقت
+// در دو فریم جدا دیده نمی‌شوند. کد فرمان برای این فایل مبهم است و اجرای
+// آن با تابع apply انجام می‌شود. این فایل به ESP-IDF وابسته نیست تا روی
+// host تست شود.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVM_LVGL_CMD_MAX_ARGS 3
+#define EVM_LVGL_CMD_WRAP     0     // کد رزرو شده: ادامه از ابتدای بافر
+
+typedef struct {
+    uint8_t op;                         // 1..255
+    uint8_t argc;
+    uint16_t str_len;                   // 0 یعنی بدون رشته
+    void *target;
+    int32_t args[EVM_LVGL_CMD_MAX_ARGS];
+    const char *str;                    // هنگام apply به داخل بافر اشاره می‌کند
+} evm_lvgl_cmd_t;
+
+typedef void (*evm_lvgl_cmd_fn)(void *ctx, const evm_lvgl_cmd_t *cmd);
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;            // مضرب 4
+    size_t write;           // فقط تولیدکننده؛ شامل فرمان‌های commit نشده
+    _Atomic size_t head;    // انتهای دسته‌های commit شده
+    _Atomic size_t tail;    // فقط مصرف‌کننده
+} evm_lvgl_cmdbuf_t;
+
+void evm_lvgl_cmdbuf_init(evm_lvgl_cmdbuf_t *cb, void *mem, size_t size);
+
+// اندازه فرمان در بافر (بایت)
+size_t evm_lvgl_cmdbuf_encoded_size(const evm_lvgl_cmd_t *cmd);
+
+// تولیدکننده: فرمان را بعد از فرمان‌های قبلی می‌نویسد. اگر جا نباشد false؛
+// در آن صورت باید commit و apply شود و دوباره امتحان شود.
+bool evm_lvgl_cmdbuf_push(evm_lvgl_cmdbuf_t *cb, const evm_lvgl_cmd_t *cmd);
+
+// تولیدکننده: فرمان‌های نوشته شده را یک‌جا برای مصرف‌کننده منتشر می‌کند
+void evm_lvgl_cmdbuf_commit(evm_lvgl_cmdbuf_t *cb);
+
+// تولیدکننده: فرمان commit نشده‌ای هست؟
+static inline bool evm_lvgl_cmdbuf_has_uncommitted(const evm_lvgl_cmdbuf_t *cb) {
+    return cb->write != atomic_load_explicit(&cb->head, memory_order_relaxed);
+}
+
+// مصرف‌کننده: همه فرمان‌های commit شده را به ترتیب اجرا می‌کند.
+// تعداد فرمان‌های اجرا شده را برمی‌گرداند.
+size_t evm_lvgl_cmdbuf_apply(evm_lvgl_cmdbuf_t *cb, evm_lvgl_cmd_fn fn, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVM_LVGL_CMD_H
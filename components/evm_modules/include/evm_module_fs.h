@@ -7,4 +7,7 @@
 esp_err_t evm_fs_init(void);
 esp_err_t evm_fs_register_js(js_State *J);
 
+// بستن فایل‌هایی که برنامه باز گذاشته (بعد از پایان برنامه)
+void evm_fs_cleanup(void);
+
 #endif
\ No newline at end of file
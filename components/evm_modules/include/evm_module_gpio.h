@@ -6,5 +6,8 @@
 
 esp_err_t evm_gpio_init(void);
 esp_err_t evm_gpio_register_js(js_State *J);
+// برداشتن وقفه‌ها و callbackهای gpio.watch هنگام توقف برنامه؛
+// بعد از evm_app_loop_detach و بستن حلقه فراخوانی شود
+void evm_gpio_cleanup(void);
 
 #endif
\ No newline at end of file
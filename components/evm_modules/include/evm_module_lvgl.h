@@ -5,6 +5,8 @@
 #include "mujs.h"
 #include "esp_err.h"
 #include "lvgl.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +28,12 @@ esp_err_t evm_lvgl_init(void);
 esp_err_t evm_lvgl_register_js_mujs(js_State *J);
 void evm_lvgl_cleanup(void);
 
+// بافر فرمان: تغییرات JS روی ویجت‌ها در تسک برنامه ثبت و در guiTask اجرا می‌شوند
+void evm_lvgl_set_gui_mutex(SemaphoreHandle_t mutex);  // قفل guiTask (xGuiSemaphore)
+void evm_lvgl_apply_pending(void);  // guiTask، با قفل GUI گرفته شده
+void evm_lvgl_commit(void);         // تسک برنامه: پایان دسته فعلی
+void evm_lvgl_flush(void);          // تسک برنامه: commit و اجرای فوری زیر قفل
+
 #ifdef __cplusplus
 }
 #endif
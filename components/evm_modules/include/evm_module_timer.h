@@ -4,6 +4,7 @@
 #include "esp_err.h"
 #include "mujs.h"
 #include "esp_timer.h"
+#include "evm_event_loop.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +14,14 @@ extern "C" {
 esp_err_t evm_timer_init(void);
 esp_err_t evm_timer_register_js(js_State *J);  // اصلاح: void* → js_State*
 
+// حلقه رویدادی که تایمرهای JavaScript روی آن اجرا می‌شوند (تسک APP CPU)
+void evm_timer_set_event_loop(evm_event_loop_t *loop);
+// delay همگام اسکریپت؛ تا پایان زمان تایمرها و رویدادهای حلقه اجرا می‌شوند
+// (از داخل یک callback فقط می‌خوابد)
+void evm_timer_delay(int ms);
+// لغو همه تایمرها و بستن حلقه هنگام توقف برنامه
+void evm_timer_cleanup(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,208 @@
+// مقایسه خواندن و نوشتن کل فایل (مثل readFileSync/writeFileSync) با
+// خواندن و نوشتن تکه به تکه، روی host در یک دایرکتوری موقت
+//   ./bench_evm_fs_stream [اندازه فایل به MB]
+// اوج حافظه heap با -Wl,--wrap=malloc شمرده می‌شود (شامل بافرهای stdio).
+#include "evm_fs_stream.h"
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CHUNK 4096
+
+// ==================== شمارش heap ====================
+
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+
+static size_t heap_live, heap_peak;
+
+void *__wrap_malloc(size_t size) {
+    void *p = __real_malloc(size);
+    if (p) {
+        heap_live += malloc_usable_size(p);
+        if (heap_live > heap_peak) heap_peak = heap_live;
+    }
+    return p;
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr) heap_live -= malloc_usable_size(ptr);
+    __real_free(ptr);
+}
+
+static void heap_reset(void) {
+    heap_peak = heap_live;
+}
+
+static size_t heap_peak_delta(size_t base) {
+    return heap_peak - base;
+}
+
+// کپی‌های شبیه js_pushstring باید دیده شوند تا کامپایلر حذفشان نکند
+static volatile unsigned checksum;
+
+static void use_copy(const char *s, size_t n) {
+    unsigned sum = 0;
+    for (size_t i = 0; i < n; i += 512) sum += (unsigned char)s[i];
+    checksum += sum;
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// ==================== روش فعلی: کل فایل ====================
+
+// مثل js_fs_readFileSync: ftell، malloc کل فایل، fread، و کپی دوم در js_pushstring
+static size_t read_whole(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    char *content = malloc(size + 1);
+    size_t n = fread(content, 1, size, f);
+    fclose(f);
+    content[n] = '\0';
+
+    char *js_copy = malloc(n + 1);
+    memcpy(js_copy, content, n + 1);
+    free(content);
+
+    use_copy(js_copy, n);
+    free(js_copy);
+    return n;
+}
+
+// مثل js_fs_writeFileSync قبلی: کپی محتوا و یک fwrite
+static void write_whole(const char *path, const char *data, size_t len) {
+    char *content = malloc(len + 1);
+    memcpy(content, data, len + 1);
+    use_copy(content, len);
+    FILE *f = fopen(path, "wb");
+    fwrite(content, 1, len, f);
+    fclose(f);
+    free(content);
+}
+
+// ==================== روش جدید: تکه به تکه ====================
+
+static size_t read_chunks(const char *path) {
+    int fd = evm_fs_open(path, "r", CHUNK);
+    char *buf = malloc(CHUNK);
+    size_t total = 0;
+    ssize_t n;
+    while ((n = evm_fs_read_text(fd, buf, CHUNK)) > 0) {
+        // js_pushlstring هر تکه را کپی می‌کند
+        char *js_copy = malloc(n + 1);
+        memcpy(js_copy, buf, n);
+        use_copy(js_copy, n);
+        free(js_copy);
+        total += n;
+    }
+    free(buf);
+    evm_fs_close(fd);
+    return total;
+}
+
+// append با بافر buffer_size؛ هر writeSync یک خط کوتاه مثل لاگ
+static void append_lines(const char *path, const char *data, size_t len, size_t buffer_size) {
+    int fd = evm_fs_open(path, "w", buffer_size);
+    const char *p = data, *end = data + len;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', end - p);
+        size_t n = nl ? (size_t)(nl - p) + 1 : (size_t)(end - p);
+        evm_fs_write(fd, p, n);
+        p += n;
+    }
+    evm_fs_close(fd);
+}
+
+static bool count_line(void *ctx, const char *line, size_t len) {
+    (void)line;
+    *(size_t *)ctx += len + 1;
+    return true;
+}
+
+// ==================== اجرا ====================
+
+static void report(const char *name, double ms, size_t bytes, size_t peak) {
+    printf("  %-26s %8.1f ms %8.1f MB/s   peak heap %9.1f KB\n",
+           name, ms, bytes / (1024.0 * 1024.0) / (ms / 1000.0), peak / 1024.0);
+}
+
+int main(int argc, char **argv) {
+    size_t mb = argc > 1 ? (size_t)atoi(argv[1]) : 8;
+    size_t len = mb * 1024 * 1024;
+
+    char dir[] = "/tmp/evm_fs_bench_XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char path[256];
+    snprintf(path, sizeof(path), "%s/data.log", dir);
+
+    // متن شبیه لاگ سنسور
+    char *data = malloc(len + 1);
+    size_t pos = 0;
+    for (int i = 0; pos < len; i++) {
+        char line[96];
+        int n = snprintf(line, sizeof(line), "2024-05-01 12:%02d:%02d sensor=%d value=%d.%d unit=C ok\n",
+                         (i / 60) % 60, i % 60, i % 16, 20 + i % 10, i % 10);
+        size_t copy = (size_t)n < len - pos ? (size_t)n : len - pos;
+        memcpy(data + pos, line, copy);
+        pos += copy;
+    }
+    data[len - 1] = '\n';
+    data[len] = '\0';
+    size_t base = heap_live;
+
+    printf("file: %zu MB in %s\n", mb, dir);
+    double t0;
+    size_t got;
+
+    printf("write\n");
+    heap_reset();
+    t0 = now_ms();
+    write_whole(path, data, len);
+    report("writeFileSync (whole)", now_ms() - t0, len, heap_peak_delta(base));
+
+    size_t buffers[] = { 512, 4096, 32768 };
+    for (int i = 0; i < 3; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "writeSync lines, buf %zu", buffers[i]);
+        heap_reset();
+        t0 = now_ms();
+        append_lines(path, data, len, buffers[i]);
+        report(name, now_ms() - t0, len, heap_peak_delta(base));
+    }
+
+    printf("read\n");
+    heap_reset();
+    t0 = now_ms();
+    got = read_whole(path);
+    report("readFileSync (whole)", now_ms() - t0, got, heap_peak_delta(base));
+
+    heap_reset();
+    t0 = now_ms();
+    got = read_chunks(path);
+    report("readSync 4 KB chunks", now_ms() - t0, got, heap_peak_delta(base));
+
+    heap_reset();
+    t0 = now_ms();
+    got = 0;
+    long lines = evm_fs_read_lines(path, 0, count_line, &got);
+    report("readLines", now_ms() - t0, got, heap_peak_delta(base));
+    printf("  %ld lines, %s\n", lines, got == len ? "sizes match" : "SIZE MISMATCH");
+
+    remove(path);
+    remove(dir);
+    free(data);
+    return got == len ? 0 : 1;
+}
@@ -0,0 +1,421 @@
+// تست‌های قطعی حلقه رویداد روی host با ساعت جعلی
+#include "evm_event_loop.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// ==================== ساعت جعلی ====================
+
+typedef struct {
+    evm_time_t now;
+    int waits;
+    evm_time_t last_wait;
+    atomic_int wakeups;
+} fake_clock_t;
+
+static evm_time_t fake_now(void *ctx) {
+    return ((fake_clock_t *)ctx)->now;
+}
+
+// خواب با ساعت جعلی: زمان به اندازه timeout جلو می‌رود
+static void fake_wait(void *ctx, evm_time_t timeout) {
+    fake_clock_t *clock = ctx;
+    clock->waits++;
+    clock->last_wait = timeout;
+    if (timeout > 0) {
+        clock->now += timeout;
+    }
+}
+
+static void fake_wakeup(void *ctx) {
+    atomic_fetch_add(&((fake_clock_t *)ctx)->wakeups, 1);
+}
+
+static void loop_init(evm_event_loop_t *loop, fake_clock_t *clock) {
+    evm_event_loop_port_t port = { fake_now, fake_wait, fake_wakeup, clock };
+    clock->now = 1000;
+    clock->waits = 0;
+    clock->last_wait = 0;
+    atomic_store(&clock->wakeups, 0);
+    evm_event_loop_init(loop, &port);
+}
+
+// ==================== ثبت ترتیب اجرا ====================
+
+static fake_clock_t clock0;
+static int fired[4096];
+static evm_time_t fired_at[4096];
+static int fired_count;
+
+static void record(void *data, uint32_t id) {
+    (void)id;
+    fired_at[fired_count] = clock0.now;
+    fired[fired_count++] = (int)(intptr_t)data;
+}
+
+static void test_order(void) {
+    evm_event_loop_t loop;
+    loop_init(&loop, &clock0);
+    fired_count = 0;
+
+    evm_event_loop_add_timer(&loop, 30, 0, record, (void *)3);
+    evm_event_loop_add_timer(&loop, 10, 0, record, (void *)1);
+    evm_event_loop_add_timer(&loop, 20, 0, record, (void *)2);
+    evm_event_loop_add_timer(&loop, 10, 0, record, (void *)11); // همان deadline، بعد از 1
+
+    evm_event_loop_run(&loop);
+
+    CHECK(fired_count == 4);
+    CHECK(fired[0] == 1 && fired_at[0] == 1010);
+    CHECK(fired[1] == 11 && fired_at[1] == 1010);
+    CHECK(fired[2] == 2 && fired_at[2] == 1020);
+    CHECK(fired[3] == 3 && fired_at[3] == 1030);
+    CHECK(evm_event_loop_timer_count(&loop) == 0);
+
+    evm_event_loop_deinit(&loop, NULL);
+}
+
+static evm_event_loop_t *interval_loop;
+static int interval_hits;
+
+static void interval_cb(void *data, uint32_t id) {
+    (void)data;
+    fired_at[interval_hits++] = clock0.now;
+    if (interval_hits == 3) {
+        CHECK(evm_event_loop_cancel_timer(interval_loop, id) == (void *)7);
+    }
+}
+
+static void test_interval(void) {
+    evm_event_loop_t loop;
+    loop_init(&loop, &clock0);
+    interval_loop = &loop;
+    interval_hits = 0;
+
+    uint32_t id = evm_event_loop_add_timer(&loop, 25, 25, interval_cb, (void *)7);
+    CHECK(id != 0);
+    evm_event_loop_run(&loop);
+
+    CHECK(interval_hits == 3);
+    CHECK(fired_at[0] == 1025 && fired_at[1] == 1050 && fired_at[2] == 1075);
+    // شناسه لغو شده دیگر معتبر نیست
+    CHECK(evm_event_loop_cancel_timer(&loop, id) == NULL);
+
+    evm_event_loop_deinit(&loop, NULL);
+}
+
+static void test_interval_late(void) {
+    evm_event_loop_t loop;
+    loop_init(&loop, &clock0);
+    interval_loop = &loop;
+    interval_hits = 0;
+
+    evm_event_loop_add_timer(&loop, 10, 10, interval_cb, (void *)7);
+    clock0.now += 100; // حلقه دیر رسیده: فقط یک بار اجرا، بدون جبران
+    CHECK(evm_event_loop_run_once(&loop, 0) == 1);
+    CHECK(evm_event_loop_next_timeout(&loop) == 10);
+
+    evm_event_loop_deinit(&loop, NULL);
+}
+
+static void test_cancel_many(void) {
+    enum { N = 2000 };
+    static uint32_t ids[N];
+    evm_event_loop_t loop;
+    loop_init(&loop, &clock0);
+    fired_count = 0;
+
+    srand(1);
+    for (int i = 0; i < N; i++) {
+        int delay = rand() % 5000;
+        ids[i] = evm_event_loop_add_timer(&loop, delay, 0, record, (void *)(intptr_t)delay);
+        CHECK(ids[i] != 0);
+    }
+    // لغو یک سوم تایمرها از وسط heap
+    int cancelled = 0;
+    for (int i = 0; i < N; i += 3) {
+        evm_event_loop_cancel_timer(&loop, ids[i]);
+        cancelled++;
+    }
+    CHECK(evm_event_loop_timer_count(&loop) == N - cancelled);
+
+    evm_event_loop_run(&loop);
+    CHECK(fired_count == N - cancelled);
+    for (int i = 0; i < fired_count; i++) {
+        CHECK(i == 0 || fired[i - 1] <= fired[i]);
+        CHECK(fired_at[i] == 1000 + fired[i]);
+    }
+
+    // خانه‌ها با نسل جدید دوباره استفاده می‌شوند
+    uint32_t again = evm_event_loop_add_timer(&loop, 1, 0, record, NULL);
+    for (int i = 0; i < N; i++) {
+        CHECK(again != ids[i]);
+        CHECK(evm_event_loop_cancel_timer(&loop, ids[i]) == NULL);
+    }
+    evm_event_loop_deinit(&loop, NULL);
+}
+
+static evm_event_loop_t *chain_loop;
+static int chain_runs;
+
+static void chain_cb(void *data, uint32_t id) {
+    (void)data;
+    (void)id;
+    chain_runs++;
+    evm_event_loop_add_timer(chain_loop, 0, 0, chain_cb, NULL);
+}
+
+static void test_zero_delay_chain(void) {
+    evm_event_loop_t loop;
+    loop_init(&loop, &clock0);
+    chain_loop = &loop;
+    chain_runs = 0;
+
+    evm_event_loop_add_timer(&loop, 0, 0, chain_cb, NULL);
+    // هر دور فقط یک بار، تا حلقه گرسنه نماند
+    CHECK(evm_event_loop_run_once(&loop, 0) == 1);
+    CHECK(evm_event_loop_run_once(&loop, 0) == 1);
+    CHECK(chain_runs == 2);
+
+    evm_event_loop_deinit(&loop, NULL);
+}
+
+static void test_idle_wait(void) {
+    evm_event_loop_t loop;
+    loop_init(&loop, &clock0);
+
+    // بدون تایمر: حداکثر max_wait
+    CHECK(evm_event_loop_run_once(&loop, 100) == 0);
+    CHECK(clock0.waits == 1 && clock0.last_wait == 100);
+
+    // خواب تا سررسید بعدی
+    evm_event_loop_add_timer(&loop, 40, 0, record, NULL);
+    CHECK(evm_event_loop_run_once(&loop, 100) == 0);
+    CHECK(clock0.waits == 2 && clock0.last_wait == 40);
+    CHECK(evm_event_loop_run_once(&loop, 100) == 1);
+
+    evm_event_loop_deinit(&loop, NULL);
+}
+
+static int disposed;
+
+static void dispose(void *data) {
+    (void)data;
+    disposed++;
+}
+
+static void test_deinit(void) {
+    evm_event_loop_t loop;
+    loop_init(&loop, &clock0);
+    disposed = 0;
+    for (int i = 0; i < 5; i++) {
+        evm_event_loop_add_timer(&loop, 10 * i, 0, record, NULL);
+    }
+    evm_event_loop_deinit(&loop, dispose);
+    CHECK(disposed == 5);
+}
+
+// ==================== صف MPSC ====================
+
+enum { PRODUCERS = 4, EVENTS_PER_PRODUCER = 100000 };
+
+typedef struct {
+    evm_event_t event;
+    int producer;
+    int seq;
+} test_event_t;
+
+static int last_seq[PRODUCERS];
+static int received;
+static int out_of_order;
+
+static void on_event(evm_event_t *event) {
+    test_event_t *e = (test_event_t *)event;
+    if (e->seq != last_seq[e->producer] + 1) {
+        out_of_order++;
+    }
+    last_seq[e->producer] = e->seq;
+    received++;
+    free(e);
+}
+
+typedef struct {
+    evm_event_loop_t *loop;
+    int producer;
+} producer_arg_t;
+
+static void *producer(void *arg) {
+    producer_arg_t *p = arg;
+    for (int i = 0; i < EVENTS_PER_PRODUCER; i++) {
+        test_event_t *e = malloc(sizeof(*e));
+        e->event.handler = on_event;
+        e->producer = p->producer;
+        e->seq = i;
+        evm_event_loop_post(p->loop, &e->event);
+    }
+    return NULL;
+}
+
+static void test_mpsc(void) {
+    evm_event_loop_t loop;
+    pthread_t threads[PRODUCERS];
+    producer_arg_t args[PRODUCERS];
+    loop_init(&loop, &clock0);
+    received = 0;
+    out_of_order = 0;
+
+    for (int i = 0; i < PRODUCERS; i++) {
+        last_seq[i] = -1;
+        args[i].loop = &loop;
+        args[i].producer = i;
+        pthread_create(&threads[i], NULL, producer, &args[i]);
+    }
+    while (received < PRODUCERS * EVENTS_PER_PRODUCER) {
+        evm_event_loop_run_once(&loop, 0);
+    }
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    evm_event_loop_run_once(&loop, 0);
+
+    CHECK(received == PRODUCERS * EVENTS_PER_PRODUCER);
+    CHECK(out_of_order == 0);
+    CHECK(atomic_load(&clock0.wakeups) == PRODUCERS * EVENTS_PER_PRODUCER);
+
+    evm_event_loop_deinit(&loop, NULL);
+}
+
+// ==================== delay همگام ====================
+
+static evm_event_loop_t delay_loop;
+static int delay_depth;
+static int delay_max_depth;
+static int interval_runs;
+
+// مثل evm_timer_delay: حلقه تا deadline اجرا می‌شود
+static void sync_delay(evm_time_t ms) {
+    evm_time_t deadline = clock0.now + ms;
+    while (clock0.now < deadline) {
+        evm_event_loop_run_once(&delay_loop, deadline - clock0.now);
+    }
+}
+
+// interval کوتاه‌تر از delay درون callback خودش
+static void delaying_interval(void *data, uint32_t id) {
+    (void)data;
+    (void)id;
+    interval_runs++;
+    if (++delay_depth > delay_max_depth) {
+        delay_max_depth = delay_depth;
+    }
+    sync_delay(100);
+    delay_depth--;
+}
+
+static void test_delay(void) {
+    loop_init(&delay_loop, &clock0);
+    fired_count = 0;
+
+    // delay در بدنه اصلی اسکریپت تایمرها را گرسنه نمی‌گذارد
+    evm_event_loop_add_timer(&delay_loop, 30, 0, record, (void *)1);
+    evm_event_loop_add_timer(&delay_loop, 70, 0, record, (void *)2);
+    sync_delay(100);
+    CHECK(fired_count == 2);
+    CHECK(fired_at[0] == 1030);
+    CHECK(fired_at[1] == 1070);
+    CHECK(clock0.now == 1100);
+
+    // delay درون callback فقط می‌خوابد و callbackها تو در تو اجرا نمی‌شوند
+    interval_runs = 0;
+    delay_depth = 0;
+    delay_max_depth = 0;
+    evm_event_loop_add_timer(&delay_loop, 10, 10, delaying_interval, NULL);
+    sync_delay(500);
+    CHECK(delay_max_depth == 1);
+    CHECK(interval_runs > 1);
+    CHECK(!delay_loop.dispatching);
+
+    evm_event_loop_deinit(&delay_loop, NULL);
+}
+
+// ==================== حلقه برنامه (evm_app_loop_post) ====================
+
+static atomic_int app_posted;
+
+static void on_app_event(evm_event_t *event) {
+    received++;
+    free(event);
+}
+
+// مثل ISR یا تسک شبکه: حلقه را نمی‌شناسد و تا detach شدن ارسال می‌کند
+static void *app_producer(void *arg) {
+    (void)arg;
+    for (;;) {
+        evm_event_t *e = malloc(sizeof(*e));
+        e->handler = on_app_event;
+        if (!evm_app_loop_post(e)) {
+            free(e);
+            return NULL;
+        }
+        atomic_fetch_add(&app_posted, 1);
+    }
+}
+
+static void test_app_loop(void) {
+    evm_event_loop_t loop;
+    pthread_t threads[PRODUCERS];
+    evm_event_t orphan = { .handler = on_app_event };
+    loop_init(&loop, &clock0);
+    received = 0;
+    atomic_store(&app_posted, 0);
+
+    CHECK(!evm_app_loop_post(&orphan));
+
+    evm_app_loop_attach(&loop);
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_create(&threads[i], NULL, app_producer, NULL);
+    }
+    while (received < 1000) {
+        evm_event_loop_run_once(&loop, 0);
+    }
+    // detach وسط ارسال: هر رویدادی که post آن true برگرداند باید در صف باشد
+    evm_app_loop_detach();
+    for (int i = 0; i < PRODUCERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    evm_event_loop_run_once(&loop, 0);
+
+    CHECK(received == atomic_load(&app_posted));
+    CHECK(!evm_app_loop_post(&orphan));
+
+    evm_event_loop_deinit(&loop, NULL);
+}
+
+int main(void) {
+    test_order();
+    test_interval();
+    test_interval_late();
+    test_cancel_many();
+    test_zero_delay_chain();
+    test_idle_wait();
+    test_deinit();
+    test_mpsc();
+    test_delay();
+    test_app_loop();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("evm_event_loop: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,317 @@
+// تست‌های فایل‌های باز و خواندن خط به خط روی host، در یک دایرکتوری موقت
+#include "evm_fs_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+static char tmpdir[] = "/tmp/evm_fs_test_XXXXXX";
+
+// چند بافر چرخشی تا دو مسیر هم‌زمان همدیگر را خراب نکنند
+static const char *tmp_path(const char *name) {
+    static char paths[4][256];
+    static int next;
+    char *path = paths[next++ % 4];
+    snprintf(path, 256, "%s/%s", tmpdir, name);
+    return path;
+}
+
+static void write_file(const char *path, const char *data, size_t len) {
+    FILE *f = fopen(path, "wb");
+    fwrite(data, 1, len, f);
+    fclose(f);
+}
+
+static size_t read_file(const char *path, char *out, size_t max) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    size_t n = fread(out, 1, max, f);
+    fclose(f);
+    return n;
+}
+
+// ==================== ثبت خط‌ها ====================
+
+typedef struct {
+    char lines[64][256];
+    size_t lens[64];
+    int count;
+    int stop_after;     // 0 یعنی بدون توقف
+} line_log_t;
+
+static bool log_line(void *ctx, const char *line, size_t len) {
+    line_log_t *log = ctx;
+    if (log->count < 64) {
+        size_t n = len < 255 ? len : 255;
+        memcpy(log->lines[log->count], line, n);
+        log->lines[log->count][n] = '\0';
+        log->lens[log->count] = len;
+    }
+    log->count++;
+    return log->stop_after == 0 || log->count < log->stop_after;
+}
+
+// ==================== تست‌ها ====================
+
+static void test_open_flags(void) {
+    const char *path = tmp_path("flags.txt");
+    write_file(path, "x", 1);
+
+    CHECK(evm_fs_open(path, "rx", 0) == -EINVAL);
+    CHECK(evm_fs_open(path, "++", 0) == -EINVAL);
+    CHECK(evm_fs_open(path, "r++", 0) == -EINVAL);
+    CHECK(evm_fs_open(tmp_path("missing.txt"), "r", 0) == -ENOENT);
+
+    int fd = evm_fs_open(path, NULL, 0);
+    CHECK(fd >= 3);
+    CHECK(evm_fs_buffer_bytes() == EVM_FS_DEFAULT_BUFFER);
+    CHECK(evm_fs_close(fd) == 0);
+    CHECK(evm_fs_close(fd) == -EBADF);
+
+    // اندازه بافر به بازه مجاز محدود می‌شود
+    fd = evm_fs_open(path, "rb", 1);
+    CHECK(evm_fs_buffer_bytes() == EVM_FS_MIN_BUFFER);
+    evm_fs_close(fd);
+    fd = evm_fs_open(path, "r", 1 << 30);
+    CHECK(evm_fs_buffer_bytes() == EVM_FS_MAX_BUFFER);
+    evm_fs_close(fd);
+
+    char c;
+    CHECK(evm_fs_read(99, &c, 1) == -EBADF);
+    CHECK(evm_fs_write(0, "x", 1) == -EBADF);
+    CHECK(evm_fs_open_count() == 0);
+}
+
+static void test_table_full(void) {
+    const char *path = tmp_path("many.txt");
+    write_file(path, "x", 1);
+
+    int fds[EVM_FS_MAX_OPEN];
+    for (int i = 0; i < EVM_FS_MAX_OPEN; i++) {
+        fds[i] = evm_fs_open(path, "r", 0);
+        CHECK(fds[i] >= 3);
+    }
+    CHECK(evm_fs_open(path, "r", 0) == -EMFILE);
+
+    // خانه آزاد شده دوباره استفاده می‌شود
+    evm_fs_close(fds[2]);
+    CHECK(evm_fs_open(path, "r", 0) == fds[2]);
+
+    CHECK(evm_fs_close_all() == EVM_FS_MAX_OPEN);
+    CHECK(evm_fs_open_count() == 0);
+    CHECK(evm_fs_buffer_bytes() == 0);
+}
+
+static void test_chunked_round_trip(void) {
+    const char *path = tmp_path("chunks.bin");
+    static char data[100000], back[100000 + 16];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (char)(i * 7 + (i >> 8));
+
+    // نوشتن با تکه‌های نامنظم و بافر کوچک
+    int fd = evm_fs_open(path, "w", 512);
+    size_t pos = 0, step = 1;
+    while (pos < sizeof(data)) {
+        size_t n = step < sizeof(data) - pos ? step : sizeof(data) - pos;
+        CHECK(evm_fs_write(fd, data + pos, n) == (ssize_t)n);
+        pos += n;
+        step = step * 3 % 1999 + 1;
+    }
+    CHECK(evm_fs_flush(fd, true) == 0);
+    CHECK(evm_fs_close(fd) == 0);
+
+    fd = evm_fs_open(path, "r", 0);
+    pos = 0;
+    ssize_t n;
+    while ((n = evm_fs_read(fd, back + pos, 4096)) > 0) pos += n;
+    CHECK(n == 0);
+    CHECK(pos == sizeof(data));
+    CHECK(memcmp(data, back, sizeof(data)) == 0);
+    evm_fs_close(fd);
+}
+
+static void test_append_buffering(void) {
+    const char *path = tmp_path("append.log");
+    write_file(path, "head\n", 5);
+
+    int fd = evm_fs_open(path, "a", 1024);
+    for (int i = 0; i < 10; i++) {
+        CHECK(evm_fs_write(fd, "0123456789", 10) == 10);
+    }
+
+    // هنوز در بافر است و روی فایل نیامده
+    char back[256];
+    CHECK(read_file(path, back, sizeof(back)) == 5);
+
+    CHECK(evm_fs_flush(fd, false) == 0);
+    CHECK(read_file(path, back, sizeof(back)) == 105);
+    CHECK(memcmp(back, "head\n0123456789", 15) == 0);
+    evm_fs_close(fd);
+
+    // close_all هم داده بافر شده را می‌نویسد
+    fd = evm_fs_open(path, "a", 1024);
+    evm_fs_write(fd, "end", 3);
+    CHECK(evm_fs_close_all() == 1);
+    CHECK(read_file(path, back, sizeof(back)) == 108);
+}
+
+static void test_read_write_switch(void) {
+    const char *path = tmp_path("rw.txt");
+    write_file(path, "abcdefgh", 8);
+
+    int fd = evm_fs_open(path, "r+", 0);
+    char buf[8];
+    CHECK(evm_fs_read(fd, buf, 3) == 3);
+    CHECK(evm_fs_write(fd, "XY", 2) == 2);
+    CHECK(evm_fs_read(fd, buf, 8) == 3);
+    CHECK(memcmp(buf, "fgh", 3) == 0);
+    evm_fs_close(fd);
+
+    CHECK(read_file(path, buf, sizeof(buf)) == 8);
+    CHECK(memcmp(buf, "abcXYfgh", 8) == 0);
+}
+
+static void test_utf8_tail(void) {
+    CHECK(evm_fs_utf8_tail("", 0) == 0);
+    CHECK(evm_fs_utf8_tail("abc", 3) == 0);
+    CHECK(evm_fs_utf8_tail("a\xC3", 2) == 1);             // é ناقص
+    CHECK(evm_fs_utf8_tail("a\xC3\xA9", 3) == 0);
+    CHECK(evm_fs_utf8_tail("\xE6\xBC", 2) == 2);          // 漢 ناقص
+    CHECK(evm_fs_utf8_tail("\xE6\xBC\xA2", 3) == 0);
+    CHECK(evm_fs_utf8_tail("x\xF0\x9F\x98", 4) == 3);     // 😀 ناقص
+    CHECK(evm_fs_utf8_tail("\xF0\x9F\x98\x80", 4) == 0);
+    CHECK(evm_fs_utf8_tail("\x80\x80\x80\x80", 4) == 0);  // نامعتبر
+    CHECK(evm_fs_utf8_tail("\xFF", 1) == 0);
+}
+
+static void test_read_text_keeps_characters(void) {
+    const char *path = tmp_path("utf8.txt");
+    const char *text = "aé漢😀bé漢😀cé漢😀";
+    size_t len = strlen(text);
+    write_file(path, text, len);
+
+    // با هر اندازه تکه، همه تکه‌ها UTF-8 کامل هستند و متن بازسازی می‌شود
+    for (size_t chunk = 4; chunk <= 9; chunk++) {
+        int fd = evm_fs_open(path, "r", 0);
+        char out[64], buf[16];
+        size_t pos = 0;
+        ssize_t n;
+        while ((n = evm_fs_read_text(fd, buf, chunk)) > 0) {
+            CHECK(evm_fs_utf8_tail(buf, n) == 0);
+            memcpy(out + pos, buf, n);
+            pos += n;
+        }
+        evm_fs_close(fd);
+        CHECK(pos == len);
+        CHECK(memcmp(out, text, len) == 0);
+    }
+
+    // بایت ناقص انتهای فایل همان‌طور تحویل می‌شود
+    write_file(path, "ab\xC3", 3);
+    int fd = evm_fs_open(path, "r", 0);
+    char buf[8];
+    CHECK(evm_fs_read_text(fd, buf, 8) == 3);
+    evm_fs_close(fd);
+}
+
+static void test_read_lines(void) {
+    const char *path = tmp_path("lines.txt");
+    const char *text = "first\r\n\nthird line\nlast";
+    write_file(path, text, strlen(text));
+
+    line_log_t log = {0};
+    CHECK(evm_fs_read_lines(path, 0, log_line, &log) == 4);
+    CHECK(log.count == 4);
+    CHECK(strcmp(log.lines[0], "first") == 0);
+    CHECK(log.lens[1] == 0);
+    CHECK(strcmp(log.lines[2], "third line") == 0);
+    CHECK(strcmp(log.lines[3], "last") == 0);
+
+    // توقف با false
+    memset(&log, 0, sizeof(log));
+    log.stop_after = 2;
+    CHECK(evm_fs_read_lines(path, 0, log_line, &log) == 2);
+
+    // فایل خالی و فایل فقط با '\n'
+    write_file(path, "", 0);
+    memset(&log, 0, sizeof(log));
+    CHECK(evm_fs_read_lines(path, 0, log_line, &log) == 0);
+    write_file(path, "\n", 1);
+    CHECK(evm_fs_read_lines(path, 0, log_line, &log) == 1);
+
+    CHECK(evm_fs_read_lines(tmp_path("missing.txt"), 0, log_line, &log) == -ENOENT);
+    CHECK(evm_fs_read_lines(path, 0, NULL, NULL) == -EINVAL);
+}
+
+static void test_read_lines_across_chunks(void) {
+    const char *path = tmp_path("long.txt");
+
+    // خط‌هایی که مرز بافر 128 بایتی را قطع می‌کنند، و یک خط 300 بایتی
+    static char text[4096];
+    size_t len = 0;
+    for (int i = 0; i < 20; i++) {
+        len += sprintf(text + len, "line %d %.*s\n", i, i * 5, "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx");
+    }
+    memset(text + len, 'L', 300);
+    len += 300;
+    text[len++] = '\n';
+    len += sprintf(text + len, "after");
+    write_file(path, text, len);
+
+    line_log_t log = {0};
+    long lines = evm_fs_read_lines(path, EVM_FS_MIN_BUFFER, log_line, &log);
+
+    // خط 300 بایتی در سه تکه 128 + 128 + 44 می‌آید
+    CHECK(lines == 20 + 3 + 1);
+    CHECK(strncmp(log.lines[7], "line 7 ", 7) == 0);
+    CHECK(log.lens[7] == 7 + 35);
+    CHECK(log.lens[19] == 8 + 95);
+    CHECK(log.lens[20] == 128);
+    CHECK(log.lens[21] == 128);
+    CHECK(log.lens[22] == 44);
+    CHECK(strcmp(log.lines[23], "after") == 0);
+
+    // با بافر پیش‌فرض همه خط‌ها کامل هستند
+    memset(&log, 0, sizeof(log));
+    CHECK(evm_fs_read_lines(path, 0, log_line, &log) == 22);
+    CHECK(log.lens[20] == 300);
+}
+
+int main(void) {
+    if (!mkdtemp(tmpdir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    test_open_flags();
+    test_table_full();
+    test_chunked_round_trip();
+    test_append_buffering();
+    test_read_write_switch();
+    test_utf8_tail();
+    test_read_text_keeps_characters();
+    test_read_lines();
+    test_read_lines_across_chunks();
+
+    char cmd[300];
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", tmpdir);
+    if (system(cmd) != 0) {
+        printf("cannot remove %s\n", tmpdir);
+    }
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("evm_fs_stream: all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,318 @@
+// تست‌های بافر فرمان LVGL روی host: اجرای دوباره جریان‌های ضبط شده
+#include "evm_lvgl_cmd.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+// ==================== ویجت جعلی ====================
+
+enum {
+    OP_TEXT = 1,
+    OP_POS,
+    OP_ANGLE,
+    OP_VALUE,
+    OP_DEL,
+};
+
+typedef struct {
+    char text[64];
+    int32_t x, y;
+    int32_t angle;
+    int32_t value;
+    bool deleted;
+    int applied;
+} fake_widget_t;
+
+static void fake_apply(void *ctx, const evm_lvgl_cmd_t *cmd) {
+    (void)ctx;
+    fake_widget_t *w = cmd->target;
+    w->applied++;
+    if (w->deleted) {
+        return;
+    }
+    switch (cmd->op) {
+    case OP_TEXT:
+        snprintf(w->text, sizeof(w->text), "%s", cmd->str ? cmd->str : "");
+        break;
+    case OP_POS:
+        w->x = cmd->args[0];
+        w->y = cmd->args[1];
+        break;
+    case OP_ANGLE:
+        w->angle = cmd->args[0];
+        break;
+    case OP_VALUE:
+        w->value = cmd->args[0];
+        break;
+    case OP_DEL:
+        w->deleted = true;
+        break;
+    }
+}
+
+static evm_lvgl_cmd_t make_cmd(uint8_t op, void *target, int argc, int32_t a0, int32_t a1, const char *str) {
+    evm_lvgl_cmd_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.op = op;
+    cmd.target = target;
+    cmd.argc = (uint8_t)argc;
+    cmd.args[0] = a0;
+    cmd.args[1] = a1;
+    cmd.str = str;
+    cmd.str_len = str ? (uint16_t)strlen(str) : 0;
+    return cmd;
+}
+
+// ==================== جریان ضبط شده ====================
+
+// یک ثانیه از برنامه ساعت: متن زمان، سه عقربه و نوار ثانیه
+typedef struct {
+    uint8_t op;
+    int widget;
+    int argc;
+    int32_t a0, a1;
+    const char *str;
+} recorded_cmd_t;
+
+static const recorded_cmd_t clock_stream[] = {
+    { OP_POS,   0, 2, 10, 5,   NULL },
+    { OP_TEXT,  0, 0, 0, 0,    "Digital Clock" },
+    { OP_POS,   1, 2, 40, 60,  NULL },
+    { OP_TEXT,  1, 0, 0, 0,    "9:50:00" },
+    { OP_ANGLE, 2, 1, 2950, 0, NULL },
+    { OP_ANGLE, 3, 1, 3000, 0, NULL },
+    { OP_ANGLE, 4, 1, 0, 0,    NULL },
+    { OP_VALUE, 5, 1, 0, 0,    NULL },
+    { OP_TEXT,  1, 0, 0, 0,    "9:50:01" },
+    { OP_ANGLE, 4, 1, 60, 0,   NULL },
+    { OP_VALUE, 5, 1, 1, 0,    NULL },
+    { OP_TEXT,  6, 0, 0, 0,    "temporary" },
+    { OP_DEL,   6, 0, 0, 0,    NULL },
+    { OP_TEXT,  6, 0, 0, 0,    "after delete" },
+    { OP_TEXT,  1, 0, 0, 0,    "" },
+    { OP_TEXT,  1, 0, 0, 0,    "9:50:02" },
+};
+
+#define CLOCK_STREAM_LEN (sizeof(clock_stream) / sizeof(clock_stream[0]))
+#define WIDGETS 7
+
+static void replay_direct(fake_widget_t *w, const recorded_cmd_t *stream, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        const recorded_cmd_t *r = &stream[i];
+        evm_lvgl_cmd_t cmd = make_cmd(r->op, &w[r->widget], r->argc, r->a0, r->a1, r->str);
+        fake_apply(NULL, &cmd);
+    }
+}
+
+static bool widgets_equal(const fake_widget_t *a, const fake_widget_t *b, int n) {
+    for (int i = 0; i < n; i++) {
+        if (strcmp(a[i].text, b[i].text) != 0 || a[i].x != b[i].x || a[i].y != b[i].y ||
+            a[i].angle != b[i].angle || a[i].value != b[i].value ||
+            a[i].deleted != b[i].deleted || a[i].applied != b[i].applied) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// اجرای جریان از طریق بافر با اندازه‌های مختلف تا هر نقطه wrap پوشش داده شود
+static void test_replay_matches_direct(void) {
+    fake_widget_t expect[WIDGETS];
+    memset(expect, 0, sizeof(expect));
+    replay_direct(expect, clock_stream, CLOCK_STREAM_LEN);
+    CHECK(strcmp(expect[1].text, "9:50:02") == 0);
+    CHECK(strcmp(expect[6].text, "temporary") == 0 && expect[6].deleted);
+
+    for (size_t size = 64; size <= 512; size += 4) {
+        uint8_t *mem = malloc(size);
+        evm_lvgl_cmdbuf_t cb;
+        evm_lvgl_cmdbuf_init(&cb, mem, size);
+
+        fake_widget_t got[WIDGETS];
+        memset(got, 0, sizeof(got));
+
+        // چند بار تکرار تا موقعیت شروع در بافر عوض شود
+        for (int round = 0; round < 5; round++) {
+            memset(got, 0, sizeof(got));
+            for (size_t i = 0; i < CLOCK_STREAM_LEN; i++) {
+                const recorded_cmd_t *r = &clock_stream[i];
+                evm_lvgl_cmd_t cmd = make_cmd(r->op, &got[r->widget], r->argc, r->a0, r->a1, r->str);
+                if (!evm_lvgl_cmdbuf_push(&cb, &cmd)) {
+                    // پر: مثل تولیدکننده واقعی commit و اجرا و دوباره
+                    evm_lvgl_cmdbuf_commit(&cb);
+                    evm_lvgl_cmdbuf_apply(&cb, fake_apply, NULL);
+                    CHECK(evm_lvgl_cmdbuf_push(&cb, &cmd));
+                }
+            }
+            evm_lvgl_cmdbuf_commit(&cb);
+            evm_lvgl_cmdbuf_apply(&cb, fake_apply, NULL);
+            CHECK(widgets_equal(got, expect, WIDGETS));
+        }
+        free(mem);
+    }
+}
+
+static void test_uncommitted_invisible(void) {
+    uint8_t mem[256];
+    evm_lvgl_cmdbuf_t cb;
+    evm_lvgl_cmdbuf_init(&cb, mem, sizeof(mem));
+
+    fake_widget_t w;
+    memset(&w, 0, sizeof(w));
+
+    evm_lvgl_cmd_t text = make_cmd(OP_TEXT, &w, 0, 0, 0, "12:00");
+    evm_lvgl_cmd_t value = make_cmd(OP_VALUE, &w, 1, 42, 0, NULL);
+    CHECK(evm_lvgl_cmdbuf_push(&cb, &text));
+    CHECK(evm_lvgl_cmdbuf_has_uncommitted(&cb));
+
+    // متن بدون مقدار نباید دیده شود
+    CHECK(evm_lvgl_cmdbuf_apply(&cb, fake_apply, NULL) == 0);
+    CHECK(w.applied == 0);
+
+    CHECK(evm_lvgl_cmdbuf_push(&cb, &value));
+    evm_lvgl_cmdbuf_commit(&cb);
+    CHECK(!evm_lvgl_cmdbuf_has_uncommitted(&cb));
+    CHECK(evm_lvgl_cmdbuf_apply(&cb, fake_apply, NULL) == 2);
+    CHECK(strcmp(w.text, "12:00") == 0 && w.value == 42);
+    CHECK(evm_lvgl_cmdbuf_apply(&cb, fake_apply, NULL) == 0);
+}
+
+static void test_full_and_oversized(void) {
+    uint8_t mem[64];
+    evm_lvgl_cmdbuf_t cb;
+    evm_lvgl_cmdbuf_init(&cb, mem, sizeof(mem));
+
+    fake_widget_t w;
+    memset(&w, 0, sizeof(w));
+
+    evm_lvgl_cmd_t angle = make_cmd(OP_ANGLE, &w, 1, 7, 0, NULL);
+    size_t n = evm_lvgl_cmdbuf_encoded_size(&angle);
+    CHECK(n % 4 == 0);
+
+    int pushed = 0;
+    while (evm_lvgl_cmdbuf_push(&cb, &angle)) {
+        pushed++;
+    }
+    CHECK(pushed == (int)((sizeof(mem) - 1) / n));
+
+    evm_lvgl_cmdbuf_commit(&cb);
+    CHECK((int)evm_lvgl_cmdbuf_apply(&cb, fake_apply, NULL) == pushed);
+    CHECK(evm_lvgl_cmdbuf_push(&cb, &angle));
+
+    // رشته‌ای که هرگز جا نمی‌شود
+    char big[128];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    evm_lvgl_cmd_t text = make_cmd(OP_TEXT, &w, 0, 0, 0, big);
+    CHECK(evm_lvgl_cmdbuf_encoded_size(&text) >= sizeof(mem));
+    CHECK(!evm_lvgl_cmdbuf_push(&cb, &text));
+
+    // کد رزرو شده پذیرفته نمی‌شود
+    evm_lvgl_cmd_t wrap = make_cmd(EVM_LVGL_CMD_WRAP, &w, 0, 0, 0, NULL);
+    CHECK(!evm_lvgl_cmdbuf_push(&cb, &wrap));
+}
+
+// ==================== دو تسک: بدون پارگی بین فرمان‌های یک دسته ====================
+
+#define TEAR_BATCHES 20000
+#define TEAR_WIDGETS 4
+
+typedef struct {
+    evm_lvgl_cmdbuf_t cb;
+    pthread_mutex_t gui_lock;
+    fake_widget_t w[TEAR_WIDGETS];
+    atomic_bool done;
+    int torn;
+    int frames;
+} tear_ctx_t;
+
+static void *gui_thread(void *arg) {
+    tear_ctx_t *t = arg;
+    for (;;) {
+        bool done = atomic_load(&t->done);
+        pthread_mutex_lock(&t->gui_lock);
+        evm_lvgl_cmdbuf_apply(&t->cb, fake_apply, NULL);
+        // «فریم»: همه ویجت‌ها باید مقدار یک دسته را داشته باشند
+        int32_t v = t->w[0].value;
+        char expect[16];
+        snprintf(expect, sizeof(expect), "%d", (int)v);
+        for (int i = 0; i < TEAR_WIDGETS; i++) {
+            if (t->w[i].value != v || t->w[i].angle != v * 6 || strcmp(t->w[i].text, v ? expect : "") != 0) {
+                t->torn++;
+            }
+        }
+        t->frames++;
+        pthread_mutex_unlock(&t->gui_lock);
+        if (done) {
+            break;
+        }
+        sched_yield();
+    }
+    return NULL;
+}
+
+static void test_no_tearing_between_tasks(void) {
+    static uint8_t mem[512];
+    static tear_ctx_t t;
+    memset(&t, 0, sizeof(t));
+    evm_lvgl_cmdbuf_init(&t.cb, mem, sizeof(mem));
+    pthread_mutex_init(&t.gui_lock, NULL);
+    atomic_store(&t.done, false);
+
+    pthread_t gui;
+    pthread_create(&gui, NULL, gui_thread, &t);
+
+    for (int32_t b = 1; b <= TEAR_BATCHES; b++) {
+        char text[16];
+        snprintf(text, sizeof(text), "%d", (int)b);
+        for (int i = 0; i < TEAR_WIDGETS; i++) {
+            evm_lvgl_cmd_t cmds[3] = {
+                make_cmd(OP_TEXT, &t.w[i], 0, 0, 0, text),
+                make_cmd(OP_ANGLE, &t.w[i], 1, b * 6, 0, NULL),
+                make_cmd(OP_VALUE, &t.w[i], 1, b, 0, NULL),
+            };
+            for (int c = 0; c < 3; c++) {
+                while (!evm_lvgl_cmdbuf_push(&t.cb, &cmds[c])) {
+                    // پر شدن وسط دسته: منتظر GUI نمی‌مانیم چون هنوز commit نشده؛
+                    // اندازه بافر برای یک دسته کافی است
+                    sched_yield();
+                }
+            }
+        }
+        evm_lvgl_cmdbuf_commit(&t.cb);
+    }
+
+    atomic_store(&t.done, true);
+    pthread_join(gui, NULL);
+
+    CHECK(t.torn == 0);
+    CHECK(t.w[0].value == TEAR_BATCHES);
+    CHECK(t.frames > 0);
+    printf("  %d batches, %d gui frames, %d torn\n", TEAR_BATCHES, t.frames, t.torn);
+    pthread_mutex_destroy(&t.gui_lock);
+}
+
+int main(void) {
+    test_uncommitted_invisible();
+    test_replay_matches_direct();
+    test_full_and_oversized();
+    test_no_tearing_between_tasks();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("evm_lvgl_cmd: all tests passed\n");
+    return 0;
+}
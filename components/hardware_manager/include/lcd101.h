@@ -11,6 +11,7 @@ extern "C" {
 
 // توابع عمومی
 void InitLcd(uint16_t mod);
+// ارسال با DMA؛ خودش lv_disp_flush_ready را (در پایان DMA) صدا می‌زند
 void lcd101_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map);
 void Delay_ms(uint16_t ms) ;
 // توابع داخلی (برای استفاده داخلی)
@@ -0,0 +1,69 @@
+#ifndef LCD101_PACK_H
+#define LCD101_PACK_H
+
+// بسته‌بندی جریان 9 بیتی PCF8833 برای ارسال DMA
+//
+// هر کلمه 9 بیت است: بیت اول D/C (1=data، 0=command) و سپس 8 بیت داده،
+// MSB اول. به جای یک تراکنش SPI برای هر کلمه، کل جریان در یک بافر
+// پشت سر هم قرار می‌گیرد. هر 8 کلمه دقیقاً 9 بایت است، پس وقتی جریان
+// روی مرز 8 کلمه باشد هر 4 پیکسل RGB565 یک‌جا به 9 بایت تبدیل می‌شود.
+// این فایل به ESP-IDF وابسته نیست تا روی host تست شود.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// تعداد بایت لازم برای n کلمه 9 بیتی
+#define LCD9_PACKED_BYTES(words) ((((size_t)(words)) * 9 + 7) / 8)
+
+// حداکثر طول سربرگ پنجره (NOP تا مرز 8 کلمه + CASET/RASET/RAMWR)
+#define LCD9_WINDOW_WORDS 18
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;     // بایت
+    size_t bits;    // بیت‌های نوشته شده
+} lcd9_writer_t;
+
+// ارسال یک تکه از جریان؛ last برای تکه آخر true است
+typedef void (*lcd9_send_fn)(void *ctx, const uint8_t *buf, size_t bits, bool last);
+
+void lcd9_init(lcd9_writer_t *w, uint8_t *buf, size_t cap);
+
+static inline size_t lcd9_words(const lcd9_writer_t *w) {
+    return w->bits / 9;
+}
+
+// تعداد کلمه‌ای که هنوز جا دارد
+static inline size_t lcd9_space(const lcd9_writer_t *w) {
+    return (w->cap * 8 - w->bits) / 9;
+}
+
+bool lcd9_cmd(lcd9_writer_t *w, uint8_t cmd);
+bool lcd9_data(lcd9_writer_t *w, uint8_t data);
+
+// CASET/RASET/RAMWR؛ قبل از آن با NOP جریان را هم‌تراز می‌کند تا
+// پیکسل‌ها از مسیر سریع بسته‌بندی شوند
+bool lcd9_window(lcd9_writer_t *w, uint16_t x1, uint16_t x2, uint16_t y1, uint16_t y2);
+
+// پیکسل‌ها را XOR با xor_mask (برای نمایشگر معکوس) و بایت بالا اول
+// بسته‌بندی می‌کند. تعداد پیکسل‌های جا شده را برمی‌گرداند.
+size_t lcd9_pixels(lcd9_writer_t *w, const uint16_t *px, size_t n, uint16_t xor_mask);
+
+// n پیکسل با یک رنگ (رنگ از قبل معکوس شده)
+size_t lcd9_fill(lcd9_writer_t *w, uint16_t color, size_t n);
+
+// جریان را به تکه‌هایی حداکثر max_bytes تقسیم می‌کند؛ مرز تکه‌ها
+// مضرب 9 بایت است تا هیچ کلمه‌ای بین دو تراکنش نصف نشود.
+// تعداد تکه‌ها را برمی‌گرداند.
+int lcd9_emit(const lcd9_writer_t *w, size_t max_bytes, lcd9_send_fn send, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LCD101_PACK_H
@@ -19,6 +19,9 @@
 #include "driver/gpio.h"
 #include "esp_private/gpio.h"  // برای gpio_matrix_out
 
+#include "lcd101_pack.h"
+#include <string.h>
+
 static const char *TAG = "lcd101";
 
 
@@ -88,6 +91,26 @@ static const char *TAG = "lcd101";
 static spi_device_handle_t spi_lcd;
 static bool spi_initialized = false;
 
+// ==================== خط لوله DMA ====================
+
+// بافر DMA به اندازه یک بافر کامل LVGL (160x128) بسته‌بندی شده
+#define LCD101_DMA_PIXELS    (LCD_WIDTH * LCD_HEIGHT)
+#define LCD101_DMA_BUF_SIZE  LCD9_PACKED_BYTES(LCD9_WINDOW_WORDS + LCD101_DMA_PIXELS * 2)
+// حداکثر طول هر تراکنش (مضرب 9 بایت = مرز کلمه)؛ فریم کامل در 3 تراکنش
+#define LCD101_TRANS_BYTES   (9 * 1820)
+#define LCD101_MAX_TRANS     ((LCD101_DMA_BUF_SIZE + LCD101_TRANS_BYTES - 1) / LCD101_TRANS_BYTES)
+
+typedef struct {
+    lv_disp_drv_t *drv;     // بعد از آخرین تراکنش lv_disp_flush_ready
+} lcd101_job_t;
+
+static uint8_t *lcd_dma_buf = NULL;
+static bool lcd_dma_failed = false;
+static bool lcd_dma_used = false;
+static spi_transaction_t lcd_trans[LCD101_MAX_TRANS];
+static int lcd_trans_queued = 0;
+static lcd101_job_t lcd_job;
+
 // توابع تاخیر
 void Delay_ms(uint16_t ms) {
     vTaskDelay(pdMS_TO_TICKS(ms));
@@ -208,6 +231,18 @@ void lcd_pin_init(void)
     }
 }
 
+ // پایان هر تراکنش DMA (ISR)؛ فقط تراکنش آخر هر نوبت user دارد
+static void IRAM_ATTR lcd101_spi_post_cb(spi_transaction_t *t)
+{
+    lcd101_job_t *job = (lcd101_job_t *)t->user;
+    if (job) {
+        gpio_set_level(GPIO_CE, 1);//CS=1;
+        if (job->drv) {
+            lv_disp_flush_ready(job->drv);
+        }
+    }
+}
+
  void spi_master_init1()
 {
 
@@ -218,11 +253,12 @@ void lcd_pin_init(void)
     // adc1_config_channel_atten(ADC1_CHANNEL_0,ADC_ATTEN_11db);
     // int val = adc1_get_voltage(ADC1_CHANNEL_0);
    
-    spi_device_interface_config_t  devcfg1;
-       devcfg1.spics_io_num=PIN_NUM_CS;
+    spi_device_interface_config_t  devcfg1 = {0};
+       devcfg1.spics_io_num=-1;                         // CS دستی روی GPIO_CE
        devcfg1.clock_speed_hz=40 * 1000 * 1000;         //Clock out at 40 MHz
        devcfg1.mode=0;                                  //SPI mode 0
-       devcfg1.queue_size=1700;                          //We want to be able to queue 7 transactions at a time
+       devcfg1.queue_size=LCD101_MAX_TRANS;             // تراکنش‌های یک نوبت flush
+       devcfg1.post_cb=lcd101_spi_post_cb;              // پایان DMA → lv_disp_flush_ready
                      
 
    spi_bus_config_t buscfg1={
@@ -230,7 +266,8 @@ void lcd_pin_init(void)
          .mosi_io_num=PIN_NUM_MOSI,
          .sclk_io_num=PIN_NUM_CLK,
          .quadwp_io_num=-1,
-         .quadhd_io_num=-1
+         .quadhd_io_num=-1,
+         .max_transfer_sz=LCD101_TRANS_BYTES
      };
 
 
@@ -287,14 +324,121 @@ void lcd_pin_init(void)
 
 }
 
+// گرفتن نتیجه تراکنش‌های قبلی؛ بعد از آن بافر DMA آزاد است
+static void lcd101_dma_wait(void)
+{
+    spi_transaction_t *done;
+    while (lcd_trans_queued > 0) {
+        spi_device_get_trans_result(spi_lcd, &done, portMAX_DELAY);
+        lcd_trans_queued--;
+    }
+}
+
+static bool lcd101_dma_ready(void)
+{
+    if (lcd_dma_buf) return true;
+    if (lcd_dma_failed) return false;
+
+    lcd_dma_buf = heap_caps_malloc(LCD101_DMA_BUF_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (!lcd_dma_buf) {
+        lcd_dma_failed = true;
+        ESP_LOGW(TAG, "No DMA buffer (%d bytes), using per-word SPI", (int)LCD101_DMA_BUF_SIZE);
+        return false;
+    }
+    ESP_LOGI(TAG, "DMA flush buffer: %d bytes, %d transactions max",
+             (int)LCD101_DMA_BUF_SIZE, (int)LCD101_MAX_TRANS);
+    return true;
+}
+
+static void lcd101_dma_send(void *ctx, const uint8_t *buf, size_t bits, bool last)
+{
+    spi_transaction_t *t = &lcd_trans[lcd_trans_queued];
+    memset(t, 0, sizeof(*t));
+    t->length = bits;
+    t->tx_buffer = buf;
+    t->user = last ? ctx : NULL;
+
+    if (spi_device_queue_trans(spi_lcd, t, portMAX_DELAY) == ESP_OK) {
+        lcd_trans_queued++;
+    } else if (last) {
+        // تراکنش صف نشد: CS و flush_ready را همین‌جا آزاد کن
+        lcd101_spi_post_cb(t);
+    }
+}
+
+// پنجره را در نوبت‌های ردیفی بسته‌بندی و ارسال می‌کند. هر نوبت منتظر
+// نوبت قبلی می‌ماند (یک بافر DMA)؛ نوبت آخر async است و در پایان
+// lv_disp_flush_ready(drv) صدا زده می‌شود. px == NULL یعنی پر کردن با fill.
+static bool lcd101_dma_window(lv_disp_drv_t *drv, uint16_t x1, uint16_t x2,
+                              uint16_t y1, uint16_t y2, const uint16_t *px, uint16_t fill)
+{
+    uint32_t width = (uint32_t)(x2 - x1 + 1);
+    if (!lcd101_dma_ready() || width > LCD101_DMA_PIXELS) {
+        return false;
+    }
+
+    uint32_t rows_per_pass = LCD101_DMA_PIXELS / width;
+    lcd9_writer_t w;
+
+    for (uint32_t y = y1; y <= y2; ) {
+        uint32_t rows = y2 - y + 1;
+        if (rows > rows_per_pass) rows = rows_per_pass;
+        size_t n = (size_t)width * rows;
+        bool last = (y + rows > y2);
+
+        lcd101_dma_wait();
+        lcd_dma_used = true;
+
+        lcd9_init(&w, lcd_dma_buf, LCD101_DMA_BUF_SIZE);
+        lcd9_window(&w, x1, x2, (uint16_t)y, (uint16_t)(y + rows - 1));
+        if (px) {
+            lcd9_pixels(&w, px, n, 0xFFFF);
+            px += n;
+        } else {
+            lcd9_fill(&w, fill, n);
+        }
+
+        lcd_job.drv = last ? drv : NULL;
+        gpio_set_level(GPIO_CE, 0);//CS=0;
+        lcd9_emit(&w, LCD101_TRANS_BYTES, lcd101_dma_send, &lcd_job);
+
+        y += rows;
+    }
+    return true;
+}
+
+// یک کلمه بعد از شروع DMA: ثبات‌های SPI دست درایور است، پس send2 نه
+static void lcd101_dma_word(uint8_t data, bool is_data)
+{
+    lcd9_writer_t w;
+
+    lcd101_dma_wait();
+    lcd9_init(&w, lcd_dma_buf, LCD101_DMA_BUF_SIZE);
+    if (is_data) lcd9_data(&w, data);
+    else lcd9_cmd(&w, data);
+
+    lcd_job.drv = NULL;
+    gpio_set_level(GPIO_CE, 0);//CS=0;
+    lcd9_emit(&w, LCD101_TRANS_BYTES, lcd101_dma_send, &lcd_job);
+    lcd101_dma_wait();
+}
+
 // توابع سازگار با کد قدیمی
 void _D(uint8_t data) {
   //  send_9bit(data, true);  // Data
+    if (lcd_dma_used) {
+        lcd101_dma_word(data, true);
+        return;
+    }
      send2(data, true);  // Data
 }
 
 void _C(uint8_t data) {
    // send_9bit(data, false); // Command
+    if (lcd_dma_used) {
+        lcd101_dma_word(data, false);
+        return;
+    }
     send2(data, false);  // Data
 }
 
@@ -432,6 +576,12 @@ void LCDClearScreen(uint16_t color) {
 
     uint8_t l_color, h_color;
 
+    // مسیر DMA: 9 بایت الگو برای هر 4 پیکسل، چند تراکنش بزرگ
+    if (lcd101_dma_window(NULL, 0x00, 0xA1, 0x00, 0x83, NULL, color ^ 0xFFFF)) {
+        lcd101_dma_wait();
+        return;
+    }
+
     // محدوده‌ها رو swap کنید برای landscape (ستون=0-161, ردیف=0-131)
     _C(0x2a); _D(0x00); _D(0x00); _D(0x00); _D(0xA1);  // Column: 0-161 (ارتفاع)
     _C(0x2b); _D(0x00); _D(0x00); _D(0x00); _D(0x83);  // Row: 0-131 (عرض)
@@ -500,8 +650,17 @@ void lcd101_flush_horizontal(lv_disp_drv_t * drv, const lv_area_t * area, lv_col
     
 }
 
+ // flush برای LVGL: پیکسل‌ها یک‌جا معکوس و بسته‌بندی می‌شوند و با DMA
+ // ارسال می‌شوند. lv_disp_flush_ready از callback پایان DMA صدا زده می‌شود
+ // تا LVGL هم‌زمان در بافر دوم رسم کند.
  void lcd101_flush(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map)
  {
+     if (lcd101_dma_window(drv, area->x1, area->x2, area->y1, area->y2,
+                           (const uint16_t *)color_map, 0)) {
+         return;
+     }
+
+     // بدون بافر DMA: ارسال کلمه به کلمه
      uint16_t temp;
      uint8_t data[4];
      int32_t x;
@@ -523,7 +682,8 @@ void lcd101_flush_horizontal(lv_disp_drv_t * drv, const lv_area_t * area, lv_col
                  cont=cont+1;
 
       }
-      
+
+      lv_disp_flush_ready(drv);
  }
 
 
@@ -0,0 +1,171 @@
+#include "lcd101_pack.h"
+#include <string.h>
+
+#define LCD9_NOP    0x00
+#define LCD9_CASET  0x2A
+#define LCD9_RASET  0x2B
+#define LCD9_RAMWR  0x2C
+
+void lcd9_init(lcd9_writer_t *w, uint8_t *buf, size_t cap) {
+    w->buf = buf;
+    w->cap = cap;
+    w->bits = 0;
+}
+
+// مسیر کند: یک کلمه 9 بیتی در هر موقعیت بیتی
+static inline void put9(lcd9_writer_t *w, uint16_t word) {
+    size_t byte = w->bits >> 3;
+    int off = (int)(w->bits & 7);
+    uint16_t v = (uint16_t)(word << (7 - off));
+
+    if (off) {
+        w->buf[byte] = (uint8_t)((w->buf[byte] & (0xFF << (8 - off))) | (v >> 8));
+    } else {
+        w->buf[byte] = (uint8_t)(v >> 8);
+    }
+    w->buf[byte + 1] = (uint8_t)v;
+    w->bits += 9;
+}
+
+bool lcd9_cmd(lcd9_writer_t *w, uint8_t cmd) {
+    if (lcd9_space(w) < 1) return false;
+    put9(w, cmd);
+    return true;
+}
+
+bool lcd9_data(lcd9_writer_t *w, uint8_t data) {
+    if (lcd9_space(w) < 1) return false;
+    put9(w, 0x100 | data);
+    return true;
+}
+
+bool lcd9_window(lcd9_writer_t *w, uint16_t x1, uint16_t x2, uint16_t y1, uint16_t y2) {
+    size_t pad = (8 - (lcd9_words(w) + 11) % 8) % 8;
+    if (lcd9_space(w) < pad + 11) return false;
+
+    while (pad--) {
+        put9(w, LCD9_NOP);
+    }
+
+    put9(w, LCD9_CASET);
+    put9(w, 0x100 | (x1 >> 8));
+    put9(w, 0x100 | (x1 & 0xFF));
+    put9(w, 0x100 | (x2 >> 8));
+    put9(w, 0x100 | (x2 & 0xFF));
+
+    put9(w, LCD9_RASET);
+    put9(w, 0x100 | (y1 >> 8));
+    put9(w, 0x100 | (y1 & 0xFF));
+    put9(w, 0x100 | (y2 >> 8));
+    put9(w, 0x100 | (y2 & 0xFF));
+
+    put9(w, LCD9_RAMWR);
+    return true;
+}
+
+// مسیر سریع: 4 پیکسل = 8 کلمه داده = دقیقاً 9 بایت
+// 7 کلمه اول (63 بیت) + بیت D/C کلمه هشتم در یک uint64 و بایت آخر جدا
+static inline void pack4(uint8_t *out, uint16_t p0, uint16_t p1, uint16_t p2, uint16_t p3) {
+    uint64_t v = 0x100 | (p0 >> 8);
+    v = (v << 9) | 0x100 | (p0 & 0xFF);
+    v = (v << 9) | 0x100 | (p1 >> 8);
+    v = (v << 9) | 0x100 | (p1 & 0xFF);
+    v = (v << 9) | 0x100 | (p2 >> 8);
+    v = (v << 9) | 0x100 | (p2 & 0xFF);
+    v = (v << 9) | 0x100 | (p3 >> 8);
+    v = (v << 1) | 1;
+
+    out[0] = (uint8_t)(v >> 56);
+    out[1] = (uint8_t)(v >> 48);
+    out[2] = (uint8_t)(v >> 40);
+    out[3] = (uint8_t)(v >> 32);
+    out[4] = (uint8_t)(v >> 24);
+    out[5] = (uint8_t)(v >> 16);
+    out[6] = (uint8_t)(v >> 8);
+    out[7] = (uint8_t)v;
+    out[8] = (uint8_t)p3;
+}
+
+size_t lcd9_pixels(lcd9_writer_t *w, const uint16_t *px, size_t n, uint16_t xor_mask) {
+    size_t space = lcd9_space(w) / 2;
+    if (n > space) n = space;
+
+    size_t i = 0;
+
+    // تا رسیدن به مرز بایت (حداکثر 3 پیکسل)
+    while (i < n && (w->bits & 7)) {
+        uint16_t c = px[i++] ^ xor_mask;
+        put9(w, 0x100 | (c >> 8));
+        put9(w, 0x100 | (c & 0xFF));
+    }
+
+    if (i < n) {
+        uint8_t *out = w->buf + (w->bits >> 3);
+        size_t groups = (n - i) / 4;
+        for (size_t g = 0; g < groups; g++, i += 4, out += 9) {
+            pack4(out, px[i] ^ xor_mask, px[i + 1] ^ xor_mask,
+                  px[i + 2] ^ xor_mask, px[i + 3] ^ xor_mask);
+        }
+        w->bits += groups * 72;
+    }
+
+    while (i < n) {
+        uint16_t c = px[i++] ^ xor_mask;
+        put9(w, 0x100 | (c >> 8));
+        put9(w, 0x100 | (c & 0xFF));
+    }
+    return n;
+}
+
+size_t lcd9_fill(lcd9_writer_t *w, uint16_t color, size_t n) {
+    size_t space = lcd9_space(w) / 2;
+    if (n > space) n = space;
+
+    size_t i = 0;
+    while (i < n && (w->bits & 7)) {
+        put9(w, 0x100 | (color >> 8));
+        put9(w, 0x100 | (color & 0xFF));
+        i++;
+    }
+
+    if (i < n) {
+        // الگوی 9 بایتی یک بار ساخته و تکرار می‌شود
+        uint8_t pattern[9];
+        pack4(pattern, color, color, color, color);
+
+        uint8_t *out = w->buf + (w->bits >> 3);
+        size_t groups = (n - i) / 4;
+        for (size_t g = 0; g < groups; g++, out += 9) {
+            memcpy(out, pattern, 9);
+        }
+        w->bits += groups * 72;
+        i += groups * 4;
+    }
+
+    while (i < n) {
+        put9(w, 0x100 | (color >> 8));
+        put9(w, 0x100 | (color & 0xFF));
+        i++;
+    }
+    return n;
+}
+
+int lcd9_emit(const lcd9_writer_t *w, size_t max_bytes, lcd9_send_fn send, void *ctx) {
+    size_t chunk = (max_bytes / 9) * 9;
+    if (chunk == 0) chunk = 9;
+
+    size_t chunk_bits = chunk * 8;
+    size_t off = 0;
+    int count = 0;
+
+    while (w->bits - off > chunk_bits) {
+        send(ctx, w->buf + off / 8, chunk_bits, false);
+        off += chunk_bits;
+        count++;
+    }
+    if (w->bits > off) {
+        send(ctx, w->buf + off / 8, w->bits - off, true);
+        count++;
+    }
+    return count;
+}
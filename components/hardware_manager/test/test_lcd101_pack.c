@@ -0,0 +1,327 @@
+// تست بسته‌بندی 9 بیتی روی host با یک sink جعلی SPI و اندازه‌گیری سرعت
+#include "lcd101_pack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#define FRAME_W 160
+#define FRAME_H 128
+#define FRAME_PIXELS (FRAME_W * FRAME_H)
+
+// ==================== مرجع: همان ترتیب _C/_D قدیمی ====================
+
+typedef struct {
+    uint16_t *words;    // بیت 8 = D/C
+    size_t len;
+    size_t cap;
+} word_list_t;
+
+static void ref_put(word_list_t *l, uint16_t word) {
+    if (l->len == l->cap) {
+        l->cap = l->cap ? l->cap * 2 : 256;
+        l->words = realloc(l->words, l->cap * sizeof(uint16_t));
+    }
+    l->words[l->len++] = word;
+}
+
+static void ref_window(word_list_t *l, uint16_t x1, uint16_t x2, uint16_t y1, uint16_t y2) {
+    ref_put(l, 0x2A);
+    ref_put(l, 0x100 | (x1 >> 8)); ref_put(l, 0x100 | (x1 & 0xFF));
+    ref_put(l, 0x100 | (x2 >> 8)); ref_put(l, 0x100 | (x2 & 0xFF));
+    ref_put(l, 0x2B);
+    ref_put(l, 0x100 | (y1 >> 8)); ref_put(l, 0x100 | (y1 & 0xFF));
+    ref_put(l, 0x100 | (y2 >> 8)); ref_put(l, 0x100 | (y2 & 0xFF));
+    ref_put(l, 0x2C);
+}
+
+static void ref_pixels(word_list_t *l, const uint16_t *px, size_t n, uint16_t xor_mask) {
+    for (size_t i = 0; i < n; i++) {
+        uint16_t c = px[i] ^ xor_mask;
+        ref_put(l, 0x100 | (c >> 8));
+        ref_put(l, 0x100 | (c & 0xFF));
+    }
+}
+
+// ==================== sink جعلی SPI ====================
+
+// تراکنش‌ها را مثل خط SPI پشت سر هم به کلمه‌های 9 بیتی برمی‌گرداند
+typedef struct {
+    word_list_t out;
+    int transactions;
+    int lasts;
+    size_t bits;
+    uint32_t acc;
+    int acc_bits;
+    bool split_ok;
+} mock_spi_t;
+
+static void mock_send(void *ctx, const uint8_t *buf, size_t bits, bool last) {
+    mock_spi_t *spi = ctx;
+    spi->transactions++;
+    spi->bits += bits;
+    if (last) spi->lasts++;
+    // CS بین تراکنش‌ها بالا می‌رود: هر تکه باید روی مرز کلمه تمام شود
+    if (!last && (bits % 9) != 0) spi->split_ok = false;
+
+    for (size_t i = 0; i < bits; i++) {
+        int bit = (buf[i / 8] >> (7 - (i % 8))) & 1;
+        spi->acc = (spi->acc << 1) | (uint32_t)bit;
+        if (++spi->acc_bits == 9) {
+            ref_put(&spi->out, (uint16_t)spi->acc);
+            spi->acc = 0;
+            spi->acc_bits = 0;
+        }
+    }
+}
+
+static void mock_init(mock_spi_t *spi) {
+    memset(spi, 0, sizeof(*spi));
+    spi->split_ok = true;
+}
+
+// کلمه‌های NOP ابتدای پنجره را حذف می‌کند (هم‌ترازسازی)
+static size_t skip_nops(const word_list_t *l, size_t i) {
+    while (i < l->len && l->words[i] == 0x000) i++;
+    return i;
+}
+
+static bool same_words(const word_list_t *got, size_t start, const word_list_t *want) {
+    if (got->len - start != want->len) return false;
+    if (want->len == 0) return true;
+    return memcmp(got->words + start, want->words, want->len * sizeof(uint16_t)) == 0;
+}
+
+static uint32_t rng = 12345;
+static uint16_t rnd16(void) {
+    rng = rng * 1103515245u + 12345u;
+    return (uint16_t)(rng >> 8);
+}
+
+// ==================== تست‌ها ====================
+
+static void test_single_words(void) {
+    uint8_t buf[64];
+    lcd9_writer_t w;
+    lcd9_init(&w, buf, sizeof(buf));
+
+    CHECK(lcd9_cmd(&w, 0x2C));
+    CHECK(lcd9_data(&w, 0xA5));
+    CHECK(w.bits == 18);
+    // 000101100 110100101
+    CHECK(buf[0] == 0x16);
+    CHECK(buf[1] == 0x69);
+    CHECK((buf[2] & 0xC0) == 0x40);
+}
+
+// همه طول‌ها و همه آفست‌های بیتی شروع، مقایسه با مرجع کلمه به کلمه
+static void test_pixels_all_offsets(void) {
+    uint16_t px[67];
+    for (size_t i = 0; i < 67; i++) px[i] = rnd16();
+
+    uint8_t buf[256];
+    for (int lead = 0; lead < 9; lead++) {
+        for (size_t n = 0; n <= 67; n++) {
+            lcd9_writer_t w;
+            word_list_t ref = {0};
+            mock_spi_t spi;
+            mock_init(&spi);
+            lcd9_init(&w, buf, sizeof(buf));
+
+            for (int k = 0; k < lead; k++) {
+                lcd9_data(&w, (uint8_t)k);
+                ref_put(&ref, 0x100 | k);
+            }
+            CHECK(lcd9_pixels(&w, px, n, 0xFFFF) == n);
+            ref_pixels(&ref, px, n, 0xFFFF);
+
+            CHECK(w.bits == ref.len * 9);
+            lcd9_emit(&w, sizeof(buf), mock_send, &spi);
+            CHECK(same_words(&spi.out, 0, &ref));
+            free(ref.words);
+            free(spi.out.words);
+        }
+    }
+}
+
+static void test_window_alignment(void) {
+    uint8_t buf[512];
+    for (int lead = 0; lead < 9; lead++) {
+        lcd9_writer_t w;
+        lcd9_init(&w, buf, sizeof(buf));
+        for (int k = 0; k < lead; k++) lcd9_cmd(&w, 0x00);
+
+        CHECK(lcd9_window(&w, 1, 160, 2, 127));
+        // بعد از RAMWR جریان روی مرز بایت است و پیکسل‌ها از مسیر سریع می‌روند
+        CHECK((w.bits & 7) == 0);
+        CHECK(lcd9_words(&w) - lead <= LCD9_WINDOW_WORDS);
+
+        word_list_t ref = {0};
+        ref_window(&ref, 1, 160, 2, 127);
+        mock_spi_t spi;
+        mock_init(&spi);
+        lcd9_emit(&w, sizeof(buf), mock_send, &spi);
+        CHECK(same_words(&spi.out, skip_nops(&spi.out, 0), &ref));
+        free(ref.words);
+        free(spi.out.words);
+    }
+}
+
+static void test_fill(void) {
+    uint8_t a[256], b[256];
+    uint16_t px[100];
+    for (int i = 0; i < 100; i++) px[i] = 0x1234;
+
+    for (int lead = 0; lead < 5; lead++) {
+        lcd9_writer_t wa, wb;
+        lcd9_init(&wa, a, sizeof(a));
+        lcd9_init(&wb, b, sizeof(b));
+        for (int k = 0; k < lead; k++) {
+            lcd9_data(&wa, 7);
+            lcd9_data(&wb, 7);
+        }
+        CHECK(lcd9_fill(&wa, 0x1234, 100) == 100);
+        CHECK(lcd9_pixels(&wb, px, 100, 0) == 100);
+        CHECK(wa.bits == wb.bits);
+        CHECK(memcmp(a, b, LCD9_PACKED_BYTES(lcd9_words(&wa))) == 0);
+    }
+}
+
+// بافر کوچک: فقط به اندازه جا پیکسل می‌گیرد و از مرز بافر رد نمی‌شود
+static void test_capacity(void) {
+    uint8_t buf[64 + 1];
+    uint16_t px[100] = {0};
+    buf[64] = 0xEE;
+
+    lcd9_writer_t w;
+    lcd9_init(&w, buf, 64);
+    size_t n = lcd9_pixels(&w, px, 100, 0xFFFF);
+    CHECK(n == (64 * 8 / 9) / 2);
+    CHECK(w.bits <= 64 * 8);
+    CHECK(buf[64] == 0xEE);
+    CHECK(lcd9_pixels(&w, px, 100, 0) == 0);
+}
+
+// فریم کامل از طریق sink جعلی با تکه‌های کوچک
+static void test_frame_split(void) {
+    uint16_t *frame = malloc(FRAME_PIXELS * sizeof(uint16_t));
+    for (int i = 0; i < FRAME_PIXELS; i++) frame[i] = rnd16();
+
+    size_t cap = LCD9_PACKED_BYTES(LCD9_WINDOW_WORDS + FRAME_PIXELS * 2);
+    uint8_t *buf = malloc(cap);
+    lcd9_writer_t w;
+    lcd9_init(&w, buf, cap);
+    CHECK(lcd9_window(&w, 0, FRAME_W - 1, 0, FRAME_H - 1));
+    CHECK(lcd9_pixels(&w, frame, FRAME_PIXELS, 0xFFFF) == FRAME_PIXELS);
+
+    word_list_t ref = {0};
+    ref_window(&ref, 0, FRAME_W - 1, 0, FRAME_H - 1);
+    ref_pixels(&ref, frame, FRAME_PIXELS, 0xFFFF);
+
+    size_t sizes[] = { 9, 100, 4092, 16380, cap };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        mock_spi_t spi;
+        mock_init(&spi);
+        int count = lcd9_emit(&w, sizes[s], mock_send, &spi);
+        CHECK(count == spi.transactions);
+        CHECK(spi.lasts == 1);
+        CHECK(spi.split_ok);
+        CHECK(spi.bits == w.bits);
+        CHECK(same_words(&spi.out, skip_nops(&spi.out, 0), &ref));
+        free(spi.out.words);
+    }
+
+    free(ref.words);
+    free(buf);
+    free(frame);
+}
+
+// ==================== سرعت ====================
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench(void) {
+    uint16_t *frame = malloc(FRAME_PIXELS * sizeof(uint16_t));
+    for (int i = 0; i < FRAME_PIXELS; i++) frame[i] = rnd16();
+
+    size_t cap = LCD9_PACKED_BYTES(LCD9_WINDOW_WORDS + FRAME_PIXELS * 2);
+    uint8_t *buf = malloc(cap);
+    lcd9_writer_t w;
+    const int frames = 2000;
+    volatile uint8_t sink = 0;
+
+    // مسیر قدیمی: یک کلمه در هر فراخوانی (مثل _D برای هر بایت)
+    double t0 = now_sec();
+    for (int f = 0; f < frames; f++) {
+        lcd9_init(&w, buf, cap);
+        lcd9_window(&w, 0, FRAME_W - 1, 0, FRAME_H - 1);
+        for (int i = 0; i < FRAME_PIXELS; i++) {
+            uint16_t c = frame[i] ^ 0xFFFF;
+            lcd9_data(&w, c >> 8);
+            lcd9_data(&w, c & 0xFF);
+        }
+        sink ^= buf[f % cap];
+    }
+    double per_word = (now_sec() - t0) / frames;
+
+    t0 = now_sec();
+    for (int f = 0; f < frames; f++) {
+        lcd9_init(&w, buf, cap);
+        lcd9_window(&w, 0, FRAME_W - 1, 0, FRAME_H - 1);
+        lcd9_pixels(&w, frame, FRAME_PIXELS, 0xFFFF);
+        sink ^= buf[f % cap];
+    }
+    double packed = (now_sec() - t0) / frames;
+
+    mock_spi_t spi;
+    mock_init(&spi);
+    int trans = lcd9_emit(&w, 16380, mock_send, &spi);
+    free(spi.out.words);
+
+    double mb = FRAME_PIXELS * 2 / 1e6;
+    printf("frame %dx%d (%d bytes in, %zu bytes packed)\n",
+           FRAME_W, FRAME_H, FRAME_PIXELS * 2, LCD9_PACKED_BYTES(lcd9_words(&w)));
+    printf("  per-word pack: %8.1f us/frame  %7.1f MB/s\n", per_word * 1e6, mb / per_word);
+    printf("  4-pixel pack:  %8.1f us/frame  %7.1f MB/s  (x%.1f)\n",
+           packed * 1e6, mb / packed, per_word / packed);
+    printf("  SPI transactions: %d (was %d with one per 9-bit word)\n",
+           trans, FRAME_PIXELS * 2 + 11);
+    printf("  wire time at 40 MHz: %.2f ms/frame\n", w.bits / 40e6 * 1e3);
+
+    (void)sink;
+    free(buf);
+    free(frame);
+}
+
+int main(int argc, char **argv) {
+    test_single_words();
+    test_pixels_all_offsets();
+    test_window_alignment();
+    test_fill();
+    test_capacity();
+    test_frame_split();
+
+    if (failures) {
+        printf("lcd101_pack: %d checks failed\n", failures);
+        return 1;
+    }
+    printf("lcd101_pack: all tests passed\n");
+
+    if (argc < 2 || strcmp(argv[1], "--no-bench") != 0) {
+        bench();
+    }
+    return 0;
+}
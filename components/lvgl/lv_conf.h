@@ -82,6 +82,11 @@
 /*Input device read period in milliseconds*/
 #define LV_INDEV_DEF_READ_PERIOD 30     /*[ms]*/
 
+/*Track invalidated areas in 16x16 tiles instead of a list of LV_INV_BUF_SIZE areas.
+ *Many small updates are merged in linear time and never fall back to redrawing the whole screen.
+ *Needs 2 bytes per tile from the LVGL heap (e.g. 1.2 kB for 480x320)*/
+#define LV_INV_TILES 1
+
 /*Use a custom tick source that tells the elapsed time in milliseconds.
  *It removes the need to manually update the tick with `lv_tick_inc()`)*/
 #define LV_TICK_CUSTOM 0
@@ -117,6 +122,16 @@
     * radius * 4 bytes are used per circle (the most often used radiuses are saved)
     * 0: to disable caching */
     #define LV_CIRCLE_CACHE_SIZE 4
+
+    /*Keep rotated/zoomed images to blend them again without resampling.
+    *LV_IMG_TRANSFORM_CACHE_SIZE is the memory budget in bytes, the least recently used images are dropped first.
+    *(sizeof(lv_color_t) + 1) bytes are used per pixel of the transformed image's bounding box.
+    *The images are allocated with `LV_IMG_CACHE_ALLOC` if it's defined.
+    *0: to disable caching*/
+    #define LV_IMG_TRANSFORM_CACHE_SIZE (128 * 1024)
+
+    /*Round the angle of the cached images to this many 0.1 degrees so that close angles share an image*/
+    #define LV_IMG_TRANSFORM_CACHE_ANGLE_STEP 10
 #endif /*LV_DRAW_COMPLEX*/
 
 /**
@@ -140,7 +155,16 @@
  *With complex image decoders (e.g. PNG or JPG) caching can save the continuous open/decode of images.
  *However the opened images might consume additional RAM.
  *0: to disable caching*/
-#define LV_IMG_CACHE_DEF_SIZE 0
+#define LV_IMG_CACHE_DEF_SIZE 8
+
+/*Memory budget of the image cache in bytes. Least recently used images are closed
+ *when the decoded data kept open by the cache would exceed it.
+ *0: limited only by LV_IMG_CACHE_DEF_SIZE*/
+#define LV_IMG_CACHE_MEM_SIZE (256 * 1024)
+
+/*Allocate fully decoded images (e.g. PNG) kept by the cache here instead of the LVGL heap.
+ *Must be freeable with `lv_mem_free`.*/
+#define LV_IMG_CACHE_ALLOC(size) heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
 
 /*Number of stops allowed per gradient. Increase this to allow more stops.
  *This adds (sizeof(lv_color_t) + 1) bytes per additional stop*/
@@ -282,6 +306,14 @@
 /*1: Draw random colored rectangles over the redrawn areas*/
 #define LV_USE_REFR_DEBUG 0
 
+/*Cache the resolved style properties of the objects to not search the styles and the parents on every draw.
+ *Each object gets a cache with this many entries (8 bytes each on 32-bit MCUs) when it's drawn first.
+ *At most 3/4 of them are used, and a drawn widget reads about 40 properties, so 64 is needed for most lookups to hit.
+ *A cache is dropped when the styles, the state or the parent of its object (or of a parent) change.
+ *Changes of shared styles must be reported with `lv_obj_report_style_change()`. Must be a power of 2.
+ *0: to disable caching*/
+#define LV_OBJ_STYLE_CACHE_SIZE 0
+
 /*Change the built in (v)snprintf functions*/
 #define LV_SPRINTF_CUSTOM 0
 #if LV_SPRINTF_CUSTOM
@@ -438,6 +438,7 @@ static void lv_obj_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
     lv_obj_enable_style_refresh(false); /*No need to refresh the style because the object will be deleted*/
     lv_obj_remove_style_all(obj);
     lv_obj_enable_style_refresh(true);
+    _lv_obj_style_cache_free(obj);
 
     /*Remove the animations from this object*/
     lv_anim_del(obj, NULL);
@@ -914,6 +915,9 @@ static void lv_obj_set_state(lv_obj_t * obj, lv_state_t new_state)
 
     lv_mem_buf_release(ts);
 
+    /*The transition styles are changed and the children might inherit style properties of the new state*/
+    _lv_obj_style_cache_invalidate(obj, LV_STYLE_PROP_ANY);
+
     if(cmp_res == _LV_STYLE_STATE_CMP_DIFF_REDRAW) {
         lv_obj_invalidate(obj);
     }
@@ -45,6 +45,10 @@ typedef enum {
 static lv_style_t * get_local_style(lv_obj_t * obj, lv_style_selector_t selector);
 static _lv_obj_style_t * get_trans_style(lv_obj_t * obj, uint32_t part);
 static lv_style_res_t get_prop_core(const lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop, lv_style_value_t * v);
+static lv_style_value_t resolve_prop(const lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop);
+#if LV_OBJ_STYLE_CACHE_SIZE
+    static _lv_obj_style_cache_entry_t * get_cache_entry(const lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop);
+#endif
 static void report_style_change_core(void * style, lv_obj_t * obj);
 static void refresh_children_style(lv_obj_t * obj);
 static bool trans_del(lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop, trans_t * tr_limit);
@@ -59,6 +63,7 @@ static void fade_in_anim_ready(lv_anim_t * a);
  *  STATIC VARIABLES
  **********************/
 static bool style_refr = true;
+static lv_obj_style_cache_monitor_t cache_monitor;
 
 /**********************
  *      MACROS
@@ -168,6 +173,9 @@ void lv_obj_refresh_style(lv_obj_t * obj, lv_style_selector_t selector, lv_style
 {
     LV_ASSERT_OBJ(obj, MY_CLASS);
 
+    /*Drop the cached values even if refreshing is disabled, they are read before the refresh*/
+    _lv_obj_style_cache_invalidate(obj, prop);
+
     if(!style_refr) return;
 
     lv_obj_invalidate(obj);
@@ -222,49 +230,25 @@ void lv_obj_enable_style_refresh(bool en)
 
 lv_style_value_t lv_obj_get_style_prop(const lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop)
 {
-    lv_style_value_t value_act;
-    bool inheritable = lv_style_prop_has_flag(prop, LV_STYLE_PROP_INHERIT);
-    lv_style_res_t found = LV_STYLE_RES_NOT_FOUND;
-    while(obj) {
-        found = get_prop_core(obj, part, prop, &value_act);
-        if(found == LV_STYLE_RES_FOUND) break;
-        if(!inheritable) break;
-
-        /*If not found, check the `MAIN` style first*/
-        if(found != LV_STYLE_RES_INHERIT && part != LV_PART_MAIN) {
-            part = LV_PART_MAIN;
-            continue;
-        }
+#if LV_OBJ_STYLE_CACHE_SIZE
+    _lv_obj_style_cache_entry_t * entry = get_cache_entry(obj, part, prop);
+    if(entry == NULL) return resolve_prop(obj, part, prop);
 
-        /*Check the parent too.*/
-        obj = lv_obj_get_parent(obj);
+    if(entry->prop != LV_STYLE_PROP_INV) {
+        cache_monitor.hit++;
+        return entry->value;
     }
 
-    if(found != LV_STYLE_RES_FOUND) {
-        if(part == LV_PART_MAIN && (prop == LV_STYLE_WIDTH || prop == LV_STYLE_HEIGHT)) {
-            const lv_obj_class_t * cls = obj->class_p;
-            while(cls) {
-                if(prop == LV_STYLE_WIDTH) {
-                    if(cls->width_def != 0) break;
-                }
-                else {
-                    if(cls->height_def != 0) break;
-                }
-                cls = cls->base_class;
-            }
-
-            if(cls) {
-                value_act.num = prop == LV_STYLE_WIDTH ? cls->width_def : cls->height_def;
-            }
-            else {
-                value_act.num = 0;
-            }
-        }
-        else {
-            value_act = lv_style_prop_get_default(prop);
-        }
-    }
-    return value_act;
+    /*Save the value in the free entry*/
+    cache_monitor.miss++;
+    entry->value = resolve_prop(obj, part, prop);
+    entry->prop = prop;
+    entry->part = part >> 16;
+    obj->style_cache->cnt++;
+    return entry->value;
+#else
+    return resolve_prop(obj, part, prop);
+#endif
 }
 
 void lv_obj_set_local_style_prop(lv_obj_t * obj, lv_style_prop_t prop, lv_style_value_t value,
@@ -314,7 +298,9 @@ bool lv_obj_remove_local_style_prop(lv_obj_t * obj, lv_style_prop_t prop, lv_sty
     /*The style is not found*/
     if(i == obj->style_cnt) return false;
 
-    return lv_style_remove_prop(obj->styles[i].style, prop);
+    bool removed = lv_style_remove_prop(obj->styles[i].style, prop);
+    if(removed) _lv_obj_style_cache_invalidate(obj, prop);
+    return removed;
 }
 
 void _lv_obj_style_create_transition(lv_obj_t * obj, lv_part_t part, lv_state_t prev_state, lv_state_t new_state,
@@ -472,6 +458,52 @@ void lv_obj_fade_out(lv_obj_t * obj, uint32_t time, uint32_t delay)
     lv_anim_start(&a);
 }
 
+void lv_obj_style_cache_monitor(lv_obj_style_cache_monitor_t * mon_p)
+{
+    *mon_p = cache_monitor;
+}
+
+void lv_obj_style_cache_monitor_reset(void)
+{
+    lv_memset_00(&cache_monitor, sizeof(cache_monitor));
+}
+
+void _lv_obj_style_cache_invalidate(lv_obj_t * obj, lv_style_prop_t prop)
+{
+#if LV_OBJ_STYLE_CACHE_SIZE
+    _lv_obj_style_cache_t * cache = obj->style_cache;
+    if(cache && cache->cnt) {
+        lv_memset_00(cache->entries, sizeof(cache->entries));
+        cache->cnt = 0;
+        cache_monitor.invalidated++;
+    }
+
+    /*The children might inherit the property*/
+    if(lv_style_prop_has_flag(prop, LV_STYLE_PROP_INHERIT)) {
+        uint32_t i;
+        uint32_t child_cnt = lv_obj_get_child_cnt(obj);
+        for(i = 0; i < child_cnt; i++) {
+            _lv_obj_style_cache_invalidate(obj->spec_attr->children[i], prop);
+        }
+    }
+#else
+    LV_UNUSED(obj);
+    LV_UNUSED(prop);
+#endif
+}
+
+void _lv_obj_style_cache_free(lv_obj_t * obj)
+{
+#if LV_OBJ_STYLE_CACHE_SIZE
+    if(obj->style_cache) {
+        lv_mem_free(obj->style_cache);
+        obj->style_cache = NULL;
+    }
+#else
+    LV_UNUSED(obj);
+#endif
+}
+
 lv_state_t lv_obj_style_get_selector_state(lv_style_selector_t selector)
 {
     return selector & 0xFFFF;
@@ -631,6 +663,105 @@ static lv_style_res_t get_prop_core(const lv_obj_t * obj, lv_part_t part, lv_sty
     else return LV_STYLE_RES_NOT_FOUND;
 }
 
+/**
+ * Get the value of a property from the styles of an object, its parents or the defaults
+ * @param obj   pointer to an object
+ * @param part  a part of the object
+ * @param prop  the property
+ * @return      the value of the property
+ */
+static lv_style_value_t resolve_prop(const lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop)
+{
+    lv_style_value_t value_act;
+    bool inheritable = lv_style_prop_has_flag(prop, LV_STYLE_PROP_INHERIT);
+    lv_style_res_t found = LV_STYLE_RES_NOT_FOUND;
+    while(obj) {
+        found = get_prop_core(obj, part, prop, &value_act);
+        if(found == LV_STYLE_RES_FOUND) break;
+        if(!inheritable) break;
+
+        /*If not found, check the `MAIN` style first*/
+        if(found != LV_STYLE_RES_INHERIT && part != LV_PART_MAIN) {
+            part = LV_PART_MAIN;
+            continue;
+        }
+
+        /*Check the parent too.*/
+        obj = lv_obj_get_parent(obj);
+    }
+
+    if(found != LV_STYLE_RES_FOUND) {
+        if(part == LV_PART_MAIN && (prop == LV_STYLE_WIDTH || prop == LV_STYLE_HEIGHT)) {
+            const lv_obj_class_t * cls = obj->class_p;
+            while(cls) {
+                if(prop == LV_STYLE_WIDTH) {
+                    if(cls->width_def != 0) break;
+                }
+                else {
+                    if(cls->height_def != 0) break;
+                }
+                cls = cls->base_class;
+            }
+
+            if(cls) {
+                value_act.num = prop == LV_STYLE_WIDTH ? cls->width_def : cls->height_def;
+            }
+            else {
+                value_act.num = 0;
+            }
+        }
+        else {
+            value_act = lv_style_prop_get_default(prop);
+        }
+    }
+    return value_act;
+}
+
+#if LV_OBJ_STYLE_CACHE_SIZE
+/**
+ * Find the cache entry of a property with linear probing
+ * @param obj   pointer to an object
+ * @param part  a part of the object
+ * @param prop  the property
+ * @return      the entry of `prop`, a free entry to save it, or NULL if it can't be cached
+ */
+static _lv_obj_style_cache_entry_t * get_cache_entry(const lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop)
+{
+    /*Skipping the transitions is temporary. Parts with states are invalid but don't mix them with the valid parts*/
+    if(obj->skip_trans || (part & ~LV_PART_ANY) != 0) return NULL;
+
+    _lv_obj_style_cache_t * cache = obj->style_cache;
+    if(cache == NULL) {
+        cache = lv_mem_alloc(sizeof(_lv_obj_style_cache_t));
+        if(cache == NULL) return NULL;
+        lv_memset_00(cache, sizeof(_lv_obj_style_cache_t));
+        cache->state = obj->state;
+        ((lv_obj_t *)obj)->style_cache = cache;
+    }
+    else if(cache->state != obj->state) {
+        /*The state is changed temporarily while creating transitions*/
+        if(cache->cnt) cache_monitor.invalidated++;
+        lv_memset_00(cache->entries, sizeof(cache->entries));
+        cache->cnt = 0;
+        cache->state = obj->state;
+    }
+
+    uint8_t part_id = part >> 16;
+    uint32_t i = ((((uint32_t)part_id << 16) | prop) * 2654435761U) >> 16;
+    while(1) {
+        _lv_obj_style_cache_entry_t * entry = &cache->entries[i & (LV_OBJ_STYLE_CACHE_SIZE - 1)];
+        if(entry->prop == prop && entry->part == part_id) return entry;
+        if(entry->prop == LV_STYLE_PROP_INV) {
+            /*Keep a quarter of the entries free to find the properties quickly*/
+            if(cache->cnt < LV_OBJ_STYLE_CACHE_SIZE * 3 / 4) return entry;
+            cache_monitor.miss++;
+            return NULL;
+        }
+        i++;
+    }
+}
+#endif
+
 /**
  * Refresh the style of all children of an object. (Called recursively)
  * @param style refresh objects only with this
@@ -701,6 +832,7 @@ static bool trans_del(lv_obj_t * obj, lv_part_t part, lv_style_prop_t prop, tran
                     lv_style_remove_prop(obj->styles[i].style, tr->prop);
                 }
             }
+            _lv_obj_style_cache_invalidate(obj, tr->prop);
 
             /*Free the transition descriptor too*/
             lv_anim_del(tr, NULL);
@@ -795,7 +927,7 @@ static void trans_anim_start_cb(lv_anim_t * a)
 
     _lv_obj_style_t * style_trans = get_trans_style(tr->obj, tr->selector);
     lv_style_set_prop(style_trans->style, tr->prop, tr->start_value);   /*Be sure `trans_style` has a valid value*/
-
+    _lv_obj_style_cache_invalidate(tr->obj, tr->prop);
 }
 
 static void trans_anim_ready_cb(lv_anim_t * a)
@@ -825,6 +957,7 @@ static void trans_anim_ready_cb(lv_anim_t * a)
 
                 _lv_obj_style_t * obj_style = &obj->styles[i];
                 lv_style_remove_prop(obj_style->style, prop);
+                _lv_obj_style_cache_invalidate(obj, prop);
 
                 if(lv_style_is_empty(obj->styles[i].style)) {
                     lv_obj_remove_style(obj, obj_style->style, obj_style->selector);
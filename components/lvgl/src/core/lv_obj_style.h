@@ -54,6 +54,27 @@ typedef struct {
 #endif
 } _lv_obj_style_transition_dsc_t;
 
+#if LV_OBJ_STYLE_CACHE_SIZE
+typedef struct {
+    lv_style_value_t value;
+    lv_style_prop_t prop;   /*LV_STYLE_PROP_INV: unused entry*/
+    uint8_t part;           /*The part shifted right by 16*/
+} _lv_obj_style_cache_entry_t;
+
+/*Resolved style properties of an object in a given state. An open addressing hash table of (part, property)*/
+typedef struct _lv_obj_style_cache_t {
+    lv_state_t state;       /*The state of the object when the entries were saved*/
+    uint16_t cnt;           /*Number of used entries*/
+    _lv_obj_style_cache_entry_t entries[LV_OBJ_STYLE_CACHE_SIZE];
+} _lv_obj_style_cache_t;
+#endif
+
+typedef struct {
+    uint32_t hit;           /**< Style properties read from the caches*/
+    uint32_t miss;          /**< Style properties resolved from the styles*/
+    uint32_t invalidated;   /**< Caches dropped because a style, the state or the parent of their object has changed*/
+} lv_obj_style_cache_monitor_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -180,6 +201,32 @@ void _lv_obj_style_create_transition(struct _lv_obj_t * obj, lv_part_t part, lv_
  */
 _lv_style_state_cmp_t _lv_obj_style_state_compare(struct _lv_obj_t * obj, lv_state_t state1, lv_state_t state2);
 
+/**
+ * Give information about the style caches of the objects
+ * @param mon_p     pointer to a lv_obj_style_cache_monitor_t variable, the counters will be stored here
+ */
+void lv_obj_style_cache_monitor(lv_obj_style_cache_monitor_t * mon_p);
+
+/**
+ * Reset the counters of the style caches
+ */
+void lv_obj_style_cache_monitor_reset(void);
+
+/**
+ * Drop the cached style properties of an object, and of its children too if they might inherit `prop`.
+ * Called internally when the styles, the state or the parent of the object change.
+ * @param obj       pointer to an object
+ * @param prop      the changed property or `LV_STYLE_PROP_ANY`
+ */
+void _lv_obj_style_cache_invalidate(struct _lv_obj_t * obj, lv_style_prop_t prop);
+
+/**
+ * Free the style cache of an object.
+ * Called internally when the object is deleted.
+ * @param obj       pointer to an object
+ */
+void _lv_obj_style_cache_free(struct _lv_obj_t * obj);
+
 /**
  * Fade in an an object and all its children.
  * @param obj       the object to fade in
@@ -26,10 +26,32 @@
 /*********************
  *      DEFINES
  *********************/
+#if LV_INV_TILES
+#define INV_TILE_SHIFT      4
+#define INV_TILE_SIZE       (1 << INV_TILE_SHIFT)
+#define INV_TILE_MASK       (INV_TILE_SIZE - 1)
+#define INV_TILE_ROW_WORDS(cols) (((cols) + 31) >> 5)
+
+/*Dirty part of a tile, relative to the tile: x1, y1, x2, y2 in 4 bits each*/
+#define INV_TILE_BOUNDS(x1, y1, x2, y2) ((uint16_t)((x1) | ((y1) << 4) | ((x2) << 8) | ((y2) << 12)))
+#define INV_TILE_X1(b) ((b) & 0xF)
+#define INV_TILE_Y1(b) (((b) >> 4) & 0xF)
+#define INV_TILE_X2(b) (((b) >> 8) & 0xF)
+#define INV_TILE_Y2(b) (((b) >> 12) & 0xF)
+#endif
 
 /**********************
  *      TYPEDEFS
  **********************/
+#if LV_INV_TILES
+/*A run of dirty tiles in a tile row and the area it was added to*/
+typedef struct {
+    uint16_t c1;
+    uint16_t c2;
+    uint32_t area;
+} inv_tile_run_t;
+#endif
+
 typedef struct {
     uint32_t    perf_last_time;
     uint32_t    elaps_sum;
@@ -52,7 +74,7 @@ typedef struct {
  *  STATIC PROTOTYPES
  **********************/
 static void lv_refr_join_area(void);
-static void refr_invalid_areas(void);
+static bool refr_invalid_areas(const lv_area_t * areas, const uint8_t * joined, uint32_t cnt);
 static void refr_area(const lv_area_t * area_p);
 static void refr_area_part(lv_draw_ctx_t * draw_ctx);
 static lv_obj_t * lv_refr_get_top_obj(const lv_area_t * area_p, lv_obj_t * obj);
@@ -61,6 +83,14 @@ static void refr_obj(lv_draw_ctx_t * draw_ctx, lv_obj_t * obj);
 static uint32_t get_max_row(lv_disp_t * disp, lv_coord_t area_w, lv_coord_t area_h);
 static void draw_buf_flush(lv_disp_t * disp);
 static void call_flush_cb(lv_disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_p);
+#if LV_INV_TILES
+    static bool inv_tiles_alloc(lv_disp_t * disp);
+    static void inv_tiles_add(lv_disp_t * disp, const lv_area_t * area);
+    static void inv_tiles_clear(lv_disp_t * disp);
+    static uint32_t inv_tiles_count_runs(lv_disp_t * disp);
+    static uint32_t inv_tiles_to_areas(lv_disp_t * disp, lv_area_t * areas, inv_tile_run_t * runs);
+    static bool refr_inv_tiles(void);
+#endif
 
 #if LV_USE_PERF_MONITOR
     static void perf_monitor_init(perf_monitor_t * perf_monitor);
@@ -216,6 +246,9 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
     /*Clear the invalidate buffer if the parameter is NULL*/
     if(area_p == NULL) {
         disp->inv_p = 0;
+#if LV_INV_TILES
+        inv_tiles_clear(disp);
+#endif
         return;
     }
 
@@ -241,6 +274,15 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p)
 
     if(disp->driver->rounder_cb) disp->driver->rounder_cb(disp->driver, &com_area);
 
+#if LV_INV_TILES
+    /*Mark the tiles instead of saving the area. Without tiles (out of memory) use the list of areas*/
+    if(inv_tiles_alloc(disp)) {
+        inv_tiles_add(disp, &com_area);
+        if(disp->refr_timer) lv_timer_resume(disp->refr_timer);
+        return;
+    }
+#endif
+
     /*Save only if this area is not in one of the saved areas*/
     uint16_t i;
     for(i = 0; i < disp->inv_p; i++) {
@@ -314,18 +356,29 @@ void _lv_disp_refr_timer(lv_timer_t * tmr)
     /*Do nothing if there is no active screen*/
     if(disp_refr->act_scr == NULL) {
         disp_refr->inv_p = 0;
+#if LV_INV_TILES
+        inv_tiles_clear(disp_refr);
+#endif
         LV_LOG_WARN("there is no active screen");
         REFR_TRACE("finished");
         return;
     }
 
-    lv_refr_join_area();
-
-    refr_invalid_areas();
-
+    bool refreshed;
+#if LV_INV_TILES
+    /*The areas made of tiles don't overlap, no need to join them*/
+    if(disp_refr->inv_tile_bits && !disp_refr->driver->full_refresh) {
+        refreshed = refr_inv_tiles();
+    }
+    else
+#endif
+    {
+        lv_refr_join_area();
+        refreshed = refr_invalid_areas(disp_refr->inv_areas, disp_refr->inv_area_joined, disp_refr->inv_p);
+    }
 
     /*If refresh happened ...*/
-    if(disp_refr->inv_p != 0) {
+    if(refreshed) {
         if(disp_refr->driver->full_refresh) {
             lv_area_t disp_area;
             lv_area_set(&disp_area, 0, 0, lv_disp_get_hor_res(disp_refr) - 1, lv_disp_get_ver_res(disp_refr) - 1);
@@ -444,6 +497,17 @@ void _lv_disp_refr_timer(lv_timer_t * tmr)
     REFR_TRACE("finished");
 }
 
+#if LV_INV_TILES
+void _lv_refr_inv_tiles_free(lv_disp_t * disp)
+{
+    lv_mem_free(disp->inv_tile_bits);
+    disp->inv_tile_bits = NULL;
+    disp->inv_tile_bounds = NULL;
+    disp->inv_tile_cols = 0;
+    disp->inv_tile_rows = 0;
+}
+#endif
+
 #if LV_USE_PERF_MONITOR
 void lv_refr_reset_fps_counter(void)
 {
@@ -502,20 +566,250 @@ static void lv_refr_join_area(void)
     }
 }
 
+#if LV_INV_TILES
+
+/**
+ * Allocate the tiles for the current resolution of the display
+ * @param disp pointer to a display
+ * @return true: the tiles are ready to use
+ */
+static bool inv_tiles_alloc(lv_disp_t * disp)
+{
+    uint16_t cols = (lv_disp_get_hor_res(disp) + INV_TILE_MASK) >> INV_TILE_SHIFT;
+    uint16_t rows = (lv_disp_get_ver_res(disp) + INV_TILE_MASK) >> INV_TILE_SHIFT;
+    if(disp->inv_tile_bits && disp->inv_tile_cols == cols && disp->inv_tile_rows == rows) return true;
+
+    _lv_refr_inv_tiles_free(disp);
+
+    /*One bit per tile and the dirty part of each tile in one allocation*/
+    uint32_t words = INV_TILE_ROW_WORDS(cols) * rows;
+    uint32_t size = words * sizeof(uint32_t) + (uint32_t)cols * rows * sizeof(uint16_t);
+    disp->inv_tile_bits = lv_mem_alloc(size);
+    if(disp->inv_tile_bits == NULL) {
+        LV_LOG_WARN("couldn't allocate the invalidated tiles");
+        return false;
+    }
+    lv_memset_00(disp->inv_tile_bits, words * sizeof(uint32_t));
+    disp->inv_tile_bounds = (uint16_t *)(disp->inv_tile_bits + words);
+    disp->inv_tile_cols = cols;
+    disp->inv_tile_rows = rows;
+    return true;
+}
+
+/**
+ * Mark the tiles covered by an area and extend their dirty parts
+ * @param disp pointer to a display
+ * @param area the invalidated area, already on the screen
+ */
+static void inv_tiles_add(lv_disp_t * disp, const lv_area_t * area)
+{
+    /*The rounder might have moved the area out of the tiles*/
+    lv_coord_t x1 = LV_MAX(area->x1, 0);
+    lv_coord_t y1 = LV_MAX(area->y1, 0);
+    lv_coord_t x2 = LV_MIN(area->x2, (disp->inv_tile_cols << INV_TILE_SHIFT) - 1);
+    lv_coord_t y2 = LV_MIN(area->y2, (disp->inv_tile_rows << INV_TILE_SHIFT) - 1);
+
+    uint32_t row_words = INV_TILE_ROW_WORDS(disp->inv_tile_cols);
+    lv_coord_t c1 = x1 >> INV_TILE_SHIFT;
+    lv_coord_t c2 = x2 >> INV_TILE_SHIFT;
+    lv_coord_t r1 = y1 >> INV_TILE_SHIFT;
+    lv_coord_t r2 = y2 >> INV_TILE_SHIFT;
+    lv_coord_t r;
+    lv_coord_t c;
+    for(r = r1; r <= r2; r++) {
+        uint32_t * bits = &disp->inv_tile_bits[r * row_words];
+        uint16_t * bounds = &disp->inv_tile_bounds[r * disp->inv_tile_cols];
+        uint32_t ty1 = r == r1 ? (y1 & INV_TILE_MASK) : 0;
+        uint32_t ty2 = r == r2 ? (y2 & INV_TILE_MASK) : INV_TILE_MASK;
+        for(c = c1; c <= c2; c++) {
+            uint32_t tx1 = c == c1 ? (x1 & INV_TILE_MASK) : 0;
+            uint32_t tx2 = c == c2 ? (x2 & INV_TILE_MASK) : INV_TILE_MASK;
+            uint32_t bit = (uint32_t)1 << (c & 31);
+            if((bits[c >> 5] & bit) == 0) {
+                bits[c >> 5] |= bit;
+                bounds[c] = INV_TILE_BOUNDS(tx1, ty1, tx2, ty2);
+            }
+            else {
+                uint16_t b = bounds[c];
+                bounds[c] = INV_TILE_BOUNDS(LV_MIN(INV_TILE_X1(b), tx1), LV_MIN(INV_TILE_Y1(b), ty1),
+                                            LV_MAX(INV_TILE_X2(b), tx2), LV_MAX(INV_TILE_Y2(b), ty2));
+            }
+        }
+    }
+}
+
+static void inv_tiles_clear(lv_disp_t * disp)
+{
+    if(disp->inv_tile_bits == NULL) return;
+    uint32_t words = INV_TILE_ROW_WORDS(disp->inv_tile_cols) * disp->inv_tile_rows;
+    lv_memset_00(disp->inv_tile_bits, words * sizeof(uint32_t));
+}
+
+/**
+ * Count the runs of dirty tiles in all tile rows
+ * @param disp pointer to a display
+ * @return number of runs, the most areas `inv_tiles_to_areas()` can make
+ */
+static uint32_t inv_tiles_count_runs(lv_disp_t * disp)
+{
+    uint32_t row_words = INV_TILE_ROW_WORDS(disp->inv_tile_cols);
+    uint32_t words = row_words * disp->inv_tile_rows;
+    uint32_t cnt = 0;
+    uint32_t carry = 0;
+    uint32_t w;
+    for(w = 0; w < words; w++) {
+        if(w % row_words == 0) carry = 0;
+        uint32_t bits = disp->inv_tile_bits[w];
+        /*A run starts at a dirty tile whose left neighbor is clean*/
+        uint32_t starts = bits & ~((bits << 1) | carry);
+        carry = bits >> 31;
+        while(starts) {
+            starts &= starts - 1;
+            cnt++;
+        }
+    }
+    return cnt;
+}
+
+/**
+ * Convert the marked tiles to areas and clear the tiles.
+ * Each run of dirty tiles in a tile row becomes an area, trimmed to the dirty parts of the tiles.
+ * A run with the same columns as a run of the previous row continues its area if the two touch.
+ * @param disp pointer to a display
+ * @param areas store the areas here, needs room for `inv_tiles_count_runs()` areas
+ * @param runs buffer for the runs of two tile rows (`(cols + 1) / 2` runs each)
+ * @return number of areas
+ */
+static uint32_t inv_tiles_to_areas(lv_disp_t * disp, lv_area_t * areas, inv_tile_run_t * runs)
+{
+    uint16_t cols = disp->inv_tile_cols;
+    uint32_t row_words = INV_TILE_ROW_WORDS(cols);
+    inv_tile_run_t * prev = runs;
+    inv_tile_run_t * cur = runs + (cols + 1) / 2;
+    uint32_t prev_cnt = 0;
+    uint32_t area_cnt = 0;
+
+    uint16_t r;
+    for(r = 0; r < disp->inv_tile_rows; r++) {
+        uint32_t * bits = &disp->inv_tile_bits[r * row_words];
+        uint16_t * bounds = &disp->inv_tile_bounds[r * cols];
+        lv_coord_t row_y = (lv_coord_t)r << INV_TILE_SHIFT;
+        uint32_t cur_cnt = 0;
+        uint32_t p = 0;
+        uint16_t c = 0;
+
+        while(c < cols) {
+            /*Skip the clean tiles, a word at once if possible*/
+            if(bits[c >> 5] == 0) {
+                c = (c | 31) + 1;
+                continue;
+            }
+            if((bits[c >> 5] & ((uint32_t)1 << (c & 31))) == 0) {
+                c++;
+                continue;
+            }
+
+            uint16_t c1 = c;
+            uint32_t ty1 = INV_TILE_MASK;
+            uint32_t ty2 = 0;
+            while(c < cols && (bits[c >> 5] & ((uint32_t)1 << (c & 31)))) {
+                ty1 = LV_MIN(ty1, INV_TILE_Y1(bounds[c]));
+                ty2 = LV_MAX(ty2, INV_TILE_Y2(bounds[c]));
+                c++;
+            }
+            uint16_t c2 = c - 1;
+
+            lv_area_t a;
+            a.x1 = ((lv_coord_t)c1 << INV_TILE_SHIFT) + INV_TILE_X1(bounds[c1]);
+            a.x2 = ((lv_coord_t)c2 << INV_TILE_SHIFT) + INV_TILE_X2(bounds[c2]);
+            a.y1 = row_y + ty1;
+            a.y2 = row_y + ty2;
+
+            /*Continue the area of the run above if it has the same columns and reaches this row*/
+            while(p < prev_cnt && prev[p].c2 < c1) p++;
+            uint32_t area_i;
+            if(p < prev_cnt && prev[p].c1 == c1 && prev[p].c2 == c2 &&
+               areas[prev[p].area].y2 + 1 >= a.y1) {
+                lv_area_t * joined = &areas[prev[p].area];
+                joined->x1 = LV_MIN(joined->x1, a.x1);
+                joined->x2 = LV_MAX(joined->x2, a.x2);
+                joined->y2 = a.y2;
+                area_i = prev[p].area;
+            }
+            else {
+                areas[area_cnt] = a;
+                area_i = area_cnt;
+                area_cnt++;
+            }
+
+            cur[cur_cnt].c1 = c1;
+            cur[cur_cnt].c2 = c2;
+            cur[cur_cnt].area = area_i;
+            cur_cnt++;
+        }
+
+        lv_memset_00(bits, row_words * sizeof(uint32_t));
+
+        inv_tile_run_t * tmp = prev;
+        prev = cur;
+        cur = tmp;
+        prev_cnt = cur_cnt;
+    }
+
+    return area_cnt;
+}
+
+/**
+ * Refresh the areas made of the marked tiles and clear the tiles
+ * @return true: there was something to refresh
+ */
+static bool refr_inv_tiles(void)
+{
+    /*Add the areas saved while the tiles couldn't be allocated*/
+    uint16_t i;
+    for(i = 0; i < disp_refr->inv_p; i++) inv_tiles_add(disp_refr, &disp_refr->inv_areas[i]);
+    disp_refr->inv_p = 0;
+
+    uint32_t run_cnt = inv_tiles_count_runs(disp_refr);
+    if(run_cnt == 0) return false;
+
+    /*An area for each run and the runs of two tile rows*/
+    uint32_t row_runs = (disp_refr->inv_tile_cols + 1) / 2;
+    lv_area_t * areas = lv_mem_alloc(run_cnt * sizeof(lv_area_t) + 2 * row_runs * sizeof(inv_tile_run_t));
+    if(areas == NULL) {
+        LV_LOG_WARN("couldn't allocate the invalidated areas, redraw the whole screen");
+        inv_tiles_clear(disp_refr);
+        lv_area_t scr_area;
+        lv_area_set(&scr_area, 0, 0, lv_disp_get_hor_res(disp_refr) - 1, lv_disp_get_ver_res(disp_refr) - 1);
+        return refr_invalid_areas(&scr_area, NULL, 1);
+    }
+
+    uint32_t area_cnt = inv_tiles_to_areas(disp_refr, areas, (inv_tile_run_t *)(areas + run_cnt));
+    bool refreshed = refr_invalid_areas(areas, NULL, area_cnt);
+    lv_mem_free(areas);
+    return refreshed;
+}
+
+#endif /*LV_INV_TILES*/
+
 /**
  * Refresh the joined areas
+ * @param areas the areas to refresh
+ * @param joined `joined[i] != 0` means `areas[i]` is joined into an other area and skipped. Can be NULL.
+ * @param cnt number of areas
+ * @return true: there was something to refresh
  */
-static void refr_invalid_areas(void)
+static bool refr_invalid_areas(const lv_area_t * areas, const uint8_t * joined, uint32_t cnt)
 {
     px_num = 0;
 
-    if(disp_refr->inv_p == 0) return;
+    if(cnt == 0) return false;
 
     /*Find the last area which will be drawn*/
     int32_t i;
     int32_t last_i = 0;
-    for(i = disp_refr->inv_p - 1; i >= 0; i--) {
-        if(disp_refr->inv_area_joined[i] == 0) {
+    for(i = cnt - 1; i >= 0; i--) {
+        if(joined == NULL || joined[i] == 0) {
             last_i = i;
             break;
         }
@@ -530,19 +824,21 @@ static void refr_invalid_areas(void)
     disp_refr->driver->draw_buf->last_part = 0;
     disp_refr->rendering_in_progress = true;
 
-    for(i = 0; i < disp_refr->inv_p; i++) {
+    for(i = 0; i < (int32_t)cnt; i++) {
         /*Refresh the unjoined areas*/
-        if(disp_refr->inv_area_joined[i] == 0) {
+        if(joined == NULL || joined[i] == 0) {
 
             if(i == last_i) disp_refr->driver->draw_buf->last_area = 1;
             disp_refr->driver->draw_buf->last_part = 0;
-            refr_area(&disp_refr->inv_areas[i]);
+            refr_area(&areas[i]);
 
-            px_num += lv_area_get_size(&disp_refr->inv_areas[i]);
+            px_num += lv_area_get_size(&areas[i]);
         }
     }
 
     disp_refr->rendering_in_progress = false;
+
+    return true;
 }
 
 /**
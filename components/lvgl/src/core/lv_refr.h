@@ -77,6 +77,14 @@ void _lv_inv_area(lv_disp_t * disp, const lv_area_t * area_p);
  */
 lv_disp_t * _lv_refr_get_disp_refreshing(void);
 
+#if LV_INV_TILES
+/**
+ * Free the invalidated tiles of a display. They are allocated again on the next invalidation.
+ * @param disp pointer to a display
+ */
+void _lv_refr_inv_tiles_free(lv_disp_t * disp);
+#endif
+
 /**
  * Set the display which is being refreshed.
  * It shouldn't be used directly by the user.
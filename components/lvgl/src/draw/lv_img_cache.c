@@ -12,19 +12,12 @@
 #include "lv_draw_img.h"
 #include "../hal/lv_hal_tick.h"
 #include "../misc/lv_gc.h"
+#include "lv_img_buf.h"
+#include "sw/lv_draw_sw.h"
 
 /*********************
  *      DEFINES
  *********************/
-/*Decrement life with this value on every open*/
-#define LV_IMG_CACHE_AGING 1
-
-/*Boost life by this factor (multiply time_to_open with this value)*/
-#define LV_IMG_CACHE_LIFE_GAIN 1
-
-/*Don't let life to be greater than this limit because it would require a lot of time to
- * "die" from very high values*/
-#define LV_IMG_CACHE_LIFE_LIMIT 1000
 
 /**********************
  *      TYPEDEFS
@@ -35,6 +28,9 @@
  **********************/
 #if LV_IMG_CACHE_DEF_SIZE
     static bool lv_img_cache_match(const void * src1, const void * src2);
+    static uint32_t entry_mem_size(const _lv_img_cache_entry_t * entry);
+    static void entry_close(_lv_img_cache_entry_t * entry);
+    static void shrink_to_budget(const _lv_img_cache_entry_t * keep);
 #endif
 
 /**********************
@@ -42,7 +38,11 @@
  **********************/
 #if LV_IMG_CACHE_DEF_SIZE
     static uint16_t entry_cnt;
+    static size_t mem_max = LV_IMG_CACHE_MEM_SIZE;
+    static size_t mem_used;
+    static uint32_t use_cnt;
 #endif
+static lv_img_cache_stats_t cache_stats;
 
 /**********************
  *      MACROS
@@ -73,43 +73,36 @@ _lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color, i
 
     _lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
 
-    /*Decrement all lifes. Make the entries older*/
     uint16_t i;
     for(i = 0; i < entry_cnt; i++) {
-        if(cache[i].life > INT32_MIN + LV_IMG_CACHE_AGING) {
-            cache[i].life -= LV_IMG_CACHE_AGING;
-        }
-    }
-
-    for(i = 0; i < entry_cnt; i++) {
-        if(color.full == cache[i].dec_dsc.color.full &&
+        if(cache[i].dec_dsc.src != NULL &&
+           color.full == cache[i].dec_dsc.color.full &&
            frame_id == cache[i].dec_dsc.frame_id &&
            lv_img_cache_match(src, cache[i].dec_dsc.src)) {
-            /*If opened increment its life.
-             *Image difficult to open should live longer to keep avoid frequent their recaching.
-             *Therefore increase `life` with `time_to_open`*/
             cached_src = &cache[i];
-            cached_src->life += cached_src->dec_dsc.time_to_open * LV_IMG_CACHE_LIFE_GAIN;
-            if(cached_src->life > LV_IMG_CACHE_LIFE_LIMIT) cached_src->life = LV_IMG_CACHE_LIFE_LIMIT;
+            cached_src->last_use = ++use_cnt;
+            cache_stats.hits++;
             LV_LOG_TRACE("image source found in the cache");
-            break;
+            return cached_src;
         }
     }
 
-    /*The image is not cached then cache it now*/
-    if(cached_src) return cached_src;
-
-    /*Find an entry to reuse. Select the entry with the least life*/
+    /*The image is not cached then cache it now.
+     *Use an empty entry or reuse the least recently used one*/
     cached_src = &cache[0];
-    for(i = 1; i < entry_cnt; i++) {
-        if(cache[i].life < cached_src->life) {
+    for(i = 0; i < entry_cnt; i++) {
+        if(cache[i].dec_dsc.src == NULL) {
+            cached_src = &cache[i];
+            break;
+        }
+        if(cache[i].last_use < cached_src->last_use) {
             cached_src = &cache[i];
         }
     }
 
-    /*Close the decoder to reuse if it was opened (has a valid source)*/
     if(cached_src->dec_dsc.src) {
-        lv_img_decoder_close(&cached_src->dec_dsc);
+        entry_close(cached_src);
+        cache_stats.evictions++;
         LV_LOG_INFO("image draw: cache miss, close and reuse an entry");
     }
     else {
@@ -118,18 +111,17 @@ _lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color, i
 #else
     cached_src = &LV_GC_ROOT(_lv_img_cache_single);
 #endif
+    cache_stats.misses++;
+
     /*Open the image and measure the time to open*/
     uint32_t t_start  = lv_tick_get();
     lv_res_t open_res = lv_img_decoder_open(&cached_src->dec_dsc, src, color, frame_id);
     if(open_res == LV_RES_INV) {
         LV_LOG_WARN("Image draw cannot open the image resource");
         lv_memset_00(cached_src, sizeof(_lv_img_cache_entry_t));
-        cached_src->life = INT32_MIN; /*Make the empty entry very "weak" to force its us*/
         return NULL;
     }
 
-    cached_src->life = 0;
-
     /*If `time_to_open` was not set in the open function set it here*/
     if(cached_src->dec_dsc.time_to_open == 0) {
         cached_src->dec_dsc.time_to_open = lv_tick_elaps(t_start);
@@ -137,9 +129,81 @@ _lv_img_cache_entry_t * _lv_img_cache_open(const void * src, lv_color_t color, i
 
     if(cached_src->dec_dsc.time_to_open == 0) cached_src->dec_dsc.time_to_open = 1;
 
+#if LV_IMG_CACHE_DEF_SIZE
+    cached_src->last_use = ++use_cnt;
+    cached_src->mem_size = entry_mem_size(cached_src);
+    mem_used += cached_src->mem_size;
+    shrink_to_budget(cached_src);
+#endif
+
     return cached_src;
 }
 
+/**
+ * Open and decode an image into the cache without drawing it,
+ * so the first frame that shows it doesn't pay for decoding.
+ * @param src source of the image. Path to file or pointer to an `lv_img_dsc_t` variable
+ * @param color the recolor the image will be drawn with
+ * @return LV_RES_OK: the image is in the cache; LV_RES_INV: caching is disabled or the image can't be opened
+ */
+lv_res_t lv_img_cache_prewarm(const void * src, lv_color_t color)
+{
+#if LV_IMG_CACHE_DEF_SIZE
+    lv_img_src_t src_type = lv_img_src_get_type(src);
+    if(entry_cnt == 0 || (src_type != LV_IMG_SRC_FILE && src_type != LV_IMG_SRC_VARIABLE)) return LV_RES_INV;
+
+    return _lv_img_cache_open(src, color, 0) ? LV_RES_OK : LV_RES_INV;
+#else
+    LV_UNUSED(src);
+    LV_UNUSED(color);
+    return LV_RES_INV;
+#endif
+}
+
+/**
+ * Limit the decoded image data kept open by the cache.
+ * Least recently used images are closed until the cache fits the new limit.
+ * @param size budget in bytes, 0: limited only by the number of entries
+ */
+void lv_img_cache_set_mem_size(size_t size)
+{
+#if LV_IMG_CACHE_DEF_SIZE
+    mem_max = size;
+    shrink_to_budget(NULL);
+#else
+    LV_UNUSED(size);
+#endif
+}
+
+/**
+ * Get the hit/miss counters and the memory usage of the cache
+ * @param stats store the statistics here
+ */
+void lv_img_cache_get_stats(lv_img_cache_stats_t * stats)
+{
+    *stats = cache_stats;
+#if LV_IMG_CACHE_DEF_SIZE
+    _lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
+    uint16_t i;
+    stats->entries = 0;
+    for(i = 0; i < entry_cnt; i++) {
+        if(cache[i].dec_dsc.src) stats->entries++;
+    }
+    stats->mem_used = mem_used;
+    stats->mem_max = mem_max;
+#endif
+}
+
+/**
+ * Reset the hit, miss and eviction counters
+ */
+void lv_img_cache_reset_stats(void)
+{
+    cache_stats.hits = 0;
+    cache_stats.misses = 0;
+    cache_stats.evictions = 0;
+}
+
 /**
  * Set the number of images to be cached.
  * More cached images mean more opened image at same time which might mean more memory usage.
@@ -156,6 +220,7 @@ void lv_img_cache_set_size(uint16_t new_entry_cnt)
         /*Clean the cache before free it*/
         lv_img_cache_invalidate_src(NULL);
         lv_mem_free(LV_GC_ROOT(_lv_img_cache_array));
+        LV_GC_ROOT(_lv_img_cache_array) = NULL;
     }
 
     /*Reallocate the cache*/
@@ -180,17 +245,21 @@ void lv_img_cache_set_size(uint16_t new_entry_cnt)
 void lv_img_cache_invalidate_src(const void * src)
 {
     LV_UNUSED(src);
+#if LV_DRAW_COMPLEX
+    /*The transformed copies of the image are outdated too*/
+    if(src == NULL) lv_draw_sw_transform_cache_invalidate(NULL);
+    else if(lv_img_src_get_type(src) == LV_IMG_SRC_VARIABLE && ((const lv_img_dsc_t *)src)->data) {
+        lv_draw_sw_transform_cache_invalidate(((const lv_img_dsc_t *)src)->data);
+    }
+#endif
 #if LV_IMG_CACHE_DEF_SIZE
     _lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
 
     uint16_t i;
     for(i = 0; i < entry_cnt; i++) {
+        if(cache[i].dec_dsc.src == NULL) continue;
         if(src == NULL || lv_img_cache_match(src, cache[i].dec_dsc.src)) {
-            if(cache[i].dec_dsc.src != NULL) {
-                lv_img_decoder_close(&cache[i].dec_dsc);
-            }
-
-            lv_memset_00(&cache[i], sizeof(_lv_img_cache_entry_t));
+            entry_close(&cache[i]);
         }
     }
 #endif
@@ -212,4 +281,44 @@ static bool lv_img_cache_match(const void * src1, const void * src2)
         return false;
     return strcmp(src1, src2) == 0;
 }
+
+/*Bytes of decoded image data the entry keeps open.
+ *Decoders that read the image line by line keep nothing worth counting,
+ *and a variable image drawn directly by the built-in decoder is not a copy.*/
+static uint32_t entry_mem_size(const _lv_img_cache_entry_t * entry)
+{
+    const lv_img_decoder_dsc_t * dsc = &entry->dec_dsc;
+    if(dsc->img_data == NULL) return 0;
+    if(dsc->src_type == LV_IMG_SRC_VARIABLE && dsc->img_data == ((const lv_img_dsc_t *)dsc->src)->data) return 0;
+
+    return lv_img_buf_get_img_size(dsc->header.w, dsc->header.h, dsc->header.cf);
+}
+
+static void entry_close(_lv_img_cache_entry_t * entry)
+{
+    mem_used -= entry->mem_size;
+    lv_img_decoder_close(&entry->dec_dsc);
+    lv_memset_00(entry, sizeof(_lv_img_cache_entry_t));
+}
+
+/*Close the least recently used entries until the cache fits the memory budget.
+ *`keep` was just opened for drawing so it's never closed here, even if it alone is over the budget.*/
+static void shrink_to_budget(const _lv_img_cache_entry_t * keep)
+{
+    if(mem_max == 0) return;
+
+    _lv_img_cache_entry_t * cache = LV_GC_ROOT(_lv_img_cache_array);
+    while(mem_used > mem_max) {
+        _lv_img_cache_entry_t * lru = NULL;
+        uint16_t i;
+        for(i = 0; i < entry_cnt; i++) {
+            if(&cache[i] == keep || cache[i].mem_size == 0) continue;
+            if(lru == NULL || cache[i].last_use < lru->last_use) lru = &cache[i];
+        }
+        if(lru == NULL) break;
+
+        entry_close(lru);
+        cache_stats.evictions++;
+    }
+}
 #endif
@@ -31,12 +31,23 @@ extern "C" {
 typedef struct {
     lv_img_decoder_dsc_t dec_dsc; /**< Image information*/
 
-    /** Count the cache entries's life. Add `time_to_open` to `life` when the entry is used.
-     * Decrement all lifes by one every in every ::lv_img_cache_open.
-     * If life == 0 the entry can be reused*/
-    int32_t life;
+    /** Value of a counter incremented on every cache access when this entry was last used.
+     * The entry with the smallest value is reused first.*/
+    uint32_t last_use;
+
+    /** Bytes of decoded image data kept open by this entry (counted against `LV_IMG_CACHE_MEM_SIZE`)*/
+    uint32_t mem_size;
 } _lv_img_cache_entry_t;
 
+typedef struct {
+    uint32_t hits;          /**< Opens served from the cache*/
+    uint32_t misses;        /**< Opens that had to decode the image*/
+    uint32_t evictions;     /**< Entries closed to make room for others*/
+    uint32_t entries;       /**< Images currently kept open*/
+    size_t mem_used;        /**< Bytes of decoded image data currently kept open*/
+    size_t mem_max;         /**< Memory budget in bytes, 0: limited only by the number of entries*/
+} lv_img_cache_stats_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -67,6 +78,33 @@ void lv_img_cache_set_size(uint16_t new_slot_num);
  */
 void lv_img_cache_invalidate_src(const void * src);
 
+/**
+ * Open and decode an image into the cache without drawing it,
+ * so the first frame that shows it doesn't pay for decoding.
+ * @param src source of the image. Path to file or pointer to an `lv_img_dsc_t` variable
+ * @param color the recolor the image will be drawn with
+ * @return LV_RES_OK: the image is in the cache; LV_RES_INV: caching is disabled or the image can't be opened
+ */
+lv_res_t lv_img_cache_prewarm(const void * src, lv_color_t color);
+
+/**
+ * Limit the decoded image data kept open by the cache.
+ * Least recently used images are closed until the cache fits the new limit.
+ * @param size budget in bytes, 0: limited only by the number of entries
+ */
+void lv_img_cache_set_mem_size(size_t size);
+
+/**
+ * Get the hit/miss counters and the memory usage of the cache
+ * @param stats store the statistics here
+ */
+void lv_img_cache_get_stats(lv_img_cache_stats_t * stats);
+
+/**
+ * Reset the hit, miss and eviction counters
+ */
+void lv_img_cache_reset_stats(void);
+
 /**********************
  *      MACROS
  **********************/
@@ -11,6 +11,7 @@
 #include "../draw/lv_draw_img.h"
 #include "../misc/lv_ll.h"
 #include "../misc/lv_gc.h"
+#include "sw/lv_draw_sw.h"
 
 /*********************
  *      DEFINES
@@ -188,6 +189,13 @@ lv_res_t lv_img_decoder_read_line(lv_img_decoder_dsc_t * dsc, lv_coord_t x, lv_c
 void lv_img_decoder_close(lv_img_decoder_dsc_t * dsc)
 {
     if(dsc->decoder) {
+#if LV_DRAW_COMPLEX
+        /*The decoded data might be freed so drop its transformed copies.
+         *A variable image drawn directly stays valid.*/
+        bool own_data = dsc->src_type != LV_IMG_SRC_VARIABLE ||
+                        dsc->img_data != ((const lv_img_dsc_t *)dsc->src)->data;
+        if(dsc->img_data && own_data) lv_draw_sw_transform_cache_invalidate(dsc->img_data);
+#endif
         if(dsc->decoder->close_cb) dsc->decoder->close_cb(dsc->decoder, dsc);
 
         if(dsc->src_type == LV_IMG_SRC_FILE) {
@@ -43,6 +43,21 @@ typedef struct {
     uint32_t has_alpha : 1;
 } lv_draw_sw_layer_ctx_t;
 
+typedef struct {
+    lv_area_t area;             /**< Where the transformed image can be visible, relative to the image*/
+    const lv_color_t * cbuf;    /**< The cached transformed pixels on `area` or NULL if not cached*/
+    const lv_opa_t * abuf;      /**< The opacity of the cached pixels on `area` or NULL if not cached*/
+} _lv_draw_sw_transformed_t;
+
+typedef struct {
+    uint32_t hits;          /**< Transformed draws served from the cache*/
+    uint32_t misses;        /**< Transformed draws that had to resample the image*/
+    uint32_t evictions;     /**< Entries dropped to make room for others*/
+    uint32_t entries;       /**< Transformed images currently kept*/
+    size_t mem_used;        /**< Bytes of transformed pixels currently kept*/
+    size_t mem_max;         /**< Memory budget in bytes, 0: caching is disabled*/
+} lv_draw_sw_transform_cache_stats_t;
+
 /**********************
  * GLOBAL PROTOTYPES
  **********************/
@@ -78,6 +93,48 @@ void lv_draw_sw_transform(lv_draw_ctx_t * draw_ctx, const lv_area_t * dest_area,
                           lv_coord_t src_w, lv_coord_t src_h, lv_coord_t src_stride,
                           const lv_draw_img_dsc_t * draw_dsc, lv_img_cf_t cf, lv_color_t * cbuf, lv_opa_t * abuf);
 
+/**
+ * Find where a transformed image can be visible and get its transformed pixels from the cache.
+ * On a cache miss the image is transformed into a new cache entry if it fits `LV_IMG_TRANSFORM_CACHE_SIZE`.
+ * The returned buffers are valid until the next call.
+ * @param draw_ctx  pointer to a draw context
+ * @param draw_dsc  the angle, zoom, pivot and anti-aliasing of the transformation
+ * @param src_buf   the decoded image
+ * @param src_w     width of the image
+ * @param src_h     height of the image
+ * @param cf        color format of the image
+ * @param res       store the visible area and the cached pixels here
+ * @return          false: the image has no visible pixels
+ */
+bool _lv_draw_sw_transform_prepare(lv_draw_ctx_t * draw_ctx, const lv_draw_img_dsc_t * draw_dsc,
+                                   const uint8_t * src_buf, lv_coord_t src_w, lv_coord_t src_h, lv_img_cf_t cf,
+                                   _lv_draw_sw_transformed_t * res);
+
+/**
+ * Drop the cached transformed images of a decoded image.
+ * Needs to be called when the image's pixels change or its buffer is freed.
+ * @param src_buf the decoded image data, NULL to drop every cached image
+ */
+void lv_draw_sw_transform_cache_invalidate(const void * src_buf);
+
+/**
+ * Limit the memory used by the transformed images.
+ * Least recently used images are dropped until the cache fits the new limit.
+ * @param size budget in bytes, 0: disable the cache
+ */
+void lv_draw_sw_transform_cache_set_mem_size(size_t size);
+
+/**
+ * Get the hit/miss counters and the memory usage of the transformed image cache
+ * @param stats store the statistics here
+ */
+void lv_draw_sw_transform_cache_get_stats(lv_draw_sw_transform_cache_stats_t * stats);
+
+/**
+ * Reset the hit, miss and eviction counters of the transformed image cache
+ */
+void lv_draw_sw_transform_cache_reset_stats(void);
+
 struct _lv_draw_layer_ctx_t * lv_draw_sw_layer_create(struct _lv_draw_ctx_t * draw_ctx, lv_draw_layer_ctx_t * layer_ctx,
                                                       lv_draw_layer_flags_t flags);
 
@@ -14,6 +14,23 @@
 /*********************
  *      DEFINES
  *********************/
+/*The RGB565 kernels are used where they give the same result as lv_color_mix()*/
+#if LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0 && LV_COLOR_MIX_ROUND_OFS == 0
+    #define BLEND_RGB565_WORD   1
+#else
+    #define BLEND_RGB565_WORD   0
+#endif
+
+/* Two RGB565 pixels of a 32 bit word are mixed in two groups. Each field has at least 5 free bits above it
+ * so `field * mix` (mix = 0..32) doesn't overflow to the next field.
+ * X: B and R of the lower pixel, G of the upper pixel
+ * Y: (word >> 5) G of the lower pixel, B and R of the upper pixel
+ * X is the same as the single pixel spreading of lv_color_mix()*/
+#define RGB565_MASK_X       0x07E0F81F
+#define RGB565_MASK_Y       0x07C0F83F
+
+/*The 0..32 mix ratio of lv_color_mix() with 16 bit color depth*/
+#define RGB565_MIX(opa)     (((uint32_t)(opa) + 4) >> 3)
 
 /**********************
  *      TYPEDEFS
@@ -63,6 +80,12 @@ static inline lv_color_t color_blend_true_color_subtractive(lv_color_t fg, lv_co
 static inline lv_color_t color_blend_true_color_multiply(lv_color_t fg, lv_color_t bg, lv_opa_t opa);
 #endif /*LV_DRAW_COMPLEX*/
 
+static inline uint32_t rgb565_mix_word(uint32_t fg, uint32_t bg, uint32_t mix);
+static inline uint16_t rgb565_mix_px(uint16_t fg, uint16_t bg, uint32_t mix);
+static inline uint32_t rgb565_load_word(const uint16_t * buf, bool aligned);
+static inline lv_opa_t fill_mask_opa(lv_opa_t mask, lv_opa_t opa);
+static inline lv_opa_t map_mask_opa(lv_opa_t mask, lv_opa_t opa);
+
 /**********************
  *  STATIC VARIABLES
  **********************/
@@ -190,6 +213,202 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_blend_basic(lv_draw_ctx_t * draw_ctx, cons
     }
 }
 
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill(uint16_t * dest_buf, int32_t dest_stride, int32_t w, int32_t h,
+                                                  uint16_t color)
+{
+    uint32_t c32 = (uint32_t)color | ((uint32_t)color << 16);
+
+    int32_t y;
+    for(y = 0; y < h; y++) {
+        uint16_t * d16 = dest_buf;
+        int32_t n = w;
+        if(((lv_uintptr_t)d16 & 0x2) && n > 0) {
+            *d16 = color;
+            d16++;
+            n--;
+        }
+
+        uint32_t * d32 = (uint32_t *)d16;
+        for(; n >= 8; n -= 8) {
+            d32[0] = c32;
+            d32[1] = c32;
+            d32[2] = c32;
+            d32[3] = c32;
+            d32 += 4;
+        }
+        for(; n >= 2; n -= 2) {
+            *d32 = c32;
+            d32++;
+        }
+        if(n) *((uint16_t *)d32) = color;
+
+        dest_buf += dest_stride;
+    }
+}
+
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill_opa(uint16_t * dest_buf, int32_t dest_stride, int32_t w, int32_t h,
+                                                      uint16_t color, lv_opa_t opa)
+{
+    /*(fg * mix + bg * (32 - mix)) >> 5 has no carry between the fields either so it's the same as
+     *((fg - bg) * mix >> 5) + bg of lv_color_mix() but the color's part can be calculated only once*/
+    uint32_t mix = RGB565_MIX(opa);
+    uint32_t mix_inv = 32 - mix;
+    uint32_t c32 = (uint32_t)color | ((uint32_t)color << 16);
+    uint32_t fg_x = (c32 & RGB565_MASK_X) * mix;
+    uint32_t fg_y = ((c32 >> 5) & RGB565_MASK_Y) * mix;
+
+    /*Buffer the result to avoid recalculating it on the same background*/
+    uint32_t last_bg = 0;
+    uint32_t last_res = ((fg_x >> 5) & RGB565_MASK_X) | (((fg_y >> 5) & RGB565_MASK_Y) << 5);
+
+    int32_t x;
+    int32_t y;
+    for(y = 0; y < h; y++) {
+        x = 0;
+        if(((lv_uintptr_t)dest_buf & 0x2) && w > 0) {
+            dest_buf[0] = rgb565_mix_px(color, dest_buf[0], mix);
+            x = 1;
+        }
+
+        uint32_t * d32 = (uint32_t *)&dest_buf[x];
+        for(; x < w - 1; x += 2) {
+            uint32_t bg = *d32;
+            if(bg != last_bg) {
+                uint32_t res_x = ((fg_x + (bg & RGB565_MASK_X) * mix_inv) >> 5) & RGB565_MASK_X;
+                uint32_t res_y = ((fg_y + ((bg >> 5) & RGB565_MASK_Y) * mix_inv) >> 5) & RGB565_MASK_Y;
+                last_res = res_x | (res_y << 5);
+                last_bg = bg;
+            }
+            *d32 = last_res;
+            d32++;
+        }
+
+        if(x < w) dest_buf[x] = rgb565_mix_px(color, dest_buf[x], mix);
+
+        dest_buf += dest_stride;
+    }
+}
+
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill_mask(uint16_t * dest_buf, int32_t dest_stride, int32_t w, int32_t h,
+                                                       uint16_t color, lv_opa_t opa, const lv_opa_t * mask, int32_t mask_stride)
+{
+    uint32_t c32 = (uint32_t)color | ((uint32_t)color << 16);
+
+    /*Buffer the mix ratio of the last mask value*/
+    lv_opa_t last_mask = LV_OPA_TRANSP;
+    uint32_t mix = 0;
+
+    int32_t x;
+    int32_t y;
+    for(y = 0; y < h; y++) {
+        x = 0;
+        if(((lv_uintptr_t)dest_buf & 0x2) && w > 0) {
+            if(mask[0]) dest_buf[0] = rgb565_mix_px(color, dest_buf[0], RGB565_MIX(fill_mask_opa(mask[0], opa)));
+            x = 1;
+        }
+
+        for(; x < w - 1; x += 2) {
+            lv_opa_t m0 = mask[x];
+            lv_opa_t m1 = mask[x + 1];
+            /*Same mask on both pixels (e.g. inside or outside of a shape): mix them together*/
+            if(m0 == m1) {
+                if(m0 == LV_OPA_TRANSP) continue;
+                if(m0 != last_mask) {
+                    mix = RGB565_MIX(fill_mask_opa(m0, opa));
+                    last_mask = m0;
+                }
+                uint32_t * d32 = (uint32_t *)&dest_buf[x];
+                if(mix == 32) *d32 = c32;
+                else *d32 = rgb565_mix_word(c32, *d32, mix);
+            }
+            /*Anti-aliased edge*/
+            else {
+                if(m0) dest_buf[x] = rgb565_mix_px(color, dest_buf[x], RGB565_MIX(fill_mask_opa(m0, opa)));
+                if(m1) dest_buf[x + 1] = rgb565_mix_px(color, dest_buf[x + 1], RGB565_MIX(fill_mask_opa(m1, opa)));
+            }
+        }
+
+        if(x < w && mask[x]) dest_buf[x] = rgb565_mix_px(color, dest_buf[x], RGB565_MIX(fill_mask_opa(mask[x], opa)));
+
+        dest_buf += dest_stride;
+        mask += mask_stride;
+    }
+}
+
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_map_opa(uint16_t * dest_buf, int32_t dest_stride, const uint16_t * src_buf,
+                                                     int32_t src_stride, int32_t w, int32_t h, lv_opa_t opa)
+{
+    uint32_t mix = RGB565_MIX(opa);
+
+    int32_t x;
+    int32_t y;
+    for(y = 0; y < h; y++) {
+        x = 0;
+        if(((lv_uintptr_t)dest_buf & 0x2) && w > 0) {
+            dest_buf[0] = rgb565_mix_px(src_buf[0], dest_buf[0], mix);
+            x = 1;
+        }
+
+        bool src_aligned = ((lv_uintptr_t)&src_buf[x] & 0x2) == 0;
+        uint32_t * d32 = (uint32_t *)&dest_buf[x];
+        for(; x < w - 1; x += 2) {
+            *d32 = rgb565_mix_word(rgb565_load_word(&src_buf[x], src_aligned), *d32, mix);
+            d32++;
+        }
+
+        if(x < w) dest_buf[x] = rgb565_mix_px(src_buf[x], dest_buf[x], mix);
+
+        dest_buf += dest_stride;
+        src_buf += src_stride;
+    }
+}
+
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_map_mask(uint16_t * dest_buf, int32_t dest_stride, const uint16_t * src_buf,
+                                                      int32_t src_stride, int32_t w, int32_t h, lv_opa_t opa,
+                                                      const lv_opa_t * mask, int32_t mask_stride)
+{
+    /*Buffer the mix ratio of the last mask value*/
+    lv_opa_t last_mask = LV_OPA_TRANSP;
+    uint32_t mix = 0;
+
+    int32_t x;
+    int32_t y;
+    for(y = 0; y < h; y++) {
+        x = 0;
+        if(((lv_uintptr_t)dest_buf & 0x2) && w > 0) {
+            if(mask[0]) dest_buf[0] = rgb565_mix_px(src_buf[0], dest_buf[0], RGB565_MIX(map_mask_opa(mask[0], opa)));
+            x = 1;
+        }
+
+        bool src_aligned = ((lv_uintptr_t)&src_buf[x] & 0x2) == 0;
+        for(; x < w - 1; x += 2) {
+            lv_opa_t m0 = mask[x];
+            lv_opa_t m1 = mask[x + 1];
+            if(m0 == m1) {
+                if(m0 == LV_OPA_TRANSP) continue;
+                if(m0 != last_mask) {
+                    mix = RGB565_MIX(map_mask_opa(m0, opa));
+                    last_mask = m0;
+                }
+                uint32_t * d32 = (uint32_t *)&dest_buf[x];
+                uint32_t s32 = rgb565_load_word(&src_buf[x], src_aligned);
+                if(mix == 32) *d32 = s32;
+                else *d32 = rgb565_mix_word(s32, *d32, mix);
+            }
+            else {
+                if(m0) dest_buf[x] = rgb565_mix_px(src_buf[x], dest_buf[x], RGB565_MIX(map_mask_opa(m0, opa)));
+                if(m1) dest_buf[x + 1] = rgb565_mix_px(src_buf[x + 1], dest_buf[x + 1], RGB565_MIX(map_mask_opa(m1, opa)));
+            }
+        }
+
+        if(x < w && mask[x]) dest_buf[x] = rgb565_mix_px(src_buf[x], dest_buf[x], RGB565_MIX(map_mask_opa(mask[x], opa)));
+
+        dest_buf += dest_stride;
+        src_buf += src_stride;
+        mask += mask_stride;
+    }
+}
+
 
 /**********************
  *   STATIC FUNCTIONS
@@ -234,6 +453,17 @@ LV_ATTRIBUTE_FAST_MEM static void fill_normal(lv_color_t * dest_buf, const lv_ar
     int32_t w = lv_area_get_width(dest_area);
     int32_t h = lv_area_get_height(dest_area);
 
+#if BLEND_RGB565_WORD
+    if(mask == NULL) {
+        if(opa >= LV_OPA_MAX) lv_draw_sw_rgb565_fill((uint16_t *)dest_buf, dest_stride, w, h, color.full);
+        else lv_draw_sw_rgb565_fill_opa((uint16_t *)dest_buf, dest_stride, w, h, color.full, opa);
+    }
+    else {
+        lv_draw_sw_rgb565_fill_mask((uint16_t *)dest_buf, dest_stride, w, h, color.full, opa, mask, mask_stride);
+    }
+    return;
+#endif
+
     int32_t x;
     int32_t y;
 
@@ -631,6 +861,18 @@ LV_ATTRIBUTE_FAST_MEM static void map_normal(lv_color_t * dest_buf, const lv_are
     int32_t w = lv_area_get_width(dest_area);
     int32_t h = lv_area_get_height(dest_area);
 
+#if BLEND_RGB565_WORD
+    if(mask) {
+        lv_draw_sw_rgb565_map_mask((uint16_t *)dest_buf, dest_stride, (const uint16_t *)src_buf, src_stride, w, h, opa,
+                                   mask, mask_stride);
+        return;
+    }
+    else if(opa < LV_OPA_MAX) {
+        lv_draw_sw_rgb565_map_opa((uint16_t *)dest_buf, dest_stride, (const uint16_t *)src_buf, src_stride, w, h, opa);
+        return;
+    }
+#endif
+
     int32_t x;
     int32_t y;
 
@@ -1037,3 +1279,42 @@ static inline lv_color_t color_blend_true_color_multiply(lv_color_t fg, lv_color
 
 #endif
 
+/*Mix both pixels of the words like lv_color_mix() with 16 bit color depth. `mix` is 0..32*/
+static inline uint32_t rgb565_mix_word(uint32_t fg, uint32_t bg, uint32_t mix)
+{
+    uint32_t bg_x = bg & RGB565_MASK_X;
+    uint32_t bg_y = (bg >> 5) & RGB565_MASK_Y;
+    uint32_t res_x = (((((fg & RGB565_MASK_X) - bg_x) * mix) >> 5) + bg_x) & RGB565_MASK_X;
+    uint32_t res_y = ((((((fg >> 5) & RGB565_MASK_Y) - bg_y) * mix) >> 5) + bg_y) & RGB565_MASK_Y;
+    return res_x | (res_y << 5);
+}
+
+static inline uint16_t rgb565_mix_px(uint16_t fg, uint16_t bg, uint32_t mix)
+{
+    uint32_t fg_x = ((uint32_t)fg | ((uint32_t)fg << 16)) & RGB565_MASK_X;
+    uint32_t bg_x = ((uint32_t)bg | ((uint32_t)bg << 16)) & RGB565_MASK_X;
+    uint32_t res = ((((fg_x - bg_x) * mix) >> 5) + bg_x) & RGB565_MASK_X;
+    return (uint16_t)((res >> 16) | res);
+}
+
+/*Little endian: the pixel on the lower address is the lower half word*/
+static inline uint32_t rgb565_load_word(const uint16_t * buf, bool aligned)
+{
+    if(aligned) return *((const uint32_t *)buf);
+    else return (uint32_t)buf[0] | ((uint32_t)buf[1] << 16);
+}
+
+/*The opacity of a masked pixel as fill_normal() calculates it*/
+static inline lv_opa_t fill_mask_opa(lv_opa_t mask, lv_opa_t opa)
+{
+    if(opa >= LV_OPA_MAX) return mask;
+    return mask == LV_OPA_COVER ? opa : (uint32_t)((uint32_t)mask * opa) >> 8;
+}
+
+/*The opacity of a masked pixel as map_normal() calculates it*/
+static inline lv_opa_t map_mask_opa(lv_opa_t mask, lv_opa_t opa)
+{
+    if(opa > LV_OPA_MAX) return mask;
+    return mask >= LV_OPA_MAX ? opa : (uint32_t)((uint32_t)mask * opa) >> 8;
+}
+
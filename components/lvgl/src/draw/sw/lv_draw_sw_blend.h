@@ -58,6 +58,80 @@ void lv_draw_sw_blend(struct _lv_draw_ctx_t * draw_ctx, const lv_draw_sw_blend_d
  */
 LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_blend_basic(struct _lv_draw_ctx_t * draw_ctx, const lv_draw_sw_blend_dsc_t * dsc);
 
+/*
+ * RGB565 kernels processing 2 pixels per 32 bit word.
+ * They work on `uint16_t` buffers in any color depth and give the same result as `lv_color_mix()`
+ * with `LV_COLOR_DEPTH 16`, `LV_COLOR_16_SWAP 0` and `LV_COLOR_MIX_ROUND_OFS 0`.
+ * `lv_draw_sw_blend_basic()` uses them in this configuration.
+ * The strides are in pixels (or mask bytes).
+ */
+
+/**
+ * Fill an area with a color.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param dest_stride   width of the destination buffer
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param color         the fill color
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill(uint16_t * dest_buf, int32_t dest_stride, int32_t w, int32_t h,
+                                                  uint16_t color);
+
+/**
+ * Mix a color to an area with an opacity.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param dest_stride   width of the destination buffer
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param color         the fill color
+ * @param opa           opacity of the color
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill_opa(uint16_t * dest_buf, int32_t dest_stride, int32_t w, int32_t h,
+                                                      uint16_t color, lv_opa_t opa);
+
+/**
+ * Mix a color to an area through an alpha mask.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param dest_stride   width of the destination buffer
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param color         the fill color
+ * @param opa           overall opacity, `>= LV_OPA_MAX` means only the mask matters
+ * @param mask          pointer to the mask value of the first pixel
+ * @param mask_stride   width of the mask buffer
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_fill_mask(uint16_t * dest_buf, int32_t dest_stride, int32_t w, int32_t h,
+                                                       uint16_t color, lv_opa_t opa, const lv_opa_t * mask, int32_t mask_stride);
+
+/**
+ * Mix an image to an area with an opacity.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param dest_stride   width of the destination buffer
+ * @param src_buf       pointer to the first pixel of the image
+ * @param src_stride    width of the image buffer
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param opa           opacity of the image
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_map_opa(uint16_t * dest_buf, int32_t dest_stride, const uint16_t * src_buf,
+                                                     int32_t src_stride, int32_t w, int32_t h, lv_opa_t opa);
+
+/**
+ * Mix an image to an area through an alpha mask.
+ * @param dest_buf      pointer to the first pixel of the area
+ * @param dest_stride   width of the destination buffer
+ * @param src_buf       pointer to the first pixel of the image
+ * @param src_stride    width of the image buffer
+ * @param w             width of the area
+ * @param h             height of the area
+ * @param opa           overall opacity, `> LV_OPA_MAX` means only the mask matters
+ * @param mask          pointer to the mask value of the first pixel
+ * @param mask_stride   width of the mask buffer
+ */
+LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_rgb565_map_mask(uint16_t * dest_buf, int32_t dest_stride, const uint16_t * src_buf,
+                                                      int32_t src_stride, int32_t w, int32_t h, lv_opa_t opa,
+                                                      const lv_opa_t * mask, int32_t mask_stride);
+
 /**********************
  *      MACROS
  **********************/
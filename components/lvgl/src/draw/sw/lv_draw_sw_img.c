@@ -102,6 +102,32 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_img_decoded(struct _lv_draw_ctx_t * draw_c
 
         lv_coord_t src_w = lv_area_get_width(coords);
         lv_coord_t src_h = lv_area_get_height(coords);
+
+#if LV_DRAW_COMPLEX
+        /*Draw only where the transformed image can be visible*/
+        _lv_draw_sw_transformed_t tr;
+        tr.cbuf = NULL;
+        if(transform) {
+            if(!_lv_draw_sw_transform_prepare(draw_ctx, draw_dsc, src_buf, src_w, src_h, cf, &tr)) return;
+
+            lv_area_t tr_area;
+            lv_area_copy(&tr_area, &tr.area);
+            lv_area_move(&tr_area, coords->x1, coords->y1);
+            if(!_lv_area_intersect(&blend_area, &blend_area, &tr_area)) return;
+
+            /*Nothing to modify on the cached pixels so blend them directly*/
+            if(tr.cbuf && !mask_any && draw_dsc->recolor_opa <= LV_OPA_MIN) {
+                blend_dsc.blend_area = &tr_area;
+                blend_dsc.src_buf = tr.cbuf;
+                blend_dsc.mask_buf = (lv_opa_t *)tr.abuf;
+                blend_dsc.mask_area = &tr_area;
+                blend_dsc.mask_res = LV_DRAW_MASK_RES_CHANGED;
+                lv_draw_sw_blend(draw_ctx, &blend_dsc);
+                return;
+            }
+        }
+#endif
+
         lv_coord_t blend_h = lv_area_get_height(&blend_area);
         lv_coord_t blend_w = lv_area_get_width(&blend_area);
 
@@ -139,6 +165,20 @@ LV_ATTRIBUTE_FAST_MEM void lv_draw_sw_img_decoded(struct _lv_draw_ctx_t * draw_c
             lv_area_t transform_area;
             lv_area_copy(&transform_area, &blend_area);
             lv_area_move(&transform_area, -coords->x1, -coords->y1);
+#if LV_DRAW_COMPLEX
+            if(tr.cbuf) {
+                /*Copy from the cache. The transformed area contains the blend area.*/
+                lv_coord_t tr_w = lv_area_get_width(&tr.area);
+                uint32_t ofs = (transform_area.y1 - tr.area.y1) * tr_w + (transform_area.x1 - tr.area.x1);
+                lv_coord_t y;
+                for(y = 0; y < lv_area_get_height(&transform_area); y++) {
+                    lv_memcpy(rgb_buf + y * blend_w, tr.cbuf + ofs, blend_w * sizeof(lv_color_t));
+                    lv_memcpy(mask_buf + y * blend_w, tr.abuf + ofs, blend_w);
+                    ofs += tr_w;
+                }
+            }
+            else
+#endif
             if(transform) {
                 lv_draw_transform(draw_ctx, &transform_area, src_buf, src_w, src_h, src_w,
                                   draw_dsc, cf, rgb_buf, mask_buf);
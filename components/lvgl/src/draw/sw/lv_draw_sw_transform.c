@@ -10,11 +10,16 @@
 #include "../../misc/lv_assert.h"
 #include "../../misc/lv_area.h"
 #include "../../core/lv_refr.h"
+#include "../../misc/lv_gc.h"
+#if defined(LV_IMG_CACHE_ALLOC) && LV_MEM_CUSTOM
+    #include LV_MEM_CUSTOM_INCLUDE
+#endif
 
 #if LV_DRAW_COMPLEX
 /*********************
  *      DEFINES
  *********************/
+#define TR_CACHE_LL (&LV_GC_ROOT(_lv_draw_sw_transform_cache_ll))
 
 /**********************
  *      TYPEDEFS
@@ -33,6 +38,22 @@ typedef struct {
     lv_point_t pivot;
 } point_transform_dsc_t;
 
+typedef struct {
+    const void * src_buf;
+    lv_coord_t src_w;
+    lv_coord_t src_h;
+    lv_img_cf_t cf;
+    int16_t angle;
+    uint16_t zoom;
+    lv_point_t pivot;
+    uint8_t antialias;
+    lv_area_t opa_area;     /*Bounding box of the not fully transparent pixels of the source*/
+    lv_area_t area;         /*Where the transformed image can be visible, relative to the image*/
+    uint32_t mem_size;
+    lv_color_t * cbuf;      /*The transformed pixels on `area`*/
+    lv_opa_t * abuf;
+} transform_cache_entry_t;
+
 /**********************
  *  STATIC PROTOTYPES
  **********************/
@@ -65,9 +86,22 @@ static void argb_and_rgb_aa(const uint8_t * src, lv_coord_t src_w, lv_coord_t sr
                             int32_t xs_ups, int32_t ys_ups, int32_t xs_step, int32_t ys_step,
                             int32_t x_end, lv_color_t * cbuf, uint8_t * abuf, lv_img_cf_t cf);
 
+static bool get_opa_area(lv_area_t * res, const uint8_t * src_buf, lv_coord_t src_w, lv_coord_t src_h,
+                         lv_img_cf_t cf);
+static bool is_transp(const uint8_t * opa, lv_coord_t len, uint32_t step);
+static void get_transformed_area(lv_area_t * res, const lv_area_t * opa_area, int16_t angle, uint16_t zoom,
+                                 const lv_point_t * pivot);
+static int16_t round_angle(int16_t angle);
+static void cache_init(void);
+static void cache_drop(transform_cache_entry_t * e);
+static void cache_shrink(size_t size);
+
 /**********************
  *  STATIC VARIABLES
  **********************/
+static size_t cache_mem_max = LV_IMG_TRANSFORM_CACHE_SIZE;
+static size_t cache_mem_used;
+static lv_draw_sw_transform_cache_stats_t cache_stats;
 
 /**********************
  *      MACROS
@@ -153,6 +187,144 @@ void lv_draw_sw_transform(lv_draw_ctx_t * draw_ctx, const lv_area_t * dest_area,
     }
 }
 
+bool _lv_draw_sw_transform_prepare(lv_draw_ctx_t * draw_ctx, const lv_draw_img_dsc_t * draw_dsc,
+                                   const uint8_t * src_buf, lv_coord_t src_w, lv_coord_t src_h, lv_img_cf_t cf,
+                                   _lv_draw_sw_transformed_t * res)
+{
+    res->cbuf = NULL;
+    res->abuf = NULL;
+    cache_init();
+
+    /*Close angles share the same cached image*/
+    int16_t angle = cache_mem_max ? round_angle(draw_dsc->angle) : draw_dsc->angle;
+
+    lv_area_t opa_area;
+    bool opa_area_known = false;
+    transform_cache_entry_t * e;
+    _LV_LL_READ(TR_CACHE_LL, e) {
+        if(e->src_buf != src_buf || e->src_w != src_w || e->src_h != src_h || e->cf != cf) continue;
+
+        if(e->angle == angle && e->zoom == draw_dsc->zoom && e->antialias == draw_dsc->antialias &&
+           e->pivot.x == draw_dsc->pivot.x && e->pivot.y == draw_dsc->pivot.y) {
+            cache_stats.hits++;
+            _lv_ll_move_before(TR_CACHE_LL, e, _lv_ll_get_head(TR_CACHE_LL));
+            res->area = e->area;
+            res->cbuf = e->cbuf;
+            res->abuf = e->abuf;
+            return true;
+        }
+
+        /*The same image with an other transformation: its opaque area is already known*/
+        opa_area = e->opa_area;
+        opa_area_known = true;
+    }
+
+    if(!opa_area_known && !get_opa_area(&opa_area, src_buf, src_w, src_h, cf)) return false;
+
+    get_transformed_area(&res->area, &opa_area, angle, draw_dsc->zoom, &draw_dsc->pivot);
+    if(cache_mem_max == 0) return true;
+
+    cache_stats.misses++;
+    uint32_t px_cnt = lv_area_get_size(&res->area);
+    uint32_t mem_size = px_cnt * (sizeof(lv_color_t) + sizeof(lv_opa_t));
+    uint8_t * buf = NULL;
+    if(mem_size <= cache_mem_max) {
+        cache_shrink(mem_size);
+#ifdef LV_IMG_CACHE_ALLOC
+        buf = LV_IMG_CACHE_ALLOC(mem_size);
+#endif
+        if(buf == NULL) buf = lv_mem_alloc(mem_size);
+    }
+    if(buf) {
+        e = _lv_ll_ins_head(TR_CACHE_LL);
+        if(e == NULL) lv_mem_free(buf);
+    }
+
+    /*Not cached: draw with the original angle*/
+    if(buf == NULL || e == NULL) {
+        if(angle != draw_dsc->angle) {
+            get_transformed_area(&res->area, &opa_area, draw_dsc->angle, draw_dsc->zoom, &draw_dsc->pivot);
+        }
+        return true;
+    }
+
+    e->src_buf = src_buf;
+    e->src_w = src_w;
+    e->src_h = src_h;
+    e->cf = cf;
+    e->angle = angle;
+    e->zoom = draw_dsc->zoom;
+    e->pivot = draw_dsc->pivot;
+    e->antialias = draw_dsc->antialias;
+    e->opa_area = opa_area;
+    e->area = res->area;
+    e->mem_size = mem_size;
+    e->cbuf = (lv_color_t *)buf;
+    e->abuf = buf + px_cnt * sizeof(lv_color_t);
+    cache_mem_used += mem_size;
+
+    /*Transform the whole visible area once, the next draws only blend it*/
+    lv_draw_img_dsc_t dsc_rounded = *draw_dsc;
+    dsc_rounded.angle = angle;
+    lv_draw_transform(draw_ctx, &e->area, src_buf, src_w, src_h, src_w, &dsc_rounded, cf, e->cbuf, e->abuf);
+
+    res->cbuf = e->cbuf;
+    res->abuf = e->abuf;
+    return true;
+}
+
+/**
+ * Drop the cached transformed images of a decoded image.
+ * Needs to be called when the image's pixels change or its buffer is freed.
+ * @param src_buf the decoded image data, NULL to drop every cached image
+ */
+void lv_draw_sw_transform_cache_invalidate(const void * src_buf)
+{
+    cache_init();
+
+    transform_cache_entry_t * e = _lv_ll_get_head(TR_CACHE_LL);
+    while(e) {
+        transform_cache_entry_t * e_next = _lv_ll_get_next(TR_CACHE_LL, e);
+        if(src_buf == NULL || e->src_buf == src_buf) cache_drop(e);
+        e = e_next;
+    }
+}
+
+/**
+ * Limit the memory used by the transformed images.
+ * Least recently used images are dropped until the cache fits the new limit.
+ * @param size budget in bytes, 0: disable the cache
+ */
+void lv_draw_sw_transform_cache_set_mem_size(size_t size)
+{
+    cache_init();
+    cache_mem_max = size;
+    cache_shrink(0);
+}
+
+/**
+ * Get the hit/miss counters and the memory usage of the transformed image cache
+ * @param stats store the statistics here
+ */
+void lv_draw_sw_transform_cache_get_stats(lv_draw_sw_transform_cache_stats_t * stats)
+{
+    cache_init();
+    *stats = cache_stats;
+    stats->entries = _lv_ll_get_len(TR_CACHE_LL);
+    stats->mem_used = cache_mem_used;
+    stats->mem_max = cache_mem_max;
+}
+
+/**
+ * Reset the hit, miss and eviction counters of the transformed image cache
+ */
+void lv_draw_sw_transform_cache_reset_stats(void)
+{
+    cache_stats.hits = 0;
+    cache_stats.misses = 0;
+    cache_stats.evictions = 0;
+}
+
 /**********************
  *   STATIC FUNCTIONS
  **********************/
@@ -492,5 +664,146 @@ static void transform_point_upscaled(point_transform_dsc_t * t, int32_t xin, int
     }
 }
 
+/**
+ * Get the bounding box of the not fully transparent pixels of an image.
+ * Only the alpha formats are checked, the others are assumed to be opaque everywhere.
+ * @param res       store the bounding box here
+ * @param src_buf   the decoded image
+ * @param src_w     width of the image
+ * @param src_h     height of the image
+ * @param cf        color format of the image
+ * @return          false: all pixels are transparent
+ */
+static bool get_opa_area(lv_area_t * res, const uint8_t * src_buf, lv_coord_t src_w, lv_coord_t src_h,
+                         lv_img_cf_t cf)
+{
+    lv_area_set(res, 0, 0, src_w - 1, src_h - 1);
+
+    /*The opacity of the pixels is every `px_size`th byte from `opa`*/
+    const uint8_t * opa;
+    uint32_t px_size;
+    if(cf == LV_IMG_CF_TRUE_COLOR_ALPHA) {
+        opa = src_buf + LV_IMG_PX_SIZE_ALPHA_BYTE - 1;
+        px_size = LV_IMG_PX_SIZE_ALPHA_BYTE;
+    }
+#if LV_COLOR_DEPTH == 16
+    else if(cf == LV_IMG_CF_RGB565A8) {
+        opa = src_buf + src_w * src_h * sizeof(lv_color_t);
+        px_size = 1;
+    }
 #endif
+    else {
+        return true;
+    }
+
+    uint32_t stride = src_w * px_size;
+    lv_coord_t y;
+    for(y = 0; y < src_h && is_transp(opa + y * stride, src_w, px_size); y++);
+    if(y == src_h) return false;
+    res->y1 = y;
+    for(y = src_h - 1; is_transp(opa + y * stride, src_w, px_size); y--);
+    res->y2 = y;
+
+    /*Check the columns only between the first and last visible rows*/
+    const uint8_t * opa_col = opa + res->y1 * stride;
+    lv_coord_t h = lv_area_get_height(res);
+    lv_coord_t x;
+    for(x = 0; is_transp(opa_col + x * px_size, h, stride); x++);
+    res->x1 = x;
+    for(x = src_w - 1; is_transp(opa_col + x * px_size, h, stride); x--);
+    res->x2 = x;
+
+    return true;
+}
 
+/**
+ * Tell whether pixels are all fully transparent
+ * @param opa       the opacity of the first pixel
+ * @param len       number of pixels to check
+ * @param step      distance of the pixels' opacity in bytes
+ * @return          true: all pixels are transparent
+ */
+static bool is_transp(const uint8_t * opa, lv_coord_t len, uint32_t step)
+{
+    lv_coord_t i;
+    for(i = 0; i < len; i++) {
+        if(*opa) return false;
+        opa += step;
+    }
+    return true;
+}
+
+/**
+ * Get where the transformed opaque area of an image can be visible.
+ * Similar to `_lv_img_buf_get_transformed_area` but the anti-aliasing mixes
+ * the 1 px wide ring around the opaque area too.
+ */
+static void get_transformed_area(lv_area_t * res, const lv_area_t * opa_area, int16_t angle, uint16_t zoom,
+                                 const lv_point_t * pivot)
+{
+    lv_point_t p[4] = {
+        {opa_area->x1 - 1, opa_area->y1 - 1},
+        {opa_area->x2 + 2, opa_area->y1 - 1},
+        {opa_area->x1 - 1, opa_area->y2 + 2},
+        {opa_area->x2 + 2, opa_area->y2 + 2},
+    };
+    lv_point_transform(&p[0], angle, zoom, pivot);
+    lv_point_transform(&p[1], angle, zoom, pivot);
+    lv_point_transform(&p[2], angle, zoom, pivot);
+    lv_point_transform(&p[3], angle, zoom, pivot);
+    res->x1 = LV_MIN4(p[0].x, p[1].x, p[2].x, p[3].x) - 2;
+    res->x2 = LV_MAX4(p[0].x, p[1].x, p[2].x, p[3].x) + 2;
+    res->y1 = LV_MIN4(p[0].y, p[1].y, p[2].y, p[3].y) - 2;
+    res->y2 = LV_MAX4(p[0].y, p[1].y, p[2].y, p[3].y) + 2;
+}
+
+/**
+ * Round an angle to `LV_IMG_TRANSFORM_CACHE_ANGLE_STEP`
+ * @param angle     angle in 0.1 degree
+ * @return          the rounded angle in [0..3600) range
+ */
+static int16_t round_angle(int16_t angle)
+{
+    int32_t a = angle % 3600;
+    if(a < 0) a += 3600;
+#if LV_IMG_TRANSFORM_CACHE_ANGLE_STEP > 1
+    a = (a + LV_IMG_TRANSFORM_CACHE_ANGLE_STEP / 2) / LV_IMG_TRANSFORM_CACHE_ANGLE_STEP;
+    a = a * LV_IMG_TRANSFORM_CACHE_ANGLE_STEP;
+    if(a >= 3600) a -= 3600;
+#endif
+    return (int16_t)a;
+}
+
+static void cache_init(void)
+{
+    /*The GC roots are cleared in `lv_init`*/
+    if(TR_CACHE_LL->n_size == 0) {
+        _lv_ll_init(TR_CACHE_LL, sizeof(transform_cache_entry_t));
+        cache_mem_used = 0;
+    }
+}
+
+static void cache_drop(transform_cache_entry_t * e)
+{
+    cache_mem_used -= e->mem_size;
+    lv_mem_free(e->cbuf);
+    _lv_ll_remove(TR_CACHE_LL, e);
+    lv_mem_free(e);
+}
+
+/**
+ * Drop the least recently used images until `size` more bytes fit the budget
+ * @param size      bytes to make room for
+ */
+static void cache_shrink(size_t size)
+{
+    transform_cache_entry_t * e = _lv_ll_get_tail(TR_CACHE_LL);
+    while(e && cache_mem_used + size > cache_mem_max) {
+        transform_cache_entry_t * e_prev = _lv_ll_get_prev(TR_CACHE_LL, e);
+        cache_drop(e);
+        cache_stats.evictions++;
+        e = e_prev;
+    }
+}
+
+#endif
@@ -12,6 +12,9 @@
 #include "lv_png.h"
 #include "lodepng.h"
 #include <stdlib.h>
+#if defined(LV_IMG_CACHE_ALLOC) && LV_MEM_CUSTOM
+    #include LV_MEM_CUSTOM_INCLUDE
+#endif
 
 /*********************
  *      DEFINES
@@ -28,6 +31,7 @@ static lv_res_t decoder_info(struct _lv_img_decoder_t * decoder, const void * sr
 static lv_res_t decoder_open(lv_img_decoder_t * dec, lv_img_decoder_dsc_t * dsc);
 static void decoder_close(lv_img_decoder_t * dec, lv_img_decoder_dsc_t * dsc);
 static void convert_color_depth(uint8_t * img, uint32_t px_cnt);
+static uint8_t * place_decoded(uint8_t * img, uint32_t px_cnt);
 
 /**********************
  *  STATIC VARIABLES
@@ -163,7 +167,7 @@ static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t *
 
             /*Convert the image to the system's color depth*/
             convert_color_depth(img_data,  png_width * png_height);
-            dsc->img_data = img_data;
+            dsc->img_data = place_decoded(img_data, png_width * png_height);
             return LV_RES_OK;     /*The image is fully decoded. Return with its pointer*/
         }
     }
@@ -186,7 +190,7 @@ static lv_res_t decoder_open(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t *
         /*Convert the image to the system's color depth*/
         convert_color_depth(img_data,  png_width * png_height);
 
-        dsc->img_data = img_data;
+        dsc->img_data = place_decoded(img_data, png_width * png_height);
         return LV_RES_OK;     /*Return with its pointer*/
     }
 
@@ -205,6 +209,29 @@ static void decoder_close(lv_img_decoder_t * decoder, lv_img_decoder_dsc_t * dsc
     }
 }
 
+/**
+ * Move the converted image to the memory given by `LV_IMG_CACHE_ALLOC` (e.g. PSRAM).
+ * Only the converted pixels are copied so the ARGB8888 decode buffer is trimmed too.
+ * @param img the converted image
+ * @param px_cnt number of pixels in `img`
+ * @return the image at its new place, or `img` if it can't be moved
+ */
+static uint8_t * place_decoded(uint8_t * img, uint32_t px_cnt)
+{
+#ifdef LV_IMG_CACHE_ALLOC
+    uint32_t size = px_cnt * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    uint8_t * placed = LV_IMG_CACHE_ALLOC(size);
+    if(placed == NULL) return img;
+
+    lv_memcpy(placed, img, size);
+    lv_mem_free(img);
+    return placed;
+#else
+    LV_UNUSED(px_cnt);
+    return img;
+#endif
+}
+
 /**
  * If the display is not in 32 bit format (ARGB888) then covert the image to the current color depth
  * @param img the ARGB888 image
@@ -189,6 +189,14 @@ uint8_t del_prev  :
     uint16_t inv_p;
     int32_t inv_en_cnt;
 
+#if LV_INV_TILES
+    /** Invalidated 16x16 tiles. They are converted to `inv_areas` when the display is refreshed*/
+    uint32_t * inv_tile_bits;       /**< One bit per tile, each row of tiles starts a new word*/
+    uint16_t * inv_tile_bounds;     /**< Dirty part of each marked tile*/
+    uint16_t inv_tile_cols;
+    uint16_t inv_tile_rows;
+#endif
+
     /*Miscellaneous data*/
     uint32_t last_activity_time;        /**< Last time when there was activity on this display*/
 } lv_disp_t;
@@ -32,6 +32,7 @@ static void lv_canvas_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj
 static void lv_canvas_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
 static void init_fake_disp(lv_obj_t * canvas, lv_disp_t * disp, lv_disp_drv_t * drv, lv_area_t * clip_area);
 static void deinit_fake_disp(lv_obj_t * canvas, lv_disp_t * disp);
+static void invalidate_buf(lv_obj_t * obj);
 
 /**********************
  *  STATIC VARIABLES
@@ -70,6 +71,8 @@ void lv_canvas_set_buffer(lv_obj_t * obj, void * buf, lv_coord_t w, lv_coord_t h
 
     lv_canvas_t * canvas = (lv_canvas_t *)obj;
 
+    lv_img_cache_invalidate_src(&canvas->dsc);
+
     canvas->dsc.header.cf = cf;
     canvas->dsc.header.w  = w;
     canvas->dsc.header.h  = h;
@@ -86,7 +89,7 @@ void lv_canvas_set_px_color(lv_obj_t * obj, lv_coord_t x, lv_coord_t y, lv_color
     lv_canvas_t * canvas = (lv_canvas_t *)obj;
 
     lv_img_buf_set_px_color(&canvas->dsc, x, y, c);
-    lv_obj_invalidate(obj);
+    invalidate_buf(obj);
 }
 
 void lv_canvas_set_px_opa(lv_obj_t * obj, lv_coord_t x, lv_coord_t y, lv_opa_t opa)
@@ -96,7 +99,7 @@ void lv_canvas_set_px_opa(lv_obj_t * obj, lv_coord_t x, lv_coord_t y, lv_opa_t o
     lv_canvas_t * canvas = (lv_canvas_t *)obj;
 
     lv_img_buf_set_px_alpha(&canvas->dsc, x, y, opa);
-    lv_obj_invalidate(obj);
+    invalidate_buf(obj);
 }
 
 void lv_canvas_set_palette(lv_obj_t * obj, uint8_t id, lv_color_t c)
@@ -106,7 +109,7 @@ void lv_canvas_set_palette(lv_obj_t * obj, uint8_t id, lv_color_t c)
     lv_canvas_t * canvas = (lv_canvas_t *)obj;
 
     lv_img_buf_set_palette(&canvas->dsc, id, c);
-    lv_obj_invalidate(obj);
+    invalidate_buf(obj);
 }
 
 /*=====================
@@ -156,6 +159,7 @@ void lv_canvas_copy_buf(lv_obj_t * obj, const void * to_copy, lv_coord_t x, lv_c
         px += canvas->dsc.header.w * px_size;
         to_copy8 += w * px_size;
     }
+    invalidate_buf(obj);
 }
 
 void lv_canvas_transform(lv_obj_t * obj, lv_img_dsc_t * src_img, int16_t angle, uint16_t zoom, lv_coord_t offset_x,
@@ -210,7 +214,7 @@ void lv_canvas_transform(lv_obj_t * obj, lv_img_dsc_t * src_img, int16_t angle,
     lv_mem_free(cbuf);
     lv_mem_free(abuf);
 
-    lv_obj_invalidate(obj);
+    invalidate_buf(obj);
 
 #else
     LV_UNUSED(obj);
@@ -349,7 +353,7 @@ void lv_canvas_blur_hor(lv_obj_t * obj, const lv_area_t * area, uint16_t r)
             if(has_alpha) asum += opa;
         }
     }
-    lv_obj_invalidate(obj);
+    invalidate_buf(obj);
 
     lv_mem_buf_release(line_buf);
 }
@@ -482,7 +486,7 @@ void lv_canvas_blur_ver(lv_obj_t * obj, const lv_area_t * area, uint16_t r)
         }
     }
 
-    lv_obj_invalidate(obj);
+    invalidate_buf(obj);
 
     lv_mem_buf_release(col_buf);
 }
@@ -513,7 +517,7 @@ void lv_canvas_fill_bg(lv_obj_t * canvas, lv_color_t color, lv_opa_t opa)
         }
     }
 
-    lv_obj_invalidate(canvas);
+    invalidate_buf(canvas);
 }
 
 void lv_canvas_draw_rect(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord_t w, lv_coord_t h,
@@ -557,7 +561,7 @@ void lv_canvas_draw_rect(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord
 
     deinit_fake_disp(canvas, &fake_disp);
 
-    lv_obj_invalidate(canvas);
+    invalidate_buf(canvas);
 }
 
 void lv_canvas_draw_text(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord_t max_w,
@@ -593,7 +597,7 @@ void lv_canvas_draw_text(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord
 
     deinit_fake_disp(canvas, &fake_disp);
 
-    lv_obj_invalidate(canvas);
+    invalidate_buf(canvas);
 }
 
 void lv_canvas_draw_img(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, const void * src,
@@ -636,7 +640,7 @@ void lv_canvas_draw_img(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, const voi
 
     deinit_fake_disp(canvas, &fake_disp);
 
-    lv_obj_invalidate(canvas);
+    invalidate_buf(canvas);
 }
 
 void lv_canvas_draw_line(lv_obj_t * canvas, const lv_point_t points[], uint32_t point_cnt,
@@ -678,7 +682,7 @@ void lv_canvas_draw_line(lv_obj_t * canvas, const lv_point_t points[], uint32_t
 
     deinit_fake_disp(canvas, &fake_disp);
 
-    lv_obj_invalidate(canvas);
+    invalidate_buf(canvas);
 }
 
 void lv_canvas_draw_polygon(lv_obj_t * canvas, const lv_point_t points[], uint32_t point_cnt,
@@ -716,7 +720,7 @@ void lv_canvas_draw_polygon(lv_obj_t * canvas, const lv_point_t points[], uint32
 
     deinit_fake_disp(canvas, &fake_disp);
 
-    lv_obj_invalidate(canvas);
+    invalidate_buf(canvas);
 }
 
 void lv_canvas_draw_arc(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord_t r, int32_t start_angle,
@@ -749,7 +753,7 @@ void lv_canvas_draw_arc(lv_obj_t * canvas, lv_coord_t x, lv_coord_t y, lv_coord_
 
     deinit_fake_disp(canvas, &fake_disp);
 
-    lv_obj_invalidate(canvas);
+    invalidate_buf(canvas);
 #else
     LV_UNUSED(canvas);
     LV_UNUSED(x);
@@ -834,6 +838,14 @@ static void deinit_fake_disp(lv_obj_t * canvas, lv_disp_t * disp)
     lv_mem_free(disp->driver->draw_ctx);
 }
 
+/*The pixels have changed: drop the cached copies of the image and redraw it*/
+static void invalidate_buf(lv_obj_t * obj)
+{
+    lv_canvas_t * canvas = (lv_canvas_t *)obj;
+    lv_img_cache_invalidate_src(&canvas->dsc);
+    lv_obj_invalidate(obj);
+}
+
 
 
 #endif
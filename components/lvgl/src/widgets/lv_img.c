@@ -12,6 +12,7 @@
 #include "../core/lv_disp.h"
 #include "../misc/lv_assert.h"
 #include "../draw/lv_img_decoder.h"
+#include "../draw/lv_img_cache.h"
 #include "../misc/lv_fs.h"
 #include "../misc/lv_txt.h"
 #include "../misc/lv_math.h"
@@ -106,6 +107,17 @@ void lv_img_set_src(lv_obj_t * obj, const void * src)
     lv_img_header_t header;
     lv_img_decoder_get_info(src, &header);
 
+#if LV_IMG_CACHE_DEF_SIZE
+    /*Decode now so the first frame showing the image doesn't have to*/
+    if(src_type == LV_IMG_SRC_FILE || src_type == LV_IMG_SRC_VARIABLE) {
+        lv_color_t recolor = lv_color_black();
+        if(lv_obj_get_style_img_recolor_opa(obj, LV_PART_MAIN) > 0) {
+            recolor = lv_obj_get_style_img_recolor_filtered(obj, LV_PART_MAIN);
+        }
+        lv_img_cache_prewarm(src, recolor);
+    }
+#endif
+
     /*Save the source*/
     if(src_type == LV_IMG_SRC_VARIABLE) {
         /*If memory was allocated because of the previous `src_type` then free it*/
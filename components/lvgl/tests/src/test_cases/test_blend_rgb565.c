@@ -0,0 +1,374 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+#include "../src/draw/sw/lv_draw_sw.h"
+
+#include "unity/unity.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BUF_W   48
+#define BUF_H   6
+
+#define BENCH_W     480
+#define BENCH_H     40
+#define BENCH_LOOP  200
+
+/*4 byte aligned buffers, the tests add offsets to them*/
+static uint32_t dest_kernel32[BUF_W * BUF_H / 2];
+static uint32_t dest_ref32[BUF_W * BUF_H / 2];
+static uint32_t src32[BUF_W * BUF_H / 2];
+static uint32_t mask32[BUF_W * BUF_H / 4];
+
+static uint32_t seed;
+
+static uint32_t rnd(void)
+{
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+/*lv_color_mix() with LV_COLOR_DEPTH 16, LV_COLOR_16_SWAP 0 and LV_COLOR_MIX_ROUND_OFS 0*/
+static uint16_t ref_mix(uint16_t c1, uint16_t c2, uint8_t mix)
+{
+    mix = (uint32_t)((uint32_t)mix + 4) >> 3;
+    uint32_t bg = (uint32_t)((uint32_t)c2 | ((uint32_t)c2 << 16)) & 0x7E0F81F;
+    uint32_t fg = (uint32_t)((uint32_t)c1 | ((uint32_t)c1 << 16)) & 0x7E0F81F;
+    uint32_t result = ((((fg - bg) * mix) >> 5) + bg) & 0x7E0F81F;
+    return (uint16_t)((result >> 16) | result);
+}
+
+/*The per pixel fill_normal() and map_normal() of lv_draw_sw_blend.c*/
+static void ref_fill(uint16_t * dest, int32_t stride, int32_t w, int32_t h, uint16_t color, lv_opa_t opa,
+                     const lv_opa_t * mask, int32_t mask_stride)
+{
+    int32_t x, y;
+    for(y = 0; y < h; y++) {
+        for(x = 0; x < w; x++) {
+            if(mask == NULL) {
+                dest[x] = opa >= LV_OPA_MAX ? color : ref_mix(color, dest[x], opa);
+            }
+            else if(mask[x]) {
+                if(opa >= LV_OPA_MAX) {
+                    dest[x] = mask[x] == LV_OPA_COVER ? color : ref_mix(color, dest[x], mask[x]);
+                }
+                else {
+                    lv_opa_t opa_tmp = mask[x] == LV_OPA_COVER ? opa : (uint32_t)((uint32_t)mask[x] * opa) >> 8;
+                    dest[x] = ref_mix(color, dest[x], opa_tmp);
+                }
+            }
+        }
+        dest += stride;
+        if(mask) mask += mask_stride;
+    }
+}
+
+static void ref_map(uint16_t * dest, int32_t stride, const uint16_t * src, int32_t src_stride, int32_t w, int32_t h,
+                    lv_opa_t opa, const lv_opa_t * mask, int32_t mask_stride)
+{
+    int32_t x, y;
+    for(y = 0; y < h; y++) {
+        for(x = 0; x < w; x++) {
+            if(mask == NULL) {
+                dest[x] = opa >= LV_OPA_MAX ? src[x] : ref_mix(src[x], dest[x], opa);
+            }
+            else if(mask[x]) {
+                if(opa > LV_OPA_MAX) {
+                    dest[x] = mask[x] == LV_OPA_COVER ? src[x] : ref_mix(src[x], dest[x], mask[x]);
+                }
+                else {
+                    lv_opa_t opa_tmp = mask[x] >= LV_OPA_MAX ? opa : ((opa * mask[x]) >> 8);
+                    dest[x] = ref_mix(src[x], dest[x], opa_tmp);
+                }
+            }
+        }
+        dest += stride;
+        src += src_stride;
+        if(mask) mask += mask_stride;
+    }
+}
+
+/*Runs of transparent, covering, equal and random mask values*/
+static void fill_mask(lv_opa_t * mask, uint32_t size)
+{
+    uint32_t i = 0;
+    while(i < size) {
+        uint32_t len = rnd() % 9 + 1;
+        uint32_t type = rnd() % 4;
+        lv_opa_t v = (lv_opa_t)rnd();
+        while(len && i < size) {
+            if(type == 0) mask[i] = LV_OPA_TRANSP;
+            else if(type == 1) mask[i] = LV_OPA_COVER;
+            else if(type == 2) mask[i] = v;
+            else mask[i] = (lv_opa_t)rnd();
+            len--;
+            i++;
+        }
+    }
+}
+
+static void buffers_init(void)
+{
+    uint32_t i;
+    for(i = 0; i < sizeof(dest_kernel32) / 4; i++) {
+        dest_kernel32[i] = rnd() ^ (rnd() << 16);
+        src32[i] = rnd() ^ (rnd() << 16);
+    }
+    lv_memcpy(dest_ref32, dest_kernel32, sizeof(dest_ref32));
+    fill_mask((lv_opa_t *)mask32, sizeof(mask32));
+}
+
+static const int32_t widths[] = {0, 1, 2, 3, 4, 5, 8, 13, 31, 40};
+
+/*Check all alignments of the destination, source and mask and odd widths*/
+static void check_fill(bool with_mask, lv_opa_t opa)
+{
+    uint32_t i;
+    int32_t ofs;
+    for(i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+        for(ofs = 0; ofs < 4; ofs++) {
+            buffers_init();
+            uint16_t color = (uint16_t)rnd();
+            int32_t w = widths[i];
+            int32_t h = BUF_H - 1;
+            uint16_t * dest_kernel = (uint16_t *)dest_kernel32 + ofs;
+            uint16_t * dest_ref = (uint16_t *)dest_ref32 + ofs;
+            const lv_opa_t * mask = with_mask ? (lv_opa_t *)mask32 + ofs : NULL;
+
+            ref_fill(dest_ref, BUF_W, w, h, color, opa, mask, BUF_W - 1);
+            if(mask) lv_draw_sw_rgb565_fill_mask(dest_kernel, BUF_W, w, h, color, opa, mask, BUF_W - 1);
+            else if(opa >= LV_OPA_MAX) lv_draw_sw_rgb565_fill(dest_kernel, BUF_W, w, h, color);
+            else lv_draw_sw_rgb565_fill_opa(dest_kernel, BUF_W, w, h, color, opa);
+
+            TEST_ASSERT_EQUAL_HEX16_ARRAY((uint16_t *)dest_ref32, (uint16_t *)dest_kernel32, BUF_W * BUF_H);
+        }
+    }
+}
+
+static void check_map(bool with_mask, lv_opa_t opa)
+{
+    uint32_t i;
+    int32_t ofs;
+    for(i = 0; i < sizeof(widths) / sizeof(widths[0]); i++) {
+        for(ofs = 0; ofs < 8; ofs++) {
+            buffers_init();
+            int32_t w = widths[i];
+            int32_t h = BUF_H - 1;
+            uint16_t * dest_kernel = (uint16_t *)dest_kernel32 + (ofs & 0x1);
+            uint16_t * dest_ref = (uint16_t *)dest_ref32 + (ofs & 0x1);
+            const uint16_t * src = (uint16_t *)src32 + ((ofs >> 1) & 0x1);
+            const lv_opa_t * mask = with_mask ? (lv_opa_t *)mask32 + (ofs >> 1) : NULL;
+
+            ref_map(dest_ref, BUF_W, src, BUF_W - 1, w, h, opa, mask, BUF_W - 2);
+            if(mask) lv_draw_sw_rgb565_map_mask(dest_kernel, BUF_W, src, BUF_W - 1, w, h, opa, mask, BUF_W - 2);
+            else lv_draw_sw_rgb565_map_opa(dest_kernel, BUF_W, src, BUF_W - 1, w, h, opa);
+
+            TEST_ASSERT_EQUAL_HEX16_ARRAY((uint16_t *)dest_ref32, (uint16_t *)dest_kernel32, BUF_W * BUF_H);
+        }
+    }
+}
+
+void setUp(void)
+{
+    seed = 12345;
+}
+
+void tearDown(void)
+{
+}
+
+void test_blend_rgb565_mix_word(void)
+{
+#if LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0 && LV_COLOR_MIX_ROUND_OFS == 0
+    /*The reference is really lv_color_mix()*/
+    uint32_t i;
+    for(i = 0; i < 100000; i++) {
+        lv_color_t c1;
+        lv_color_t c2;
+        c1.full = (uint16_t)rnd();
+        c2.full = (uint16_t)rnd();
+        lv_opa_t mix = (lv_opa_t)rnd();
+        TEST_ASSERT_EQUAL_HEX16(lv_color_mix(c1, c2, mix).full, ref_mix(c1.full, c2.full, mix));
+    }
+#endif
+
+    /*Extreme field values in both pixels of the words*/
+    static const uint16_t colors[] = {0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x07FF, 0xF81F, 0xFFE0, 0x0821, 0xF7DE};
+    uint32_t fg;
+    uint32_t bg;
+    uint32_t opa;
+    const uint32_t color_cnt = sizeof(colors) / sizeof(colors[0]);
+    for(fg = 0; fg < color_cnt * color_cnt; fg++) {
+        for(bg = 0; bg < color_cnt * color_cnt; bg++) {
+            for(opa = 0; opa <= 255; opa += 3) {
+                uint16_t * d = (uint16_t *)dest_kernel32;
+                uint16_t * s = (uint16_t *)src32;
+                s[0] = colors[fg % color_cnt];
+                s[1] = colors[fg / color_cnt];
+                d[0] = colors[bg % color_cnt];
+                d[1] = colors[bg / color_cnt];
+                uint16_t res0 = ref_mix(s[0], d[0], (lv_opa_t)opa);
+                uint16_t res1 = ref_mix(s[1], d[1], (lv_opa_t)opa);
+                lv_draw_sw_rgb565_map_opa(d, 2, s, 2, 2, 1, (lv_opa_t)opa);
+                TEST_ASSERT_EQUAL_HEX16(res0, d[0]);
+                TEST_ASSERT_EQUAL_HEX16(res1, d[1]);
+            }
+        }
+    }
+}
+
+void test_blend_rgb565_fill(void)
+{
+    check_fill(false, LV_OPA_COVER);
+    check_fill(false, LV_OPA_MAX);
+}
+
+void test_blend_rgb565_fill_opa(void)
+{
+    uint32_t opa;
+    for(opa = LV_OPA_MIN; opa < LV_OPA_MAX; opa++) {
+        check_fill(false, (lv_opa_t)opa);
+    }
+}
+
+void test_blend_rgb565_fill_mask(void)
+{
+    uint32_t opa;
+    for(opa = LV_OPA_MIN; opa <= LV_OPA_COVER; opa += 7) {
+        check_fill(true, (lv_opa_t)opa);
+    }
+    check_fill(true, LV_OPA_MAX);
+    check_fill(true, LV_OPA_MAX - 1);
+    check_fill(true, LV_OPA_COVER);
+}
+
+void test_blend_rgb565_map_opa(void)
+{
+    uint32_t opa;
+    for(opa = LV_OPA_MIN; opa < LV_OPA_MAX; opa++) {
+        check_map(false, (lv_opa_t)opa);
+    }
+}
+
+void test_blend_rgb565_map_mask(void)
+{
+    uint32_t opa;
+    for(opa = LV_OPA_MIN; opa <= LV_OPA_COVER; opa += 7) {
+        check_map(true, (lv_opa_t)opa);
+    }
+    check_map(true, LV_OPA_MAX);
+    check_map(true, LV_OPA_MAX + 1);
+    check_map(true, LV_OPA_COVER);
+}
+
+/**********************
+ * Benchmark
+ **********************/
+
+static uint16_t bench_dest[BENCH_W * BENCH_H];
+static uint16_t bench_src[BENCH_W * BENCH_H];
+static lv_opa_t bench_mask[BENCH_W * BENCH_H];
+
+static double cpu_ms(void)
+{
+    return (double)clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/*Anti-aliased circles: large covered and transparent areas with some edges*/
+static void bench_mask_init(void)
+{
+    int32_t x, y;
+    for(y = 0; y < BENCH_H; y++) {
+        for(x = 0; x < BENCH_W; x++) {
+            int32_t cx = (x / BENCH_H) * BENCH_H + BENCH_H / 2;
+            int32_t dx = x - cx;
+            int32_t dy = y - BENCH_H / 2;
+            lv_sqrt_res_t r;
+            lv_sqrt((uint32_t)(dx * dx + dy * dy), &r, 0x800);
+            int32_t d = (int32_t)(r.i * 256 + r.f) - (BENCH_H / 2 - 2) * 256;
+            bench_mask[y * BENCH_W + x] = d <= 0 ? LV_OPA_COVER : d >= 256 ? LV_OPA_TRANSP : (lv_opa_t)(255 - d);
+        }
+    }
+}
+
+static void bench_print(const char * name, double t_ref, double t_kernel)
+{
+    double px = (double)BENCH_W * BENCH_H * BENCH_LOOP;
+    printf("rgb565 %-10s: reference %6.2f ns/px, word-wide %6.2f ns/px, %.2fx\n",
+           name, t_ref * 1e6 / px, t_kernel * 1e6 / px, t_ref / t_kernel);
+}
+
+void test_blend_rgb565_bench(void)
+{
+    uint32_t i;
+    for(i = 0; i < BENCH_W * BENCH_H; i++) {
+        bench_dest[i] = (uint16_t)(i / 7);
+        bench_src[i] = (uint16_t)rnd();
+    }
+    bench_mask_init();
+
+    const uint16_t color = 0x3A5F;
+    const lv_opa_t opa = LV_OPA_60;
+    double t_start;
+    double t_ref;
+    double t_kernel;
+
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) ref_fill(bench_dest, BENCH_W, BENCH_W, BENCH_H, color, LV_OPA_COVER, NULL, 0);
+    t_ref = cpu_ms() - t_start;
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) lv_draw_sw_rgb565_fill(bench_dest, BENCH_W, BENCH_W, BENCH_H, color);
+    t_kernel = cpu_ms() - t_start;
+    bench_print("fill", t_ref, t_kernel);
+
+    /*Restore a varying background before each pass to not measure only the cached result*/
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) {
+        lv_memcpy(bench_dest, bench_src, sizeof(bench_dest));
+        ref_fill(bench_dest, BENCH_W, BENCH_W, BENCH_H, color, opa, NULL, 0);
+    }
+    t_ref = cpu_ms() - t_start;
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) {
+        lv_memcpy(bench_dest, bench_src, sizeof(bench_dest));
+        lv_draw_sw_rgb565_fill_opa(bench_dest, BENCH_W, BENCH_W, BENCH_H, color, opa);
+    }
+    t_kernel = cpu_ms() - t_start;
+    bench_print("fill_opa", t_ref, t_kernel);
+
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) {
+        lv_memcpy(bench_dest, bench_src, sizeof(bench_dest));
+        ref_fill(bench_dest, BENCH_W, BENCH_W, BENCH_H, color, LV_OPA_COVER, bench_mask, BENCH_W);
+    }
+    t_ref = cpu_ms() - t_start;
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) {
+        lv_memcpy(bench_dest, bench_src, sizeof(bench_dest));
+        lv_draw_sw_rgb565_fill_mask(bench_dest, BENCH_W, BENCH_W, BENCH_H, color, LV_OPA_COVER, bench_mask, BENCH_W);
+    }
+    t_kernel = cpu_ms() - t_start;
+    bench_print("fill_mask", t_ref, t_kernel);
+
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) ref_map(bench_dest, BENCH_W, bench_src, BENCH_W, BENCH_W, BENCH_H, opa, NULL, 0);
+    t_ref = cpu_ms() - t_start;
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) lv_draw_sw_rgb565_map_opa(bench_dest, BENCH_W, bench_src, BENCH_W, BENCH_W, BENCH_H, opa);
+    t_kernel = cpu_ms() - t_start;
+    bench_print("map_opa", t_ref, t_kernel);
+
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) {
+        ref_map(bench_dest, BENCH_W, bench_src, BENCH_W, BENCH_W, BENCH_H, LV_OPA_COVER, bench_mask, BENCH_W);
+    }
+    t_ref = cpu_ms() - t_start;
+    t_start = cpu_ms();
+    for(i = 0; i < BENCH_LOOP; i++) {
+        lv_draw_sw_rgb565_map_mask(bench_dest, BENCH_W, bench_src, BENCH_W, BENCH_W, BENCH_H, LV_OPA_COVER, bench_mask, BENCH_W);
+    }
+    t_kernel = cpu_ms() - t_start;
+    bench_print("map_mask", t_ref, t_kernel);
+}
+
+#endif
@@ -0,0 +1,197 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#if LV_USE_PNG && LV_IMG_CACHE_DEF_SIZE
+
+#include <stdio.h>
+
+#define HOUR_SRC    "A:src/test_files/clock/hour.png"
+#define MINUTE_SRC  "A:src/test_files/clock/minute.png"
+#define SECOND_SRC  "A:src/test_files/clock/second.png"
+#define WATCH_SRC   "A:src/test_files/clock/watch.png"
+
+#define BENCH_FRAMES 60
+
+static lv_obj_t * watch;
+static lv_obj_t * hands[3];
+
+static uint32_t png_size(const char * src)
+{
+    lv_img_header_t header;
+    TEST_ASSERT_EQUAL(LV_RES_OK, lv_img_decoder_get_info(src, &header));
+    return lv_img_buf_get_img_size(header.w, header.h, header.cf);
+}
+
+static lv_obj_t * hand_create(const char * src)
+{
+    lv_obj_t * img = lv_img_create(lv_scr_act());
+    lv_img_set_src(img, src);
+    lv_obj_align(img, LV_ALIGN_CENTER, 0, 0);
+    lv_img_set_pivot(img, lv_obj_get_width(img) / 2, lv_obj_get_height(img) - 10);
+    return img;
+}
+
+static void clock_create(void)
+{
+    watch = lv_img_create(lv_scr_act());
+    lv_img_set_src(watch, WATCH_SRC);
+    lv_obj_center(watch);
+
+    hands[0] = hand_create(HOUR_SRC);
+    hands[1] = hand_create(MINUTE_SRC);
+    hands[2] = hand_create(SECOND_SRC);
+}
+
+/*Tick like the clock apps do: every frame moves the hands and redraws them.
+ *Returns the elapsed wall time in ms (the LVGL tick isn't running in the tests)*/
+static uint32_t clock_run(uint32_t frames)
+{
+    uint32_t t_start = custom_tick_get();
+    uint32_t i;
+    for(i = 0; i < frames; i++) {
+        lv_img_set_angle(hands[0], (int16_t)((i * 5) % 3600));
+        lv_img_set_angle(hands[1], (int16_t)((i * 60) % 3600));
+        lv_img_set_angle(hands[2], (int16_t)((i * 60 * 6) % 3600));
+        lv_refr_now(NULL);
+    }
+    return custom_tick_get() - t_start;
+}
+
+void setUp(void)
+{
+    lv_img_cache_set_mem_size(0);
+    lv_img_cache_invalidate_src(NULL);
+    lv_img_cache_reset_stats();
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_img_cache_invalidate_src(NULL);
+    lv_img_cache_set_mem_size(LV_IMG_CACHE_MEM_SIZE);
+}
+
+void test_img_cache_prewarm_on_set_src(void)
+{
+    lv_obj_t * img = lv_img_create(lv_scr_act());
+    lv_img_set_src(img, HOUR_SRC);
+
+    lv_img_cache_stats_t stats;
+    lv_img_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.misses);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(png_size(HOUR_SRC), stats.mem_used);
+
+    /*The first frame is served from the cache*/
+    lv_refr_now(NULL);
+    lv_img_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.misses);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.hits);
+}
+
+void test_img_cache_rotating_hands_decode_once(void)
+{
+    clock_create();
+    clock_run(30);
+
+    lv_img_cache_stats_t stats;
+    lv_img_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.misses);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.evictions);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.entries);
+}
+
+void test_img_cache_respects_mem_size(void)
+{
+    uint32_t hour = png_size(HOUR_SRC);
+    uint32_t minute = png_size(MINUTE_SRC);
+    uint32_t second = png_size(SECOND_SRC);
+
+    /*Room for two of the three hands*/
+    size_t budget = LV_MAX(hour, LV_MAX(minute, second)) * 2;
+    lv_img_cache_set_mem_size(budget);
+
+    lv_img_cache_prewarm(HOUR_SRC, lv_color_black());
+    lv_img_cache_prewarm(MINUTE_SRC, lv_color_black());
+    lv_img_cache_prewarm(HOUR_SRC, lv_color_black());  /*Hour is now more recent than minute*/
+    lv_img_cache_prewarm(SECOND_SRC, lv_color_black());
+
+    lv_img_cache_stats_t stats;
+    lv_img_cache_get_stats(&stats);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(budget, stats.mem_used);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.evictions);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.hits);
+
+    /*Minute was the least recently used so it was closed*/
+    lv_img_cache_prewarm(HOUR_SRC, lv_color_black());
+    lv_img_cache_prewarm(SECOND_SRC, lv_color_black());
+    lv_img_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.hits);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.misses);
+
+    /*Shrinking the budget closes entries right away*/
+    lv_img_cache_set_mem_size(1);
+    lv_img_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.mem_used);
+}
+
+void test_img_cache_invalidate_frees_memory(void)
+{
+    lv_img_cache_prewarm(HOUR_SRC, lv_color_black());
+    lv_img_cache_prewarm(MINUTE_SRC, lv_color_black());
+
+    lv_img_cache_invalidate_src(HOUR_SRC);
+
+    lv_img_cache_stats_t stats;
+    lv_img_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(png_size(MINUTE_SRC), stats.mem_used);
+
+    lv_img_cache_invalidate_src(NULL);
+    lv_img_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.mem_used);
+}
+
+/*Frames per second of an analog clock with rotating PNG hands,
+ *with the hands cached and with a budget too small to keep any of them*/
+void test_img_cache_bench_rotating_hands(void)
+{
+    clock_create();
+
+    lv_img_cache_set_mem_size(1);
+    lv_img_cache_reset_stats();
+    uint32_t t_thrash = clock_run(BENCH_FRAMES);
+    lv_img_cache_stats_t thrash;
+    lv_img_cache_get_stats(&thrash);
+
+    lv_img_cache_set_mem_size(0);
+    clock_run(1);
+    lv_img_cache_reset_stats();
+    uint32_t t_cached = clock_run(BENCH_FRAMES);
+    lv_img_cache_stats_t cached;
+    lv_img_cache_get_stats(&cached);
+
+    printf("rotating hands, %d frames:\n", BENCH_FRAMES);
+    printf("  no room in cache: %5.1f fps  (%u decodes)\n",
+           BENCH_FRAMES * 1000.0 / LV_MAX(t_thrash, 1), (unsigned)thrash.misses);
+    printf("  cached:           %5.1f fps  (%u decodes, %u bytes)\n",
+           BENCH_FRAMES * 1000.0 / LV_MAX(t_cached, 1), (unsigned)cached.misses, (unsigned)cached.mem_used);
+
+    TEST_ASSERT_EQUAL_UINT32(0, cached.misses);
+    TEST_ASSERT_GREATER_THAN_UINT32(BENCH_FRAMES, thrash.misses);
+}
+
+#else /*LV_USE_PNG && LV_IMG_CACHE_DEF_SIZE*/
+
+void test_img_cache_bench_rotating_hands(void)
+{
+
+}
+
+#endif
+
+#endif
@@ -0,0 +1,324 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+#include "../src/draw/sw/lv_draw_sw.h"
+
+#include "unity/unity.h"
+
+#if LV_DRAW_COMPLEX && LV_IMG_TRANSFORM_CACHE_SIZE
+
+#include <stdio.h>
+#include <time.h>
+
+#define HAND_SIZE       100
+#define BENCH_FRAMES    120
+#define FB_SIZE         (800 * 480)
+
+extern lv_color_t test_fb[];
+static lv_color_t ref_fb[FB_SIZE];
+
+static uint8_t hand_bufs[3][HAND_SIZE * HAND_SIZE * LV_IMG_PX_SIZE_ALPHA_BYTE];
+static lv_img_dsc_t hand_dscs[3];
+static lv_obj_t * hands[3];
+
+static void hand_set_px(uint8_t * buf, lv_coord_t x, lv_coord_t y, lv_color_t c, lv_opa_t opa)
+{
+    uint8_t * px = &buf[(y * HAND_SIZE + x) * LV_IMG_PX_SIZE_ALPHA_BYTE];
+    lv_memcpy(px, &c, sizeof(lv_color_t));
+    px[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = opa;
+}
+
+/*A 100x100 ARGB sprite with a vertical bar from the center upwards and soft edges.
+ *Most of the sprite is transparent like the hands of the clock apps.*/
+static void hand_dsc_init(uint32_t i, lv_coord_t len, lv_coord_t width, lv_color_t c)
+{
+    uint8_t * buf = hand_bufs[i];
+    lv_memset_00(buf, sizeof(hand_bufs[i]));
+
+    lv_coord_t x1 = HAND_SIZE / 2 - width / 2;
+    lv_coord_t x2 = x1 + width - 1;
+    lv_coord_t y;
+    for(y = HAND_SIZE / 2 - len; y <= HAND_SIZE / 2 + 8; y++) {
+        lv_coord_t x;
+        for(x = x1; x <= x2; x++) hand_set_px(buf, x, y, c, LV_OPA_COVER);
+        hand_set_px(buf, x1 - 1, y, c, LV_OPA_50);
+        hand_set_px(buf, x2 + 1, y, c, LV_OPA_50);
+    }
+
+    lv_img_dsc_t * dsc = &hand_dscs[i];
+    lv_memset_00(dsc, sizeof(lv_img_dsc_t));
+    dsc->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    dsc->header.w = HAND_SIZE;
+    dsc->header.h = HAND_SIZE;
+    dsc->data_size = sizeof(hand_bufs[i]);
+    dsc->data = buf;
+}
+
+static void clock_create(void)
+{
+    hand_dsc_init(0, 25, 8, lv_palette_main(LV_PALETTE_BLUE));
+    hand_dsc_init(1, 38, 6, lv_palette_main(LV_PALETTE_GREEN));
+    hand_dsc_init(2, 46, 2, lv_palette_main(LV_PALETTE_RED));
+
+    uint32_t i;
+    for(i = 0; i < 3; i++) {
+        hands[i] = lv_img_create(lv_scr_act());
+        lv_img_set_src(hands[i], &hand_dscs[i]);
+        lv_obj_center(hands[i]);
+    }
+}
+
+/*Like a clock: the second hand moves in 60 steps, the others rarely*/
+static void clock_set_time(uint32_t sec)
+{
+    lv_img_set_angle(hands[0], (int16_t)((900 + sec / 120) % 3600));
+    lv_img_set_angle(hands[1], (int16_t)((1800 + sec / 10) % 3600));
+    lv_img_set_angle(hands[2], (int16_t)((sec % 60) * 60));
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*Return the average time of a frame in ms*/
+static double clock_run(uint32_t frames)
+{
+    uint64_t t_start = now_ns();
+    uint32_t i;
+    for(i = 0; i < frames; i++) {
+        clock_set_time(i);
+        lv_refr_now(NULL);
+    }
+    return (double)(now_ns() - t_start) / 1000000.0 / frames;
+}
+
+/*Redraw the whole screen so that `test_fb` has all of it*/
+static void refr_screen(void)
+{
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+}
+
+static void assert_same_as_uncached(void)
+{
+    lv_draw_sw_transform_cache_set_mem_size(0);
+    refr_screen();
+    lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+
+    lv_draw_sw_transform_cache_set_mem_size(LV_IMG_TRANSFORM_CACHE_SIZE);
+
+    /*First drawn on a miss, then from the cache*/
+    uint32_t i;
+    for(i = 0; i < 2; i++) {
+        refr_screen();
+        TEST_ASSERT_EQUAL_MEMORY(ref_fb, test_fb, sizeof(ref_fb));
+    }
+}
+
+void setUp(void)
+{
+    lv_draw_sw_transform_cache_set_mem_size(LV_IMG_TRANSFORM_CACHE_SIZE);
+    lv_draw_sw_transform_cache_invalidate(NULL);
+    lv_draw_sw_transform_cache_reset_stats();
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_draw_sw_transform_cache_invalidate(NULL);
+    lv_draw_sw_transform_cache_set_mem_size(LV_IMG_TRANSFORM_CACHE_SIZE);
+}
+
+void test_img_transform_cache_same_pixels(void)
+{
+    clock_create();
+
+    /*Angles on the cache's angle step are drawn exactly*/
+    int16_t angles[] = {0, 450, 900, 1230, 2700, 3590};
+    uint32_t i;
+    for(i = 0; i < sizeof(angles) / sizeof(angles[0]); i++) {
+        int16_t a = angles[i] - angles[i] % LV_IMG_TRANSFORM_CACHE_ANGLE_STEP;
+        lv_img_set_angle(hands[0], a);
+        lv_img_set_angle(hands[1], (int16_t)((a + 1200) % 3600));
+        lv_img_set_angle(hands[2], (int16_t)((a + 2400) % 3600));
+        assert_same_as_uncached();
+    }
+
+    /*Zoomed and recolored (copied from the cache instead of blended directly)*/
+    lv_img_set_zoom(hands[1], 384);
+    lv_obj_set_style_img_recolor(hands[2], lv_color_white(), 0);
+    lv_obj_set_style_img_recolor_opa(hands[2], LV_OPA_50, 0);
+    assert_same_as_uncached();
+
+    lv_draw_sw_transform_cache_stats_t stats;
+    lv_draw_sw_transform_cache_get_stats(&stats);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.hits);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(LV_IMG_TRANSFORM_CACHE_SIZE, stats.mem_used);
+}
+
+void test_img_transform_cache_round_angle(void)
+{
+    clock_create();
+    lv_img_set_angle(hands[2], 300);
+    lv_refr_now(NULL);
+
+    /*Less than half step away: the same image is used*/
+    lv_img_set_angle(hands[2], 300 + (LV_IMG_TRANSFORM_CACHE_ANGLE_STEP - 1) / 2);
+    lv_draw_sw_transform_cache_reset_stats();
+    lv_refr_now(NULL);
+
+    lv_draw_sw_transform_cache_stats_t stats;
+    lv_draw_sw_transform_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.misses);
+}
+
+void test_img_transform_cache_respects_mem_size(void)
+{
+    clock_create();
+    clock_set_time(1);
+    lv_refr_now(NULL);
+
+    lv_draw_sw_transform_cache_stats_t stats;
+    lv_draw_sw_transform_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.entries);
+    size_t one_hand = stats.mem_used / 3;
+
+    /*Room for about two hands: the second hand evicts the others on every step*/
+    size_t budget = one_hand * 2;
+    lv_draw_sw_transform_cache_set_mem_size(budget);
+    lv_draw_sw_transform_cache_reset_stats();
+    uint32_t i;
+    for(i = 2; i < 10; i++) {
+        clock_set_time(i);
+        lv_refr_now(NULL);
+        lv_draw_sw_transform_cache_get_stats(&stats);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(budget, stats.mem_used);
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.evictions);
+
+    /*Shrinking the budget drops entries right away*/
+    lv_draw_sw_transform_cache_set_mem_size(1);
+    lv_draw_sw_transform_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.mem_used);
+}
+
+void test_img_transform_cache_invalidate(void)
+{
+    clock_create();
+    clock_set_time(7);
+    lv_refr_now(NULL);
+
+    /*Changed pixels are noticed after invalidating the source*/
+    hand_dsc_init(2, 46, 2, lv_palette_main(LV_PALETTE_ORANGE));
+    lv_img_cache_invalidate_src(&hand_dscs[2]);
+
+    lv_draw_sw_transform_cache_stats_t stats;
+    lv_draw_sw_transform_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.entries);
+
+    lv_obj_invalidate(hands[2]);
+    assert_same_as_uncached();
+
+    lv_img_cache_invalidate_src(NULL);
+    lv_draw_sw_transform_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.mem_used);
+}
+
+void test_img_transform_cache_transparent_img(void)
+{
+    static uint8_t buf[HAND_SIZE * HAND_SIZE * LV_IMG_PX_SIZE_ALPHA_BYTE];
+    lv_img_dsc_t dsc;
+    lv_memset_00(&dsc, sizeof(dsc));
+    dsc.header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    dsc.header.w = HAND_SIZE;
+    dsc.header.h = HAND_SIZE;
+    dsc.data_size = sizeof(buf);
+    dsc.data = buf;
+
+    lv_obj_t * img = lv_img_create(lv_scr_act());
+    lv_img_set_src(img, &dsc);
+    lv_img_set_angle(img, 450);
+    lv_refr_now(NULL);
+
+    /*Nothing to draw so nothing is cached*/
+    lv_draw_sw_transform_cache_stats_t stats;
+    lv_draw_sw_transform_cache_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.entries);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.misses);
+}
+
+/*Three rotating 100x100 ARGB hands without and with the cache.
+ *The second hand needs 60 images, the first lap fills the cache.*/
+void test_img_transform_cache_bench_rotating_hands(void)
+{
+    clock_create();
+
+    lv_draw_sw_transform_cache_set_mem_size(0);
+    double t_off = clock_run(BENCH_FRAMES);
+
+    lv_draw_sw_transform_cache_set_mem_size(LV_IMG_TRANSFORM_CACHE_SIZE);
+    lv_draw_sw_transform_cache_reset_stats();
+    double t_cold = clock_run(60);
+    double t_warm = clock_run(BENCH_FRAMES);
+    lv_draw_sw_transform_cache_stats_t stats;
+    lv_draw_sw_transform_cache_get_stats(&stats);
+
+    printf("rotating %dx%d ARGB hands, %d frames:\n", HAND_SIZE, HAND_SIZE, BENCH_FRAMES);
+    printf("  no cache:         %6.3f ms/frame\n", t_off);
+    printf("  cache, first lap: %6.3f ms/frame\n", t_cold);
+    printf("  cache:            %6.3f ms/frame  (%u hits, %u misses, %u bytes)\n", t_warm,
+           (unsigned)stats.hits, (unsigned)stats.misses, (unsigned)stats.mem_used);
+
+    TEST_ASSERT_EQUAL_UINT32(0, stats.evictions);
+}
+
+#else /*LV_DRAW_COMPLEX && LV_IMG_TRANSFORM_CACHE_SIZE*/
+
+/*The runner refers to all of these in every config*/
+void setUp(void)
+{
+
+}
+
+void tearDown(void)
+{
+
+}
+
+void test_img_transform_cache_same_pixels(void)
+{
+
+}
+
+void test_img_transform_cache_round_angle(void)
+{
+
+}
+
+void test_img_transform_cache_respects_mem_size(void)
+{
+
+}
+
+void test_img_transform_cache_invalidate(void)
+{
+
+}
+
+void test_img_transform_cache_transparent_img(void)
+{
+
+}
+
+void test_img_transform_cache_bench_rotating_hands(void)
+{
+
+}
+
+#endif
+
+#endif
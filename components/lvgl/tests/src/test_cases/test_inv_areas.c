@@ -0,0 +1,235 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+#include "../demos/lv_demos.h"
+
+#include "unity/unity.h"
+
+#include "lv_test_helpers.h"
+#include "lv_test_indev.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define HOR_RES 800
+#define VER_RES 480
+#define MAX_FLUSHED 4096
+
+#if LV_INV_TILES
+    #define MODE_NAME "tiles"
+#else
+    #define MODE_NAME "area list"
+#endif
+
+/*Frame buffer built from the flushed areas, like the display has it*/
+static lv_color_t fb[HOR_RES * VER_RES];
+static lv_color_t fb_partial[HOR_RES * VER_RES];
+static lv_area_t flushed[MAX_FLUSHED];
+static uint32_t flushed_cnt;
+static uint32_t px_sum;
+static uint32_t refr_cnt;
+
+static void (*orig_flush_cb)(lv_disp_drv_t *, const lv_area_t *, lv_color_t *);
+
+static void fb_flush_cb(lv_disp_drv_t * disp_drv, const lv_area_t * area, lv_color_t * color_p)
+{
+    if(flushed_cnt < MAX_FLUSHED) flushed[flushed_cnt] = *area;
+    flushed_cnt++;
+
+    lv_coord_t w = lv_area_get_width(area);
+    lv_coord_t y;
+    for(y = area->y1; y <= area->y2; y++) {
+        lv_memcpy(&fb[y * HOR_RES + area->x1], color_p, w * sizeof(lv_color_t));
+        color_p += w;
+    }
+
+    lv_disp_flush_ready(disp_drv);
+}
+
+static void count_monitor_cb(lv_disp_drv_t * disp_drv, uint32_t time, uint32_t px)
+{
+    LV_UNUSED(disp_drv);
+    LV_UNUSED(time);
+    px_sum += px;
+    refr_cnt++;
+}
+
+static void records_reset(void)
+{
+    flushed_cnt = 0;
+    px_sum = 0;
+    refr_cnt = 0;
+}
+
+static double cpu_ms(void)
+{
+    return (double)clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/*Redraw the whole screen and check that the partial refreshes left the same frame buffer*/
+static void assert_same_as_full_redraw(void)
+{
+    lv_memcpy(fb_partial, fb, sizeof(fb));
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+    TEST_ASSERT_EQUAL_MEMORY(fb, fb_partial, sizeof(fb));
+}
+
+void setUp(void)
+{
+    lv_disp_t * disp = lv_disp_get_default();
+    orig_flush_cb = disp->driver->flush_cb;
+    disp->driver->flush_cb = fb_flush_cb;
+    disp->driver->monitor_cb = count_monitor_cb;
+
+    lv_obj_invalidate(lv_scr_act());
+    lv_refr_now(NULL);
+    records_reset();
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_refr_now(NULL);
+
+    lv_disp_t * disp = lv_disp_get_default();
+    disp->driver->flush_cb = orig_flush_cb;
+    disp->driver->monitor_cb = NULL;
+}
+
+void test_inv_areas_separate_are_exact(void)
+{
+    static const lv_area_t areas[] = {
+        {5, 3, 14, 7},
+        {200, 100, 260, 113},
+        {790, 470, 799, 479},
+        {417, 33, 417, 33},
+    };
+    uint32_t i;
+    uint32_t size_sum = 0;
+    for(i = 0; i < sizeof(areas) / sizeof(areas[0]); i++) {
+        _lv_inv_area(NULL, &areas[i]);
+        size_sum += lv_area_get_size(&areas[i]);
+    }
+    lv_refr_now(NULL);
+
+    /*Both trackers redraw exactly the invalidated pixels if nothing is shared*/
+    TEST_ASSERT_EQUAL(size_sum, px_sum);
+    TEST_ASSERT_EQUAL(4, flushed_cnt);
+    for(i = 0; i < flushed_cnt; i++) {
+        uint32_t j;
+        bool found = false;
+        for(j = 0; j < 4; j++) {
+            if(memcmp(&flushed[i], &areas[j], sizeof(lv_area_t)) == 0) found = true;
+        }
+        TEST_ASSERT_TRUE(found);
+    }
+}
+
+void test_inv_areas_cover_random_areas(void)
+{
+    static uint8_t inv_map[HOR_RES * VER_RES];
+    static uint8_t flushed_map[HOR_RES * VER_RES];
+    lv_memset_00(inv_map, sizeof(inv_map));
+    lv_memset_00(flushed_map, sizeof(flushed_map));
+
+    /*Far more areas than LV_INV_BUF_SIZE, some of them partly out of the screen*/
+    uint32_t seed = 12345;
+    uint32_t i;
+    uint32_t inv_px = 0;
+    for(i = 0; i < 300; i++) {
+        lv_area_t a;
+        seed = seed * 1103515245 + 12345;
+        a.x1 = (lv_coord_t)((seed >> 8) % (HOR_RES + 40)) - 20;
+        seed = seed * 1103515245 + 12345;
+        a.y1 = (lv_coord_t)((seed >> 8) % (VER_RES + 40)) - 20;
+        seed = seed * 1103515245 + 12345;
+        a.x2 = a.x1 + (lv_coord_t)((seed >> 8) % 60);
+        seed = seed * 1103515245 + 12345;
+        a.y2 = a.y1 + (lv_coord_t)((seed >> 8) % 24);
+        _lv_inv_area(NULL, &a);
+
+        lv_coord_t x, y;
+        for(y = LV_MAX(a.y1, 0); y <= LV_MIN(a.y2, VER_RES - 1); y++) {
+            for(x = LV_MAX(a.x1, 0); x <= LV_MIN(a.x2, HOR_RES - 1); x++) {
+                if(inv_map[y * HOR_RES + x] == 0) inv_px++;
+                inv_map[y * HOR_RES + x] = 1;
+            }
+        }
+    }
+    lv_refr_now(NULL);
+    TEST_ASSERT_LESS_OR_EQUAL(MAX_FLUSHED, flushed_cnt);
+
+    for(i = 0; i < flushed_cnt; i++) {
+        lv_coord_t x, y;
+        for(y = flushed[i].y1; y <= flushed[i].y2; y++) {
+            for(x = flushed[i].x1; x <= flushed[i].x2; x++) {
+                flushed_map[y * HOR_RES + x] = 1;
+            }
+        }
+    }
+
+    for(i = 0; i < HOR_RES * VER_RES; i++) {
+        if(inv_map[i]) TEST_ASSERT_EQUAL_MESSAGE(1, flushed_map[i], "an invalidated pixel wasn't redrawn");
+    }
+
+    printf("random areas (%s): %"LV_PRIu32" px invalidated, %"LV_PRIu32" px redrawn in %"LV_PRIu32" areas\n",
+           MODE_NAME, inv_px, px_sum, flushed_cnt);
+#if LV_INV_TILES
+    /*Too many areas for the list, but the tiles don't need to redraw the whole screen*/
+    TEST_ASSERT_LESS_THAN(HOR_RES * VER_RES, px_sum);
+#endif
+}
+
+/*Many small labels updated in every tick, like the dashboard apps*/
+void test_inv_areas_dashboard(void)
+{
+    enum { COLS = 8, ROWS = 12, FRAMES = 60 };
+    lv_obj_t * labels[COLS * ROWS];
+    uint32_t i;
+    for(i = 0; i < COLS * ROWS; i++) {
+        labels[i] = lv_label_create(lv_scr_act());
+        lv_obj_set_pos(labels[i], (lv_coord_t)((i % COLS) * 100 + 7), (lv_coord_t)((i / COLS) * 40 + 5));
+        lv_label_set_text_fmt(labels[i], "%"LV_PRIu32, i);
+    }
+    lv_refr_now(NULL);
+    records_reset();
+
+    double t_start = cpu_ms();
+    uint32_t f;
+    for(f = 0; f < FRAMES; f++) {
+        for(i = 0; i < COLS * ROWS; i++) {
+            lv_label_set_text_fmt(labels[i], "%"LV_PRIu32".%"LV_PRIu32, (i * 7 + f * 13) % 1000, f % 10);
+        }
+        lv_refr_now(NULL);
+    }
+    double t = cpu_ms() - t_start;
+
+    printf("dashboard (%s): %d labels, %d frames, %"LV_PRIu32" px/frame, %.2f ms/frame\n",
+           MODE_NAME, COLS * ROWS, FRAMES, px_sum / FRAMES, t / FRAMES);
+#if LV_INV_TILES
+    TEST_ASSERT_LESS_THAN(HOR_RES * VER_RES / 2, px_sum / FRAMES);
+#endif
+
+    assert_same_as_full_redraw();
+}
+
+/*Keep this the last test: the stress demo leaves its timers running*/
+void test_inv_areas_stress_demo(void)
+{
+#if LV_USE_DEMO_STRESS
+    lv_demo_stress();
+    lv_test_indev_wait(LV_DEMO_STRESS_TIME_STEP * 33);
+    records_reset();
+
+    double t_start = cpu_ms();
+    lv_test_indev_wait(LV_DEMO_STRESS_TIME_STEP * 33 * 3);
+    double t = cpu_ms() - t_start;
+
+    printf("stress demo (%s): %"LV_PRIu32" refreshes, %"LV_PRIu32" px/refresh, %.2f ms/refresh\n",
+           MODE_NAME, refr_cnt, refr_cnt ? px_sum / refr_cnt : 0, refr_cnt ? t / refr_cnt : 0.0);
+
+    assert_same_as_full_redraw();
+#endif
+}
+
+#endif
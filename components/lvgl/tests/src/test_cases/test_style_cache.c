@@ -0,0 +1,356 @@
+#if LV_BUILD_TEST
+#include "../lvgl.h"
+
+#include "unity/unity.h"
+
+#include <stdio.h>
+#include <time.h>
+
+static lv_style_t style_card;
+static lv_style_t style_btn;
+static lv_style_t style_btn_pr;
+static lv_style_t style_btn_chk;
+static lv_style_t style_text;
+
+void setUp(void)
+{
+    lv_style_init(&style_card);
+    lv_style_set_radius(&style_card, 12);
+    lv_style_set_bg_color(&style_card, lv_palette_lighten(LV_PALETTE_GREY, 4));
+    lv_style_set_border_width(&style_card, 2);
+    lv_style_set_border_color(&style_card, lv_palette_main(LV_PALETTE_GREY));
+    lv_style_set_shadow_width(&style_card, 10);
+    lv_style_set_shadow_ofs_y(&style_card, 4);
+    lv_style_set_pad_all(&style_card, 6);
+    lv_style_set_pad_row(&style_card, 4);
+    lv_style_set_pad_column(&style_card, 4);
+
+    lv_style_init(&style_btn);
+    lv_style_set_radius(&style_btn, 6);
+    lv_style_set_bg_color(&style_btn, lv_palette_main(LV_PALETTE_BLUE));
+    lv_style_set_bg_grad_color(&style_btn, lv_palette_darken(LV_PALETTE_BLUE, 2));
+    lv_style_set_bg_grad_dir(&style_btn, LV_GRAD_DIR_VER);
+    lv_style_set_outline_width(&style_btn, 1);
+    lv_style_set_outline_color(&style_btn, lv_color_black());
+
+    lv_style_init(&style_btn_pr);
+    lv_style_set_bg_color(&style_btn_pr, lv_palette_main(LV_PALETTE_RED));
+
+    lv_style_init(&style_btn_chk);
+    lv_style_set_bg_color(&style_btn_chk, lv_palette_main(LV_PALETTE_GREEN));
+    lv_style_set_text_color(&style_btn_chk, lv_color_black());
+
+    lv_style_init(&style_text);
+    lv_style_set_text_color(&style_text, lv_color_white());
+    lv_style_set_text_letter_space(&style_text, 1);
+}
+
+void tearDown(void)
+{
+    lv_obj_clean(lv_scr_act());
+    lv_style_reset(&style_card);
+    lv_style_reset(&style_btn);
+    lv_style_reset(&style_btn_pr);
+    lv_style_reset(&style_btn_chk);
+    lv_style_reset(&style_text);
+}
+
+void test_style_cache_shared_style_change(void)
+{
+    lv_obj_t * obj = lv_obj_create(lv_scr_act());
+    lv_obj_add_style(obj, &style_btn, 0);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_BLUE), lv_obj_get_style_bg_color(obj, LV_PART_MAIN));
+    TEST_ASSERT_EQUAL(6, lv_obj_get_style_radius(obj, LV_PART_MAIN));
+
+    lv_style_set_bg_color(&style_btn, lv_palette_main(LV_PALETTE_ORANGE));
+    lv_style_remove_prop(&style_btn, LV_STYLE_RADIUS);
+    lv_obj_report_style_change(&style_btn);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_ORANGE), lv_obj_get_style_bg_color(obj, LV_PART_MAIN));
+    lv_obj_t * ref = lv_obj_create(lv_scr_act());
+    TEST_ASSERT_EQUAL(lv_obj_get_style_radius(ref, LV_PART_MAIN), lv_obj_get_style_radius(obj, LV_PART_MAIN));
+
+    lv_obj_remove_style(obj, &style_btn, 0);
+    TEST_ASSERT_NOT_EQUAL(lv_palette_main(LV_PALETTE_ORANGE).full, lv_obj_get_style_bg_color(obj, LV_PART_MAIN).full);
+
+    lv_obj_set_style_bg_color(obj, lv_palette_main(LV_PALETTE_TEAL), 0);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_TEAL), lv_obj_get_style_bg_color(obj, LV_PART_MAIN));
+}
+
+void test_style_cache_state_change(void)
+{
+    lv_obj_t * btn = lv_btn_create(lv_scr_act());
+    lv_obj_remove_style_all(btn);
+    lv_obj_add_style(btn, &style_btn, 0);
+    lv_obj_add_style(btn, &style_btn_pr, LV_STATE_PRESSED);
+    lv_obj_add_style(btn, &style_btn_chk, LV_STATE_CHECKED);
+
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_BLUE), lv_obj_get_style_bg_color(btn, LV_PART_MAIN));
+    lv_obj_add_state(btn, LV_STATE_PRESSED);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_RED), lv_obj_get_style_bg_color(btn, LV_PART_MAIN));
+    lv_obj_add_state(btn, LV_STATE_CHECKED);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_RED), lv_obj_get_style_bg_color(btn, LV_PART_MAIN));
+    lv_obj_clear_state(btn, LV_STATE_PRESSED);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_GREEN), lv_obj_get_style_bg_color(btn, LV_PART_MAIN));
+    lv_obj_clear_state(btn, LV_STATE_CHECKED);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_BLUE), lv_obj_get_style_bg_color(btn, LV_PART_MAIN));
+}
+
+void test_style_cache_inherited(void)
+{
+    lv_obj_t * parent1 = lv_obj_create(lv_scr_act());
+    lv_obj_t * parent2 = lv_obj_create(lv_scr_act());
+    lv_obj_t * label = lv_label_create(parent1);
+
+    lv_obj_set_style_text_color(parent1, lv_palette_main(LV_PALETTE_RED), 0);
+    lv_obj_set_style_text_color(parent2, lv_palette_main(LV_PALETTE_BLUE), 0);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_RED), lv_obj_get_style_text_color(label, LV_PART_MAIN));
+
+    /*The parent's own style changes*/
+    lv_obj_set_style_text_color(parent1, lv_palette_main(LV_PALETTE_PINK), 0);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_PINK), lv_obj_get_style_text_color(label, LV_PART_MAIN));
+
+    /*The parent's state changes*/
+    lv_obj_add_style(parent1, &style_btn_chk, LV_STATE_CHECKED);
+    lv_obj_add_state(parent1, LV_STATE_CHECKED);
+    TEST_ASSERT_EQUAL_COLOR(lv_color_black(), lv_obj_get_style_text_color(label, LV_PART_MAIN));
+    lv_obj_clear_state(parent1, LV_STATE_CHECKED);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_PINK), lv_obj_get_style_text_color(label, LV_PART_MAIN));
+
+    /*The parent changes*/
+    lv_obj_set_parent(label, parent2);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_BLUE), lv_obj_get_style_text_color(label, LV_PART_MAIN));
+}
+
+void test_style_cache_transition(void)
+{
+    static const lv_style_prop_t props[] = {LV_STYLE_BG_COLOR, LV_STYLE_TEXT_COLOR, 0};
+    static lv_style_transition_dsc_t trans;
+    lv_style_transition_dsc_init(&trans, props, lv_anim_path_linear, 100, 0, NULL);
+
+    lv_obj_t * btn = lv_btn_create(lv_scr_act());
+    lv_obj_remove_style_all(btn);
+    lv_obj_set_style_bg_color(btn, lv_color_black(), 0);
+    lv_obj_set_style_text_color(btn, lv_color_black(), 0);
+    lv_obj_set_style_bg_color(btn, lv_color_white(), LV_STATE_PRESSED);
+    lv_obj_set_style_text_color(btn, lv_color_white(), LV_STATE_PRESSED);
+    lv_obj_set_style_transition(btn, &trans, LV_STATE_PRESSED);
+    lv_obj_t * label = lv_label_create(btn);
+    TEST_ASSERT_EQUAL_COLOR(lv_color_black(), lv_obj_get_style_bg_color(btn, LV_PART_MAIN));
+    TEST_ASSERT_EQUAL_COLOR(lv_color_black(), lv_obj_get_style_text_color(label, LV_PART_MAIN));
+
+    /*The transition starts from the previous values*/
+    lv_obj_add_state(btn, LV_STATE_PRESSED);
+    TEST_ASSERT_EQUAL_COLOR(lv_color_black(), lv_obj_get_style_bg_color(btn, LV_PART_MAIN));
+    TEST_ASSERT_EQUAL_COLOR(lv_color_black(), lv_obj_get_style_text_color(label, LV_PART_MAIN));
+
+    /*Every step is visible, the children inherit it too*/
+    lv_tick_inc(40);
+    lv_timer_handler();
+    lv_color_t c1 = lv_obj_get_style_bg_color(btn, LV_PART_MAIN);
+    TEST_ASSERT_NOT_EQUAL(lv_color_black().full, c1.full);
+    TEST_ASSERT_EQUAL_COLOR(c1, lv_obj_get_style_text_color(label, LV_PART_MAIN));
+
+    lv_tick_inc(40);
+    lv_timer_handler();
+    lv_color_t c2 = lv_obj_get_style_bg_color(btn, LV_PART_MAIN);
+    TEST_ASSERT_NOT_EQUAL(c1.full, c2.full);
+    TEST_ASSERT_NOT_EQUAL(lv_color_white().full, c2.full);
+    TEST_ASSERT_EQUAL_COLOR(c2, lv_obj_get_style_text_color(label, LV_PART_MAIN));
+
+    lv_tick_inc(100);
+    lv_timer_handler();
+    TEST_ASSERT_EQUAL_COLOR(lv_color_white(), lv_obj_get_style_bg_color(btn, LV_PART_MAIN));
+    TEST_ASSERT_EQUAL_COLOR(lv_color_white(), lv_obj_get_style_text_color(label, LV_PART_MAIN));
+}
+
+void test_style_cache_counters(void)
+{
+#if LV_OBJ_STYLE_CACHE_SIZE
+    lv_obj_t * obj = lv_obj_create(lv_scr_act());
+    lv_obj_add_style(obj, &style_card, 0);
+    lv_obj_get_style_radius(obj, LV_PART_MAIN);
+
+    lv_obj_style_cache_monitor_reset();
+    lv_obj_style_cache_monitor_t mon;
+    uint32_t i;
+    for(i = 0; i < 10; i++) lv_obj_get_style_radius(obj, LV_PART_MAIN);
+    lv_obj_style_cache_monitor(&mon);
+    TEST_ASSERT_EQUAL(10, mon.hit);
+    TEST_ASSERT_EQUAL(0, mon.miss);
+    TEST_ASSERT_EQUAL(0, mon.invalidated);
+
+    lv_style_set_radius(&style_card, 20);
+    lv_obj_report_style_change(&style_card);
+    TEST_ASSERT_EQUAL(20, lv_obj_get_style_radius(obj, LV_PART_MAIN));
+    lv_obj_style_cache_monitor(&mon);
+    TEST_ASSERT_GREATER_THAN(0, mon.miss);     /*The refresh reads the properties again*/
+    TEST_ASSERT_EQUAL(1, mon.invalidated);
+#endif
+}
+
+void test_style_cache_invalidate_only_affected(void)
+{
+#if LV_OBJ_STYLE_CACHE_SIZE
+    lv_obj_t * card1 = lv_obj_create(lv_scr_act());
+    lv_obj_t * card2 = lv_obj_create(lv_scr_act());
+    lv_obj_t * label1 = lv_label_create(card1);
+    lv_obj_t * label2 = lv_label_create(card2);
+    lv_obj_add_style(card1, &style_card, 0);
+    lv_obj_add_style(card2, &style_btn, 0);
+
+    lv_obj_t * objs[] = {card1, card2, label1, label2};
+    uint32_t i;
+    for(i = 0; i < 4; i++) {
+        lv_obj_get_style_radius(objs[i], LV_PART_MAIN);
+        lv_obj_get_style_text_color(objs[i], LV_PART_MAIN);
+    }
+
+    /*Only the objects using the style and their children*/
+    lv_obj_style_cache_monitor_reset();
+    lv_style_set_radius(&style_card, 3);
+    lv_obj_report_style_change(&style_card);
+    lv_obj_style_cache_monitor_t mon;
+    lv_obj_style_cache_monitor(&mon);
+    TEST_ASSERT_EQUAL(2, mon.invalidated);
+    TEST_ASSERT_EQUAL(3, lv_obj_get_style_radius(card1, LV_PART_MAIN));
+
+    lv_obj_style_cache_monitor_reset();
+    lv_obj_get_style_radius(card2, LV_PART_MAIN);
+    lv_obj_get_style_text_color(label2, LV_PART_MAIN);
+    lv_obj_style_cache_monitor(&mon);
+    TEST_ASSERT_EQUAL(2, mon.hit);
+    TEST_ASSERT_EQUAL(0, mon.miss);
+
+    /*A not inherited property doesn't affect the children*/
+    lv_obj_style_cache_monitor_reset();
+    lv_obj_set_style_radius(card2, 5, 0);
+    lv_obj_style_cache_monitor(&mon);
+    TEST_ASSERT_EQUAL(1, mon.invalidated);
+    TEST_ASSERT_EQUAL(5, lv_obj_get_style_radius(card2, LV_PART_MAIN));
+
+    /*An inherited property affects the children too*/
+    lv_obj_style_cache_monitor_reset();
+    lv_obj_set_style_text_color(card2, lv_palette_main(LV_PALETTE_RED), 0);
+    lv_obj_style_cache_monitor(&mon);
+    TEST_ASSERT_EQUAL(2, mon.invalidated);
+    TEST_ASSERT_EQUAL_COLOR(lv_palette_main(LV_PALETTE_RED), lv_obj_get_style_text_color(label2, LV_PART_MAIN));
+
+    /*Removing a local property drops the cached value too*/
+    lv_obj_remove_local_style_prop(card2, LV_STYLE_TEXT_COLOR, 0);
+    TEST_ASSERT_EQUAL_COLOR(lv_obj_get_style_text_color(label1, LV_PART_MAIN),
+                            lv_obj_get_style_text_color(label2, LV_PART_MAIN));
+#endif
+}
+
+static lv_obj_t * create_dashboard(void)
+{
+    lv_obj_t * scr = lv_scr_act();
+    lv_obj_set_flex_flow(scr, LV_FLEX_FLOW_ROW_WRAP);
+
+    uint32_t c;
+    for(c = 0; c < 6; c++) {
+        lv_obj_t * card = lv_obj_create(scr);
+        lv_obj_add_style(card, &style_card, 0);
+        lv_obj_add_style(card, &style_text, 0);
+        lv_obj_set_size(card, 250, 220);
+        lv_obj_set_flex_flow(card, LV_FLEX_FLOW_COLUMN);
+
+        lv_obj_t * title = lv_label_create(card);
+        lv_label_set_text_fmt(title, "Card %"LV_PRIu32, c);
+
+        uint32_t r;
+        for(r = 0; r < 4; r++) {
+            lv_obj_t * row = lv_obj_create(card);
+            lv_obj_remove_style_all(row);
+            lv_obj_set_size(row, LV_PCT(100), LV_SIZE_CONTENT);
+            lv_obj_set_flex_flow(row, LV_FLEX_FLOW_ROW);
+            lv_obj_set_style_pad_column(row, 4, 0);
+
+            uint32_t b;
+            for(b = 0; b < 4; b++) {
+                lv_obj_t * btn = lv_btn_create(row);
+                lv_obj_add_style(btn, &style_btn, 0);
+                lv_obj_add_style(btn, &style_btn_pr, LV_STATE_PRESSED);
+                lv_obj_add_style(btn, &style_btn_chk, LV_STATE_CHECKED);
+                if((c + r + b) % 3 == 0) lv_obj_add_state(btn, LV_STATE_CHECKED);
+
+                lv_obj_t * label = lv_label_create(btn);
+                lv_label_set_text_fmt(label, "%"LV_PRIu32, c * 16 + r * 4 + b);
+            }
+        }
+    }
+
+    lv_obj_update_layout(scr);
+    return scr;
+}
+
+/*Initialize the draw descriptors of an object and its children like the draw events do*/
+static void init_draw_dscs(lv_obj_t * obj)
+{
+    lv_draw_rect_dsc_t rect_dsc;
+    lv_draw_rect_dsc_init(&rect_dsc);
+    lv_obj_init_draw_rect_dsc(obj, LV_PART_MAIN, &rect_dsc);
+    if(lv_obj_check_type(obj, &lv_label_class)) {
+        lv_draw_label_dsc_t label_dsc;
+        lv_draw_label_dsc_init(&label_dsc);
+        lv_obj_init_draw_label_dsc(obj, LV_PART_MAIN, &label_dsc);
+    }
+
+    uint32_t i;
+    for(i = 0; i < lv_obj_get_child_cnt(obj); i++) {
+        init_draw_dscs(lv_obj_get_child(obj, i));
+    }
+}
+
+/*Full screen redraws of many widgets with several styles and inherited text styles*/
+void test_style_cache_benchmark(void)
+{
+    enum { FRAMES = 20, BATCHES = 5 };
+    lv_obj_t * scr = create_dashboard();
+    lv_obj_invalidate(scr);
+    lv_refr_now(NULL);
+
+    /*The best batch is the least disturbed by the other processes of the host*/
+    lv_obj_style_cache_monitor_reset();
+    double t = 0;
+    uint32_t i;
+    for(i = 0; i < BATCHES; i++) {
+        clock_t t_start = clock();
+        uint32_t f;
+        for(f = 0; f < FRAMES; f++) {
+            lv_obj_invalidate(scr);
+            lv_refr_now(NULL);
+        }
+        double t_batch = (double)(clock() - t_start) * 1000.0 / CLOCKS_PER_SEC;
+        if(i == 0 || t_batch < t) t = t_batch;
+    }
+
+    lv_obj_style_cache_monitor_t mon;
+    lv_obj_style_cache_monitor(&mon);
+    printf("style cache (%d entries): %.2f ms/frame, %"LV_PRIu32" hits, %"LV_PRIu32" misses, %"LV_PRIu32" invalidated per frame\n",
+           LV_OBJ_STYLE_CACHE_SIZE, t / FRAMES, mon.hit / (FRAMES * BATCHES), mon.miss / (FRAMES * BATCHES),
+           mon.invalidated / (FRAMES * BATCHES));
+
+    /*Only the style lookups of the drawing, without rendering the pixels*/
+    double t_dsc = 0;
+    for(i = 0; i < BATCHES; i++) {
+        clock_t t_start = clock();
+        uint32_t f;
+        for(f = 0; f < FRAMES; f++) init_draw_dscs(scr);
+        double t_batch = (double)(clock() - t_start) * 1000.0 / CLOCKS_PER_SEC;
+        if(i == 0 || t_batch < t_dsc) t_dsc = t_batch;
+    }
+    printf("style cache (%d entries): %.3f ms/frame to initialize the draw descriptors\n",
+           LV_OBJ_STYLE_CACHE_SIZE, t_dsc / FRAMES);
+
+#if LV_OBJ_STYLE_CACHE_SIZE
+    /*Nothing changes between the frames so most lookups should be served by the caches*/
+    TEST_ASSERT_GREATER_THAN(mon.miss, mon.hit);
+    TEST_ASSERT_EQUAL(0, mon.invalidated);
+#endif
+
+    lv_obj_remove_local_style_prop(scr, LV_STYLE_FLEX_FLOW, 0);
+    lv_obj_remove_local_style_prop(scr, LV_STYLE_LAYOUT, 0);
+}
+
+#endif
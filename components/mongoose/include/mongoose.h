@@ -442,6 +442,9 @@ extern int SockSet(SOCKET hSock, int Type, int Prop, void *pbuf, int size);
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(MG_ENABLE_EPOLL) && MG_ENABLE_EPOLL
+#include <sys/epoll.h>
+#endif
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
@@ -592,6 +595,15 @@ int sscanf(const char *, const char *, ...);
 #define MG_ENABLE_SOCKET 1
 #endif
 
+// Use epoll(7) instead of select() in mg_mgr_poll(), Linux only
+#ifndef MG_ENABLE_EPOLL
+#define MG_ENABLE_EPOLL 0
+#endif
+
+#if MG_ENABLE_EPOLL && !(MG_ARCH == MG_ARCH_UNIX && defined(__linux__))
+#error "MG_ENABLE_EPOLL requires Linux"
+#endif
+
 #ifndef MG_ENABLE_MBEDTLS
 #define MG_ENABLE_MBEDTLS 0
 #endif
@@ -667,6 +679,12 @@ int sscanf(const char *, const char *, ...);
 #define MG_SOCK_LISTEN_BACKLOG_SIZE 3
 #endif
 
+// With MG_ENABLE_EPOLL, connections without pending I/O get MG_EV_POLL only
+// this often. 0 sends it to all connections on every poll, like select()
+#ifndef MG_EPOLL_IDLE_MS
+#define MG_EPOLL_IDLE_MS 100
+#endif
+
 #ifndef MG_DIRSEP
 #define MG_DIRSEP '/'
 #endif
@@ -965,6 +983,11 @@ struct mg_mgr {
 #if MG_ARCH == MG_ARCH_FREERTOS_TCP
   SocketSet_t ss;  // NOTE(lsm): referenced from socket struct
 #endif
+#if MG_ENABLE_EPOLL
+  int epoll_fd;                 // All sockets, registered until closed
+  struct mg_connection *ready;  // Connections with pending I/O
+  uint64_t idle_poll;           // Next MG_EV_POLL to idle connections
+#endif
 };
 
 struct mg_connection {
@@ -996,6 +1019,10 @@ struct mg_connection {
   unsigned is_closing : 1;     // Close and free the connection immediately
   unsigned is_readable : 1;    // Connection is ready to read
   unsigned is_writable : 1;    // Connection is ready to write
+#if MG_ENABLE_EPOLL
+  unsigned is_queued : 1;            // Connection is on mgr->ready
+  struct mg_connection *next_ready;  // Linkage in struct mg_mgr :: ready
+#endif
 };
 
 void mg_mgr_poll(struct mg_mgr *, int ms);
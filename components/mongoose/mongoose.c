@@ -3567,11 +3567,18 @@ struct mg_connection *mg_listen(struct mg_mgr *mgr, const char *url,
   return c;
 }
 
+#if MG_ENABLE_EPOLL
+void mg_epoll_add(struct mg_connection *c);
+#endif
+
 struct mg_connection *mg_wrapfd(struct mg_mgr *mgr, int fd,
                                 mg_event_handler_t fn, void *fn_data) {
   struct mg_connection *c = mg_alloc_conn(mgr);
   if (c != NULL) {
     c->fd = (void *) (size_t) fd;
+#if MG_ENABLE_EPOLL
+    mg_epoll_add(c);
+#endif
     c->fn = fn;
     c->fn_data = fn_data;
     mg_call(c, MG_EV_OPEN, NULL);
@@ -3593,9 +3600,16 @@ void mg_mgr_free(struct mg_mgr *mgr) {
   while (t != NULL) tmp = t->next, free(t), t = tmp;
   mgr->timers = NULL;  // Important. Next call to poll won't touch timers
   for (c = mgr->conns; c != NULL; c = c->next) c->is_closing = 1;
+#if MG_ENABLE_EPOLL
+  mgr->idle_poll = 0;  // Visit all connections, not only the ready ones
+#endif
   mg_mgr_poll(mgr, 0);
 #if MG_ARCH == MG_ARCH_FREERTOS_TCP
   FreeRTOS_DeleteSocketSet(mgr->ss);
+#endif
+#if MG_ENABLE_EPOLL
+  if (mgr->epoll_fd >= 0) close(mgr->epoll_fd);
+  mgr->epoll_fd = -1;
 #endif
   MG_DEBUG(("All connections closed"));
 }
@@ -3612,6 +3626,11 @@ void mg_mgr_init(struct mg_mgr *mgr) {
   // Ignore SIGPIPE signal, so if client cancels the request, it
   // won't kill the whole process.
   signal(SIGPIPE, SIG_IGN);
+#endif
+#if MG_ENABLE_EPOLL
+  if ((mgr->epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+    MG_ERROR(("epoll_create1: %d", errno));
+  }
 #endif
   mgr->dnstimeout = 3000;
   mgr->dns4.url = "udp://8.8.8.8:53";
@@ -4061,6 +4080,30 @@ static void iolog(struct mg_connection *c, char *buf, long n, bool r) {
   }
 }
 
+#if MG_ENABLE_EPOLL
+// Sockets are registered once, edge triggered, and stay registered until
+// closed. An edge sets is_readable / is_writable, which stay set until recv()
+// or send() would block. Meanwhile the connection is kept on mgr->ready, and
+// mg_mgr_poll() walks only that list instead of all connections
+#ifndef MG_EPOLL_MAX_EVENTS
+#define MG_EPOLL_MAX_EVENTS 64
+#endif
+
+static void mg_epoll_queue(struct mg_connection *c) {
+  if (c->is_queued) return;
+  c->is_queued = 1;
+  c->next_ready = c->mgr->ready;
+  c->mgr->ready = c;
+}
+
+static void mg_epoll_dequeue(struct mg_connection *c) {
+  struct mg_connection **p = &c->mgr->ready;
+  while (*p != NULL && *p != c) p = &(*p)->next_ready;
+  if (*p == c) *p = c->next_ready;
+  c->is_queued = 0;
+}
+#endif
+
 static long mg_sock_send(struct mg_connection *c, const void *buf, size_t len) {
   long n;
   if (c->is_udp) {
@@ -4085,6 +4128,9 @@ bool mg_send(struct mg_connection *c, const void *buf, size_t len) {
     iolog(c, (char *) buf, n, false);
     return n > 0;
   } else {
+#if MG_ENABLE_EPOLL
+    mg_epoll_queue(c);  // Could be writable since long, no edge will come
+#endif
     return mg_iobuf_add(&c->send, c->send.len, buf, len, MG_IO_SIZE);
   }
 }
@@ -4122,6 +4168,18 @@ static void mg_set_non_blocking_mode(SOCKET fd) {
 #endif
 }
 
+#if MG_ENABLE_EPOLL
+void mg_epoll_add(struct mg_connection *c) {
+  struct epoll_event ev;
+  ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+  ev.data.ptr = c;
+  mg_set_non_blocking_mode(FD(c));  // Edge triggered sockets must not block
+  if (epoll_ctl(c->mgr->epoll_fd, EPOLL_CTL_ADD, FD(c), &ev) != 0) {
+    MG_ERROR(("%lu epoll_ctl: %d", c->id, MG_SOCK_ERRNO));
+  }
+}
+#endif
+
 bool mg_open_listener(struct mg_connection *c, const char *url) {
   SOCKET fd = INVALID_SOCKET;
   bool success = false;
@@ -4172,6 +4230,9 @@ bool mg_open_listener(struct mg_connection *c, const char *url) {
       setlocaddr(fd, &c->loc);
       mg_set_non_blocking_mode(fd);
       c->fd = S2PTR(fd);
+#if MG_ENABLE_EPOLL
+      mg_epoll_add(c);
+#endif
       success = true;
     }
   }
@@ -4212,23 +4273,30 @@ static long read_conn(struct mg_connection *c) {
   return n;
 }
 
-static void write_conn(struct mg_connection *c) {
+static long write_conn(struct mg_connection *c) {
   char *buf = (char *) c->send.buf;
   size_t len = c->send.len;
   long n = c->is_tls ? mg_tls_send(c, buf, len) : mg_sock_send(c, buf, len);
   MG_DEBUG(("%lu %p %d:%d %ld err %d (%s)", c->id, c->fd, (int) c->send.len,
             (int) c->recv.len, n, MG_SOCK_ERRNO, strerror(errno)));
   iolog(c, buf, n, false);
+  return n;
 }
 
 static void close_conn(struct mg_connection *c) {
   if (FD(c) != INVALID_SOCKET) {
+#if MG_ENABLE_EPOLL
+    epoll_ctl(c->mgr->epoll_fd, EPOLL_CTL_DEL, FD(c), NULL);
+#endif
     closesocket(FD(c));
 #if MG_ARCH == MG_ARCH_FREERTOS_TCP
     FreeRTOS_FD_CLR(c->fd, c->mgr->ss, eSELECT_ALL);
 #endif
     c->fd = NULL;
   }
+#if MG_ENABLE_EPOLL
+  if (c->is_queued) mg_epoll_dequeue(c);
+#endif
   mg_close_conn(c);
 }
 
@@ -4259,6 +4327,9 @@ void mg_connect_resolved(struct mg_connection *c) {
   if (FD(c) == INVALID_SOCKET) {
     mg_error(c, "socket(): %d", MG_SOCK_ERRNO);
   } else if (c->is_udp) {
+#if MG_ENABLE_EPOLL
+    mg_epoll_add(c);
+#endif
     mg_call(c, MG_EV_RESOLVE, NULL);
     mg_call(c, MG_EV_CONNECT, NULL);
   } else {
@@ -4266,6 +4337,9 @@ void mg_connect_resolved(struct mg_connection *c) {
     socklen_t slen = tousa(&c->rem, &usa);
     mg_set_non_blocking_mode(FD(c));
     setsockopts(c);
+#if MG_ENABLE_EPOLL
+    mg_epoll_add(c);
+#endif
     mg_call(c, MG_EV_RESOLVE, NULL);
     if ((rc = connect(FD(c), &usa.sa, slen)) == 0) {
       mg_call(c, MG_EV_CONNECT, NULL);
@@ -4293,7 +4367,11 @@ static void accept_conn(struct mg_mgr *mgr, struct mg_connection *lsn) {
   socklen_t sa_len = sizeof(usa);
   SOCKET fd = raccept(FD(lsn), &usa, sa_len);
   if (fd == INVALID_SOCKET) {
-#if MG_ARCH == MG_ARCH_AZURERTOS
+#if MG_ENABLE_EPOLL
+    // Backlog is drained, wait for the next edge
+    lsn->is_readable = 0;
+    if (!mg_sock_would_block())
+#elif MG_ARCH == MG_ARCH_AZURERTOS
     // AzureRTOS, in non-block socket mode can mark listening socket readable
     // even it is not. See comment for 'select' func implementation in
     // nx_bsd.c That's not an error, just should try later
@@ -4301,7 +4379,7 @@ static void accept_conn(struct mg_mgr *mgr, struct mg_connection *lsn) {
 #endif
       MG_ERROR(("%lu accept failed, errno %d", lsn->id, MG_SOCK_ERRNO));
 #if (MG_ARCH != MG_ARCH_WIN32) && (MG_ARCH != MG_ARCH_FREERTOS_TCP) && \
-    (MG_ARCH != MG_ARCH_TIRTOS)
+    (MG_ARCH != MG_ARCH_TIRTOS) && !MG_ENABLE_EPOLL
   } else if ((long) fd >= FD_SETSIZE) {
     MG_ERROR(("%ld > %ld", (long) fd, (long) FD_SETSIZE));
     closesocket(fd);
@@ -4318,6 +4396,9 @@ static void accept_conn(struct mg_mgr *mgr, struct mg_connection *lsn) {
     c->fd = S2PTR(fd);
     mg_set_non_blocking_mode(FD(c));
     setsockopts(c);
+#if MG_ENABLE_EPOLL
+    mg_epoll_add(c);
+#endif
     c->is_accepted = 1;
     c->is_hexdumping = lsn->is_hexdumping;
     c->loc = lsn->loc;
@@ -4393,6 +4474,22 @@ static void mg_iotest(struct mg_mgr *mgr, int ms) {
     FreeRTOS_FD_CLR(c->fd, mgr->ss,
                     eSELECT_READ | eSELECT_EXCEPT | eSELECT_WRITE);
   }
+#elif MG_ENABLE_EPOLL
+  struct epoll_event evs[MG_EPOLL_MAX_EVENTS];
+  int i, n;
+  if (mgr->ready != NULL) ms = 0;  // Queued connections have work to do
+  if ((n = epoll_wait(mgr->epoll_fd, evs, MG_EPOLL_MAX_EVENTS, ms)) < 0) {
+    if (MG_SOCK_ERRNO != EINTR) MG_ERROR(("epoll_wait: %d", MG_SOCK_ERRNO));
+    n = 0;
+  }
+  // More than MG_EPOLL_MAX_EVENTS events stay in the kernel for the next call
+  for (i = 0; i < n; i++) {
+    struct mg_connection *c = (struct mg_connection *) evs[i].data.ptr;
+    uint32_t e = evs[i].events;
+    if (e & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) c->is_readable = 1;
+    if (e & (EPOLLOUT | EPOLLHUP | EPOLLERR)) c->is_writable = 1;
+    mg_epoll_queue(c);
+  }
 #else
   struct timeval tv = {ms / 1000, (ms % 1000) * 1000}, tv_zero = {0, 0};
   struct mg_connection *c;
@@ -4448,6 +4545,44 @@ static void connect_conn(struct mg_connection *c) {
   }
 }
 
+static void poll_conn(struct mg_mgr *mgr, struct mg_connection *c,
+                      uint64_t now) {
+  mg_call(c, MG_EV_POLL, &now);
+  MG_VERBOSE(("%lu %c%c %c%c%c%c%c", c->id, c->is_readable ? 'r' : '-',
+              c->is_writable ? 'w' : '-', c->is_tls ? 'T' : 't',
+              c->is_connecting ? 'C' : 'c', c->is_tls_hs ? 'H' : 'h',
+              c->is_resolving ? 'R' : 'r', c->is_closing ? 'C' : 'c'));
+  if (c->is_resolving || c->is_closing) {
+    // Do nothing
+  } else if (c->is_listening && c->is_udp == 0) {
+    if (c->is_readable) accept_conn(mgr, c);
+  } else if (c->is_connecting) {
+    if (c->is_readable || c->is_writable) connect_conn(c);
+  } else if (c->is_tls_hs) {
+    if ((c->is_readable || c->is_writable)) mg_tls_handshake(c);
+  } else {
+#if MG_ENABLE_EPOLL
+    // Readiness is sticky until the socket would block
+    if (c->is_readable && read_conn(c) == 0 && mg_tls_pending(c) == 0)
+      c->is_readable = 0;
+    if (c->is_writable && c->send.len > 0 && write_conn(c) == 0)
+      c->is_writable = 0;
+#else
+    if (c->is_readable) read_conn(c);
+    if (c->is_writable) write_conn(c);
+#endif
+  }
+
+  if (c->is_draining && c->send.len == 0) c->is_closing = 1;
+  if (c->is_closing) {
+    close_conn(c);
+#if MG_ENABLE_EPOLL
+  } else if (c->is_readable || (c->is_writable && c->send.len > 0)) {
+    mg_epoll_queue(c);  // Not drained yet, no new edge will come for it
+#endif
+  }
+}
+
 void mg_mgr_poll(struct mg_mgr *mgr, int ms) {
   struct mg_connection *c, *tmp;
   uint64_t now;
@@ -4456,29 +4591,26 @@ void mg_mgr_poll(struct mg_mgr *mgr, int ms) {
   now = mg_millis();
   mg_timer_poll(&mgr->timers, now);
 
+#if MG_ENABLE_EPOLL
+  // Idle connections get MG_EV_POLL every MG_EPOLL_IDLE_MS. This also picks
+  // up flags like is_closing that other handlers set on them
+  if (now >= mgr->idle_poll) {
+    mgr->idle_poll = now + MG_EPOLL_IDLE_MS;
+    for (c = mgr->conns; c != NULL; c = c->next) mg_epoll_queue(c);
+  }
+  tmp = mgr->ready;
+  mgr->ready = NULL;
+  while ((c = tmp) != NULL) {
+    tmp = c->next_ready;
+    c->is_queued = 0;
+    poll_conn(mgr, c, now);
+  }
+#else
   for (c = mgr->conns; c != NULL; c = tmp) {
     tmp = c->next;
-    mg_call(c, MG_EV_POLL, &now);
-    MG_VERBOSE(("%lu %c%c %c%c%c%c%c", c->id, c->is_readable ? 'r' : '-',
-                c->is_writable ? 'w' : '-', c->is_tls ? 'T' : 't',
-                c->is_connecting ? 'C' : 'c', c->is_tls_hs ? 'H' : 'h',
-                c->is_resolving ? 'R' : 'r', c->is_closing ? 'C' : 'c'));
-    if (c->is_resolving || c->is_closing) {
-      // Do nothing
-    } else if (c->is_listening && c->is_udp == 0) {
-      if (c->is_readable) accept_conn(mgr, c);
-    } else if (c->is_connecting) {
-      if (c->is_readable || c->is_writable) connect_conn(c);
-    } else if (c->is_tls_hs) {
-      if ((c->is_readable || c->is_writable)) mg_tls_handshake(c);
-    } else {
-      if (c->is_readable) read_conn(c);
-      if (c->is_writable) write_conn(c);
-    }
-
-    if (c->is_draining && c->send.len == 0) c->is_closing = 1;
-    if (c->is_closing) close_conn(c);
+    poll_conn(mgr, c, now);
   }
+#endif
 }
 #endif
 
@@ -0,0 +1,219 @@
+// benchmark تعداد اتصال برای mg_mgr_poll: سرور HTTP mongoose در این پروسس،
+// و یک load generator با سوکت‌های معمولی در پروسس fork شده که N اتصال
+// بی‌کار باز نگه می‌دارد و با چند اتصال keep-alive درخواست می‌فرستد
+//   ./bench_mg_epoll [N ...]
+#include "mongoose.h"
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#if MG_ENABLE_EPOLL
+#define BACKEND "epoll"
+#else
+#define BACKEND "select"
+#endif
+
+#define ACTIVE      8       // اتصال‌های فعال load generator
+#define RUN_MS      1000    // مدت هر اجرا زیر بار
+#define IDLE_MS     500     // مدت mg_mgr_poll(0) بدون ترافیک، چند دور MG_EPOLL_IDLE_MS
+
+static const char request[] = "GET / HTTP/1.1\r\nHost: bench\r\n\r\n";
+static const char response[] = "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nok\n";
+
+static int accepted;
+static long requests;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+static void srv_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    (void) ev_data, (void) fn_data;
+    if (ev == MG_EV_ACCEPT) {
+        accepted++;
+    } else if (ev == MG_EV_HTTP_MSG) {
+        requests++;
+        mg_http_reply(c, 200, "", "ok\n");
+    }
+}
+
+// ==================== load generator ====================
+
+static int connect_to(int port) {
+    struct sockaddr_in sin;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons((uint16_t) port);
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && connect(fd, (struct sockaddr *) &sin, sizeof(sin)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// هر اتصال فعال یک درخواست در راه دارد؛ پاسخ کامل که رسید، درخواست بعدی
+static long run_active(int *fds, int n, int ms) {
+    struct pollfd pfds[ACTIVE];
+    size_t got[ACTIVE];
+    long done = 0;
+    int i;
+    for (i = 0; i < n; i++) {
+        pfds[i].fd = fds[i];
+        pfds[i].events = POLLIN;
+        got[i] = 0;
+        if (send(fds[i], request, sizeof(request) - 1, 0) < 0) return -1;
+    }
+    uint64_t end = now_us() + (uint64_t) ms * 1000;
+    while (now_us() < end) {
+        if (poll(pfds, (nfds_t) n, 100) <= 0) continue;
+        for (i = 0; i < n; i++) {
+            char buf[512];
+            if (!(pfds[i].revents & POLLIN)) continue;
+            ssize_t r = recv(fds[i], buf, sizeof(buf), 0);
+            if (r <= 0) return -1;
+            got[i] += (size_t) r;
+            while (got[i] >= sizeof(response) - 1) {
+                got[i] -= sizeof(response) - 1;
+                done++;
+                if (send(fds[i], request, sizeof(request) - 1, 0) < 0) return -1;
+            }
+        }
+    }
+    return done;
+}
+
+static void load_generator(int port, int idle, int ctl, int res) {
+    int *fds = calloc((size_t) (idle + ACTIVE), sizeof(int));
+    int i, n = 0;
+    char cmd;
+    long done = -1;
+    for (i = 0; i < idle + ACTIVE; i++) {
+        if ((fds[i] = connect_to(port)) < 0) break;
+        n++;
+    }
+    if (write(res, "r", 1) != 1) _exit(1);
+    if (read(ctl, &cmd, 1) == 1 && cmd == 'g' && n == idle + ACTIVE) {
+        done = run_active(fds + idle, ACTIVE, RUN_MS);
+    }
+    if (write(res, &done, sizeof(done)) != sizeof(done)) _exit(1);
+    if (read(ctl, &cmd, 1) != 1) (void) 0;  // منتظر 'q'
+    for (i = 0; i < n; i++) close(fds[i]);
+    free(fds);
+    _exit(0);
+}
+
+// ==================== اندازه‌گیری ====================
+
+static bool read_nb(int fd, void *buf, size_t len) {
+    struct pollfd p = {fd, POLLIN, 0};
+    return poll(&p, 1, 0) == 1 && read(fd, buf, len) == (ssize_t) len;
+}
+
+static void bench(int idle) {
+    struct mg_mgr mgr;
+    int ctl[2], res[2];
+    char ready;
+
+#if !MG_ENABLE_EPOLL
+    if (idle + ACTIVE + 16 > FD_SETSIZE) {
+        printf("  %6d   (more sockets than FD_SETSIZE %d)\n", idle, FD_SETSIZE);
+        return;
+    }
+#endif
+
+    mg_mgr_init(&mgr);
+    struct mg_connection *lsn = mg_http_listen(&mgr, "http://127.0.0.1:0", srv_cb, NULL);
+    if (lsn == NULL || pipe(ctl) != 0 || pipe(res) != 0) {
+        printf("setup failed\n");
+        exit(1);
+    }
+    accepted = 0;
+    requests = 0;
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        mg_log_set("0");
+        close(ctl[1]);
+        close(res[0]);
+        load_generator(mg_ntohs(lsn->loc.port), idle, ctl[0], res[1]);
+    }
+    close(ctl[0]);
+    close(res[1]);
+
+    // همه اتصال‌ها accept شوند
+    uint64_t deadline = now_us() + 30 * 1000000ULL;
+    bool gen_ready = false;
+    while ((!gen_ready || accepted < idle + ACTIVE) && now_us() < deadline) {
+        mg_mgr_poll(&mgr, 10);
+        if (!gen_ready) gen_ready = read_nb(res[0], &ready, 1);
+    }
+
+    // هزینه یک poll وقتی هیچ اتصالی کاری ندارد، با MG_EV_POLL های دوره‌ای
+    uint64_t t0 = now_us();
+    long idle_polls = 0;
+    while (now_us() - t0 < IDLE_MS * 1000) {
+        mg_mgr_poll(&mgr, 0);
+        idle_polls++;
+    }
+    double idle_us = (double) (now_us() - t0) / (double) idle_polls;
+
+    // زیر بار
+    long done = -1, polls = 0;
+    uint64_t in_poll = 0;
+    if (write(ctl[1], "g", 1) != 1) exit(1);
+    t0 = now_us();
+    for (;;) {
+        uint64_t t = now_us();
+        mg_mgr_poll(&mgr, 100);
+        in_poll += now_us() - t;
+        polls++;
+        if (read_nb(res[0], &done, sizeof(done))) break;
+    }
+    double secs = (double) (now_us() - t0) / 1e6;
+
+    if (write(ctl[1], "q", 1) != 1) exit(1);
+    waitpid(pid, NULL, 0);
+    close(ctl[1]);
+    close(res[0]);
+    mg_mgr_free(&mgr);
+
+    if (accepted < idle + ACTIVE || done < 0) {
+        printf("  %6d   failed: %d of %d accepted\n", idle, accepted, idle + ACTIVE);
+        return;
+    }
+    printf("  %6d   %10.1f   %8.0f   %10.1f\n", idle, idle_us, (double) requests / secs,
+           (double) in_poll / (double) polls);
+}
+
+int main(int argc, char **argv) {
+    static const int defaults[] = {10, 100, 500, 1000, 5000};
+    struct rlimit rl;
+    int i;
+
+    // N اتصال در هر دو پروسس fd لازم دارد
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    mg_log_set("1");
+
+    printf("mg_mgr_poll (%s), %d active keep-alive connections, %d ms per run\n",
+           BACKEND, ACTIVE, RUN_MS);
+    printf("  %6s   %10s   %8s   %10s\n", "idle", "idle us", "req/s", "busy us");
+    if (argc > 1) {
+        for (i = 1; i < argc; i++) bench(atoi(argv[i]));
+    } else {
+        for (i = 0; i < (int) (sizeof(defaults) / sizeof(defaults[0])); i++) {
+            if ((rlim_t) defaults[i] + ACTIVE + 64 > rl.rlim_cur) {
+                printf("  %6d   (ulimit -n %lu)\n", defaults[i], (unsigned long) rl.rlim_cur);
+                continue;
+            }
+            bench(defaults[i]);
+        }
+    }
+    printf("  idle us: one mg_mgr_poll(0) with no traffic; busy us: one mg_mgr_poll under load\n");
+    return 0;
+}
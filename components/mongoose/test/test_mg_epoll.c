@@ -0,0 +1,367 @@
+// تست‌های mg_mgr_poll روی host با اتصال‌های واقعی روی 127.0.0.1
+// همین فایل یک بار با select و یک بار با MG_ENABLE_EPOLL=1 ساخته می‌شود
+#include "mongoose.h"
+#include <pthread.h>
+#include <sys/resource.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        failures++; \
+    } \
+} while (0)
+
+#if MG_ENABLE_EPOLL
+#define BACKEND "epoll"
+#else
+#define BACKEND "select"
+#endif
+
+static struct mg_mgr mgr;
+
+// تا وقتی شرط برقرار نشده poll می‌کند، حداکثر ms میلی‌ثانیه
+#define POLL_UNTIL(cond, ms) do { \
+    uint64_t end_ = mg_millis() + (ms); \
+    while (!(cond) && mg_millis() < end_) mg_mgr_poll(&mgr, 10); \
+} while (0)
+
+static int count_conns(void) {
+    int n = 0;
+    struct mg_connection *c;
+    for (c = mgr.conns; c != NULL; c = c->next) n++;
+    return n;
+}
+
+static void url_of(struct mg_connection *lsn, const char *proto, char *buf, size_t len) {
+    snprintf(buf, len, "%s://127.0.0.1:%d", proto, mg_ntohs(lsn->loc.port));
+}
+
+// ==================== HTTP ====================
+
+static void http_srv_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    (void) fn_data;
+    if (ev == MG_EV_HTTP_MSG) {
+        struct mg_http_message *hm = (struct mg_http_message *) ev_data;
+        mg_http_reply(c, 200, "", "hello %.*s", (int) hm->uri.len, hm->uri.ptr);
+    }
+}
+
+typedef struct {
+    int status;
+    char body[64];
+    bool closed;
+} http_result_t;
+
+static void http_cli_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    http_result_t *r = (http_result_t *) fn_data;
+    if (ev == MG_EV_CONNECT) {
+        mg_printf(c, "GET /abc HTTP/1.1\r\nHost: x\r\n\r\n");
+    } else if (ev == MG_EV_HTTP_MSG) {
+        struct mg_http_message *hm = (struct mg_http_message *) ev_data;
+        r->status = mg_http_status(hm);
+        snprintf(r->body, sizeof(r->body), "%.*s", (int) hm->body.len, hm->body.ptr);
+        c->is_draining = 1;
+    } else if (ev == MG_EV_CLOSE) {
+        r->closed = true;
+    }
+}
+
+static void test_http_request(void) {
+    char url[64];
+    http_result_t r;
+    memset(&r, 0, sizeof(r));
+    struct mg_connection *lsn = mg_http_listen(&mgr, "http://127.0.0.1:0", http_srv_cb, NULL);
+    CHECK(lsn != NULL);
+    url_of(lsn, "http", url, sizeof(url));
+    mg_http_connect(&mgr, url, http_cli_cb, &r);
+    POLL_UNTIL(r.closed, 2000);
+    CHECK(r.status == 200);
+    CHECK(strcmp(r.body, "hello /abc") == 0);
+    CHECK(r.closed);
+    lsn->is_closing = 1;
+    POLL_UNTIL(count_conns() == 0, 2000);
+    CHECK(count_conns() == 0);
+}
+
+// ==================== echo بزرگ ====================
+
+// بیشتر از بافرهای سوکت، تا send و recv چند بار block شوند
+#define ECHO_SIZE (4 * 1024 * 1024)
+
+static void echo_srv_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    (void) ev_data, (void) fn_data;
+    if (ev == MG_EV_READ) {
+        mg_send(c, c->recv.buf, c->recv.len);
+        mg_iobuf_del(&c->recv, 0, c->recv.len);
+    }
+}
+
+typedef struct {
+    unsigned char *data;
+    size_t sent, received;
+    bool mismatch, closed;
+} echo_client_t;
+
+static void echo_cli_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    echo_client_t *e = (echo_client_t *) fn_data;
+    (void) ev_data;
+    if (ev == MG_EV_CONNECT || ev == MG_EV_WRITE) {
+        // send را بیش از 256 KB جلوتر از echo نگه دار
+        while (e->sent < ECHO_SIZE && c->send.len < 256 * 1024) {
+            size_t n = ECHO_SIZE - e->sent < 16384 ? ECHO_SIZE - e->sent : 16384;
+            mg_send(c, e->data + e->sent, n);
+            e->sent += n;
+        }
+    } else if (ev == MG_EV_READ) {
+        if (e->received + c->recv.len > ECHO_SIZE ||
+            memcmp(e->data + e->received, c->recv.buf, c->recv.len) != 0) {
+            e->mismatch = true;
+        }
+        e->received += c->recv.len;
+        mg_iobuf_del(&c->recv, 0, c->recv.len);
+        if (e->received >= ECHO_SIZE) c->is_closing = 1;
+    } else if (ev == MG_EV_CLOSE) {
+        e->closed = true;
+    }
+}
+
+static void test_echo_large(void) {
+    char url[64];
+    echo_client_t e;
+    memset(&e, 0, sizeof(e));
+    e.data = malloc(ECHO_SIZE);
+    size_t i;
+    for (i = 0; i < ECHO_SIZE; i++) e.data[i] = (unsigned char) (i * 7 + (i >> 13));
+
+    struct mg_connection *lsn = mg_listen(&mgr, "tcp://127.0.0.1:0", echo_srv_cb, NULL);
+    CHECK(lsn != NULL);
+    url_of(lsn, "tcp", url, sizeof(url));
+    mg_connect(&mgr, url, echo_cli_cb, &e);
+    POLL_UNTIL(e.closed, 10000);
+    CHECK(e.closed);
+    CHECK(!e.mismatch);
+    CHECK(e.received == ECHO_SIZE);
+    lsn->is_closing = 1;
+    POLL_UNTIL(count_conns() == 0, 2000);
+    CHECK(count_conns() == 0);
+    free(e.data);
+}
+
+// ==================== تعداد زیاد اتصال ====================
+
+#define MANY 300
+
+static int pongs, many_closed;
+
+static void ping_srv_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    (void) ev_data, (void) fn_data;
+    if (ev == MG_EV_READ && c->recv.len >= 4) {
+        mg_send(c, "pong", 4);
+        mg_iobuf_del(&c->recv, 0, 4);
+    }
+}
+
+static void ping_cli_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    (void) ev_data, (void) fn_data;
+    if (ev == MG_EV_CONNECT) {
+        mg_send(c, "ping", 4);
+    } else if (ev == MG_EV_READ && c->recv.len >= 4) {
+        if (memcmp(c->recv.buf, "pong", 4) == 0) pongs++;
+        c->is_closing = 1;
+    } else if (ev == MG_EV_CLOSE) {
+        many_closed++;
+    }
+}
+
+static void test_many_connections(void) {
+    char url[64];
+    struct mg_connection *lsn = mg_listen(&mgr, "tcp://127.0.0.1:0", ping_srv_cb, NULL);
+    CHECK(lsn != NULL);
+    url_of(lsn, "tcp", url, sizeof(url));
+    pongs = many_closed = 0;
+    int i;
+    for (i = 0; i < MANY; i++) mg_connect(&mgr, url, ping_cli_cb, NULL);
+    POLL_UNTIL(pongs == MANY, 10000);
+    CHECK(pongs == MANY);
+
+    // سمت سرور بسته شدن سمت مقابل را می‌بیند
+    POLL_UNTIL(count_conns() == 1, 5000);
+    CHECK(count_conns() == 1);
+    CHECK(many_closed == MANY);
+    lsn->is_closing = 1;
+    POLL_UNTIL(count_conns() == 0, 2000);
+}
+
+// ==================== پرچم‌ها و ارسال از بیرون اتصال ====================
+
+static struct mg_connection *idle_srv;
+static int idle_got, idle_closed;
+
+static void idle_srv_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    (void) ev_data, (void) fn_data;
+    if (ev == MG_EV_ACCEPT) idle_srv = c;
+    if (ev == MG_EV_CLOSE && c == idle_srv) idle_srv = NULL;
+}
+
+static void idle_cli_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    (void) ev_data, (void) fn_data;
+    if (ev == MG_EV_READ) {
+        idle_got += (int) c->recv.len;
+        mg_iobuf_del(&c->recv, 0, c->recv.len);
+    } else if (ev == MG_EV_CLOSE) {
+        idle_closed++;
+    }
+}
+
+static void send_to_idle(void *arg) {
+    (void) arg;
+    if (idle_srv != NULL) mg_send(idle_srv, "late", 4);
+}
+
+// اتصالی که مدت‌هاست writable است و لبه تازه‌ای نمی‌گیرد هم باید بفرستد،
+// و is_closing که از بیرون گذاشته شود هم باید دیده شود
+static void test_send_and_close_from_outside(void) {
+    char url[64];
+    struct mg_connection *lsn = mg_listen(&mgr, "tcp://127.0.0.1:0", idle_srv_cb, NULL);
+    url_of(lsn, "tcp", url, sizeof(url));
+    idle_srv = NULL;
+    idle_got = idle_closed = 0;
+    mg_connect(&mgr, url, idle_cli_cb, NULL);
+    POLL_UNTIL(idle_srv != NULL, 2000);
+    CHECK(idle_srv != NULL);
+
+    // چند دور poll بی‌کار تا همه لبه‌ها مصرف شوند
+    int i;
+    for (i = 0; i < 20; i++) mg_mgr_poll(&mgr, 10);
+
+    mg_timer_add(&mgr, 1, 0, send_to_idle, NULL);
+    uint64_t t0 = mg_millis();
+    POLL_UNTIL(idle_got == 4, 2000);
+    CHECK(idle_got == 4);
+    // mg_send اتصال را فورا در صف می‌گذارد، نه در دور بعدی MG_EPOLL_IDLE_MS
+    CHECK(mg_millis() - t0 < 80);
+
+    idle_srv->is_closing = 1;
+    POLL_UNTIL(idle_closed == 1, 2000);
+    CHECK(idle_closed == 1);
+    lsn->is_closing = 1;
+    POLL_UNTIL(count_conns() == 0, 2000);
+    CHECK(count_conns() == 0);
+}
+
+// ==================== MG_EV_POLL ====================
+
+static int poll_events;
+
+static void poll_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    (void) c, (void) ev_data, (void) fn_data;
+    if (ev == MG_EV_POLL) poll_events++;
+}
+
+// اتصال بی‌کار هم MG_EV_POLL می‌گیرد؛ با epoll حداقل هر MG_EPOLL_IDLE_MS
+static void test_idle_poll_event(void) {
+    struct mg_connection *lsn = mg_listen(&mgr, "tcp://127.0.0.1:0", poll_cb, NULL);
+    poll_events = 0;
+    uint64_t end = mg_millis() + 3 * MG_EPOLL_IDLE_MS + 50;
+    while (mg_millis() < end) mg_mgr_poll(&mgr, 10);
+    CHECK(poll_events >= 3);
+    lsn->is_closing = 1;
+    POLL_UNTIL(count_conns() == 0, 2000);
+}
+
+// ==================== mg_mkpipe ====================
+
+static int pipe_reads;
+
+static void pipe_cb(struct mg_connection *c, int ev, void *ev_data, void *fn_data) {
+    (void) ev_data, (void) fn_data;
+    if (ev == MG_EV_READ) {
+        pipe_reads += (int) c->recv.len;
+        mg_iobuf_del(&c->recv, 0, c->recv.len);
+    }
+}
+
+static void *pipe_writer(void *arg) {
+    int fd = *(int *) arg;
+    int i;
+    for (i = 0; i < 5; i++) {
+        usleep(20000);
+        if (send(fd, "x", 1, 0) != 1) break;
+    }
+    return NULL;
+}
+
+static void test_wakeup_pipe(void) {
+    pthread_t t;
+    pipe_reads = 0;
+    int fd = mg_mkpipe(&mgr, pipe_cb, NULL);
+    CHECK(fd >= 0);
+    pthread_create(&t, NULL, pipe_writer, &fd);
+    POLL_UNTIL(pipe_reads == 5, 2000);
+    CHECK(pipe_reads == 5);
+    pthread_join(t, NULL);
+    close(fd);
+    POLL_UNTIL(count_conns() == 0, 2000);
+    CHECK(count_conns() == 0);
+}
+
+// ==================== fd بزرگ‌تر از FD_SETSIZE ====================
+
+#if MG_ENABLE_EPOLL
+// select سوکت‌های با fd >= FD_SETSIZE را رد می‌کند، epoll نه
+static void test_fd_above_setsize(void) {
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < FD_SETSIZE + 64 && rl.rlim_max >= FD_SETSIZE + 64) {
+        rl.rlim_cur = FD_SETSIZE + 64;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    if (rl.rlim_cur < FD_SETSIZE + 64) {
+        printf("skip test_fd_above_setsize: ulimit -n %lu\n", (unsigned long) rl.rlim_cur);
+        return;
+    }
+    static int fillers[FD_SETSIZE];
+    int n = 0, fd;
+    while ((fd = open("/dev/null", O_RDONLY)) >= 0 && fd < FD_SETSIZE) fillers[n++] = fd;
+    if (fd >= FD_SETSIZE) close(fd);
+
+    http_result_t r;
+    char url[64];
+    memset(&r, 0, sizeof(r));
+    struct mg_connection *lsn = mg_http_listen(&mgr, "http://127.0.0.1:0", http_srv_cb, NULL);
+    CHECK(lsn != NULL && (long) (size_t) lsn->fd >= FD_SETSIZE);
+    url_of(lsn, "http", url, sizeof(url));
+    mg_http_connect(&mgr, url, http_cli_cb, &r);
+    POLL_UNTIL(r.closed, 2000);
+    CHECK(r.status == 200);
+    lsn->is_closing = 1;
+    POLL_UNTIL(count_conns() == 0, 2000);
+    while (n > 0) close(fillers[--n]);
+}
+#endif
+
+int main(void) {
+    mg_log_set(getenv("MGLOG") ? getenv("MGLOG") : "0");
+    mg_mgr_init(&mgr);
+
+    test_http_request();
+    test_echo_large();
+    test_many_connections();
+    test_send_and_close_from_outside();
+    test_idle_poll_event();
+    test_wakeup_pipe();
+#if MG_ENABLE_EPOLL
+    test_fd_above_setsize();
+#endif
+
+    mg_mgr_free(&mgr);
+
+    if (failures) {
+        printf("mg_mgr_poll (%s): %d check(s) failed\n", BACKEND, failures);
+        return 1;
+    }
+    printf("mg_mgr_poll (%s): all tests passed\n", BACKEND);
+    return 0;
+}
@@ -5,6 +5,8 @@
 int js_getlength(js_State *J, int idx)
 {
 	int len;
+	if (js_isarray(J, idx))
+		return js_toobject(J, idx)->u.a.length;
 	js_getproperty(J, idx, "length");
 	len = js_tointeger(J, -1);
 	js_pop(J, 1);
@@ -17,30 +19,6 @@ void js_setlength(js_State *J, int idx, int len)
 	js_setproperty(J, idx < 0 ? idx - 1 : idx, "length");
 }
 
-int js_hasindex(js_State *J, int idx, int i)
-{
-	char buf[32];
-	return js_hasproperty(J, idx, js_itoa(buf, i));
-}
-
-void js_getindex(js_State *J, int idx, int i)
-{
-	char buf[32];
-	js_getproperty(J, idx, js_itoa(buf, i));
-}
-
-void js_setindex(js_State *J, int idx, int i)
-{
-	char buf[32];
-	js_setproperty(J, idx, js_itoa(buf, i));
-}
-
-void js_delindex(js_State *J, int idx, int i)
-{
-	char buf[32];
-	js_delproperty(J, idx, js_itoa(buf, i));
-}
-
 static void jsB_new_Array(js_State *J)
 {
 	int i, top = js_gettop(J);
@@ -226,6 +204,15 @@ static void Ap_shift(js_State *J)
 
 	js_getindex(J, 0, 0);
 
+	if (js_isarray(J, 0)) {
+		js_Object *obj = js_toobject(J, 0);
+		if (obj->u.a.simple && obj->u.a.flat_length == len) {
+			memmove(obj->u.a.array, obj->u.a.array + 1, (len - 1) * sizeof(js_Value));
+			obj->u.a.flat_length = obj->u.a.length = len - 1;
+			return;
+		}
+	}
+
 	for (k = 1; k < len; ++k) {
 		if (js_hasindex(J, 0, k))
 			js_setindex(J, 0, k - 1);
@@ -273,8 +260,8 @@ static int sortcmp(const void *avoid, const void *bvoid)
 	double v;
 	int c;
 
-	int unx = (a->type == JS_TUNDEFINED);
-	int uny = (b->type == JS_TUNDEFINED);
+	int unx = (JSV_TYPE(a) == JS_TUNDEFINED);
+	int uny = (JSV_TYPE(b) == JS_TUNDEFINED);
 	if (unx) return !uny;
 	if (uny) return -1;
 
@@ -413,6 +400,24 @@ static void Ap_unshift(js_State *J)
 
 	len = js_getlength(J, 0);
 
+	if (js_isarray(J, 0) && top > 1) {
+		js_Object *obj = js_toobject(J, 0);
+		if (obj->u.a.simple && obj->u.a.flat_length == len && len + top - 1 <= JS_ARRAYLIMIT) {
+			/* grow the dense storage, then slide the elements up in one go */
+			for (k = len; k < len + top - 1; ++k) {
+				js_pushundefined(J);
+				js_setindex(J, 0, k);
+			}
+			memmove(obj->u.a.array + top - 1, obj->u.a.array, len * sizeof(js_Value));
+			for (i = 1; i < top; ++i) {
+				jsG_writebarrier(J, js_tovalue(J, i));
+				obj->u.a.array[i - 1] = *js_tovalue(J, i);
+			}
+			js_pushnumber(J, len + top - 1);
+			return;
+		}
+	}
+
 	for (k = len; k > 0; --k) {
 		int from = k - 1;
 		int to = k + top - 2;
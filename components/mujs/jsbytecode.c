@@ -0,0 +1,492 @@
+#include "jsi.h"
+#include "jscompile.h"
+#include "jsvalue.h"
+
+/*
+	Serialized script functions, so a script can be run without going
+	through the lexer, parser and compiler again.
+
+	Layout: header, string table, then the function tree depth first.
+	Integers are stored as 32-bit little endian. Code is stored as-is
+	except that string operands hold an index into the string table.
+	Code is in host byte order and sized for the host instruction and
+	pointer types, so bytecode is only loaded by a build with the same
+	layout; anything else is rejected and should be recompiled from source.
+
+	Operands are range checked when loading, but the code itself is not
+	verified, so callers should checksum bytecode they did not write.
+*/
+
+#define BC_VERSION 2
+#define BC_STRSLOTS (int)(sizeof(const char *) / sizeof(js_Instruction))
+#define BC_NUMSLOTS (int)(sizeof(double) / sizeof(js_Instruction))
+
+static const char bc_magic[4] = { 'M', 'J', 'B', 'C' };
+
+static int bc_layout(void)
+{
+	int numops = sizeof (const char *[]) {
+#include "opnames.h"
+	} / sizeof (const char *);
+	unsigned short order = 0x0102;
+	return (int)sizeof(js_Instruction) | (int)sizeof(const char *) << 4 | (*(unsigned char *)&order) << 8 | numops << 16;
+}
+
+/* Number of operand slots following an opcode. Strings are always the first operand. */
+static int bc_operands(int op, int *string)
+{
+	*string = 0;
+	switch (op) {
+	case OP_NUMBER:
+		return BC_NUMSLOTS;
+	case OP_STRING:
+	case OP_GETVAR:
+	case OP_HASVAR:
+	case OP_SETVAR:
+	case OP_DELVAR:
+	case OP_DELPROP_S:
+	case OP_CATCH:
+		*string = 1;
+		return BC_STRSLOTS;
+	case OP_NEWREGEXP:
+	case OP_GETPROP_S:
+	case OP_SETPROP_S:
+	case OP_GETMETHOD_S:
+		*string = 1;
+		return BC_STRSLOTS + 1;
+	case OP_JNLTLOCAL:
+		return 3;
+	case OP_GETUPVAR:
+	case OP_SETUPVAR:
+	case OP_ADDLOCALS:
+		return 2;
+	case OP_INTEGER:
+	case OP_GETLOCAL:
+	case OP_SETLOCAL:
+	case OP_DELLOCAL:
+	case OP_CLOSURE:
+	case OP_CALL:
+	case OP_NEW:
+	case OP_JUMP:
+	case OP_JTRUE:
+	case OP_JFALSE:
+	case OP_JCASE:
+	case OP_TRY:
+		return 1;
+	}
+	return 0;
+}
+
+/* Save */
+
+typedef struct {
+	js_State *J;
+	js_Writer write;
+	void *data;
+	const char **strtab;
+	int strlen, strcap;
+	int *hash;
+	int hashcap;
+} js_BytecodeWriter;
+
+static unsigned int bc_hashptr(const char *s)
+{
+	size_t x = (size_t)s;
+	return (unsigned int)(x ^ (x >> 9)) * 2654435761u;
+}
+
+static int bc_findstring(js_BytecodeWriter *W, const char *s)
+{
+	unsigned int h = bc_hashptr(s) & (W->hashcap - 1);
+	while (W->hash[h] >= 0) {
+		if (W->strtab[W->hash[h]] == s)
+			return W->hash[h];
+		h = (h + 1) & (W->hashcap - 1);
+	}
+	return -1;
+}
+
+static void bc_addstring(js_BytecodeWriter *W, const char *s)
+{
+	js_State *J = W->J;
+	unsigned int h;
+	int i;
+
+	if (W->strlen * 2 >= W->hashcap) {
+		js_free(J, W->hash);
+		W->hash = NULL;
+		W->hashcap = W->hashcap ? W->hashcap * 2 : 256;
+		W->hash = js_malloc(J, W->hashcap * sizeof *W->hash);
+		for (i = 0; i < W->hashcap; ++i)
+			W->hash[i] = -1;
+		for (i = 0; i < W->strlen; ++i) {
+			h = bc_hashptr(W->strtab[i]) & (W->hashcap - 1);
+			while (W->hash[h] >= 0)
+				h = (h + 1) & (W->hashcap - 1);
+			W->hash[h] = i;
+		}
+	}
+
+	if (bc_findstring(W, s) >= 0)
+		return;
+
+	if (W->strlen >= W->strcap) {
+		W->strcap = W->strcap ? W->strcap * 2 : 256;
+		W->strtab = js_realloc(J, W->strtab, W->strcap * sizeof *W->strtab);
+	}
+	h = bc_hashptr(s) & (W->hashcap - 1);
+	while (W->hash[h] >= 0)
+		h = (h + 1) & (W->hashcap - 1);
+	W->hash[h] = W->strlen;
+	W->strtab[W->strlen++] = s;
+}
+
+static void bc_collectstrings(js_BytecodeWriter *W, js_Function *F)
+{
+	js_Instruction *p = F->code;
+	js_Instruction *end = F->code + F->codelen;
+	const char *s;
+	int i, n, string;
+
+	bc_addstring(W, F->name);
+	for (i = 0; i < F->varlen; ++i)
+		bc_addstring(W, F->vartab[i]);
+	while (p < end) {
+		n = bc_operands(*p++, &string);
+		if (string) {
+			memcpy(&s, p, sizeof s);
+			bc_addstring(W, s);
+		}
+		p += n;
+	}
+	for (i = 0; i < F->funlen; ++i)
+		bc_collectstrings(W, F->funtab[i]);
+}
+
+static void bc_putint(js_BytecodeWriter *W, int v)
+{
+	unsigned int u = v;
+	unsigned char buf[4];
+	buf[0] = u;
+	buf[1] = u >> 8;
+	buf[2] = u >> 16;
+	buf[3] = u >> 24;
+	W->write(W->data, buf, 4);
+}
+
+static void bc_savefunction(js_BytecodeWriter *W, js_Function *F)
+{
+	js_Instruction *p = F->code;
+	js_Instruction *end = F->code + F->codelen;
+	js_Instruction *q;
+	const char *s;
+	size_t x;
+	int i, n, string;
+
+	bc_putint(W, bc_findstring(W, F->name));
+	bc_putint(W, F->script | F->lightweight << 1 | F->strict << 2 | F->arguments << 3 | F->dynamic << 4);
+	bc_putint(W, F->numparams);
+	bc_putint(W, F->line);
+	bc_putint(W, F->lastline);
+
+	bc_putint(W, F->varlen);
+	for (i = 0; i < F->varlen; ++i)
+		bc_putint(W, bc_findstring(W, F->vartab[i]));
+
+	bc_putint(W, F->cachelen);
+
+	bc_putint(W, F->codelen);
+	while (p < end) {
+		q = p;
+		n = bc_operands(*p++, &string);
+		if (string) {
+			W->write(W->data, q, 1 * sizeof *p);
+			memcpy(&s, p, sizeof s);
+			x = bc_findstring(W, s);
+			W->write(W->data, &x, sizeof x);
+			W->write(W->data, p + BC_STRSLOTS, (n - BC_STRSLOTS) * sizeof *p);
+		} else {
+			W->write(W->data, q, (n + 1) * sizeof *p);
+		}
+		p += n;
+	}
+
+	bc_putint(W, F->linelen);
+	for (i = 0; i < F->linelen * 2; ++i)
+		bc_putint(W, F->linetab[i]);
+
+	bc_putint(W, F->funlen);
+	for (i = 0; i < F->funlen; ++i)
+		bc_savefunction(W, F->funtab[i]);
+}
+
+void js_savebytecode(js_State *J, int idx, js_Writer write, void *data)
+{
+	js_BytecodeWriter W;
+	js_Object *obj;
+	int i, n;
+
+	obj = js_toobject(J, idx);
+	if (obj->type != JS_CSCRIPT)
+		js_typeerror(J, "not a script");
+
+	memset(&W, 0, sizeof W);
+	W.J = J;
+	W.write = write;
+	W.data = data;
+
+	if (js_try(J)) {
+		js_free(J, W.strtab);
+		js_free(J, W.hash);
+		js_throw(J);
+	}
+
+	bc_collectstrings(&W, obj->u.f.function);
+
+	write(data, bc_magic, 4);
+	bc_putint(&W, BC_VERSION);
+	bc_putint(&W, bc_layout());
+
+	bc_putint(&W, W.strlen);
+	for (i = 0; i < W.strlen; ++i) {
+		n = strlen(W.strtab[i]);
+		bc_putint(&W, n);
+		write(data, W.strtab[i], n + 1);
+	}
+
+	bc_savefunction(&W, obj->u.f.function);
+
+	js_endtry(J);
+	js_free(J, W.strtab);
+	js_free(J, W.hash);
+}
+
+/* Load */
+
+typedef struct {
+	js_State *J;
+	const char *filename;
+	const unsigned char *p, *end;
+	const char **strtab;
+	int strlen;
+} js_BytecodeReader;
+
+static void bc_corrupt(js_BytecodeReader *R)
+{
+	js_error(R->J, "%s: bytecode is corrupt", R->filename);
+}
+
+static int bc_getint(js_BytecodeReader *R)
+{
+	unsigned int u;
+	if (R->end - R->p < 4)
+		bc_corrupt(R);
+	u = R->p[0] | R->p[1] << 8 | R->p[2] << 16 | (unsigned int)R->p[3] << 24;
+	R->p += 4;
+	return (int)u;
+}
+
+static int bc_getcount(js_BytecodeReader *R, int size)
+{
+	int n = bc_getint(R);
+	if (n < 0 || n > (R->end - R->p) / size)
+		bc_corrupt(R);
+	return n;
+}
+
+static const char *bc_getstring(js_BytecodeReader *R)
+{
+	int i = bc_getint(R);
+	if (i < 0 || i >= R->strlen)
+		bc_corrupt(R);
+	return R->strtab[i];
+}
+
+/* Resolve string operands and check that operands stay inside the function. */
+static void bc_linkcode(js_BytecodeReader *R, js_Function *F)
+{
+	js_Instruction *p = F->code;
+	js_Instruction *end = F->code + F->codelen;
+	const char *s;
+	size_t x;
+	int op, n, string;
+
+	while (p < end) {
+		if (end - p < 1)
+			bc_corrupt(R);
+		op = *p++;
+		if (op >= (bc_layout() >> 16))
+			bc_corrupt(R);
+		n = bc_operands(op, &string);
+		if (end - p < n)
+			bc_corrupt(R);
+		if (string) {
+			memcpy(&x, p, sizeof x);
+			if (x >= (size_t)R->strlen)
+				bc_corrupt(R);
+			s = R->strtab[x];
+			memcpy(p, &s, sizeof s);
+		}
+		switch (op) {
+		case OP_GETLOCAL:
+		case OP_SETLOCAL:
+		case OP_DELLOCAL:
+			if (*p < 1 || *p > F->varlen)
+				bc_corrupt(R);
+			break;
+		case OP_CLOSURE:
+			if (*p >= F->funlen)
+				bc_corrupt(R);
+			break;
+		case OP_ADDLOCALS:
+			if (p[0] < 1 || p[0] > F->varlen || p[1] < 1 || p[1] > F->varlen)
+				bc_corrupt(R);
+			break;
+		case OP_GETPROP_S:
+		case OP_SETPROP_S:
+		case OP_GETMETHOD_S:
+			if (p[BC_STRSLOTS] >= F->cachelen)
+				bc_corrupt(R);
+			break;
+		case OP_JNLTLOCAL:
+			if (*p < 1 || *p > F->varlen || p[2] > F->codelen)
+				bc_corrupt(R);
+			break;
+		case OP_JUMP:
+		case OP_JTRUE:
+		case OP_JFALSE:
+		case OP_JCASE:
+		case OP_TRY:
+			if (*p > F->codelen)
+				bc_corrupt(R);
+			break;
+		}
+		p += n;
+	}
+}
+
+static js_Function *bc_loadfunction(js_BytecodeReader *R, int depth)
+{
+	js_State *J = R->J;
+	js_Function *F;
+	int i, flags;
+
+	if (depth > JS_ASTLIMIT)
+		bc_corrupt(R);
+
+	F = js_malloc(J, sizeof *F);
+	memset(F, 0, sizeof *F);
+	F->gcmark = jsG_newmark(J);
+	F->gcnext = J->gcfun;
+	J->gcfun = F;
+	++J->gccounter;
+
+	F->filename = R->filename;
+	F->name = bc_getstring(R);
+	flags = bc_getint(R);
+	F->script = flags & 1;
+	F->lightweight = (flags >> 1) & 1;
+	F->strict = (flags >> 2) & 1;
+	F->arguments = (flags >> 3) & 1;
+	F->dynamic = (flags >> 4) & 1;
+	F->numparams = bc_getint(R);
+	F->line = bc_getint(R);
+	F->lastline = bc_getint(R);
+
+	F->varlen = F->varcap = bc_getcount(R, 4);
+	if (F->varlen > 0) {
+		F->vartab = js_malloc(J, F->varlen * sizeof *F->vartab);
+		for (i = 0; i < F->varlen; ++i)
+			F->vartab[i] = bc_getstring(R);
+	}
+	if (F->numparams < 0 || F->numparams > F->varlen)
+		bc_corrupt(R);
+
+	F->cachelen = bc_getint(R);
+	if (F->cachelen < 0 || F->cachelen > 0xffff)
+		bc_corrupt(R);
+	if (F->cachelen > 0) {
+		F->cachetab = js_malloc(J, F->cachelen * sizeof *F->cachetab);
+		memset(F->cachetab, 0, F->cachelen * sizeof *F->cachetab);
+	}
+
+	F->codelen = F->codecap = bc_getcount(R, sizeof *F->code);
+	if (F->codelen > 0) {
+		F->code = js_malloc(J, F->codelen * sizeof *F->code);
+		memcpy(F->code, R->p, F->codelen * sizeof *F->code);
+		R->p += F->codelen * sizeof *F->code;
+	}
+
+	F->linelen = F->linecap = bc_getcount(R, 8);
+	if (F->linelen > 0) {
+		F->linetab = js_malloc(J, F->linelen * 2 * sizeof *F->linetab);
+		for (i = 0; i < F->linelen * 2; i += 2) {
+			F->linetab[i] = bc_getint(R);
+			F->linetab[i+1] = bc_getint(R);
+			if (F->linetab[i] >= F->codelen || (i > 0 && F->linetab[i] <= F->linetab[i-2]))
+				bc_corrupt(R);
+		}
+	}
+
+	F->funlen = F->funcap = bc_getcount(R, 4);
+	if (F->funlen > 0) {
+		F->funtab = js_malloc(J, F->funlen * sizeof *F->funtab);
+		memset(F->funtab, 0, F->funlen * sizeof *F->funtab);
+		for (i = 0; i < F->funlen; ++i)
+			F->funtab[i] = bc_loadfunction(R, depth + 1);
+	}
+
+	bc_linkcode(R, F);
+
+	return F;
+}
+
+int js_isbytecode(const void *data, int size)
+{
+	return size >= 4 && !memcmp(data, bc_magic, 4);
+}
+
+void js_loadbytecode(js_State *J, const char *filename, const void *data, int size)
+{
+	js_BytecodeReader R;
+	js_Function *F;
+	int i, n;
+
+	R.J = J;
+	R.filename = js_intern(J, filename);
+	R.p = data;
+	R.end = R.p + size;
+	R.strtab = NULL;
+	R.strlen = 0;
+
+	if (!js_isbytecode(data, size))
+		js_error(J, "%s: not bytecode", filename);
+	R.p += 4;
+	if (bc_getint(&R) != BC_VERSION || bc_getint(&R) != bc_layout())
+		js_error(J, "%s: bytecode was compiled by an incompatible version", filename);
+
+	if (js_try(J)) {
+		js_free(J, R.strtab);
+		js_throw(J);
+	}
+
+	n = bc_getcount(&R, 5);
+	R.strtab = js_malloc(J, (n > 0 ? n : 1) * sizeof *R.strtab);
+	for (i = 0; i < n; ++i) {
+		int len = bc_getcount(&R, 1);
+		if (len >= R.end - R.p || R.p[len] != 0)
+			bc_corrupt(&R);
+		R.strtab[i] = js_intern(J, (const char *)R.p);
+		R.p += len + 1;
+		R.strlen = i + 1;
+	}
+
+	F = bc_loadfunction(&R, 0);
+	if (!F->script || R.p != R.end)
+		bc_corrupt(&R);
+
+	js_endtry(J);
+	js_free(J, R.strtab);
+
+	js_newscript(J, F, J->GE);
+}
@@ -51,11 +51,11 @@ static void checkfutureword(JF, js_Ast *exp)
 	}
 }
 
-static js_Function *newfun(js_State *J, int line, js_Ast *name, js_Ast *params, js_Ast *body, int script, int default_strict)
+static js_Function *newfun(js_State *J, js_Function *parent, int line, js_Ast *name, js_Ast *params, js_Ast *body, int script, int default_strict)
 {
 	js_Function *F = js_malloc(J, sizeof *F);
 	memset(F, 0, sizeof *F);
-	F->gcmark = 0;
+	F->gcmark = jsG_newmark(J);
 	F->gcnext = J->gcfun;
 	J->gcfun = F;
 	++J->gccounter;
@@ -66,8 +66,21 @@ static js_Function *newfun(js_State *J, int line, js_Ast *name, js_Ast *params,
 	F->strict = default_strict;
 	F->name = name ? name->string : "";
 
+	if (parent) {
+		F->parent = parent;
+		F->parentscope = parent->scope;
+	}
+
 	cfunbody(J, F, name, params, body);
 
+	F->parent = NULL;
+	F->parentscope = NULL;
+
+	if (F->cachelen > 0) {
+		F->cachetab = js_malloc(J, F->cachelen * sizeof *F->cachetab);
+		memset(F->cachetab, 0, F->cachelen * sizeof *F->cachetab);
+	}
+
 	return F;
 }
 
@@ -84,9 +97,33 @@ static void emitraw(JF, int value)
 	F->code[F->codelen++] = value;
 }
 
+/* Record the line of the instruction about to be emitted, if it differs from the previous one */
+static void emitlinetab(JF)
+{
+	int n = F->linelen;
+	if (n > 0 && F->linetab[2*n-1] == F->lastline)
+		return;
+	if (F->lastline != (js_Instruction)F->lastline)
+		js_syntaxerror(J, "integer overflow in instruction coding");
+	if (n > 0 && F->linetab[2*n-2] == F->codelen) {
+		F->linetab[2*n-1] = F->lastline;
+		return;
+	}
+	if (n >= F->linecap) {
+		F->linecap = F->linecap ? F->linecap * 2 : 16;
+		F->linetab = js_realloc(J, F->linetab, F->linecap * 2 * sizeof *F->linetab);
+	}
+	F->linetab[2*n] = F->codelen;
+	F->linetab[2*n+1] = F->lastline;
+	F->linelen = n + 1;
+}
+
 static void emit(JF, int value)
 {
-	emitraw(J, F, F->lastline);
+	F->lastinst[2] = F->lastinst[1];
+	F->lastinst[1] = F->lastinst[0];
+	F->lastinst[0] = F->codelen;
+	emitlinetab(J, F);
 	emitraw(J, F, value);
 }
 
@@ -100,6 +137,80 @@ static void emitline(JF, js_Ast *node)
 	F->lastline = node->line;
 }
 
+int jsC_findline(js_Function *F, int pc)
+{
+	int lo = 0, hi = F->linelen - 1, line = F->line;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		if (F->linetab[2*mid] <= pc) {
+			line = F->linetab[2*mid+1];
+			lo = mid + 1;
+		} else {
+			hi = mid - 1;
+		}
+	}
+	return line;
+}
+
+/*
+	Superinstructions: a few common sequences are replaced by one instruction
+	as they are emitted. Only the first instruction of a sequence may be a
+	jump target, so targets are remembered in lasttarget.
+*/
+
+/* Opcode of the k'th last instruction, if it and what follows can be fused */
+static int lastop(JF, int k)
+{
+	int i;
+	if (F->codelen <= F->lasttarget)
+		return -1;
+	for (i = 0; i < k; ++i)
+		if (F->lastinst[i] <= F->lasttarget || F->lastinst[i+1] >= F->lastinst[i])
+			return -1;
+	return F->code[F->lastinst[k]];
+}
+
+/* Drop the code from inst on, to be emitted again as a superinstruction */
+static void unemit(JF, int inst)
+{
+	F->codelen = inst;
+	while (F->linelen > 0 && F->linetab[2*F->linelen-2] > inst)
+		--F->linelen;
+	F->lastinst[0] = F->lastinst[1] = F->lastinst[2] = inst;
+}
+
+/* getlocal A; getlocal B; add */
+static int fuseadd(JF)
+{
+	int inst = F->lastinst[1];
+	int a, b;
+	if (lastop(J, F, 0) != OP_GETLOCAL || lastop(J, F, 1) != OP_GETLOCAL)
+		return 0;
+	a = F->code[inst+1];
+	b = F->code[F->lastinst[0]+1];
+	unemit(J, F, inst);
+	emit(J, F, OP_ADDLOCALS);
+	emitarg(J, F, a);
+	emitarg(J, F, b);
+	return 1;
+}
+
+/* getlocal A; integer N; lt; jfalse */
+static int fusejfalse(JF)
+{
+	int inst = F->lastinst[2];
+	int a, n;
+	if (lastop(J, F, 0) != OP_LT || lastop(J, F, 1) != OP_INTEGER || lastop(J, F, 2) != OP_GETLOCAL)
+		return 0;
+	a = F->code[inst+1];
+	n = F->code[F->lastinst[1]+1];
+	unemit(J, F, inst);
+	emit(J, F, OP_JNLTLOCAL);
+	emitarg(J, F, a);
+	emitarg(J, F, n);
+	return 1;
+}
+
 static int addfunction(JF, js_Function *value)
 {
 	if (F->funlen >= F->funcap) {
@@ -110,6 +221,8 @@ static int addfunction(JF, js_Function *value)
 	return F->funlen++;
 }
 
+static int pushlocal(JF, const char *name);
+
 static int addlocal(JF, js_Ast *ident, int reuse)
 {
 	const char *name = ident->string;
@@ -133,6 +246,11 @@ static int addlocal(JF, js_Ast *ident, int reuse)
 			}
 		}
 	}
+	return pushlocal(J, F, name);
+}
+
+static int pushlocal(JF, const char *name)
+{
 	if (F->varlen >= F->varcap) {
 		F->varcap = F->varcap ? F->varcap * 2 : 16;
 		F->vartab = js_realloc(J, F->vartab, F->varcap * sizeof *F->vartab);
@@ -150,6 +268,37 @@ static int findlocal(JF, const char *name)
 	return -1;
 }
 
+/*
+ * Resolve a variable to a slot in the environment of this or an enclosing
+ * function, counting the environment records to walk up at run time.
+ * Give up if the name could be shadowed by something only known at run time.
+ */
+static int resolvevar(JF, const char *name, int *depth)
+{
+	js_Function *G = F;
+	js_Scope *S = F->scope;
+	int d = 0;
+	int i;
+
+	for (;;) {
+		if (G->dynamic)
+			return -1;
+		for (; S; S = S->up, ++d)
+			if (!S->name || !strcmp(S->name, name))
+				return -1;
+		i = findlocal(J, G, name);
+		if (i > 0) {
+			*depth = d;
+			return i;
+		}
+		S = G->parentscope;
+		G = G->parent;
+		if (!G)
+			return -1;
+		++d;
+	}
+}
+
 static void emitfunction(JF, js_Function *fun)
 {
 	F->lightweight = 0;
@@ -191,10 +340,18 @@ static void emitstring(JF, int opcode, const char *str)
 #undef N
 }
 
+/* Named property access with an inline cache slot */
+static void emitprop(JF, int opcode, const char *str)
+{
+	emitstring(J, F, opcode, str);
+	emitarg(J, F, F->cachelen++);
+}
+
 static void emitlocal(JF, int oploc, int opvar, js_Ast *ident)
 {
 	int is_arguments = !strcmp(ident->string, "arguments");
 	int is_eval = !strcmp(ident->string, "eval");
+	int depth;
 	int i;
 
 	if (is_arguments) {
@@ -212,24 +369,47 @@ static void emitlocal(JF, int oploc, int opvar, js_Ast *ident)
 	if (is_eval)
 		js_evalerror(J, "%s:%d: invalid use of 'eval'", J->filename, ident->line);
 
+	/* give the arguments object a slot of its own */
+	if (is_arguments && !F->dynamic && findlocal(J, F, ident->string) < 0)
+		pushlocal(J, F, ident->string);
+
 	i = findlocal(J, F, ident->string);
+	if (F->dynamic || (i > 0 && !F->scope)) {
+		if (i < 0) {
+			emitstring(J, F, opvar, ident->string);
+		} else {
+			emit(J, F, oploc);
+			emitarg(J, F, i);
+		}
+		return;
+	}
+
+	i = resolvevar(J, F, ident->string, &depth);
 	if (i < 0) {
 		emitstring(J, F, opvar, ident->string);
-	} else {
+	} else if (depth == 0) {
 		emit(J, F, oploc);
 		emitarg(J, F, i);
+	} else if (oploc == OP_DELLOCAL) {
+		emit(J, F, OP_FALSE);
+	} else {
+		emit(J, F, oploc == OP_SETLOCAL ? OP_SETUPVAR : OP_GETUPVAR);
+		emitarg(J, F, depth);
+		emitarg(J, F, i);
 	}
 }
 
 static int here(JF)
 {
+	F->lasttarget = F->codelen;
 	return F->codelen;
 }
 
 static int emitjump(JF, int opcode)
 {
 	int inst;
-	emit(J, F, opcode);
+	if (opcode != OP_JFALSE || !fusejfalse(J, F))
+		emit(J, F, opcode);
 	inst = F->codelen;
 	emitarg(J, F, 0);
 	return inst;
@@ -252,6 +432,7 @@ static void labelto(JF, int inst, int addr)
 
 static void label(JF, int inst)
 {
+	F->lasttarget = F->codelen;
 	labelto(J, F, inst, F->codelen);
 }
 
@@ -281,7 +462,8 @@ static void cbinary(JF, js_Ast *exp, int opcode)
 	cexp(J, F, exp->a);
 	cexp(J, F, exp->b);
 	emitline(J, F, exp);
-	emit(J, F, opcode);
+	if (opcode != OP_ADD || !fuseadd(J, F))
+		emit(J, F, opcode);
 }
 
 static void carray(JF, js_Ast *list)
@@ -347,12 +529,12 @@ static void cobject(JF, js_Ast *list)
 			emit(J, F, OP_INITPROP);
 			break;
 		case EXP_PROP_GET:
-			emitfunction(J, F, newfun(J, prop->line, NULL, NULL, kv->c, 0, F->strict));
+			emitfunction(J, F, newfun(J, F, prop->line, NULL, NULL, kv->c, 0, F->strict));
 			emitline(J, F, kv);
 			emit(J, F, OP_INITGETTER);
 			break;
 		case EXP_PROP_SET:
-			emitfunction(J, F, newfun(J, prop->line, NULL, kv->b, kv->c, 0, F->strict));
+			emitfunction(J, F, newfun(J, F, prop->line, NULL, kv->b, kv->c, 0, F->strict));
 			emitline(J, F, kv);
 			emit(J, F, OP_INITSETTER);
 			break;
@@ -394,7 +576,7 @@ static void cassign(JF, js_Ast *exp)
 		cexp(J, F, lhs->a);
 		cexp(J, F, rhs);
 		emitline(J, F, exp);
-		emitstring(J, F, OP_SETPROP_S, lhs->b->string);
+		emitprop(J, F, OP_SETPROP_S, lhs->b->string);
 		break;
 	default:
 		jsC_error(J, lhs, "invalid l-value in assignment");
@@ -432,7 +614,7 @@ static void cassignforin(JF, js_Ast *stm)
 		cexp(J, F, lhs->a);
 		emitline(J, F, lhs);
 		emit(J, F, OP_ROT2);
-		emitstring(J, F, OP_SETPROP_S, lhs->b->string);
+		emitprop(J, F, OP_SETPROP_S, lhs->b->string);
 		emit(J, F, OP_POP);
 		break;
 	default:
@@ -458,7 +640,7 @@ static void cassignop1(JF, js_Ast *lhs)
 		cexp(J, F, lhs->a);
 		emitline(J, F, lhs);
 		emit(J, F, OP_DUP);
-		emitstring(J, F, OP_GETPROP_S, lhs->b->string);
+		emitprop(J, F, OP_GETPROP_S, lhs->b->string);
 		break;
 	default:
 		jsC_error(J, lhs, "invalid l-value in assignment");
@@ -481,7 +663,7 @@ static void cassignop2(JF, js_Ast *lhs, int postfix)
 	case EXP_MEMBER:
 		emitline(J, F, lhs);
 		if (postfix) emit(J, F, OP_ROT3);
-		emitstring(J, F, OP_SETPROP_S, lhs->b->string);
+		emitprop(J, F, OP_SETPROP_S, lhs->b->string);
 		break;
 	default:
 		jsC_error(J, lhs, "invalid l-value in assignment");
@@ -495,7 +677,8 @@ static void cassignop(JF, js_Ast *exp, int opcode)
 	cassignop1(J, F, lhs);
 	cexp(J, F, rhs);
 	emitline(J, F, exp);
-	emit(J, F, opcode);
+	if (opcode != OP_ADD || !fuseadd(J, F))
+		emit(J, F, opcode);
 	cassignop2(J, F, lhs, 0);
 }
 
@@ -550,9 +733,7 @@ static void ccall(JF, js_Ast *fun, js_Ast *args)
 		break;
 	case EXP_MEMBER:
 		cexp(J, F, fun->a);
-		emit(J, F, OP_DUP);
-		emitstring(J, F, OP_GETPROP_S, fun->b->string);
-		emit(J, F, OP_ROT2);
+		emitprop(J, F, OP_GETMETHOD_S, fun->b->string);
 		break;
 	case EXP_IDENTIFIER:
 		if (!strcmp(fun->string, "eval")) {
@@ -625,7 +806,7 @@ static void cexp(JF, js_Ast *exp)
 
 	case EXP_FUN:
 		emitline(J, F, exp);
-		emitfunction(J, F, newfun(J, exp->line, exp->a, exp->b, exp->c, 0, F->strict));
+		emitfunction(J, F, newfun(J, F, exp->line, exp->a, exp->b, exp->c, 0, F->strict));
 		break;
 
 	case EXP_IDENTIFIER:
@@ -643,7 +824,7 @@ static void cexp(JF, js_Ast *exp)
 	case EXP_MEMBER:
 		cexp(J, F, exp->a);
 		emitline(J, F, exp);
-		emitstring(J, F, OP_GETPROP_S, exp->b->string);
+		emitprop(J, F, OP_GETPROP_S, exp->b->string);
 		break;
 
 	case EXP_CALL:
@@ -951,6 +1132,19 @@ static void ctryfinally(JF, js_Ast *trystm, js_Ast *finallystm)
 	cstm(J, F, finallystm);
 }
 
+static void ccatch(JF, js_Ast *catchvar, js_Ast *catchstm)
+{
+	js_Scope scope;
+	emitline(J, F, catchvar);
+	emitstring(J, F, OP_CATCH, catchvar->string);
+	scope.name = catchvar->string;
+	scope.up = F->scope;
+	F->scope = &scope;
+	cstm(J, F, catchstm);
+	F->scope = scope.up;
+	emit(J, F, OP_ENDCATCH);
+}
+
 static void ctrycatch(JF, js_Ast *trystm, js_Ast *catchvar, js_Ast *catchstm)
 {
 	int L1, L2;
@@ -964,10 +1158,7 @@ static void ctrycatch(JF, js_Ast *trystm, js_Ast *catchvar, js_Ast *catchstm)
 			if (!strcmp(catchvar->string, "eval"))
 				jsC_error(J, catchvar, "redefining 'eval' is not allowed in strict mode");
 		}
-		emitline(J, F, catchvar);
-		emitstring(J, F, OP_CATCH, catchvar->string);
-		cstm(J, F, catchstm);
-		emit(J, F, OP_ENDCATCH);
+		ccatch(J, F, catchvar, catchstm);
 		L2 = emitjump(J, F, OP_JUMP); /* skip past the try block */
 	}
 	label(J, F, L1);
@@ -996,10 +1187,7 @@ static void ctrycatchfinally(JF, js_Ast *trystm, js_Ast *catchvar, js_Ast *catch
 			if (!strcmp(catchvar->string, "eval"))
 				jsC_error(J, catchvar, "redefining 'eval' is not allowed in strict mode");
 		}
-		emitline(J, F, catchvar);
-		emitstring(J, F, OP_CATCH, catchvar->string);
-		cstm(J, F, catchstm);
-		emit(J, F, OP_ENDCATCH);
+		ccatch(J, F, catchvar, catchstm);
 		emit(J, F, OP_ENDTRY);
 		L3 = emitjump(J, F, OP_JUMP); /* skip past the try block to the finally block */
 	}
@@ -1269,7 +1457,14 @@ static void cstm(JF, js_Ast *stm)
 		cexp(J, F, stm->a);
 		emitline(J, F, stm);
 		emit(J, F, OP_WITH);
-		cstm(J, F, stm->b);
+		{
+			js_Scope scope;
+			scope.name = NULL;
+			scope.up = F->scope;
+			F->scope = &scope;
+			cstm(J, F, stm->b);
+			F->scope = scope.up;
+		}
 		emitline(J, F, stm);
 		emit(J, F, OP_ENDWITH);
 		break;
@@ -1363,7 +1558,7 @@ static void cfundecs(JF, js_Ast *list)
 		js_Ast *stm = list->a;
 		if (stm->type == AST_FUNDEC) {
 			emitline(J, F, stm);
-			emitfunction(J, F, newfun(J, stm->line, stm->a, stm->b, stm->c, 0, F->strict));
+			emitfunction(J, F, newfun(J, F, stm->line, stm->a, stm->b, stm->c, 0, F->strict));
 			emitline(J, F, stm);
 			emit(J, F, OP_SETLOCAL);
 			emitarg(J, F, addlocal(J, F, stm->a, 1));
@@ -1373,6 +1568,33 @@ static void cfundecs(JF, js_Ast *list)
 	}
 }
 
+/* Look for 'with' statements and direct calls to 'eval', which can introduce bindings at run time */
+static int hasdynamicscope(js_Ast *node)
+{
+	while (node) {
+		if (node->type == AST_LIST) {
+			if (hasdynamicscope(node->a))
+				return 1;
+			node = node->b;
+			continue;
+		}
+
+		if (isfun(node->type))
+			return 0; /* stop at inner functions */
+
+		if (node->type == STM_WITH)
+			return 1;
+		if (node->type == EXP_CALL && node->a->type == EXP_IDENTIFIER && !strcmp(node->a->string, "eval"))
+			return 1;
+
+		if (node->a && hasdynamicscope(node->a)) return 1;
+		if (node->b && hasdynamicscope(node->b)) return 1;
+		if (node->c && hasdynamicscope(node->c)) return 1;
+		node = node->d;
+	}
+	return 0;
+}
+
 static void cfunbody(JF, js_Ast *name, js_Ast *params, js_Ast *body)
 {
 	F->lightweight = 1;
@@ -1381,6 +1603,9 @@ static void cfunbody(JF, js_Ast *name, js_Ast *params, js_Ast *body)
 	if (F->script)
 		F->lightweight = 0;
 
+	/* script variables are properties of the global object */
+	F->dynamic = F->script || hasdynamicscope(body);
+
 	/* Check if first statement is 'use strict': */
 	if (body && body->type == AST_LIST && body->a && body->a->type == EXP_STRING)
 		if (!strcmp(body->a->string, "use strict"))
@@ -1418,10 +1643,10 @@ static void cfunbody(JF, js_Ast *name, js_Ast *params, js_Ast *body)
 
 js_Function *jsC_compilefunction(js_State *J, js_Ast *prog)
 {
-	return newfun(J, prog->line, prog->a, prog->b, prog->c, 0, J->default_strict);
+	return newfun(J, NULL, prog->line, prog->a, prog->b, prog->c, 0, J->default_strict);
 }
 
 js_Function *jsC_compilescript(js_State *J, js_Ast *prog, int default_strict)
 {
-	return newfun(J, prog ? prog->line : 0, NULL, NULL, prog, 1, default_strict);
+	return newfun(J, NULL, prog ? prog->line : 0, NULL, NULL, prog, 1, default_strict);
 }
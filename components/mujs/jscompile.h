@@ -30,6 +30,8 @@ enum js_OpCode
 	OP_GETLOCAL,	/* -K- <value> */
 	OP_SETLOCAL,	/* <value> -K- <value> */
 	OP_DELLOCAL,	/* -K- false */
+	OP_GETUPVAR,	/* -D,K- <value> */
+	OP_SETUPVAR,	/* <value> -D,K- <value> */
 
 	OP_HASVAR,	/* -S- ( <value> | undefined ) */
 	OP_GETVAR,	/* -S- <value> */
@@ -44,9 +46,9 @@ enum js_OpCode
 	OP_INITSETTER,	/* <obj> <key> <closure> -- <obj> */
 
 	OP_GETPROP,	/* <obj> <name> -- <value> */
-	OP_GETPROP_S,	/* <obj> -S- <value> */
+	OP_GETPROP_S,	/* <obj> -S,cache- <value> */
 	OP_SETPROP,	/* <obj> <name> <value> -- <value> */
-	OP_SETPROP_S,	/* <obj> <value> -S- <value> */
+	OP_SETPROP_S,	/* <obj> <value> -S,cache- <value> */
 	OP_DELPROP,	/* <obj> <name> -- <success> */
 	OP_DELPROP_S,	/* <obj> -S- <success> */
 
@@ -106,6 +108,30 @@ enum js_OpCode
 	OP_JTRUE,
 	OP_JFALSE,
 	OP_RETURN,
+
+	/* Superinstructions for common sequences, fused by the compiler */
+	OP_GETMETHOD_S,	/* <obj> -S,cache- <closure> <obj> (dup getprop_s rot2) */
+	OP_ADDLOCALS,	/* -K,K- <sum> (getlocal getlocal add) */
+	OP_JNLTLOCAL,	/* -K,N,ADDR- (getlocal integer lt jfalse) */
+};
+
+/* Compile time scope nesting inside a function: catch variables and with statements */
+typedef struct js_Scope js_Scope;
+
+struct js_Scope
+{
+	const char *name; /* catch variable, or NULL for a with statement */
+	js_Scope *up;
+};
+
+/* Monomorphic inline cache for a named property access site */
+typedef struct js_PropCache js_PropCache;
+
+struct js_PropCache
+{
+	unsigned int shape; /* shape of the object, 0 if empty */
+	unsigned int pshape; /* shape of the prototype holding the property, 0 if own */
+	struct js_Property *ref;
 };
 
 struct js_Function
@@ -115,20 +141,38 @@ struct js_Function
 	int lightweight;
 	int strict;
 	int arguments;
+	int dynamic; /* uses eval or with, so variables live in a named object environment */
 	int numparams;
 
 	js_Instruction *code;
 	int codecap, codelen;
 
+	/* pairs of code offset and line, for each instruction that starts a new line */
+	js_Instruction *linetab;
+	int linecap, linelen;
+
 	js_Function **funtab;
 	int funcap, funlen;
 
 	const char **vartab;
 	int varcap, varlen;
 
+	js_PropCache *cachetab;
+	int cachelen;
+
 	const char *filename;
 	int line, lastline;
 
+	/* only valid while compiling, for resolving variables of enclosing functions */
+	js_Function *parent;
+	js_Scope *parentscope, *scope;
+
+	/* only valid while compiling, for fusing instructions that are not jump targets */
+	int lastinst[3];
+	int lasttarget;
+
+	unsigned int opcount; /* instructions executed while profiling */
+
 	js_Function *gcnext;
 	int gcmark;
 };
@@ -136,6 +180,7 @@ struct js_Function
 js_Function *jsC_compilefunction(js_State *J, js_Ast *prog);
 js_Function *jsC_compilescript(js_State *J, js_Ast *prog, int default_strict);
 const char *jsC_opcodestring(enum js_OpCode opcode);
+int jsC_findline(js_Function *F, int pc);
 void jsC_dumpfunction(js_State *J, js_Function *fun);
 
 #endif
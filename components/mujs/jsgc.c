@@ -5,6 +5,11 @@
 
 #include "regexp.h"
 
+#include <time.h>
+#if defined(__unix__) || defined(__APPLE__) || defined(ESP_PLATFORM)
+#include <sys/time.h>
+#endif
+
 static void jsG_freeenvironment(js_State *J, js_Environment *env)
 {
 	js_free(J, env);
@@ -14,7 +19,9 @@ static void jsG_freefunction(js_State *J, js_Function *fun)
 {
 	js_free(J, fun->funtab);
 	js_free(J, fun->vartab);
+	js_free(J, fun->cachetab);
 	js_free(J, fun->code);
+	js_free(J, fun->linetab);
 	js_free(J, fun);
 }
 
@@ -34,10 +41,18 @@ static void jsG_freeiterator(js_State *J, js_Iterator *node)
 	}
 }
 
+static void jsG_freestring(js_State *J, js_String *str)
+{
+	js_free(J, str->index);
+	js_free(J, str);
+}
+
 static void jsG_freeobject(js_State *J, js_Object *obj)
 {
 	if (obj->properties->level)
 		jsG_freeproperty(J, obj->properties);
+	if (obj->type == JS_CARRAY && obj->u.a.simple)
+		js_free(J, obj->u.a.array);
 	if (obj->type == JS_CREGEXP) {
 		js_free(J, obj->u.r.source);
 		js_regfreex(J->alloc, J->actx, obj->u.r.prog);
@@ -51,6 +66,28 @@ static void jsG_freeobject(js_State *J, js_Object *obj)
 	js_free(J, obj);
 }
 
+static void jsG_markrope(js_State *J, int mark, js_Rope *rope)
+{
+	for (;;) {
+		js_Value *v = &rope->right;
+		rope->gcmark = mark;
+		if (rope->flat) {
+			rope->flat->gcmark = mark;
+			return;
+		}
+		if (JSV_TYPE(v) == JS_TMEMSTR && JSV_MEMSTR(v)->gcmark != mark)
+			JSV_MEMSTR(v)->gcmark = mark;
+		if (JSV_TYPE(v) == JS_TROPE && JSV_ROPE(v)->gcmark != mark)
+			jsG_markrope(J, mark, JSV_ROPE(v));
+		v = &rope->left;
+		if (JSV_TYPE(v) == JS_TMEMSTR && JSV_MEMSTR(v)->gcmark != mark)
+			JSV_MEMSTR(v)->gcmark = mark;
+		if (JSV_TYPE(v) != JS_TROPE || JSV_ROPE(v)->gcmark == mark)
+			return;
+		rope = JSV_ROPE(v);
+	}
+}
+
 /* Mark and add object to scan queue */
 static void jsG_markobject(js_State *J, int mark, js_Object *obj)
 {
@@ -68,11 +105,29 @@ static void jsG_markfunction(js_State *J, int mark, js_Function *fun)
 			jsG_markfunction(J, mark, fun->funtab[i]);
 }
 
+static void jsG_markslots(js_State *J, int mark, js_Environment *env)
+{
+	int i;
+	for (i = 0; i < env->function->varlen; ++i) {
+		js_Value *v = &env->slots[i];
+		if (JSV_TYPE(v) == JS_TMEMSTR && JSV_MEMSTR(v)->gcmark != mark)
+			JSV_MEMSTR(v)->gcmark = mark;
+		if (JSV_TYPE(v) == JS_TROPE && JSV_ROPE(v)->gcmark != mark)
+			jsG_markrope(J, mark, JSV_ROPE(v));
+		if (JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->gcmark != mark)
+			jsG_markobject(J, mark, JSV_OBJECT(v));
+	}
+	if (env->function->gcmark != mark)
+		jsG_markfunction(J, mark, env->function);
+}
+
 static void jsG_markenvironment(js_State *J, int mark, js_Environment *env)
 {
 	do {
 		env->gcmark = mark;
-		if (env->variables->gcmark != mark)
+		if (!env->variables)
+			jsG_markslots(J, mark, env);
+		else if (env->variables->gcmark != mark)
 			jsG_markobject(J, mark, env->variables);
 		env = env->outer;
 	} while (env && env->gcmark != mark);
@@ -83,23 +138,43 @@ static void jsG_markproperty(js_State *J, int mark, js_Property *node)
 	if (node->left->level) jsG_markproperty(J, mark, node->left);
 	if (node->right->level) jsG_markproperty(J, mark, node->right);
 
-	if (node->value.type == JS_TMEMSTR && node->value.u.memstr->gcmark != mark)
-		node->value.u.memstr->gcmark = mark;
-	if (node->value.type == JS_TOBJECT && node->value.u.object->gcmark != mark)
-		jsG_markobject(J, mark, node->value.u.object);
+	if (JSV_TYPE(&node->value) == JS_TMEMSTR && JSV_MEMSTR(&node->value)->gcmark != mark)
+		JSV_MEMSTR(&node->value)->gcmark = mark;
+	if (JSV_TYPE(&node->value) == JS_TROPE && JSV_ROPE(&node->value)->gcmark != mark)
+		jsG_markrope(J, mark, JSV_ROPE(&node->value));
+	if (JSV_TYPE(&node->value) == JS_TOBJECT && JSV_OBJECT(&node->value)->gcmark != mark)
+		jsG_markobject(J, mark, JSV_OBJECT(&node->value));
 	if (node->getter && node->getter->gcmark != mark)
 		jsG_markobject(J, mark, node->getter);
 	if (node->setter && node->setter->gcmark != mark)
 		jsG_markobject(J, mark, node->setter);
 }
 
+static void jsG_markarray(js_State *J, int mark, js_Object *obj)
+{
+	int i;
+	for (i = 0; i < obj->u.a.flat_length; ++i) {
+		js_Value *v = &obj->u.a.array[i];
+		if (JSV_TYPE(v) == JS_TMEMSTR && JSV_MEMSTR(v)->gcmark != mark)
+			JSV_MEMSTR(v)->gcmark = mark;
+		if (JSV_TYPE(v) == JS_TROPE && JSV_ROPE(v)->gcmark != mark)
+			jsG_markrope(J, mark, JSV_ROPE(v));
+		if (JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->gcmark != mark)
+			jsG_markobject(J, mark, JSV_OBJECT(v));
+	}
+}
+
 /* Mark everything the object can reach. */
 static void jsG_scanobject(js_State *J, int mark, js_Object *obj)
 {
 	if (obj->properties->level)
 		jsG_markproperty(J, mark, obj->properties);
+	if (obj->type == JS_CARRAY && obj->u.a.simple)
+		jsG_markarray(J, mark, obj);
 	if (obj->prototype && obj->prototype->gcmark != mark)
 		jsG_markobject(J, mark, obj->prototype);
+	if (obj->type == JS_CSTRING && obj->u.s.memstr && obj->u.s.memstr->gcmark != mark)
+		obj->u.s.memstr->gcmark = mark;
 	if (obj->type == JS_CITERATOR && obj->u.iter.target->gcmark != mark) {
 		jsG_markobject(J, mark, obj->u.iter.target);
 	}
@@ -116,54 +191,45 @@ static void jsG_markstack(js_State *J, int mark)
 	js_Value *v = J->stack;
 	int n = J->top;
 	while (n--) {
-		if (v->type == JS_TMEMSTR && v->u.memstr->gcmark != mark)
-			v->u.memstr->gcmark = mark;
-		if (v->type == JS_TOBJECT && v->u.object->gcmark != mark)
-			jsG_markobject(J, mark, v->u.object);
+		if (JSV_TYPE(v) == JS_TMEMSTR && JSV_MEMSTR(v)->gcmark != mark)
+			JSV_MEMSTR(v)->gcmark = mark;
+		if (JSV_TYPE(v) == JS_TROPE && JSV_ROPE(v)->gcmark != mark)
+			jsG_markrope(J, mark, JSV_ROPE(v));
+		if (JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->gcmark != mark)
+			jsG_markobject(J, mark, JSV_OBJECT(v));
 		++v;
 	}
 }
 
-void js_gc(js_State *J, int report)
+static void jsG_markroot(js_State *J, int mark, js_Object *obj)
 {
-	js_Function *fun, *nextfun, **prevnextfun;
-	js_Object *obj, *nextobj, **prevnextobj;
-	js_String *str, *nextstr, **prevnextstr;
-	js_Environment *env, *nextenv, **prevnextenv;
-	unsigned int nenv = 0, nfun = 0, nobj = 0, nstr = 0, nprop = 0;
-	unsigned int genv = 0, gfun = 0, gobj = 0, gstr = 0, gprop = 0;
-	int mark;
-	int i;
-
-	if (J->gcpause) {
-		if (report)
-			js_report(J, "garbage collector is paused");
-		return;
-	}
-
-	mark = J->gcmark = J->gcmark == 1 ? 2 : 1;
-
-	/* Add initial roots. */
-
-	jsG_markobject(J, mark, J->Object_prototype);
-	jsG_markobject(J, mark, J->Array_prototype);
-	jsG_markobject(J, mark, J->Function_prototype);
-	jsG_markobject(J, mark, J->Boolean_prototype);
-	jsG_markobject(J, mark, J->Number_prototype);
-	jsG_markobject(J, mark, J->String_prototype);
-	jsG_markobject(J, mark, J->RegExp_prototype);
-	jsG_markobject(J, mark, J->Date_prototype);
+	if (obj->gcmark != mark)
+		jsG_markobject(J, mark, obj);
+}
 
-	jsG_markobject(J, mark, J->Error_prototype);
-	jsG_markobject(J, mark, J->EvalError_prototype);
-	jsG_markobject(J, mark, J->RangeError_prototype);
-	jsG_markobject(J, mark, J->ReferenceError_prototype);
-	jsG_markobject(J, mark, J->SyntaxError_prototype);
-	jsG_markobject(J, mark, J->TypeError_prototype);
-	jsG_markobject(J, mark, J->URIError_prototype);
+static void jsG_markroots(js_State *J, int mark)
+{
+	int i;
 
-	jsG_markobject(J, mark, J->R);
-	jsG_markobject(J, mark, J->G);
+	jsG_markroot(J, mark, J->Object_prototype);
+	jsG_markroot(J, mark, J->Array_prototype);
+	jsG_markroot(J, mark, J->Function_prototype);
+	jsG_markroot(J, mark, J->Boolean_prototype);
+	jsG_markroot(J, mark, J->Number_prototype);
+	jsG_markroot(J, mark, J->String_prototype);
+	jsG_markroot(J, mark, J->RegExp_prototype);
+	jsG_markroot(J, mark, J->Date_prototype);
+
+	jsG_markroot(J, mark, J->Error_prototype);
+	jsG_markroot(J, mark, J->EvalError_prototype);
+	jsG_markroot(J, mark, J->RangeError_prototype);
+	jsG_markroot(J, mark, J->ReferenceError_prototype);
+	jsG_markroot(J, mark, J->SyntaxError_prototype);
+	jsG_markroot(J, mark, J->TypeError_prototype);
+	jsG_markroot(J, mark, J->URIError_prototype);
+
+	jsG_markroot(J, mark, J->R);
+	jsG_markroot(J, mark, J->G);
 
 	jsG_markstack(J, mark);
 
@@ -171,96 +237,313 @@ void js_gc(js_State *J, int report)
 	jsG_markenvironment(J, mark, J->GE);
 	for (i = 0; i < J->envtop; ++i)
 		jsG_markenvironment(J, mark, J->envstack[i]);
+}
 
-	/* Scan objects until none remain. */
+/*
+	Incremental collection runs the same mark and sweep in steps, in
+	between which the program keeps running (the mutator):
 
-	while ((obj = J->gcroot) != NULL) {
+	Marking: gray objects are queued on gcroot, black ones have been
+	scanned. Environments and functions are marked in one go. Stores
+	into objects and environments go through jsG_writebarrier, which
+	grays the stored value so a scanned object never points to a white
+	one. The stack and environment stack are not guarded, so they are
+	marked again in the final atomic step before sweeping.
+
+	Sweeping: each list is swept from a saved position. Anything created
+	meanwhile gets the current mark (jsG_newmark) and survives.
+*/
+
+void jsG_barrier(js_State *J, js_Value *v)
+{
+	if (JSV_TYPE(v) == JS_TMEMSTR && JSV_MEMSTR(v)->gcmark != J->gcmark)
+		JSV_MEMSTR(v)->gcmark = J->gcmark;
+	if (JSV_TYPE(v) == JS_TROPE && JSV_ROPE(v)->gcmark != J->gcmark)
+		jsG_markrope(J, J->gcmark, JSV_ROPE(v));
+	if (JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->gcmark != J->gcmark)
+		jsG_markobject(J, J->gcmark, JSV_OBJECT(v));
+}
+
+void jsG_barrierobject(js_State *J, js_Object *obj)
+{
+	if (obj->gcmark != J->gcmark)
+		jsG_markobject(J, J->gcmark, obj);
+}
+
+static void jsG_begin(js_State *J)
+{
+	J->gcmark = J->gcmark == 1 ? 2 : 1;
+	J->gcstate = JS_GCMARK;
+	J->gcstart = J->gccounter;
+	memset(&J->gcswept, 0, sizeof J->gcswept);
+	jsG_markroots(J, J->gcmark);
+}
+
+/* Scan gray objects until the budget is spent; a negative budget is unlimited. */
+static int jsG_propagate(js_State *J, int budget)
+{
+	js_Object *obj;
+	while (budget != 0 && (obj = J->gcroot) != NULL) {
 		J->gcroot = obj->gcroot;
 		obj->gcroot = NULL;
-		jsG_scanobject(J, mark, obj);
+		jsG_scanobject(J, J->gcmark, obj);
+		if (budget > 0) {
+			budget -= 1 + obj->count;
+			if (obj->type == JS_CARRAY && obj->u.a.simple)
+				budget -= obj->u.a.flat_length;
+			if (budget < 0)
+				budget = 0;
+		}
 	}
+	return budget;
+}
 
-	/* Free everything not marked. */
-
-	prevnextenv = &J->gcenv;
-	for (env = J->gcenv; env; env = nextenv) {
-		nextenv = env->gcnext;
+static void jsG_atomic(js_State *J)
+{
+	/* mark the unguarded roots again, and finish marking in one go */
+	jsG_markroots(J, J->gcmark);
+	jsG_propagate(J, -1);
+
+	J->gcstate = JS_GCSWEEP;
+	J->gcsweepenv = &J->gcenv;
+	J->gcsweepfun = &J->gcfun;
+	J->gcsweepobj = &J->gcobj;
+	J->gcsweepstr = &J->gcstr;
+	J->gcsweeprope = &J->gcrope;
+}
+/* Free unmarked items until the budget is spent; a negative budget is unlimited. */
+static int jsG_sweep(js_State *J, int budget)
+{
+	js_Environment *env;
+	js_Function *fun;
+	js_Object *obj;
+	js_String *str;
+	js_Rope *rope;
+	int mark = J->gcmark;
+
+	while (budget != 0 && (env = *J->gcsweepenv) != NULL) {
 		if (env->gcmark != mark) {
-			*prevnextenv = nextenv;
+			*J->gcsweepenv = env->gcnext;
 			jsG_freeenvironment(J, env);
-			++genv;
+			++J->gcswept.genv;
 		} else {
-			prevnextenv = &env->gcnext;
+			J->gcsweepenv = &env->gcnext;
 		}
-		++nenv;
+		++J->gcswept.nenv;
+		if (budget > 0) --budget;
 	}
 
-	prevnextfun = &J->gcfun;
-	for (fun = J->gcfun; fun; fun = nextfun) {
-		nextfun = fun->gcnext;
+	while (budget != 0 && (fun = *J->gcsweepfun) != NULL) {
 		if (fun->gcmark != mark) {
-			*prevnextfun = nextfun;
+			*J->gcsweepfun = fun->gcnext;
 			jsG_freefunction(J, fun);
-			++gfun;
+			++J->gcswept.gfun;
 		} else {
-			prevnextfun = &fun->gcnext;
+			J->gcsweepfun = &fun->gcnext;
 		}
-		++nfun;
+		++J->gcswept.nfun;
+		if (budget > 0) --budget;
 	}
 
-	prevnextobj = &J->gcobj;
-	for (obj = J->gcobj; obj; obj = nextobj) {
-		nprop += obj->count;
-		nextobj = obj->gcnext;
+	while (budget != 0 && (obj = *J->gcsweepobj) != NULL) {
+		int count = obj->count;
+		if (obj->type == JS_CARRAY && obj->u.a.simple)
+			count += obj->u.a.flat_length;
+		J->gcswept.nprop += count;
 		if (obj->gcmark != mark) {
-			gprop += obj->count;
-			*prevnextobj = nextobj;
+			J->gcswept.gprop += count;
+			*J->gcsweepobj = obj->gcnext;
 			jsG_freeobject(J, obj);
-			++gobj;
+			++J->gcswept.gobj;
 		} else {
-			prevnextobj = &obj->gcnext;
+			J->gcsweepobj = &obj->gcnext;
 		}
-		++nobj;
+		++J->gcswept.nobj;
+		if (budget > 0) --budget;
 	}
 
-	prevnextstr = &J->gcstr;
-	for (str = J->gcstr; str; str = nextstr) {
-		nextstr = str->gcnext;
+	while (budget != 0 && (str = *J->gcsweepstr) != NULL) {
 		if (str->gcmark != mark) {
-			*prevnextstr = nextstr;
-			js_free(J, str);
-			++gstr;
+			*J->gcsweepstr = str->gcnext;
+			jsG_freestring(J, str);
+			++J->gcswept.gstr;
+		} else {
+			J->gcsweepstr = &str->gcnext;
+		}
+		++J->gcswept.nstr;
+		if (budget > 0) --budget;
+	}
+
+	while (budget != 0 && (rope = *J->gcsweeprope) != NULL) {
+		if (rope->gcmark != mark) {
+			*J->gcsweeprope = rope->gcnext;
+			js_free(J, rope);
+			++J->gcswept.gstr;
 		} else {
-			prevnextstr = &str->gcnext;
+			J->gcsweeprope = &rope->gcnext;
 		}
-		++nstr;
+		++J->gcswept.nstr;
+		if (budget > 0) --budget;
 	}
 
-	unsigned int ntot = nenv + nfun + nobj + nstr + nprop;
-	unsigned int gtot = genv + gfun + gobj + gstr + gprop;
-	unsigned int remaining = ntot - gtot;
+	if (budget != 0)
+		J->gcstate = JS_GCIDLE;
 
-	J->gccounter = remaining;
-	J->gcthresh = remaining * JS_GCFACTOR;
+	return budget;
+}
+
+static void jsG_finish(js_State *J, int report)
+{
+	unsigned int ntot = J->gcswept.nenv + J->gcswept.nfun + J->gcswept.nobj + J->gcswept.nstr + J->gcswept.nprop;
+	unsigned int gtot = J->gcswept.genv + J->gcswept.gfun + J->gcswept.gobj + J->gcswept.gstr + J->gcswept.gprop;
+
+	/* items created while sweeping were counted but not swept */
+	J->gccounter = J->gccounter > gtot ? J->gccounter - gtot : 0;
+	J->gcthresh = J->gccounter * JS_GCFACTOR;
+	++J->gcstats.cycles;
 
 	if (report) {
 		char buf[256];
 		snprintf(buf, sizeof buf, "garbage collected (%d%%): %d/%d envs, %d/%d funs, %d/%d objs, %d/%d props, %d/%d strs",
-			100*gtot/ntot, genv, nenv, gfun, nfun, gobj, nobj, gprop, nprop, gstr, nstr);
+			100*gtot/ntot, J->gcswept.genv, J->gcswept.nenv, J->gcswept.gfun, J->gcswept.nfun,
+			J->gcswept.gobj, J->gcswept.nobj, J->gcswept.gprop, J->gcswept.nprop, J->gcswept.gstr, J->gcswept.nstr);
 		js_report(J, buf);
 	}
 }
 
+static double jsG_clock(void)
+{
+#if defined(__unix__) || defined(__APPLE__) || defined(ESP_PLATFORM)
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+#else
+	return clock() * 1000.0 / CLOCKS_PER_SEC;
+#endif
+}
+
+static void jsG_pause(js_State *J, double start)
+{
+	double pause = jsG_clock() - start;
+	J->gcstats.lastpause = pause;
+	J->gcstats.totalpause += pause;
+	if (pause > J->gcstats.maxpause)
+		J->gcstats.maxpause = pause;
+}
+
+void js_gc(js_State *J, int report)
+{
+	double start;
+
+	if (J->gcpause) {
+		if (report)
+			js_report(J, "garbage collector is paused");
+		return;
+	}
+
+	start = jsG_clock();
+
+	/* finish an incremental cycle in progress, objects that died during it may survive it */
+	if (J->gcstate == JS_GCMARK)
+		jsG_atomic(J);
+	if (J->gcstate == JS_GCSWEEP) {
+		jsG_sweep(J, -1);
+		jsG_finish(J, 0);
+	}
+
+	jsG_begin(J);
+	jsG_atomic(J);
+	jsG_sweep(J, -1);
+	jsG_finish(J, report);
+
+	jsG_pause(J, start);
+}
+
+/*
+	Called from the interpreter loop when gccounter passes gcthresh.
+	An incremental step does gcstep units of work and schedules the next
+	step after gcstep/2 more allocations, so collection outpaces the
+	program. A cycle that lets the heap double is finished in one go.
+*/
+void jsG_step(js_State *J)
+{
+	double start;
+	int budget;
+
+	if (!J->gcincremental) {
+		js_gc(J, 0);
+		return;
+	}
+
+	if (J->gcpause)
+		return;
+
+	start = jsG_clock();
+	budget = J->gcstep;
+
+	if (J->gcstate == JS_GCIDLE)
+		jsG_begin(J);
+
+	if (J->gccounter > J->gcstart * 2 + J->gcstep)
+		budget = -1;
+
+	if (J->gcstate == JS_GCMARK) {
+		budget = jsG_propagate(J, budget);
+		if (!J->gcroot)
+			jsG_atomic(J);
+	}
+
+	if (J->gcstate == JS_GCSWEEP && budget != 0) {
+		jsG_sweep(J, budget);
+		if (J->gcstate == JS_GCIDLE)
+			jsG_finish(J, 0);
+	}
+
+	if (J->gcstate != JS_GCIDLE)
+		J->gcthresh = J->gccounter + J->gcstep / 2;
+
+	++J->gcstats.steps;
+	jsG_pause(J, start);
+}
+
+/*
+	For the embedder to call when it is idle: advances a cycle in
+	progress, or does the step the interpreter would do at its next
+	poll if the allocation debt calls for one. Returns non-zero while
+	a cycle is still in progress.
+*/
+int js_gcstep(js_State *J)
+{
+	if (J->gcstate != JS_GCIDLE || J->gccounter > J->gcthresh)
+		jsG_step(J);
+	return J->gcstate != JS_GCIDLE;
+}
+
+void js_setgcstep(js_State *J, int work)
+{
+	J->gcstep = work > 0 ? work : JS_GCSTEPSIZE;
+}
+
+void js_getgcstats(js_State *J, js_GCStats *stats)
+{
+	*stats = J->gcstats;
+}
+
 void js_freestate(js_State *J)
 {
 	js_Function *fun, *nextfun;
 	js_Object *obj, *nextobj;
 	js_Environment *env, *nextenv;
 	js_String *str, *nextstr;
+	js_Rope *rope, *nextrope;
 
 	if (!J)
 		return;
 
+#ifdef JS_OPPROFILE
+	jsR_dumpopprofile(20);
+#endif
+
 	for (env = J->gcenv; env; env = nextenv)
 		nextenv = env->gcnext, jsG_freeenvironment(J, env);
 	for (fun = J->gcfun; fun; fun = nextfun)
@@ -268,10 +551,13 @@ void js_freestate(js_State *J)
 	for (obj = J->gcobj; obj; obj = nextobj)
 		nextobj = obj->gcnext, jsG_freeobject(J, obj);
 	for (str = J->gcstr; str; str = nextstr)
-		nextstr = str->gcnext, js_free(J, str);
+		nextstr = str->gcnext, jsG_freestring(J, str);
+	for (rope = J->gcrope; rope; rope = nextrope)
+		nextrope = rope->gcnext, js_free(J, rope);
 
 	jsS_freestrings(J);
 
+	js_free(J, J->profile);
 	js_free(J, J->lexbuf.text);
 	J->alloc(J->actx, J->stack, 0);
 	J->alloc(J->actx, J, 0);
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdarg.h>
 #include <string.h>
 #include <setjmp.h>
@@ -68,12 +69,15 @@ typedef struct js_Regexp js_Regexp;
 typedef struct js_Value js_Value;
 typedef struct js_Object js_Object;
 typedef struct js_String js_String;
+typedef struct js_Rope js_Rope;
 typedef struct js_Ast js_Ast;
+typedef struct js_AstBlock js_AstBlock;
 typedef struct js_Function js_Function;
 typedef struct js_Environment js_Environment;
 typedef struct js_StringNode js_StringNode;
 typedef struct js_Jumpbuf js_Jumpbuf;
 typedef struct js_StackTrace js_StackTrace;
+typedef struct js_Profile js_Profile;
 
 /* Limits */
 
@@ -97,12 +101,36 @@ typedef struct js_StackTrace js_StackTrace;
  */
 #define JS_GCFACTOR 5.0		/* memory overhead factor >= 1.0 */
 #endif
+#ifndef JS_GCSTEPSIZE
+#define JS_GCSTEPSIZE 1024	/* incremental gc work per step */
+#endif
 #ifndef JS_ASTLIMIT
 #define JS_ASTLIMIT 100		/* max nested expressions */
 #endif
+#ifndef JS_JSONLIMIT
+#define JS_JSONLIMIT 100	/* max nested arrays and objects in JSON.parse */
+#endif
+#ifndef JS_ARRAYLIMIT
+#define JS_ARRAYLIMIT (1<<26)	/* max dense array length */
+#endif
 #ifndef JS_STRLIMIT
 #define JS_STRLIMIT (1<<28)	/* max string length */
 #endif
+#ifndef JS_UTFINDEXSTEP
+#define JS_UTFINDEXSTEP 32	/* characters between entries of a string's index */
+#endif
+#ifndef JS_ROPEMIN
+#define JS_ROPEMIN 256		/* shorter concatenations are copied right away */
+#endif
+#ifndef JS_ROPELEAF
+#define JS_ROPELEAF 256		/* max size of merged pieces at the end of a rope */
+#endif
+#ifndef JS_ROPEDEPTH
+#define JS_ROPEDEPTH 32		/* max nesting of ropes on the right side */
+#endif
+#ifndef JS_PROFILEDEPTH
+#define JS_PROFILEDEPTH 8	/* innermost frames kept in a profile sample */
+#endif
 
 /* instruction size -- change to int if you get integer overflow syntax errors */
 
@@ -127,6 +155,8 @@ double js_strtod(const char *as, char **aas);
 
 double js_strtol(const char *s, char **ep, int radix);
 
+js_State *js_newemptystate(js_Alloc alloc, void *actx, int flags);
+
 /* Private stack functions */
 
 void js_newarguments(js_State *J);
@@ -139,6 +169,9 @@ int js_isarrayindex(js_State *J, const char *str, int *idx);
 int js_runeat(js_State *J, const char *s, int i);
 int js_utfptrtoidx(const char *s, const char *p);
 const char *js_utfidxtoptr(const char *s, int i);
+int js_stringlength(js_String *str);
+const char *js_stringidxtoptr(js_State *J, js_String *str, int i);
+int js_stringruneat(js_State *J, js_String *str, int i);
 
 void js_dup(js_State *J);
 void js_dup2(js_State *J);
@@ -154,13 +187,37 @@ void js_RegExp_prototype_exec(js_State *J, js_Regexp *re, const char *text);
 
 void js_trap(js_State *J, int pc); /* dump stack and environment to stdout */
 
+/* Garbage collector */
+
+enum { JS_GCIDLE, JS_GCMARK, JS_GCSWEEP };
+
+void jsG_step(js_State *J);
+void jsG_barrier(js_State *J, js_Value *v);
+void jsG_barrierobject(js_State *J, js_Object *obj);
+
+/* Call before storing a value into an object or environment that may already have been marked */
+#define jsG_writebarrier(J, v) \
+	((J)->gcstate == JS_GCMARK ? jsG_barrier(J, v) : (void)0)
+
+/* Mark for new objects, so they survive the rest of a sweep in progress */
+#define jsG_newmark(J) \
+	((J)->gcstate == JS_GCSWEEP ? (J)->gcmark : 0)
+
 struct js_StackTrace
 {
 	const char *name;
 	const char *file;
 	int line;
+	js_Function *function; /* script function running in this frame, or NULL */
+	js_Instruction **pc; /* its program counter, for looking up the current line */
 };
 
+int jsR_traceline(js_State *J, int n);
+void jsR_profilestep(js_State *J, js_Function *F);
+#ifdef JS_OPPROFILE
+void jsR_dumpopprofile(int n);
+#endif
+
 /* Exception handling */
 
 struct js_Jumpbuf
@@ -198,6 +255,7 @@ struct js_State
 	js_Panic panic;
 
 	js_StringNode *strings;
+	js_State *snapshot; /* template whose interned strings are shared, see jssnapshot.c */
 
 	int default_strict;
 	int strict;
@@ -219,7 +277,7 @@ struct js_State
 	int lookahead;
 	const char *text;
 	double number;
-	js_Ast *gcast; /* list of allocated nodes to free after parsing */
+	js_AstBlock *gcast; /* blocks of nodes to free after parsing */
 
 	/* runtime environment */
 	js_Object *Object_prototype;
@@ -241,6 +299,8 @@ struct js_State
 
 	unsigned int seed; /* Math.random seed */
 
+	unsigned int shapeseq; /* last object shape handed out */
+
 	int nextref; /* for js_ref use */
 	js_Object *R; /* registry of hidden values */
 	js_Object *G; /* the global object */
@@ -259,9 +319,23 @@ struct js_State
 	js_Function *gcfun;
 	js_Object *gcobj;
 	js_String *gcstr;
+	js_Rope *gcrope;
 
 	js_Object *gcroot; /* gc scan list */
 
+	/* incremental collector */
+	int gcincremental;
+	int gcstate;
+	int gcstep; /* work budget per step */
+	unsigned int gcstart; /* gccounter when the cycle started */
+	js_Environment **gcsweepenv;
+	js_Function **gcsweepfun;
+	js_Object **gcsweepobj;
+	js_String **gcsweepstr;
+	js_Rope **gcsweeprope;
+	struct { unsigned int nenv, nfun, nobj, nstr, nprop, genv, gfun, gobj, gstr, gprop; } gcswept;
+	js_GCStats gcstats;
+
 	/* environments on the call stack but currently not in scope */
 	int envtop;
 	js_Environment *envstack[JS_ENVLIMIT];
@@ -270,6 +344,10 @@ struct js_State
 	int tracetop;
 	js_StackTrace trace[JS_ENVLIMIT];
 
+	/* sampling profiler */
+	int profiling;
+	js_Profile *profile;
+
 	/* exception stack */
 	int trytop;
 	js_Jumpbuf trybuf[JS_TRYLIMIT];
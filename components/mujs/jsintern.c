@@ -19,14 +19,32 @@ void js_putc(js_State *J, js_Buffer **sbp, int c)
 
 void js_puts(js_State *J, js_Buffer **sb, const char *s)
 {
-	while (*s)
-		js_putc(J, sb, *s++);
+	js_putm(J, sb, s, s + strlen(s));
 }
 
-void js_putm(js_State *J, js_Buffer **sb, const char *s, const char *e)
+void js_putm(js_State *J, js_Buffer **sbp, const char *s, const char *e)
 {
-	while (s < e)
-		js_putc(J, sb, *s++);
+	js_Buffer *sb = *sbp;
+	int n = e - s;
+	int m;
+	if (!sb) {
+		m = sizeof sb->s;
+		while (m < n)
+			m *= 2;
+		sb = js_malloc(J, soffsetof(js_Buffer, s) + m);
+		sb->n = 0;
+		sb->m = m;
+		*sbp = sb;
+	} else if (sb->n + n > sb->m) {
+		m = sb->m;
+		while (m < sb->n + n)
+			m *= 2;
+		sb = js_realloc(J, sb, soffsetof(js_Buffer, s) + m);
+		sb->m = m;
+		*sbp = sb;
+	}
+	memcpy(sb->s + sb->n, s, n);
+	sb->n += n;
 }
 
 /* Use an AA-tree to quickly look up interned strings. */
@@ -127,9 +145,25 @@ void jsS_freestrings(js_State *J)
 		jsS_freestringnode(J, J->strings);
 }
 
+static const char *jsS_lookup(js_StringNode *node, const char *string)
+{
+	while (node && node != &jsS_sentinel) {
+		int c = strcmp(string, node->string);
+		if (c == 0)
+			return node->string;
+		node = c < 0 ? node->left : node->right;
+	}
+	return NULL;
+}
+
 const char *js_intern(js_State *J, const char *s)
 {
 	const char *result;
+	js_State *T;
+	/* strings of a snapshot template come first, so that copies keep using its pointers */
+	for (T = J->snapshot; T; T = T->snapshot)
+		if ((result = jsS_lookup(T->strings, s)))
+			return result;
 	if (!J->strings)
 		J->strings = &jsS_sentinel;
 	J->strings = jsS_insert(J, J->strings, s, &result);
@@ -58,12 +58,21 @@ static void Op_valueOf(js_State *J)
 	js_copy(J, 0);
 }
 
+/* Own element of a dense array, which is not stored in the property tree */
+static int O_isflatindex(js_State *J, js_Object *obj, const char *name)
+{
+	int k;
+	if (obj->type == JS_CARRAY && obj->u.a.simple)
+		return js_isarrayindex(J, name, &k) && k < obj->u.a.flat_length;
+	return 0;
+}
+
 static void Op_hasOwnProperty(js_State *J)
 {
 	js_Object *self = js_toobject(J, 0);
 	const char *name = js_tostring(J, 1);
 	js_Property *ref = jsV_getownproperty(J, self, name);
-	js_pushboolean(J, ref != NULL);
+	js_pushboolean(J, ref != NULL || O_isflatindex(J, self, name));
 }
 
 static void Op_isPrototypeOf(js_State *J)
@@ -87,7 +96,7 @@ static void Op_propertyIsEnumerable(js_State *J)
 	js_Object *self = js_toobject(J, 0);
 	const char *name = js_tostring(J, 1);
 	js_Property *ref = jsV_getownproperty(J, self, name);
-	js_pushboolean(J, ref && !(ref->atts & JS_DONTENUM));
+	js_pushboolean(J, (ref && !(ref->atts & JS_DONTENUM)) || O_isflatindex(J, self, name));
 }
 
 static void O_getPrototypeOf(js_State *J)
@@ -109,6 +118,7 @@ static void O_getOwnPropertyDescriptor(js_State *J)
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
 	obj = js_toobject(J, 1);
+	jsV_unflattenarray(J, obj);
 	ref = jsV_getproperty(J, obj, js_tostring(J, 2));
 	if (!ref)
 		js_pushundefined(J);
@@ -161,10 +171,16 @@ static void O_getOwnPropertyNames(js_State *J)
 
 	js_newarray(J);
 
+	i = 0;
+	if (obj->type == JS_CARRAY && obj->u.a.simple) {
+		for (k = 0; k < obj->u.a.flat_length; ++k) {
+			js_pushnumber(J, k);
+			js_setindex(J, -2, i++);
+		}
+	}
+
 	if (obj->properties->level)
-		i = O_getOwnPropertyNames_walk(J, obj->properties, 0);
-	else
-		i = 0;
+		i = O_getOwnPropertyNames_walk(J, obj->properties, i);
 
 	if (obj->type == JS_CARRAY) {
 		js_pushliteral(J, "length");
@@ -276,6 +292,7 @@ static void O_defineProperties(js_State *J)
 	if (!js_isobject(J, 2)) js_typeerror(J, "not an object");
 
 	props = js_toobject(J, 2);
+	jsV_unflattenarray(J, props);
 	if (props->properties->level)
 		O_defineProperties_walk(J, props->properties);
 
@@ -287,9 +304,9 @@ static void O_create_walk(js_State *J, js_Object *obj, js_Property *ref)
 	if (ref->left->level)
 		O_create_walk(J, obj, ref->left);
 	if (!(ref->atts & JS_DONTENUM)) {
-		if (ref->value.type != JS_TOBJECT)
+		if (JSV_TYPE(&ref->value) != JS_TOBJECT)
 			js_typeerror(J, "not an object");
-		ToPropertyDescriptor(J, obj, ref->name, ref->value.u.object);
+		ToPropertyDescriptor(J, obj, ref->name, JSV_OBJECT(&ref->value));
 	}
 	if (ref->right->level)
 		O_create_walk(J, obj, ref->right);
@@ -315,6 +332,7 @@ static void O_create(js_State *J)
 		if (!js_isobject(J, 2))
 			js_typeerror(J, "not an object");
 		props = js_toobject(J, 2);
+		jsV_unflattenarray(J, props);
 		if (props->properties->level)
 			O_create_walk(J, obj, props->properties);
 	}
@@ -344,10 +362,16 @@ static void O_keys(js_State *J)
 
 	js_newarray(J);
 
+	i = 0;
+	if (obj->type == JS_CARRAY && obj->u.a.simple) {
+		for (k = 0; k < obj->u.a.flat_length; ++k) {
+			js_pushnumber(J, k);
+			js_setindex(J, -2, i++);
+		}
+	}
+
 	if (obj->properties->level)
-		i = O_keys_walk(J, obj->properties, 0);
-	else
-		i = 0;
+		i = O_keys_walk(J, obj->properties, i);
 
 	if (obj->type == JS_CSTRING) {
 		for (k = 0; k < obj->u.s.length; ++k) {
@@ -359,9 +383,12 @@ static void O_keys(js_State *J)
 
 static void O_preventExtensions(js_State *J)
 {
+	js_Object *obj;
 	if (!js_isobject(J, 1))
 		js_typeerror(J, "not an object");
-	js_toobject(J, 1)->extensible = 0;
+	obj = js_toobject(J, 1);
+	jsV_unflattenarray(J, obj);
+	obj->extensible = 0;
 	js_copy(J, 1);
 }
 
@@ -389,10 +416,12 @@ static void O_seal(js_State *J)
 		js_typeerror(J, "not an object");
 
 	obj = js_toobject(J, 1);
+	jsV_unflattenarray(J, obj);
 	obj->extensible = 0;
 
 	if (obj->properties->level)
 		O_seal_walk(J, obj->properties);
+	obj->shape = ++J->shapeseq;
 
 	js_copy(J, 1);
 }
@@ -446,10 +475,12 @@ static void O_freeze(js_State *J)
 		js_typeerror(J, "not an object");
 
 	obj = js_toobject(J, 1);
+	jsV_unflattenarray(J, obj);
 	obj->extensible = 0;
 
 	if (obj->properties->level)
 		O_freeze_walk(J, obj->properties);
+	obj->shape = ++J->shapeseq;
 
 	js_copy(J, 1);
 }
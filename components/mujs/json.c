@@ -25,91 +25,347 @@ int js_isdateobject(js_State *J, int idx)
 	return js_isobject(J, idx) && js_toobject(J, idx)->type == JS_CDATE;
 }
 
-static void jsonnext(js_State *J)
+/*
+	JSON.parse reads the source text directly instead of going through the
+	lexer. Strings without escapes are pushed straight from the source, and
+	property names go through a small cache of interned strings, since the
+	same few keys repeat throughout a document.
+*/
+
+#define JSON_KEYCACHE 32
+
+struct jsonparser
 {
-	J->lookahead = jsY_lexjson(J);
+	const char *source;
+	const char *keys[JSON_KEYCACHE];
+	int depth;
+};
+
+static void jsonerror(js_State *J, struct jsonparser *P, const char *p, const char *message)
+{
+	const char *s;
+	int line = 1;
+	for (s = P->source; s < p; ++s)
+		if (*s == '\n')
+			++line;
+	js_syntaxerror(J, "JSON:%d: %s", line, message);
 }
 
-static int jsonaccept(js_State *J, int t)
+static void jsonunexpected(js_State *J, struct jsonparser *P, const char *p, const char *expected)
 {
-	if (J->lookahead == t) {
-		jsonnext(J);
-		return 1;
+	char buf[80];
+	if (*p == 0)
+		snprintf(buf, sizeof buf, "unexpected end of input");
+	else if (*p >= 0x20 && *p <= 0x7E)
+		snprintf(buf, sizeof buf, "unexpected character: '%c'", *p);
+	else
+		snprintf(buf, sizeof buf, "unexpected character: \\x%02X", (unsigned char)*p);
+	if (expected) {
+		strcat(buf, " (expected ");
+		strcat(buf, expected);
+		strcat(buf, ")");
 	}
-	return 0;
+	jsonerror(J, P, p, buf);
 }
 
-static void jsonexpect(js_State *J, int t)
+static const char *jsonwhite(const char *p)
 {
-	if (!jsonaccept(J, t))
-		js_syntaxerror(J, "JSON: unexpected token: %s (expected %s)",
-				jsY_tokenstring(J->lookahead), jsY_tokenstring(t));
+	while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+		++p;
+	return p;
 }
 
-static void jsonvalue(js_State *J)
+/* Decoded strings are built in the lexer's text buffer */
+
+static void jsonputm(js_State *J, const char *s, int n)
 {
+	if (!J->lexbuf.text) {
+		J->lexbuf.cap = 4096;
+		J->lexbuf.text = js_malloc(J, J->lexbuf.cap);
+	}
+	if (J->lexbuf.len + n + UTFmax + 1 > J->lexbuf.cap) {
+		while (J->lexbuf.len + n + UTFmax + 1 > J->lexbuf.cap)
+			J->lexbuf.cap *= 2;
+		J->lexbuf.text = js_realloc(J, J->lexbuf.text, J->lexbuf.cap);
+	}
+	memcpy(J->lexbuf.text + J->lexbuf.len, s, n);
+	J->lexbuf.len += n;
+}
+
+static void jsonputrune(js_State *J, Rune c)
+{
+	char buf[UTFmax];
+	jsonputm(J, buf, runetochar(buf, &c));
+}
+
+static const char *jsonescape(js_State *J, struct jsonparser *P, const char *p)
+{
+	Rune x = 0;
 	int i;
-	const char *name;
 
-	switch (J->lookahead) {
-	case TK_STRING:
-		js_pushstring(J, J->text);
-		jsonnext(J);
-		break;
+	/* already consumed '\' */
+
+	switch (*p) {
+	case '"': jsonputm(J, "\"", 1); break;
+	case '\\': jsonputm(J, "\\", 1); break;
+	case '/': jsonputm(J, "/", 1); break;
+	case 'b': jsonputm(J, "\b", 1); break;
+	case 'f': jsonputm(J, "\f", 1); break;
+	case 'n': jsonputm(J, "\n", 1); break;
+	case 'r': jsonputm(J, "\r", 1); break;
+	case 't': jsonputm(J, "\t", 1); break;
+	case 'u':
+		for (i = 1; i <= 4; ++i) {
+			if (!jsY_ishex(p[i]))
+				jsonerror(J, P, p + i, "invalid escape sequence");
+			x = (x << 4) | jsY_tohex(p[i]);
+		}
+		jsonputrune(J, x);
+		return p + 5;
+	default:
+		jsonerror(J, P, p, "invalid escape sequence");
+	}
+	return p + 1;
+}
 
-	case TK_NUMBER:
-		js_pushnumber(J, J->number);
-		jsonnext(J);
-		break;
+/* Scan a string after its opening quote. The text is left either in the source or in the text buffer. */
+static const char *jsonstring(js_State *J, struct jsonparser *P, const char *p, const char **text, int *len)
+{
+	const char *s = p;
+	Rune c;
+	int n;
 
-	case '{':
-		js_newobject(J);
-		jsonnext(J);
-		if (jsonaccept(J, '}'))
-			return;
-		do {
-			if (J->lookahead != TK_STRING)
-				js_syntaxerror(J, "JSON: unexpected token: %s (expected string)", jsY_tokenstring(J->lookahead));
-			name = J->text;
-			jsonnext(J);
-			jsonexpect(J, ':');
-			jsonvalue(J);
-			js_setproperty(J, -2, name);
-		} while (jsonaccept(J, ','));
-		jsonexpect(J, '}');
-		break;
+	for (;;) {
+		unsigned char x = *p;
+		if (x == '"') {
+			*text = s;
+			*len = p - s;
+			return p + 1;
+		}
+		if (x >= 0x20 && x < 0x80 && x != '\\')
+			++p;
+		else if (x >= 0x80 && ((n = chartorune(&c, p)) > 1 || c != Runeerror))
+			p += n;
+		else
+			break;
+	}
 
+	J->lexbuf.len = 0;
+	jsonputm(J, s, p - s);
+	for (;;) {
+		unsigned char x = *p;
+		if (x == '"')
+			break;
+		if (x == 0)
+			jsonerror(J, P, p, "unterminated string");
+		if (x < 0x20)
+			jsonerror(J, P, p, "invalid control character in string");
+		if (x == '\\') {
+			p = jsonescape(J, P, p + 1);
+		} else if (x >= 0x80) {
+			/* invalid sequences become U+FFFD */
+			p += chartorune(&c, p);
+			jsonputrune(J, c);
+		} else {
+			s = p++;
+			while ((x = *p) >= 0x20 && x < 0x80 && x != '"' && x != '\\')
+				++p;
+			jsonputm(J, s, p - s);
+		}
+	}
+	J->lexbuf.text[J->lexbuf.len] = 0;
+	*text = J->lexbuf.text;
+	*len = J->lexbuf.len;
+	return p + 1;
+}
+
+static const char *jsonkey(js_State *J, struct jsonparser *P, const char *s, int n)
+{
+	const char **slot;
+	unsigned int h = n;
+	int i;
+
+	for (i = 0; i < n; ++i)
+		h = h * 31 + (unsigned char)s[i];
+	slot = &P->keys[h % JSON_KEYCACHE];
+	if (*slot && !strncmp(*slot, s, n) && (*slot)[n] == 0)
+		return *slot;
+
+	/* names still in the source are not zero-terminated */
+	if (s[n] != 0) {
+		J->lexbuf.len = 0;
+		jsonputm(J, s, n);
+		J->lexbuf.text[n] = 0;
+		s = J->lexbuf.text;
+	}
+	return *slot = js_intern(J, s);
+}
+
+static const char *jsonnumber(js_State *J, struct jsonparser *P, const char *p)
+{
+	const char *s = p;
+	double n = 0;
+	int digits = 0, simple = 1;
+
+	if (*p == '-')
+		++p;
+
+	if (*p == '0')
+		++p;
+	else if (*p >= '1' && *p <= '9')
+		for (; *p >= '0' && *p <= '9'; ++p, ++digits)
+			n = n * 10 + (*p - '0');
+	else
+		jsonunexpected(J, P, p, "digit");
+
+	if (*p == '.') {
+		++p;
+		if (*p < '0' || *p > '9')
+			jsonerror(J, P, p, "missing digits after decimal point");
+		while (*p >= '0' && *p <= '9')
+			++p;
+		simple = 0;
+	}
+
+	if (*p == 'e' || *p == 'E') {
+		++p;
+		if (*p == '-' || *p == '+')
+			++p;
+		if (*p < '0' || *p > '9')
+			jsonerror(J, P, p, "missing digits after exponent indicator");
+		while (*p >= '0' && *p <= '9')
+			++p;
+		simple = 0;
+	}
+
+	/* integers of up to 15 digits are exact in a double */
+	if (simple && digits <= 15)
+		js_pushnumber(J, *s == '-' ? -n : n);
+	else
+		js_pushnumber(J, js_strtod(s, NULL));
+	return p;
+}
+
+static const char *jsonvalue(js_State *J, struct jsonparser *P, const char *p);
+
+static const char *jsonobject(js_State *J, struct jsonparser *P, const char *p)
+{
+	js_Object *obj;
+	js_Property *ref;
+	const char *name, *s;
+	int n;
+
+	js_newobject(J);
+	obj = js_toobject(J, -1);
+	p = jsonwhite(p);
+	if (*p == '}')
+		return p + 1;
+	for (;;) {
+		if (*p != '"')
+			jsonunexpected(J, P, p, "string");
+		p = jsonstring(J, P, p + 1, &s, &n);
+		name = jsonkey(J, P, s, n);
+		p = jsonwhite(p);
+		if (*p != ':')
+			jsonunexpected(J, P, p, "':'");
+		p = jsonvalue(J, P, jsonwhite(p + 1));
+		ref = jsV_setinternedproperty(J, obj, name);
+		jsG_writebarrier(J, js_tovalue(J, -1));
+		ref->value = *js_tovalue(J, -1);
+		js_pop(J, 1);
+		p = jsonwhite(p);
+		if (*p == '}')
+			return p + 1;
+		if (*p != ',')
+			jsonunexpected(J, P, p, "',' or '}'");
+		p = jsonwhite(p + 1);
+	}
+}
+
+static const char *jsonarray(js_State *J, struct jsonparser *P, const char *p)
+{
+	int i = 0;
+
+	js_newarray(J);
+	p = jsonwhite(p);
+	if (*p == ']')
+		return p + 1;
+	for (;;) {
+		p = jsonvalue(J, P, p);
+		js_setindex(J, -2, i++);
+		p = jsonwhite(p);
+		if (*p == ']')
+			return p + 1;
+		if (*p != ',')
+			jsonunexpected(J, P, p, "',' or ']'");
+		p = jsonwhite(p + 1);
+	}
+}
+
+static const char *jsonvalue(js_State *J, struct jsonparser *P, const char *p)
+{
+	const char *s;
+	int n;
+
+	switch (*p) {
+	case '"':
+		p = jsonstring(J, P, p + 1, &s, &n);
+		js_pushlstring(J, s, n);
+		return p;
+
+	case '{':
 	case '[':
-		js_newarray(J);
-		jsonnext(J);
-		i = 0;
-		if (jsonaccept(J, ']'))
-			return;
-		do {
-			jsonvalue(J);
-			js_setindex(J, -2, i++);
-		} while (jsonaccept(J, ','));
-		jsonexpect(J, ']');
+		if (++P->depth > JS_JSONLIMIT)
+			jsonerror(J, P, p, "too deeply nested");
+		p = *p == '{' ? jsonobject(J, P, p + 1) : jsonarray(J, P, p + 1);
+		--P->depth;
+		return p;
+
+	case '-':
+	case '0': case '1': case '2': case '3': case '4':
+	case '5': case '6': case '7': case '8': case '9':
+		return jsonnumber(J, P, p);
+
+	case 't':
+		if (!strncmp(p, "true", 4)) {
+			js_pushboolean(J, 1);
+			return p + 4;
+		}
 		break;
 
-	case TK_TRUE:
-		js_pushboolean(J, 1);
-		jsonnext(J);
+	case 'f':
+		if (!strncmp(p, "false", 5)) {
+			js_pushboolean(J, 0);
+			return p + 5;
+		}
 		break;
 
-	case TK_FALSE:
-		js_pushboolean(J, 0);
-		jsonnext(J);
+	case 'n':
+		if (!strncmp(p, "null", 4)) {
+			js_pushnull(J);
+			return p + 4;
+		}
 		break;
+	}
+	jsonunexpected(J, P, p, NULL);
+	return p;
+}
 
-	case TK_NULL:
-		js_pushnull(J);
-		jsonnext(J);
-		break;
+void js_parsejson(js_State *J, const char *source)
+{
+	struct jsonparser P;
+	const char *p = source;
 
-	default:
-		js_syntaxerror(J, "JSON: unexpected token: %s", jsY_tokenstring(J->lookahead));
-	}
+	memset(&P, 0, sizeof P);
+	P.source = source;
+
+	/* byte order mark */
+	if (!strncmp(p, "\xEF\xBB\xBF", 3))
+		p += 3;
+
+	p = jsonwhite(jsonvalue(J, &P, jsonwhite(p)));
+	if (*p)
+		jsonunexpected(J, &P, p, "end of input");
 }
 
 static void jsonrevive(js_State *J, const char *name)
@@ -163,19 +419,25 @@ static void jsonrevive(js_State *J, const char *name)
 static void JSON_parse(js_State *J)
 {
 	const char *source = js_tostring(J, 1);
-	jsY_initlex(J, "JSON", source);
-	jsonnext(J);
 
 	if (js_iscallable(J, 2)) {
 		js_newobject(J);
-		jsonvalue(J);
+		js_parsejson(J, source);
 		js_defproperty(J, -2, "", 0);
 		jsonrevive(J, "");
 	} else {
-		jsonvalue(J);
+		js_parsejson(J, source);
 	}
 }
 
+struct jsonwriter
+{
+	js_Buffer *sb;
+	const char *gap;
+	int replacer; /* stack slot of the replacer function or property list, or 0 */
+	int base; /* stack slot of the outermost holder, for the cycle check */
+};
+
 static void fmtnum(js_State *J, js_Buffer **sb, double n)
 {
 	if (isnan(n)) js_puts(J, sb, "null");
@@ -190,10 +452,20 @@ static void fmtnum(js_State *J, js_Buffer **sb, double n)
 static void fmtstr(js_State *J, js_Buffer **sb, const char *s)
 {
 	static const char *HEX = "0123456789ABCDEF";
-	int i, n;
+	const char *run;
+	char esc[6];
+	int n;
 	Rune c;
 	js_putc(J, sb, '"');
-	while (*s) {
+	for (;;) {
+		/* copy runs that need no escaping in one go; 0xC0 may start an encoded NUL */
+		run = s;
+		while ((unsigned char)*s >= ' ' && *s != '"' && *s != '\\' && (unsigned char)*s != 0xC0)
+			++s;
+		if (s > run)
+			js_putm(J, sb, run, s);
+		if (!*s)
+			break;
 		n = chartorune(&c, s);
 		switch (c) {
 		case '"': js_puts(J, sb, "\\\""); break;
@@ -205,17 +477,15 @@ static void fmtstr(js_State *J, js_Buffer **sb, const char *s)
 		case '\t': js_puts(J, sb, "\\t"); break;
 		default:
 			if (c < ' ') {
-				js_putc(J, sb, '\\');
-				js_putc(J, sb, 'u');
-				js_putc(J, sb, HEX[(c>>12)&15]);
-				js_putc(J, sb, HEX[(c>>8)&15]);
-				js_putc(J, sb, HEX[(c>>4)&15]);
-				js_putc(J, sb, HEX[c&15]);
-			} else if (c < 128) {
-				js_putc(J, sb, c);
+				esc[0] = '\\';
+				esc[1] = 'u';
+				esc[2] = HEX[(c>>12)&15];
+				esc[3] = HEX[(c>>8)&15];
+				esc[4] = HEX[(c>>4)&15];
+				esc[5] = HEX[c&15];
+				js_putm(J, sb, esc, esc + 6);
 			} else {
-				for (i = 0; i < n; ++i)
-					js_putc(J, sb, s[i]);
+				js_putm(J, sb, s, s + n);
 			}
 			break;
 		}
@@ -231,17 +501,16 @@ static void fmtindent(js_State *J, js_Buffer **sb, const char *gap, int level)
 		js_puts(J, sb, gap);
 }
 
-static int fmtvalue(js_State *J, js_Buffer **sb, const char *key, const char *gap, int level);
+static int fmtvalue(js_State *J, struct jsonwriter *W, const char *key, int index, int level);
 
-static int filterprop(js_State *J, const char *key)
+static int filterprop(js_State *J, struct jsonwriter *W, const char *key)
 {
 	int i, n, found;
-	/* replacer/property-list is in stack slot 2 */
-	if (js_isarray(J, 2)) {
+	if (W->replacer && js_isarray(J, W->replacer)) {
 		found = 0;
-		n = js_getlength(J, 2);
+		n = js_getlength(J, W->replacer);
 		for (i = 0; i < n && !found; ++i) {
-			js_getindex(J, 2, i);
+			js_getindex(J, W->replacer, i);
 			if (js_isstring(J, -1) || js_isnumber(J, -1) ||
 				js_isstringobject(J, -1) || js_isnumberobject(J, -1))
 				found = !strcmp(key, js_tostring(J, -1));
@@ -252,78 +521,105 @@ static int filterprop(js_State *J, const char *key)
 	return 1;
 }
 
-static void fmtobject(js_State *J, js_Buffer **sb, js_Object *obj, const char *gap, int level)
+static void fmtcycle(js_State *J, struct jsonwriter *W)
 {
-	const char *key;
-	int save;
+	js_Object *obj = js_toobject(J, -1);
 	int i, n;
-
 	n = js_gettop(J) - 1;
-	for (i = 4; i < n; ++i)
+	for (i = W->base; i < n; ++i)
 		if (js_isobject(J, i))
-			if (js_toobject(J, i) == js_toobject(J, -1))
+			if (js_toobject(J, i) == obj)
 				js_typeerror(J, "cyclic object value");
+}
+
+static void fmtproperty(js_State *J, struct jsonwriter *W, const char *key, int *n, int level)
+{
+	/* the value is on top of the stack, above the object */
+	int save = W->sb->n;
+	if (*n) js_putc(J, &W->sb, ',');
+	if (W->gap) fmtindent(J, &W->sb, W->gap, level + 1);
+	fmtstr(J, &W->sb, key);
+	js_putc(J, &W->sb, ':');
+	if (W->gap)
+		js_putc(J, &W->sb, ' ');
+	if (!fmtvalue(J, W, key, 0, level + 1))
+		W->sb->n = save;
+	else
+		++*n;
+}
+
+static void fmtobject(js_State *J, struct jsonwriter *W, js_Object *obj, int level)
+{
+	js_Property *ref;
+	const char *key;
+	int n;
+
+	fmtcycle(J, W);
 
 	n = 0;
-	js_putc(J, sb, '{');
+	js_putc(J, &W->sb, '{');
+
+	/* plain objects: read the property tree in name order, the same order as the iterator;
+	 * each step looks up the successor by name, so keys added by toJSON during the walk are seen */
+	if (obj->type == JS_COBJECT) {
+		for (ref = jsV_nextownproperty(J, obj, NULL); ref; ref = jsV_nextownproperty(J, obj, key)) {
+			key = ref->name;
+			if (filterprop(J, W, key)) {
+				if (ref->getter)
+					js_getproperty(J, -1, key);
+				else
+					js_pushvalue(J, ref->value);
+				fmtproperty(J, W, key, &n, level);
+			}
+		}
+		if (W->gap && n) fmtindent(J, &W->sb, W->gap, level);
+		js_putc(J, &W->sb, '}');
+		return;
+	}
+
 	js_pushiterator(J, -1, 1);
 	while ((key = js_nextiterator(J, -1))) {
-		if (filterprop(J, key)) {
-			save = (*sb)->n;
-			if (n) js_putc(J, sb, ',');
-			if (gap) fmtindent(J, sb, gap, level + 1);
-			fmtstr(J, sb, key);
-			js_putc(J, sb, ':');
-			if (gap)
-				js_putc(J, sb, ' ');
+		if (filterprop(J, W, key)) {
 			js_rot2(J);
-			if (!fmtvalue(J, sb, key, gap, level + 1))
-				(*sb)->n = save;
-			else
-				++n;
+			js_getproperty(J, -1, key);
+			fmtproperty(J, W, key, &n, level);
 			js_rot2(J);
 		}
 	}
 	js_pop(J, 1);
-	if (gap && n) fmtindent(J, sb, gap, level);
-	js_putc(J, sb, '}');
+	if (W->gap && n) fmtindent(J, &W->sb, W->gap, level);
+	js_putc(J, &W->sb, '}');
 }
 
-static void fmtarray(js_State *J, js_Buffer **sb, const char *gap, int level)
+static void fmtarray(js_State *J, struct jsonwriter *W, int level)
 {
 	int n, i;
-	char buf[32];
 
-	n = js_gettop(J) - 1;
-	for (i = 4; i < n; ++i)
-		if (js_isobject(J, i))
-			if (js_toobject(J, i) == js_toobject(J, -1))
-				js_typeerror(J, "cyclic object value");
+	fmtcycle(J, W);
 
-	js_putc(J, sb, '[');
+	js_putc(J, &W->sb, '[');
 	n = js_getlength(J, -1);
 	for (i = 0; i < n; ++i) {
-		if (i) js_putc(J, sb, ',');
-		if (gap) fmtindent(J, sb, gap, level + 1);
-		if (!fmtvalue(J, sb, js_itoa(buf, i), gap, level + 1))
-			js_puts(J, sb, "null");
+		if (i) js_putc(J, &W->sb, ',');
+		if (W->gap) fmtindent(J, &W->sb, W->gap, level + 1);
+		js_getindex(J, -1, i);
+		if (!fmtvalue(J, W, NULL, i, level + 1))
+			js_puts(J, &W->sb, "null");
 	}
-	if (gap && n) fmtindent(J, sb, gap, level);
-	js_putc(J, sb, ']');
+	if (W->gap && n) fmtindent(J, &W->sb, W->gap, level);
+	js_putc(J, &W->sb, ']');
 }
 
-static int fmtvalue(js_State *J, js_Buffer **sb, const char *key, const char *gap, int level)
+/* The value is on top of the stack with its holder below; its name is key, or index if key is NULL */
+static int fmtvalue(js_State *J, struct jsonwriter *W, const char *key, int index, int level)
 {
-	/* replacer/property-list is in 2 */
-	/* holder is in -1 */
-
-	js_getproperty(J, -1, key);
+	char buf[32];
 
 	if (js_isobject(J, -1)) {
 		if (js_hasproperty(J, -1, "toJSON")) {
 			if (js_iscallable(J, -1)) {
 				js_copy(J, -2);
-				js_pushstring(J, key);
+				js_pushstring(J, key ? key : js_itoa(buf, index));
 				js_call(J, 1);
 				js_rot2pop1(J);
 			} else {
@@ -332,10 +628,10 @@ static int fmtvalue(js_State *J, js_Buffer **sb, const char *key, const char *ga
 		}
 	}
 
-	if (js_iscallable(J, 2)) {
-		js_copy(J, 2); /* replacer function */
+	if (W->replacer && js_iscallable(J, W->replacer)) {
+		js_copy(J, W->replacer); /* replacer function */
 		js_copy(J, -3); /* holder as this */
-		js_pushstring(J, key); /* name */
+		js_pushstring(J, key ? key : js_itoa(buf, index)); /* name */
 		js_copy(J, -4); /* old value */
 		js_call(J, 2);
 		js_rot2pop1(J); /* pop old value, leave new value on stack */
@@ -344,21 +640,21 @@ static int fmtvalue(js_State *J, js_Buffer **sb, const char *key, const char *ga
 	if (js_isobject(J, -1) && !js_iscallable(J, -1)) {
 		js_Object *obj = js_toobject(J, -1);
 		switch (obj->type) {
-		case JS_CNUMBER: fmtnum(J, sb, obj->u.number); break;
-		case JS_CSTRING: fmtstr(J, sb, obj->u.s.string); break;
-		case JS_CBOOLEAN: js_puts(J, sb, obj->u.boolean ? "true" : "false"); break;
-		case JS_CARRAY: fmtarray(J, sb, gap, level); break;
-		default: fmtobject(J, sb, obj, gap, level); break;
+		case JS_CNUMBER: fmtnum(J, &W->sb, obj->u.number); break;
+		case JS_CSTRING: fmtstr(J, &W->sb, obj->u.s.string); break;
+		case JS_CBOOLEAN: js_puts(J, &W->sb, obj->u.boolean ? "true" : "false"); break;
+		case JS_CARRAY: fmtarray(J, W, level); break;
+		default: fmtobject(J, W, obj, level); break;
 		}
 	}
 	else if (js_isboolean(J, -1))
-		js_puts(J, sb, js_toboolean(J, -1) ? "true" : "false");
+		js_puts(J, &W->sb, js_toboolean(J, -1) ? "true" : "false");
 	else if (js_isnumber(J, -1))
-		fmtnum(J, sb, js_tonumber(J, -1));
+		fmtnum(J, &W->sb, js_tonumber(J, -1));
 	else if (js_isstring(J, -1))
-		fmtstr(J, sb, js_tostring(J, -1));
+		fmtstr(J, &W->sb, js_tostring(J, -1));
 	else if (js_isnull(J, -1))
-		js_puts(J, sb, "null");
+		js_puts(J, &W->sb, "null");
 	else {
 		js_pop(J, 1);
 		return 0;
@@ -368,16 +664,58 @@ static int fmtvalue(js_State *J, js_Buffer **sb, const char *key, const char *ga
 	return 1;
 }
 
+/* Stringify the value on top of the stack, with its wrapper object below; pushes the text or undefined */
+static int fmtroot(js_State *J, struct jsonwriter *W)
+{
+	int ok;
+
+	if (js_try(J)) {
+		js_free(J, W->sb);
+		js_throw(J);
+	}
+
+	ok = fmtvalue(J, W, "", 0, 0);
+	if (ok)
+		js_pushlstring(J, W->sb ? W->sb->s : "", W->sb ? W->sb->n : 0);
+	else
+		js_pushundefined(J);
+
+	js_endtry(J);
+	js_free(J, W->sb);
+	return ok;
+}
+
+int js_stringifyjson(js_State *J, int idx, const char *gap)
+{
+	struct jsonwriter W;
+	int ok;
+
+	W.sb = NULL;
+	W.gap = gap && *gap ? gap : NULL;
+	W.replacer = 0;
+
+	js_copy(J, idx);
+	js_newobject(J); /* wrapper */
+	js_copy(J, -2);
+	js_defproperty(J, -2, "", 0);
+	W.base = js_gettop(J) - 1;
+	js_copy(J, -2);
+	ok = fmtroot(J, &W);
+	js_rot3pop2(J);
+	return ok;
+}
+
 static void JSON_stringify(js_State *J)
 {
-	js_Buffer *sb = NULL;
+	struct jsonwriter W;
 	char buf[12];
-	/* NOTE: volatile to silence GCC warning about longjmp clobbering a variable */
-	const char * volatile gap;
 	const char *s;
 	int n;
 
-	gap = NULL;
+	W.sb = NULL;
+	W.gap = NULL;
+	W.replacer = 2;
+	W.base = 4;
 
 	if (js_isnumber(J, 3) || js_isnumberobject(J, 3)) {
 		n = js_tointeger(J, 3);
@@ -385,34 +723,22 @@ static void JSON_stringify(js_State *J)
 		if (n > 10) n = 10;
 		memset(buf, ' ', n);
 		buf[n] = 0;
-		if (n > 0) gap = buf;
+		if (n > 0) W.gap = buf;
 	} else if (js_isstring(J, 3) || js_isstringobject(J, 3)) {
 		s = js_tostring(J, 3);
 		n = strlen(s);
 		if (n > 10) n = 10;
 		memcpy(buf, s, n);
 		buf[n] = 0;
-		if (n > 0) gap = buf;
-	}
-
-	if (js_try(J)) {
-		js_free(J, sb);
-		js_throw(J);
+		if (n > 0) W.gap = buf;
 	}
 
 	js_newobject(J); /* wrapper */
 	js_copy(J, 1);
 	js_defproperty(J, -2, "", 0);
-	if (!fmtvalue(J, &sb, "", gap, 0)) {
-		js_pushundefined(J);
-	} else {
-		js_putc(J, &sb, 0);
-		js_pushstring(J, sb ? sb->s : "");
-		js_rot2pop1(J);
-	}
-
-	js_endtry(J);
-	js_free(J, sb);
+	js_copy(J, 1);
+	fmtroot(J, &W);
+	js_rot2pop1(J);
 }
 
 void jsB_initjson(js_State *J)
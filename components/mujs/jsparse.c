@@ -61,7 +61,16 @@ static void jsP_warning(js_State *J, const char *fmt, ...)
 
 static js_Ast *jsP_newnode(js_State *J, enum js_AstType type, int line, js_Ast *a, js_Ast *b, js_Ast *c, js_Ast *d)
 {
-	js_Ast *node = js_malloc(J, sizeof *node);
+	js_AstBlock *block = J->gcast;
+	js_Ast *node;
+
+	if (!block || block->used == JS_ASTBLOCK) {
+		block = js_malloc(J, sizeof *block);
+		block->used = 0;
+		block->next = J->gcast;
+		J->gcast = block;
+	}
+	node = &block->node[block->used++];
 
 	node->type = type;
 	node->line = line;
@@ -80,9 +89,6 @@ static js_Ast *jsP_newnode(js_State *J, enum js_AstType type, int line, js_Ast *
 	if (c) c->parent = node;
 	if (d) d->parent = node;
 
-	node->gcnext = J->gcast;
-	J->gcast = node;
-
 	return node;
 }
 
@@ -123,12 +129,14 @@ static void jsP_freejumps(js_State *J, js_JumpList *node)
 
 void jsP_freeparse(js_State *J)
 {
-	js_Ast *node = J->gcast;
-	while (node) {
-		js_Ast *next = node->gcnext;
-		jsP_freejumps(J, node->jumps);
-		js_free(J, node);
-		node = next;
+	js_AstBlock *block = J->gcast;
+	int i;
+	while (block) {
+		js_AstBlock *next = block->next;
+		for (i = 0; i < block->used; ++i)
+			jsP_freejumps(J, block->node[i].jumps);
+		js_free(J, block);
+		block = next;
 	}
 	J->gcast = NULL;
 }
@@ -132,7 +132,18 @@ struct js_Ast
 	const char *string;
 	js_JumpList *jumps; /* list of break/continue jumps to patch */
 	int casejump; /* for switch case clauses */
-	js_Ast *gcnext; /* next in alloc list */
+};
+
+/* Nodes are carved out of blocks, which are all freed together after parsing */
+#ifndef JS_ASTBLOCK
+#define JS_ASTBLOCK 64
+#endif
+
+struct js_AstBlock
+{
+	js_AstBlock *next;
+	int used;
+	js_Ast node[JS_ASTBLOCK];
 };
 
 js_Ast *jsP_parsefunction(js_State *J, const char *filename, const char *params, const char *body);
@@ -0,0 +1,242 @@
+#include "jsi.h"
+#include "jscompile.h"
+
+/*
+	Sampling profiler.
+
+	While a profile is running, jsR_run sends every instruction through
+	jsR_profilestep, which counts it against the running function and,
+	every 'interval' instructions, copies the innermost frames of the call
+	stack into a ring of samples. The interval is counted in instructions,
+	not time, so a profile shows where interpreted work goes and is the
+	same from run to run; time spent inside native functions is not seen.
+	The interval is jittered so that it does not lock onto the period of a
+	loop and keep sampling the same instructions.
+
+	Functions pick up the change on entry and on their next jump.
+*/
+
+typedef struct js_ProfileFrame js_ProfileFrame;
+typedef struct js_ProfileSample js_ProfileSample;
+
+struct js_ProfileFrame
+{
+	const char *name;
+	const char *file;
+	int line;
+};
+
+struct js_ProfileSample
+{
+	int depth;
+	js_ProfileFrame frame[JS_PROFILEDEPTH]; /* innermost first */
+};
+
+struct js_Profile
+{
+	int interval, countdown;
+	unsigned int seed; /* jitter */
+	int size, len, next;
+	js_ProfileSample ring[1];
+};
+
+void js_profilestart(js_State *J, int interval, int size)
+{
+	js_Function *fun;
+
+	if (interval < 1)
+		interval = 1;
+	if (size < 1)
+		size = 1;
+	if (size > 1 << 16)
+		size = 1 << 16;
+
+	js_free(J, J->profile);
+	J->profile = NULL;
+	J->profiling = 0;
+
+	J->profile = js_malloc(J, soffsetof(js_Profile, ring) + size * sizeof(js_ProfileSample));
+	J->profile->interval = J->profile->countdown = interval;
+	J->profile->seed = 1;
+	J->profile->size = size;
+	J->profile->len = J->profile->next = 0;
+
+	for (fun = J->gcfun; fun; fun = fun->gcnext)
+		fun->opcount = 0;
+
+	J->profiling = 1;
+}
+
+void js_profilestop(js_State *J)
+{
+	J->profiling = 0;
+}
+
+/* Next countdown, uniform in [interval/2, interval*3/2] */
+static int pf_countdown(js_Profile *P)
+{
+	P->seed = P->seed * 1103515245 + 12345;
+	return P->interval / 2 + 1 + (int)((P->seed >> 8) % (unsigned int)(P->interval + 1));
+}
+
+void jsR_profilestep(js_State *J, js_Function *F)
+{
+	js_Profile *P = J->profile;
+	js_ProfileSample *S;
+	int n, k;
+
+	if (!J->profiling)
+		return;
+
+	++F->opcount;
+	if (--P->countdown > 0)
+		return;
+	P->countdown = pf_countdown(P);
+
+	/* frame 0 is the dummy at the bottom of the trace stack */
+	S = &P->ring[P->next];
+	for (n = J->tracetop, k = 0; n > 0 && k < JS_PROFILEDEPTH; --n, ++k) {
+		S->frame[k].name = J->trace[n].name;
+		S->frame[k].file = J->trace[n].file;
+		S->frame[k].line = jsR_traceline(J, n);
+	}
+	S->depth = k;
+
+	P->next = (P->next + 1) % P->size;
+	if (P->len < P->size)
+		++P->len;
+}
+
+/* Dump */
+
+static int pf_cmpptr(const void *a, const void *b)
+{
+	return (size_t)a < (size_t)b ? -1 : (size_t)a > (size_t)b;
+}
+
+static int pf_cmpsample(const void *va, const void *vb)
+{
+	const js_ProfileSample *a = *(const js_ProfileSample **)va;
+	const js_ProfileSample *b = *(const js_ProfileSample **)vb;
+	int i, c;
+	if (a->depth != b->depth)
+		return a->depth - b->depth;
+	for (i = 0; i < a->depth; ++i) {
+		if ((c = pf_cmpptr(a->frame[i].name, b->frame[i].name)) != 0)
+			return c;
+		if ((c = pf_cmpptr(a->frame[i].file, b->frame[i].file)) != 0)
+			return c;
+		if (a->frame[i].line != b->frame[i].line)
+			return a->frame[i].line - b->frame[i].line;
+	}
+	return 0;
+}
+
+static int pf_cmpcount(const void *va, const void *vb)
+{
+	const js_Function *a = *(const js_Function **)va;
+	const js_Function *b = *(const js_Function **)vb;
+	return a->opcount < b->opcount ? 1 : a->opcount > b->opcount ? -1 : 0;
+}
+
+static void pf_write(js_Writer write, void *data, char *buf, int n, int size)
+{
+	if (n < 0)
+		return;
+	write(data, buf, n < size ? n : size - 1);
+}
+
+/* Same form as a line of a stack trace */
+static void pf_frame(js_Writer write, void *data, const char *name, const char *file, int line)
+{
+	char buf[256];
+	if (line > 0) {
+		if (name[0])
+			pf_write(write, data, buf, snprintf(buf, sizeof buf, "%s (%s:%d)", name, file, line), sizeof buf);
+		else
+			pf_write(write, data, buf, snprintf(buf, sizeof buf, "%s:%d", file, line), sizeof buf);
+	} else if (name[0]) {
+		pf_write(write, data, buf, snprintf(buf, sizeof buf, "%s (%s)", name, file), sizeof buf);
+	} else {
+		pf_write(write, data, buf, snprintf(buf, sizeof buf, "%s", file), sizeof buf);
+	}
+}
+
+static void pf_dumpfolded(js_State *J, js_Writer write, void *data)
+{
+	js_Profile *P = J->profile;
+	js_ProfileSample **S;
+	char buf[32];
+	int i, k, n;
+
+	if (P->len == 0)
+		return;
+
+	S = js_malloc(J, P->len * sizeof *S);
+	if (js_try(J)) {
+		js_free(J, S);
+		js_throw(J);
+	}
+
+	for (i = 0; i < P->len; ++i)
+		S[i] = &P->ring[i];
+	qsort(S, P->len, sizeof *S, pf_cmpsample);
+
+	for (i = 0; i < P->len; i += n) {
+		for (n = 1; i + n < P->len && !pf_cmpsample(&S[i], &S[i+n]); ++n)
+			;
+		for (k = S[i]->depth - 1; k >= 0; --k) {
+			pf_frame(write, data, S[i]->frame[k].name, S[i]->frame[k].file, S[i]->frame[k].line);
+			if (k > 0)
+				write(data, ";", 1);
+		}
+		pf_write(write, data, buf, snprintf(buf, sizeof buf, " %d\n", n), sizeof buf);
+	}
+
+	js_endtry(J);
+	js_free(J, S);
+}
+
+static void pf_dumpcounts(js_State *J, js_Writer write, void *data)
+{
+	js_Function *fun, **F;
+	char buf[32];
+	int i, n = 0;
+
+	for (fun = J->gcfun; fun; fun = fun->gcnext)
+		if (fun->opcount)
+			++n;
+	if (n == 0)
+		return;
+
+	F = js_malloc(J, n * sizeof *F);
+	if (js_try(J)) {
+		js_free(J, F);
+		js_throw(J);
+	}
+
+	n = 0;
+	for (fun = J->gcfun; fun; fun = fun->gcnext)
+		if (fun->opcount)
+			F[n++] = fun;
+	qsort(F, n, sizeof *F, pf_cmpcount);
+
+	for (i = 0; i < n; ++i) {
+		pf_write(write, data, buf, snprintf(buf, sizeof buf, "%u ", F[i]->opcount), sizeof buf);
+		pf_frame(write, data, F[i]->name, F[i]->filename, F[i]->line);
+		write(data, "\n", 1);
+	}
+
+	js_endtry(J);
+	js_free(J, F);
+}
+
+void js_profiledump(js_State *J, int what, js_Writer write, void *data)
+{
+	if (!J->profile)
+		return;
+	if (what == JS_PROFILECOUNTS)
+		pf_dumpcounts(J, write, data);
+	else
+		pf_dumpfolded(J, write, data);
+}
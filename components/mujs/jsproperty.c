@@ -22,21 +22,23 @@ static js_Property sentinel = {
 	"",
 	&sentinel, &sentinel,
 	0, 0,
-	{ {0}, {0}, JS_TUNDEFINED },
+	JSV_INIT_UNDEFINED,
 	NULL, NULL
 };
 
-static js_Property *newproperty(js_State *J, js_Object *obj, const char *name)
+static js_Property *newproperty(js_State *J, js_Object *obj, const char *name, int interned)
 {
 	js_Property *node = js_malloc(J, sizeof *node);
-	node->name = js_intern(J, name);
+	node->name = interned ? name : js_intern(J, name);
 	node->left = node->right = &sentinel;
 	node->level = 1;
 	node->atts = 0;
-	node->value.type = JS_TUNDEFINED;
-	node->value.u.number = 0;
+	JSV_SETUNDEFINED(&node->value);
 	node->getter = NULL;
 	node->setter = NULL;
+	obj->shape = ++J->shapeseq;
+	if (*name >= '0' && *name <= '9')
+		obj->indexprops = 1;
 	++obj->count;
 	++J->gccounter;
 	return node;
@@ -45,7 +47,11 @@ static js_Property *newproperty(js_State *J, js_Object *obj, const char *name)
 static js_Property *lookup(js_Property *node, const char *name)
 {
 	while (node != &sentinel) {
-		int c = strcmp(name, node->name);
+		int c;
+		/* property names are interned, so most hits compare equal by pointer */
+		if (name == node->name)
+			return node;
+		c = strcmp(name, node->name);
 		if (c == 0)
 			return node;
 		else if (c < 0)
@@ -79,21 +85,21 @@ static js_Property *split(js_Property *node)
 	return node;
 }
 
-static js_Property *insert(js_State *J, js_Object *obj, js_Property *node, const char *name, js_Property **result)
+static js_Property *insert(js_State *J, js_Object *obj, js_Property *node, const char *name, int interned, js_Property **result)
 {
 	if (node != &sentinel) {
 		int c = strcmp(name, node->name);
 		if (c < 0)
-			node->left = insert(J, obj, node->left, name, result);
+			node->left = insert(J, obj, node->left, name, interned, result);
 		else if (c > 0)
-			node->right = insert(J, obj, node->right, name, result);
+			node->right = insert(J, obj, node->right, name, interned, result);
 		else
 			return *result = node;
 		node = skew(node);
 		node = split(node);
 		return node;
 	}
-	return *result = newproperty(J, obj, name);
+	return *result = newproperty(J, obj, name, interned);
 }
 
 static void freeproperty(js_State *J, js_Object *obj, js_Property *node)
@@ -151,15 +157,21 @@ js_Object *jsV_newobject(js_State *J, enum js_Class type, js_Object *prototype)
 {
 	js_Object *obj = js_malloc(J, sizeof *obj);
 	memset(obj, 0, sizeof *obj);
-	obj->gcmark = 0;
+	obj->gcmark = jsG_newmark(J);
 	obj->gcnext = J->gcobj;
 	J->gcobj = obj;
 	++J->gccounter;
 
 	obj->type = type;
+	obj->shape = ++J->shapeseq;
 	obj->properties = &sentinel;
 	obj->prototype = prototype;
 	obj->extensible = 1;
+
+	/* arrays start out dense; see jsV_unflattenarray */
+	if (type == JS_CARRAY)
+		obj->u.a.simple = 1;
+
 	return obj;
 }
 
@@ -214,14 +226,45 @@ js_Property *jsV_setproperty(js_State *J, js_Object *obj, const char *name)
 		return result;
 	}
 
-	obj->properties = insert(J, obj, obj->properties, name, &result);
+	obj->properties = insert(J, obj, obj->properties, name, 0, &result);
 
 	return result;
 }
 
+/* Add an own property to a fresh extensible object; name must come from js_intern */
+js_Property *jsV_setinternedproperty(js_State *J, js_Object *obj, const char *name)
+{
+	js_Property *result;
+	obj->properties = insert(J, obj, obj->properties, name, 1, &result);
+	return result;
+}
+
 void jsV_delproperty(js_State *J, js_Object *obj, const char *name)
 {
 	obj->properties = delete(J, obj, obj->properties, name);
+	obj->shape = ++J->shapeseq;
+}
+
+/* Own enumerable property with the smallest name after 'name' (or the first one if NULL).
+ * Looking up the successor by name, rather than keeping a cursor into the tree,
+ * stays valid when the object is changed between calls. */
+js_Property *jsV_nextownproperty(js_State *J, js_Object *obj, const char *name)
+{
+	js_Property *node, *next;
+	do {
+		next = NULL;
+		for (node = obj->properties; node != &sentinel; ) {
+			if (!name || strcmp(node->name, name) > 0) {
+				next = node;
+				node = node->left;
+			} else {
+				node = node->right;
+			}
+		}
+		if (next)
+			name = next->name;
+	} while (next && (next->atts & JS_DONTENUM));
+	return next;
 }
 
 /* Flatten hierarchy of enumerable properties into an iterator object */
@@ -243,6 +286,19 @@ static js_Iterator *itwalk(js_State *J, js_Iterator *iter, js_Property *prop, js
 	return iter;
 }
 
+static js_Iterator *itflatarray(js_State *J, js_Iterator *iter, js_Object *obj)
+{
+	char buf[32];
+	int k;
+	for (k = obj->u.a.flat_length - 1; k >= 0; --k) {
+		js_Iterator *head = js_malloc(J, sizeof *head);
+		head->name = js_intern(J, js_itoa(buf, k));
+		head->next = iter;
+		iter = head;
+	}
+	return iter;
+}
+
 static js_Iterator *itflatten(js_State *J, js_Object *obj)
 {
 	js_Iterator *iter = NULL;
@@ -250,9 +306,24 @@ static js_Iterator *itflatten(js_State *J, js_Object *obj)
 		iter = itflatten(J, obj->prototype);
 	if (obj->properties != &sentinel)
 		iter = itwalk(J, iter, obj->properties, obj->prototype);
+	if (obj->type == JS_CARRAY && obj->u.a.simple)
+		iter = itflatarray(J, iter, obj);
 	return iter;
 }
 
+/* Check if an index name refers to an element of a dense array in the prototype chain */
+static int jsV_hasflatindex(js_State *J, js_Object *obj, const char *name)
+{
+	int k;
+	do {
+		if (obj->type == JS_CARRAY && obj->u.a.simple)
+			if (js_isarrayindex(J, name, &k) && k < obj->u.a.flat_length)
+				return 1;
+		obj = obj->prototype;
+	} while (obj);
+	return 0;
+}
+
 js_Object *jsV_newiterator(js_State *J, js_Object *obj, int own)
 {
 	char buf[32];
@@ -263,6 +334,8 @@ js_Object *jsV_newiterator(js_State *J, js_Object *obj, int own)
 		io->u.iter.head = NULL;
 		if (obj->properties != &sentinel)
 			io->u.iter.head = itwalk(J, io->u.iter.head, obj->properties, NULL);
+		if (obj->type == JS_CARRAY && obj->u.a.simple)
+			io->u.iter.head = itflatarray(J, io->u.iter.head, obj);
 	} else {
 		io->u.iter.head = itflatten(J, obj);
 	}
@@ -301,6 +374,8 @@ const char *jsV_nextiterator(js_State *J, js_Object *io)
 		io->u.iter.head = next;
 		if (jsV_getproperty(J, io->u.iter.target, name))
 			return name;
+		if (jsV_hasflatindex(J, io->u.iter.target, name))
+			return name;
 		if (io->u.iter.target->type == JS_CSTRING)
 			if (js_isarrayindex(J, name, &k) && k < io->u.iter.target->u.s.length)
 				return name;
@@ -308,6 +383,29 @@ const char *jsV_nextiterator(js_State *J, js_Object *io)
 	return NULL;
 }
 
+/* Move the elements of a dense array into ordinary properties. */
+
+void jsV_unflattenarray(js_State *J, js_Object *obj)
+{
+	char buf[32];
+	js_Property *ref;
+	int k;
+
+	if (obj->type != JS_CARRAY || !obj->u.a.simple)
+		return;
+
+	for (k = 0; k < obj->u.a.flat_length; ++k) {
+		ref = jsV_setproperty(J, obj, js_itoa(buf, k));
+		ref->value = obj->u.a.array[k];
+	}
+
+	js_free(J, obj->u.a.array);
+	obj->u.a.simple = 0;
+	obj->u.a.flat_length = 0;
+	obj->u.a.flat_capacity = 0;
+	obj->u.a.array = NULL;
+}
+
 /* Walk all the properties and delete them one by one for arrays */
 
 void jsV_resizearray(js_State *J, js_Object *obj, int newlen)
@@ -315,6 +413,12 @@ void jsV_resizearray(js_State *J, js_Object *obj, int newlen)
 	char buf[32];
 	const char *s;
 	int k;
+	if (obj->u.a.simple) {
+		if (newlen < obj->u.a.flat_length)
+			obj->u.a.flat_length = newlen;
+		obj->u.a.length = newlen;
+		return;
+	}
 	if (newlen < obj->u.a.length) {
 		if (obj->u.a.length > obj->count * 2) {
 			js_Object *it = jsV_newiterator(J, obj, 1);
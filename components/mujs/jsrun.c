@@ -15,24 +15,21 @@ static void jsR_run(js_State *J, js_Function *F);
 
 static void js_trystackoverflow(js_State *J)
 {
-	STACK[TOP].type = JS_TLITSTR;
-	STACK[TOP].u.litstr = "exception stack overflow";
+	JSV_SETLITSTR(&STACK[TOP], "exception stack overflow");
 	++TOP;
 	js_throw(J);
 }
 
 static void js_stackoverflow(js_State *J)
 {
-	STACK[TOP].type = JS_TLITSTR;
-	STACK[TOP].u.litstr = "stack overflow";
+	JSV_SETLITSTR(&STACK[TOP], "stack overflow");
 	++TOP;
 	js_throw(J);
 }
 
 static void js_outofmemory(js_State *J)
 {
-	STACK[TOP].type = JS_TLITSTR;
-	STACK[TOP].u.litstr = "out of memory";
+	JSV_SETLITSTR(&STACK[TOP], "out of memory");
 	++TOP;
 	js_throw(J);
 }
@@ -69,9 +66,12 @@ void js_free(js_State *J, void *ptr)
 js_String *jsV_newmemstring(js_State *J, const char *s, int n)
 {
 	js_String *v = js_malloc(J, soffsetof(js_String, p) + n + 1);
-	memcpy(v->p, s, n);
+	if (s)
+		memcpy(v->p, s, n);
 	v->p[n] = 0;
-	v->gcmark = 0;
+	v->length = -1;
+	v->index = NULL;
+	v->gcmark = jsG_newmark(J);
 	v->gcnext = J->gcstr;
 	J->gcstr = v;
 	++J->gccounter;
@@ -90,30 +90,28 @@ void js_pushvalue(js_State *J, js_Value v)
 void js_pushundefined(js_State *J)
 {
 	CHECKSTACK(1);
-	STACK[TOP].type = JS_TUNDEFINED;
+	JSV_SETUNDEFINED(&STACK[TOP]);
 	++TOP;
 }
 
 void js_pushnull(js_State *J)
 {
 	CHECKSTACK(1);
-	STACK[TOP].type = JS_TNULL;
+	JSV_SETNULL(&STACK[TOP]);
 	++TOP;
 }
 
 void js_pushboolean(js_State *J, int v)
 {
 	CHECKSTACK(1);
-	STACK[TOP].type = JS_TBOOLEAN;
-	STACK[TOP].u.boolean = !!v;
+	JSV_SETBOOLEAN(&STACK[TOP], !!v);
 	++TOP;
 }
 
 void js_pushnumber(js_State *J, double v)
 {
 	CHECKSTACK(1);
-	STACK[TOP].type = JS_TNUMBER;
-	STACK[TOP].u.number = v;
+	JSV_SETNUMBER(&STACK[TOP], v);
 	++TOP;
 }
 
@@ -123,14 +121,13 @@ void js_pushstring(js_State *J, const char *v)
 	if (n > JS_STRLIMIT)
 		js_rangeerror(J, "invalid string length");
 	CHECKSTACK(1);
-	if (n <= soffsetof(js_Value, type)) {
-		char *s = STACK[TOP].u.shrstr;
+	if (n <= JS_SHRSTRMAX) {
+		char *s = JSV_SHRSTR(&STACK[TOP]);
 		while (n--) *s++ = *v++;
 		*s = 0;
-		STACK[TOP].type = JS_TSHRSTR;
+		JSV_SETSHRSTR(&STACK[TOP]);
 	} else {
-		STACK[TOP].type = JS_TMEMSTR;
-		STACK[TOP].u.memstr = jsV_newmemstring(J, v, n);
+		JSV_SETMEMSTR(&STACK[TOP], jsV_newmemstring(J, v, n));
 	}
 	++TOP;
 }
@@ -140,14 +137,13 @@ void js_pushlstring(js_State *J, const char *v, int n)
 	if (n > JS_STRLIMIT)
 		js_rangeerror(J, "invalid string length");
 	CHECKSTACK(1);
-	if (n <= soffsetof(js_Value, type)) {
-		char *s = STACK[TOP].u.shrstr;
+	if (n <= JS_SHRSTRMAX) {
+		char *s = JSV_SHRSTR(&STACK[TOP]);
 		while (n--) *s++ = *v++;
 		*s = 0;
-		STACK[TOP].type = JS_TSHRSTR;
+		JSV_SETSHRSTR(&STACK[TOP]);
 	} else {
-		STACK[TOP].type = JS_TMEMSTR;
-		STACK[TOP].u.memstr = jsV_newmemstring(J, v, n);
+		JSV_SETMEMSTR(&STACK[TOP], jsV_newmemstring(J, v, n));
 	}
 	++TOP;
 }
@@ -155,16 +151,14 @@ void js_pushlstring(js_State *J, const char *v, int n)
 void js_pushliteral(js_State *J, const char *v)
 {
 	CHECKSTACK(1);
-	STACK[TOP].type = JS_TLITSTR;
-	STACK[TOP].u.litstr = v;
+	JSV_SETLITSTR(&STACK[TOP], v);
 	++TOP;
 }
 
 void js_pushobject(js_State *J, js_Object *v)
 {
 	CHECKSTACK(1);
-	STACK[TOP].type = JS_TOBJECT;
-	STACK[TOP].u.object = v;
+	JSV_SETOBJECT(&STACK[TOP], v);
 	++TOP;
 }
 
@@ -179,14 +173,14 @@ void js_currentfunction(js_State *J)
 	if (BOT > 0)
 		STACK[TOP] = STACK[BOT-1];
 	else
-		STACK[TOP].type = JS_TUNDEFINED;
+		JSV_SETUNDEFINED(&STACK[TOP]);
 	++TOP;
 }
 
 void *js_currentfunctiondata(js_State *J)
 {
 	if (BOT > 0)
-		return STACK[BOT-1].u.object->u.c.data;
+		return JSV_OBJECT(&STACK[BOT-1])->u.c.data;
 	return NULL;
 }
 
@@ -194,7 +188,7 @@ void *js_currentfunctiondata(js_State *J)
 
 static js_Value *stackidx(js_State *J, int idx)
 {
-	static js_Value undefined = { {0}, {0}, JS_TUNDEFINED };
+	static js_Value undefined = JSV_INIT_UNDEFINED;
 	idx = idx < 0 ? TOP + idx : BOT + idx;
 	if (idx < 0 || idx >= TOP)
 		return &undefined;
@@ -206,56 +200,56 @@ js_Value *js_tovalue(js_State *J, int idx)
 	return stackidx(J, idx);
 }
 
-int js_isdefined(js_State *J, int idx) { return stackidx(J, idx)->type != JS_TUNDEFINED; }
-int js_isundefined(js_State *J, int idx) { return stackidx(J, idx)->type == JS_TUNDEFINED; }
-int js_isnull(js_State *J, int idx) { return stackidx(J, idx)->type == JS_TNULL; }
-int js_isboolean(js_State *J, int idx) { return stackidx(J, idx)->type == JS_TBOOLEAN; }
-int js_isnumber(js_State *J, int idx) { return stackidx(J, idx)->type == JS_TNUMBER; }
-int js_isstring(js_State *J, int idx) { enum js_Type t = stackidx(J, idx)->type; return t == JS_TSHRSTR || t == JS_TLITSTR || t == JS_TMEMSTR; }
-int js_isprimitive(js_State *J, int idx) { return stackidx(J, idx)->type != JS_TOBJECT; }
-int js_isobject(js_State *J, int idx) { return stackidx(J, idx)->type == JS_TOBJECT; }
-int js_iscoercible(js_State *J, int idx) { js_Value *v = stackidx(J, idx); return v->type != JS_TUNDEFINED && v->type != JS_TNULL; }
+int js_isdefined(js_State *J, int idx) { return JSV_TYPE(stackidx(J, idx)) != JS_TUNDEFINED; }
+int js_isundefined(js_State *J, int idx) { return JSV_TYPE(stackidx(J, idx)) == JS_TUNDEFINED; }
+int js_isnull(js_State *J, int idx) { return JSV_TYPE(stackidx(J, idx)) == JS_TNULL; }
+int js_isboolean(js_State *J, int idx) { return JSV_TYPE(stackidx(J, idx)) == JS_TBOOLEAN; }
+int js_isnumber(js_State *J, int idx) { return JSV_TYPE(stackidx(J, idx)) == JS_TNUMBER; }
+int js_isstring(js_State *J, int idx) { enum js_Type t = JSV_TYPE(stackidx(J, idx)); return t == JS_TSHRSTR || t == JS_TLITSTR || t == JS_TMEMSTR || t == JS_TROPE; }
+int js_isprimitive(js_State *J, int idx) { return JSV_TYPE(stackidx(J, idx)) != JS_TOBJECT; }
+int js_isobject(js_State *J, int idx) { return JSV_TYPE(stackidx(J, idx)) == JS_TOBJECT; }
+int js_iscoercible(js_State *J, int idx) { js_Value *v = stackidx(J, idx); return JSV_TYPE(v) != JS_TUNDEFINED && JSV_TYPE(v) != JS_TNULL; }
 
 int js_iscallable(js_State *J, int idx)
 {
 	js_Value *v = stackidx(J, idx);
-	if (v->type == JS_TOBJECT)
-		return v->u.object->type == JS_CFUNCTION ||
-			v->u.object->type == JS_CSCRIPT ||
-			v->u.object->type == JS_CCFUNCTION;
+	if (JSV_TYPE(v) == JS_TOBJECT)
+		return JSV_OBJECT(v)->type == JS_CFUNCTION ||
+			JSV_OBJECT(v)->type == JS_CSCRIPT ||
+			JSV_OBJECT(v)->type == JS_CCFUNCTION;
 	return 0;
 }
 
 int js_isarray(js_State *J, int idx)
 {
 	js_Value *v = stackidx(J, idx);
-	return v->type == JS_TOBJECT && v->u.object->type == JS_CARRAY;
+	return JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->type == JS_CARRAY;
 }
 
 int js_isregexp(js_State *J, int idx)
 {
 	js_Value *v = stackidx(J, idx);
-	return v->type == JS_TOBJECT && v->u.object->type == JS_CREGEXP;
+	return JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->type == JS_CREGEXP;
 }
 
 int js_isuserdata(js_State *J, int idx, const char *tag)
 {
 	js_Value *v = stackidx(J, idx);
-	if (v->type == JS_TOBJECT && v->u.object->type == JS_CUSERDATA)
-		return !strcmp(tag, v->u.object->u.user.tag);
+	if (JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->type == JS_CUSERDATA)
+		return !strcmp(tag, JSV_OBJECT(v)->u.user.tag);
 	return 0;
 }
 
 int js_iserror(js_State *J, int idx)
 {
 	js_Value *v = stackidx(J, idx);
-	return v->type == JS_TOBJECT && v->u.object->type == JS_CERROR;
+	return JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->type == JS_CERROR;
 }
 
 const char *js_typeof(js_State *J, int idx)
 {
 	js_Value *v = stackidx(J, idx);
-	switch (v->type) {
+	switch (JSV_TYPE(v)) {
 	default:
 	case JS_TSHRSTR: return "string";
 	case JS_TUNDEFINED: return "undefined";
@@ -264,8 +258,9 @@ const char *js_typeof(js_State *J, int idx)
 	case JS_TNUMBER: return "number";
 	case JS_TLITSTR: return "string";
 	case JS_TMEMSTR: return "string";
+	case JS_TROPE: return "string";
 	case JS_TOBJECT:
-		if (v->u.object->type == JS_CFUNCTION || v->u.object->type == JS_CCFUNCTION)
+		if (JSV_OBJECT(v)->type == JS_CFUNCTION || JSV_OBJECT(v)->type == JS_CCFUNCTION)
 			return "function";
 		return "object";
 	}
@@ -274,7 +269,7 @@ const char *js_typeof(js_State *J, int idx)
 int js_type(js_State *J, int idx)
 {
 	js_Value *v = stackidx(J, idx);
-	switch (v->type) {
+	switch (JSV_TYPE(v)) {
 	default:
 	case JS_TSHRSTR: return JS_ISSTRING;
 	case JS_TUNDEFINED: return JS_ISUNDEFINED;
@@ -283,8 +278,9 @@ int js_type(js_State *J, int idx)
 	case JS_TNUMBER: return JS_ISNUMBER;
 	case JS_TLITSTR: return JS_ISSTRING;
 	case JS_TMEMSTR: return JS_ISSTRING;
+	case JS_TROPE: return JS_ISSTRING;
 	case JS_TOBJECT:
-		if (v->u.object->type == JS_CFUNCTION || v->u.object->type == JS_CCFUNCTION)
+		if (JSV_OBJECT(v)->type == JS_CFUNCTION || JSV_OBJECT(v)->type == JS_CCFUNCTION)
 			return JS_ISFUNCTION;
 		return JS_ISOBJECT;
 	}
@@ -343,28 +339,28 @@ void js_toprimitive(js_State *J, int idx, int hint)
 js_Regexp *js_toregexp(js_State *J, int idx)
 {
 	js_Value *v = stackidx(J, idx);
-	if (v->type == JS_TOBJECT && v->u.object->type == JS_CREGEXP)
-		return &v->u.object->u.r;
+	if (JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->type == JS_CREGEXP)
+		return &JSV_OBJECT(v)->u.r;
 	js_typeerror(J, "not a regexp");
 }
 
 void *js_touserdata(js_State *J, int idx, const char *tag)
 {
 	js_Value *v = stackidx(J, idx);
-	if (v->type == JS_TOBJECT && v->u.object->type == JS_CUSERDATA)
-		if (!strcmp(tag, v->u.object->u.user.tag))
-			return v->u.object->u.user.data;
+	if (JSV_TYPE(v) == JS_TOBJECT && JSV_OBJECT(v)->type == JS_CUSERDATA)
+		if (!strcmp(tag, JSV_OBJECT(v)->u.user.tag))
+			return JSV_OBJECT(v)->u.user.data;
 	js_typeerror(J, "not a %s", tag);
 }
 
 static js_Object *jsR_tofunction(js_State *J, int idx)
 {
 	js_Value *v = stackidx(J, idx);
-	if (v->type == JS_TUNDEFINED || v->type == JS_TNULL)
+	if (JSV_TYPE(v) == JS_TUNDEFINED || JSV_TYPE(v) == JS_TNULL)
 		return NULL;
-	if (v->type == JS_TOBJECT)
-		if (v->u.object->type == JS_CFUNCTION || v->u.object->type == JS_CCFUNCTION)
-			return v->u.object;
+	if (JSV_TYPE(v) == JS_TOBJECT)
+		if (JSV_OBJECT(v)->type == JS_CFUNCTION || JSV_OBJECT(v)->type == JS_CCFUNCTION)
+			return JSV_OBJECT(v);
 	js_typeerror(J, "not a function");
 }
 
@@ -517,9 +513,69 @@ static void js_pushrune(js_State *J, Rune rune)
 	}
 }
 
+/* Dense array storage */
+
+static void jsR_setarrayindex(js_State *J, js_Object *obj, int k, js_Value *value)
+{
+	int newlen = k + 1;
+	if (newlen > JS_ARRAYLIMIT)
+		js_rangeerror(J, "array too large");
+	if (newlen > obj->u.a.flat_length) {
+		if (newlen > obj->u.a.flat_capacity) {
+			int newcap = obj->u.a.flat_capacity;
+			if (newcap == 0)
+				newcap = 8;
+			while (newcap < newlen)
+				newcap <<= 1;
+			obj->u.a.array = js_realloc(J, obj->u.a.array, newcap * sizeof(js_Value));
+			obj->u.a.flat_capacity = newcap;
+		}
+		obj->u.a.flat_length = newlen;
+		++J->gccounter;
+	}
+	if (newlen > obj->u.a.length)
+		obj->u.a.length = newlen;
+	jsG_writebarrier(J, value);
+	obj->u.a.array[k] = *value;
+}
+
+/* Appending to a dense array is a plain store only if nothing up the prototype
+ * chain intercepts that index with an accessor or a read-only property.
+ * Objects that never had an index named property are skipped without a lookup. */
+static int jsR_canappend(js_State *J, js_Object *obj, int k)
+{
+	js_Property *ref;
+	char buf[32];
+	const char *name = NULL;
+	if (!obj->extensible || k >= JS_ARRAYLIMIT)
+		return 0;
+	for (; obj; obj = obj->prototype) {
+		if (!obj->indexprops)
+			continue;
+		if (!name)
+			name = js_itoa(buf, k);
+		ref = jsV_getownproperty(J, obj, name);
+		if (ref)
+			return !ref->getter && !ref->setter && !(ref->atts & JS_READONLY);
+	}
+	return 1;
+}
+
+/* Returns the element index of a number value usable as a dense array subscript, or -1. */
+static int jsR_valuetoindex(js_Value *v)
+{
+	if (JSV_TYPE(v) == JS_TNUMBER) {
+		double n = JSV_NUMBER(v);
+		if (n >= 0 && n < JS_ARRAYLIMIT && n == (int)n)
+			return (int)n;
+	}
+	return -1;
+}
+
 static int jsR_hasproperty(js_State *J, js_Object *obj, const char *name)
 {
 	js_Property *ref;
+	js_Object *proto;
 	int k;
 
 	if (obj->type == JS_CARRAY) {
@@ -527,6 +583,12 @@ static int jsR_hasproperty(js_State *J, js_Object *obj, const char *name)
 			js_pushnumber(J, obj->u.a.length);
 			return 1;
 		}
+		if (obj->u.a.simple && js_isarrayindex(J, name, &k)) {
+			if (k < obj->u.a.flat_length) {
+				js_pushvalue(J, obj->u.a.array[k]);
+				return 1;
+			}
+		}
 	}
 
 	else if (obj->type == JS_CSTRING) {
@@ -536,7 +598,10 @@ static int jsR_hasproperty(js_State *J, js_Object *obj, const char *name)
 		}
 		if (js_isarrayindex(J, name, &k)) {
 			if (k >= 0 && k < obj->u.s.length) {
-				js_pushrune(J, js_runeat(J, obj->u.s.string, k));
+				if (obj->u.s.memstr)
+					js_pushrune(J, js_stringruneat(J, obj->u.s.memstr, k));
+				else
+					js_pushrune(J, js_runeat(J, obj->u.s.string, k));
 				return 1;
 			}
 		}
@@ -582,6 +647,16 @@ static int jsR_hasproperty(js_State *J, js_Object *obj, const char *name)
 		return 1;
 	}
 
+	/* elements of dense arrays used as prototypes are not in the property tree */
+	for (proto = obj->prototype; proto; proto = proto->prototype) {
+		if (proto->type == JS_CARRAY && proto->u.a.simple && js_isarrayindex(J, name, &k)) {
+			if (k < proto->u.a.flat_length) {
+				js_pushvalue(J, proto->u.a.array[k]);
+				return 1;
+			}
+		}
+	}
+
 	return 0;
 }
 
@@ -607,9 +682,18 @@ static void jsR_setproperty(js_State *J, js_Object *obj, const char *name, int t
 			jsV_resizearray(J, obj, newlen);
 			return;
 		}
-		if (js_isarrayindex(J, name, &k))
+		if (js_isarrayindex(J, name, &k)) {
+			if (obj->u.a.simple) {
+				if (k < obj->u.a.flat_length || (k == obj->u.a.flat_length && jsR_canappend(J, obj, k))) {
+					jsR_setarrayindex(J, obj, k, value);
+					return;
+				}
+				/* a hole would open up or the prototype chain takes the store, fall back to sparse properties */
+				jsV_unflattenarray(J, obj);
+			}
 			if (k >= obj->u.a.length)
 				obj->u.a.length = k + 1;
+		}
 	}
 
 	else if (obj->type == JS_CSTRING) {
@@ -666,9 +750,10 @@ static void jsR_setproperty(js_State *J, js_Object *obj, const char *name, int t
 	}
 
 	if (ref) {
-		if (!(ref->atts & JS_READONLY))
+		if (!(ref->atts & JS_READONLY)) {
+			jsG_writebarrier(J, value);
 			ref->value = *value;
-		else
+		} else
 			goto readonly;
 	}
 
@@ -679,6 +764,119 @@ readonly:
 		js_typeerror(J, "'%s' is read-only", name);
 }
 
+/* Inline cached access for OP_GETPROP_S and OP_SETPROP_S */
+
+static int jsR_iscacheable(js_Object *obj, const char *name)
+{
+	switch (obj->type) {
+	case JS_CARRAY:
+	case JS_CSTRING:
+		return strcmp(name, "length") != 0;
+	case JS_CREGEXP:
+	case JS_CUSERDATA:
+		return 0;
+	default:
+		return 1;
+	}
+}
+
+static void jsR_getcachedproperty(js_State *J, js_Object *obj, const char *name, js_PropCache *ic)
+{
+	js_Object *proto = obj->prototype;
+	js_Property *ref;
+
+	if (ic->shape == obj->shape) {
+		if (!ic->pshape || (proto && ic->pshape == proto->shape)) {
+			js_pushvalue(J, ic->ref->value);
+			return;
+		}
+	}
+
+	if (jsR_iscacheable(obj, name)) {
+		ref = jsV_getownproperty(J, obj, name);
+		if (ref && !ref->getter) {
+			ic->shape = obj->shape;
+			ic->pshape = 0;
+			ic->ref = ref;
+			js_pushvalue(J, ref->value);
+			return;
+		}
+		if (!ref && proto) {
+			ref = jsV_getownproperty(J, proto, name);
+			if (ref && !ref->getter) {
+				ic->shape = obj->shape;
+				ic->pshape = proto->shape;
+				ic->ref = ref;
+				js_pushvalue(J, ref->value);
+				return;
+			}
+		}
+	}
+
+	jsR_getproperty(J, obj, name);
+}
+
+/* Property of the primitive string on top of the stack, looked up without a String object */
+static int jsR_getstringproperty(js_State *J, const char *name, js_PropCache *ic)
+{
+	js_Object *proto = J->String_prototype;
+	js_Property *ref;
+	int k;
+
+	if (!strcmp(name, "length")) {
+		k = jsV_stringlength(J, stackidx(J, -1));
+		js_pop(J, 1);
+		js_pushnumber(J, k);
+		return 1;
+	}
+
+	if (ic->shape == proto->shape && !ic->pshape) {
+		js_pop(J, 1);
+		js_pushvalue(J, ic->ref->value);
+		return 1;
+	}
+
+	/* indices, getters (which need 'this') and inherited names take the slow path */
+	if (js_isarrayindex(J, name, &k))
+		return 0;
+	ref = jsV_getownproperty(J, proto, name);
+	if (ref && !ref->getter) {
+		ic->shape = proto->shape;
+		ic->pshape = 0;
+		ic->ref = ref;
+		js_pop(J, 1);
+		js_pushvalue(J, ref->value);
+		return 1;
+	}
+	return 0;
+}
+
+static void jsR_setcachedproperty(js_State *J, js_Object *obj, const char *name, int transient, js_PropCache *ic)
+{
+	js_Property *ref;
+
+	if (!transient) {
+		if (ic->shape == obj->shape && !ic->pshape) {
+			jsG_writebarrier(J, stackidx(J, -1));
+			ic->ref->value = *stackidx(J, -1);
+			return;
+		}
+		if (jsR_iscacheable(obj, name)) {
+			ref = jsV_getownproperty(J, obj, name);
+			if (ref && !ref->getter && !ref->setter && !(ref->atts & JS_READONLY)) {
+				ic->shape = obj->shape;
+				ic->pshape = 0;
+				ic->ref = ref;
+				jsG_writebarrier(J, stackidx(J, -1));
+				ref->value = *stackidx(J, -1);
+				return;
+			}
+		}
+	}
+
+	jsR_setproperty(J, obj, name, transient);
+}
+
 static void jsR_defproperty(js_State *J, js_Object *obj, const char *name,
 	int atts, js_Value *value, js_Object *getter, js_Object *setter,
 	int throw)
@@ -689,6 +887,8 @@ static void jsR_defproperty(js_State *J, js_Object *obj, const char *name,
 	if (obj->type == JS_CARRAY) {
 		if (!strcmp(name, "length"))
 			goto readonly;
+		if (obj->u.a.simple && js_isarrayindex(J, name, &k))
+			jsV_unflattenarray(J, obj);
 	}
 
 	else if (obj->type == JS_CSTRING) {
@@ -715,24 +915,30 @@ static void jsR_defproperty(js_State *J, js_Object *obj, const char *name,
 	ref = jsV_setproperty(J, obj, name);
 	if (ref) {
 		if (value) {
-			if (!(ref->atts & JS_READONLY))
+			if (!(ref->atts & JS_READONLY)) {
+				jsG_writebarrier(J, value);
 				ref->value = *value;
-			else if (J->strict)
+			} else if (J->strict)
 				js_typeerror(J, "'%s' is read-only", name);
 		}
 		if (getter) {
+			if (J->gcstate == JS_GCMARK)
+				jsG_barrierobject(J, getter);
 			if (!(ref->atts & JS_DONTCONF))
 				ref->getter = getter;
 			else if (J->strict)
 				js_typeerror(J, "'%s' is non-configurable", name);
 		}
 		if (setter) {
+			if (J->gcstate == JS_GCMARK)
+				jsG_barrierobject(J, setter);
 			if (!(ref->atts & JS_DONTCONF))
 				ref->setter = setter;
 			else if (J->strict)
 				js_typeerror(J, "'%s' is non-configurable", name);
 		}
 		ref->atts |= atts;
+		obj->shape = ++J->shapeseq;
 	}
 
 	return;
@@ -750,6 +956,16 @@ static int jsR_delproperty(js_State *J, js_Object *obj, const char *name)
 	if (obj->type == JS_CARRAY) {
 		if (!strcmp(name, "length"))
 			goto dontconf;
+		if (obj->u.a.simple && js_isarrayindex(J, name, &k)) {
+			/* deleting past the end, or the last element, keeps the array dense */
+			if (k >= obj->u.a.flat_length)
+				return 1;
+			if (k == obj->u.a.flat_length - 1) {
+				--obj->u.a.flat_length;
+				return 1;
+			}
+			jsV_unflattenarray(J, obj);
+		}
 	}
 
 	else if (obj->type == JS_CSTRING) {
@@ -794,14 +1010,14 @@ const char *js_ref(js_State *J)
 	js_Value *v = stackidx(J, -1);
 	const char *s;
 	char buf[32];
-	switch (v->type) {
+	switch (JSV_TYPE(v)) {
 	case JS_TUNDEFINED: s = "_Undefined"; break;
 	case JS_TNULL: s = "_Null"; break;
 	case JS_TBOOLEAN:
-		s = v->u.boolean ? "_True" : "_False";
+		s = JSV_BOOLEAN(v) ? "_True" : "_False";
 		break;
 	case JS_TOBJECT:
-		sprintf(buf, "%p", (void*)v->u.object);
+		sprintf(buf, "%p", (void*)JSV_OBJECT(v));
 		s = js_intern(J, buf);
 		break;
 	default:
@@ -889,6 +1105,52 @@ int js_hasproperty(js_State *J, int idx, const char *name)
 	return jsR_hasproperty(J, js_toobject(J, idx), name);
 }
 
+/* Array element accessors, bypassing the index to string conversion for dense arrays */
+
+static int jsR_hasindex(js_State *J, js_Object *obj, int k)
+{
+	char buf[32];
+	if (obj->type == JS_CARRAY && obj->u.a.simple && k >= 0 && k < obj->u.a.flat_length) {
+		js_pushvalue(J, obj->u.a.array[k]);
+		return 1;
+	}
+	return jsR_hasproperty(J, obj, js_itoa(buf, k));
+}
+
+static void jsR_setindex(js_State *J, js_Object *obj, int k, int transient)
+{
+	char buf[32];
+	if (obj->type == JS_CARRAY && obj->u.a.simple && k >= 0 &&
+		(k < obj->u.a.flat_length || (k == obj->u.a.flat_length && jsR_canappend(J, obj, k)))) {
+		jsR_setarrayindex(J, obj, k, stackidx(J, -1));
+		return;
+	}
+	jsR_setproperty(J, obj, js_itoa(buf, k), transient);
+}
+
+int js_hasindex(js_State *J, int idx, int i)
+{
+	return jsR_hasindex(J, js_toobject(J, idx), i);
+}
+
+void js_getindex(js_State *J, int idx, int i)
+{
+	if (!jsR_hasindex(J, js_toobject(J, idx), i))
+		js_pushundefined(J);
+}
+
+void js_setindex(js_State *J, int idx, int i)
+{
+	jsR_setindex(J, js_toobject(J, idx), i, !js_isobject(J, idx));
+	js_pop(J, 1);
+}
+
+void js_delindex(js_State *J, int idx, int i)
+{
+	char buf[32];
+	jsR_delproperty(J, js_toobject(J, idx), js_itoa(buf, i));
+}
+
 /* Iterator */
 
 void js_pushiterator(js_State *J, int idx, int own)
@@ -906,16 +1168,44 @@ const char *js_nextiterator(js_State *J, int idx)
 js_Environment *jsR_newenvironment(js_State *J, js_Object *vars, js_Environment *outer)
 {
 	js_Environment *E = js_malloc(J, sizeof *E);
-	E->gcmark = 0;
+	E->gcmark = jsG_newmark(J);
 	E->gcnext = J->gcenv;
 	J->gcenv = E;
 	++J->gccounter;
 
 	E->outer = outer;
 	E->variables = vars;
+	E->function = NULL;
+	return E;
+}
+
+js_Environment *jsR_newslotenvironment(js_State *J, js_Function *F, js_Environment *outer)
+{
+	js_Environment *E = js_malloc(J, soffsetof(js_Environment, slots) + F->varlen * sizeof(js_Value));
+	int i;
+	E->gcmark = jsG_newmark(J);
+	E->gcnext = J->gcenv;
+	J->gcenv = E;
+	++J->gccounter;
+
+	E->outer = outer;
+	E->variables = NULL;
+	E->function = F;
+	for (i = 0; i < F->varlen; ++i)
+		JSV_SETUNDEFINED(&E->slots[i]);
 	return E;
 }
 
+static js_Value *js_findslot(js_Environment *E, const char *name)
+{
+	const char **vartab = E->function->vartab;
+	int i;
+	for (i = E->function->varlen - 1; i >= 0; --i)
+		if (vartab[i] == name || !strcmp(vartab[i], name))
+			return &E->slots[i];
+	return NULL;
+}
+
 static void js_initvar(js_State *J, const char *name, int idx)
 {
 	jsR_defproperty(J, J->E->variables, name, JS_DONTENUM | JS_DONTCONF, stackidx(J, idx), NULL, NULL, 0);
@@ -925,7 +1215,17 @@ static int js_hasvar(js_State *J, const char *name)
 {
 	js_Environment *E = J->E;
 	do {
-		js_Property *ref = jsV_getproperty(J, E->variables, name);
+		js_Property *ref;
+		if (!E->variables) {
+			js_Value *slot = js_findslot(E, name);
+			if (slot) {
+				js_pushvalue(J, *slot);
+				return 1;
+			}
+			E = E->outer;
+			continue;
+		}
+		ref = jsV_getproperty(J, E->variables, name);
 		if (ref) {
 			if (ref->getter) {
 				js_pushobject(J, ref->getter);
@@ -945,7 +1245,18 @@ static void js_setvar(js_State *J, const char *name)
 {
 	js_Environment *E = J->E;
 	do {
-		js_Property *ref = jsV_getproperty(J, E->variables, name);
+		js_Property *ref;
+		if (!E->variables) {
+			js_Value *slot = js_findslot(E, name);
+			if (slot) {
+				jsG_writebarrier(J, stackidx(J, -1));
+				*slot = *stackidx(J, -1);
+				return;
+			}
+			E = E->outer;
+			continue;
+		}
+		ref = jsV_getproperty(J, E->variables, name);
 		if (ref) {
 			if (ref->setter) {
 				js_pushobject(J, ref->setter);
@@ -955,9 +1266,10 @@ static void js_setvar(js_State *J, const char *name)
 				js_pop(J, 1);
 				return;
 			}
-			if (!(ref->atts & JS_READONLY))
+			if (!(ref->atts & JS_READONLY)) {
+				jsG_writebarrier(J, stackidx(J, -1));
 				ref->value = *stackidx(J, -1);
-			else if (J->strict)
+			} else if (J->strict)
 				js_typeerror(J, "'%s' is read-only", name);
 			return;
 		}
@@ -972,7 +1284,18 @@ static int js_delvar(js_State *J, const char *name)
 {
 	js_Environment *E = J->E;
 	do {
-		js_Property *ref = jsV_getownproperty(J, E->variables, name);
+		js_Property *ref;
+		if (!E->variables) {
+			/* declared variables cannot be deleted */
+			if (js_findslot(E, name)) {
+				if (J->strict)
+					js_typeerror(J, "'%s' is non-configurable", name);
+				return 0;
+			}
+			E = E->outer;
+			continue;
+		}
+		ref = jsV_getownproperty(J, E->variables, name);
 		if (ref) {
 			if (ref->atts & JS_DONTCONF) {
 				if (J->strict)
@@ -1025,11 +1348,53 @@ static void jsR_calllwfunction(js_State *J, int n, js_Function *F, js_Environmen
 	jsR_restorescope(J);
 }
 
+static void jsR_callslotfunction(js_State *J, int n, js_Function *F, js_Environment *scope)
+{
+	js_Value v;
+	int i;
+
+	scope = jsR_newslotenvironment(J, F, scope);
+
+	jsR_savescope(J, scope);
+
+	if (F->arguments) {
+		js_newarguments(J);
+		if (!J->strict) {
+			js_currentfunction(J);
+			js_defproperty(J, -2, "callee", JS_DONTENUM);
+		}
+		js_pushnumber(J, n);
+		js_defproperty(J, -2, "length", JS_DONTENUM);
+		for (i = 0; i < n; ++i) {
+			js_copy(J, i + 1);
+			js_setindex(J, -2, i);
+		}
+		*js_findslot(scope, "arguments") = *stackidx(J, -1);
+		js_pop(J, 1);
+	}
+
+	for (i = 0; i < n && i < F->numparams; ++i)
+		scope->slots[i] = *stackidx(J, i + 1);
+	js_pop(J, n);
+
+	jsR_run(J, F);
+	v = *stackidx(J, -1);
+	TOP = --BOT; /* clear stack */
+	js_pushvalue(J, v);
+
+	jsR_restorescope(J);
+}
+
 static void jsR_callfunction(js_State *J, int n, js_Function *F, js_Environment *scope)
 {
 	js_Value v;
 	int i;
 
+	if (!F->dynamic) {
+		jsR_callslotfunction(J, n, F, scope);
+		return;
+	}
+
 	scope = jsR_newenvironment(J, jsV_newobject(J, JS_COBJECT, NULL), scope);
 
 	jsR_savescope(J, scope);
@@ -1135,6 +1500,16 @@ static void jsR_pushtrace(js_State *J, const char *name, const char *file, int l
 	J->trace[J->tracetop].name = name;
 	J->trace[J->tracetop].file = file;
 	J->trace[J->tracetop].line = line;
+	J->trace[J->tracetop].function = NULL;
+}
+
+/* Line a frame is at; script functions only look it up when asked */
+int jsR_traceline(js_State *J, int n)
+{
+	js_StackTrace *T = &J->trace[n];
+	if (T->function)
+		return jsC_findline(T->function, (int)(*T->pc - T->function->code) - 1);
+	return T->line;
 }
 
 void js_call(js_State *J, int n)
@@ -1345,8 +1720,19 @@ static void jsR_dumpstack(js_State *J)
 
 static void jsR_dumpenvironment(js_State *J, js_Environment *E, int d)
 {
+	int i;
 	printf("scope %d ", d);
-	js_dumpobject(J, E->variables);
+	if (E->variables) {
+		js_dumpobject(J, E->variables);
+	} else {
+		printf("{\n");
+		for (i = 0; i < E->function->varlen; ++i) {
+			printf("\t%s: ", E->function->vartab[i]);
+			js_dumpvalue(J, E->slots[i]);
+			printf(",\n");
+		}
+		printf("}\n");
+	}
 	if (E->outer)
 		jsR_dumpenvironment(J, E->outer, d+1);
 }
@@ -1358,7 +1744,7 @@ void js_stacktrace(js_State *J)
 	for (n = J->tracetop; n >= 0; --n) {
 		const char *name = J->trace[n].name;
 		const char *file = J->trace[n].file;
-		int line = J->trace[n].line;
+		int line = jsR_traceline(J, n);
 		if (line > 0) {
 			if (name[0])
 				printf("\tat %s (%s:%d)\n", name, file, line);
@@ -1372,7 +1758,7 @@ void js_stacktrace(js_State *J)
 void js_trap(js_State *J, int pc)
 {
 	if (pc > 0) {
-		js_Function *F = STACK[BOT-1].u.object->u.f.function;
+		js_Function *F = JSV_OBJECT(&STACK[BOT-1])->u.f.function;
 		printf("trap at %d in function ", pc);
 		jsC_dumpfunction(J, F);
 	}
@@ -1381,14 +1767,65 @@ void js_trap(js_State *J, int pc)
 	js_stacktrace(J);
 }
 
+#ifdef JS_OPPROFILE
+
+/* Counts of adjacent opcode pairs, for choosing superinstructions */
+
+static const char *opprofile_names[] = {
+#include "opnames.h"
+};
+
+#define JS_NUMOPS (int)(sizeof opprofile_names / sizeof *opprofile_names)
+
+static unsigned long opprofile_pairs[JS_NUMOPS][JS_NUMOPS];
+static int opprofile_last;
+
+static int opprofile(int op)
+{
+	++opprofile_pairs[opprofile_last][op];
+	opprofile_last = op;
+	return op;
+}
+
+void jsR_dumpopprofile(int n)
+{
+	unsigned long total = 0;
+	int i, k, a, b, best_a, best_b;
+	for (a = 0; a < JS_NUMOPS; ++a)
+		for (b = 0; b < JS_NUMOPS; ++b)
+			total += opprofile_pairs[a][b];
+	printf("opcode pairs: %lu\n", total);
+	for (k = 0; k < n; ++k) {
+		best_a = best_b = -1;
+		for (a = 0; a < JS_NUMOPS; ++a)
+			for (b = 0; b < JS_NUMOPS; ++b)
+				if (opprofile_pairs[a][b] && (best_a < 0 || opprofile_pairs[a][b] > opprofile_pairs[best_a][best_b]))
+					best_a = a, best_b = b;
+		if (best_a < 0)
+			break;
+		printf("%8lu %5.2f%% %s %s\n", opprofile_pairs[best_a][best_b],
+			100.0 * opprofile_pairs[best_a][best_b] / total,
+			opprofile_names[best_a], opprofile_names[best_b]);
+		opprofile_pairs[best_a][best_b] = 0;
+	}
+	for (i = 0; i < JS_NUMOPS; ++i)
+		memset(opprofile_pairs[i], 0, sizeof opprofile_pairs[i]);
+}
+
+#define OPPROFILE(op) opprofile(op)
+#else
+#define OPPROFILE(op) (op)
+#endif
+
 static void jsR_run(js_State *J, js_Function *F)
 {
 	js_Function **FT = F->funtab;
+	js_PropCache *CT = F->cachetab;
 	const char **VT = F->vartab-1;
 	int lightweight = F->lightweight;
+	int slotted = !F->lightweight && !F->dynamic;
 	js_Instruction *pcstart = F->code;
 	js_Instruction *pc = F->code;
-	enum js_OpCode opcode;
 	int offset;
 	int savestrict;
 
@@ -1399,6 +1836,7 @@ static void jsR_run(js_State *J, js_Function *F)
 	int ix, iy, okay;
 	int b;
 	int transient;
+	js_Environment *E;
 
 	savestrict = J->strict;
 	J->strict = F->strict;
@@ -1407,51 +1845,185 @@ static void jsR_run(js_State *J, js_Function *F)
 	memcpy(&str, pc, sizeof(str)); \
 	pc += sizeof(str) / sizeof(*pc)
 
+	/* the line is looked up from pc in the line table only when a trace is needed */
+	J->trace[J->tracetop].function = F;
+	J->trace[J->tracetop].pc = &pc;
+
+#if defined(__GNUC__) && !defined(JS_NOTHREADING)
+	/* direct threading: each instruction jumps straight to the next one's label */
+	static const void *optab[] = {
+		&&L_OP_POP,
+		&&L_OP_DUP,
+		&&L_OP_DUP2,
+		&&L_OP_ROT2,
+		&&L_OP_ROT3,
+		&&L_OP_ROT4,
+		&&L_OP_INTEGER,
+		&&L_OP_NUMBER,
+		&&L_OP_STRING,
+		&&L_OP_CLOSURE,
+		&&L_OP_NEWARRAY,
+		&&L_OP_NEWOBJECT,
+		&&L_OP_NEWREGEXP,
+		&&L_OP_UNDEF,
+		&&L_OP_NULL,
+		&&L_OP_TRUE,
+		&&L_OP_FALSE,
+		&&L_OP_THIS,
+		&&L_OP_CURRENT,
+		&&L_OP_GETLOCAL,
+		&&L_OP_SETLOCAL,
+		&&L_OP_DELLOCAL,
+		&&L_OP_GETUPVAR,
+		&&L_OP_SETUPVAR,
+		&&L_OP_HASVAR,
+		&&L_OP_GETVAR,
+		&&L_OP_SETVAR,
+		&&L_OP_DELVAR,
+		&&L_OP_IN,
+		&&L_OP_INITARRAY,
+		&&L_OP_INITPROP,
+		&&L_OP_INITGETTER,
+		&&L_OP_INITSETTER,
+		&&L_OP_GETPROP,
+		&&L_OP_GETPROP_S,
+		&&L_OP_SETPROP,
+		&&L_OP_SETPROP_S,
+		&&L_OP_DELPROP,
+		&&L_OP_DELPROP_S,
+		&&L_OP_ITERATOR,
+		&&L_OP_NEXTITER,
+		&&L_OP_EVAL,
+		&&L_OP_CALL,
+		&&L_OP_NEW,
+		&&L_OP_TYPEOF,
+		&&L_OP_POS,
+		&&L_OP_NEG,
+		&&L_OP_BITNOT,
+		&&L_OP_LOGNOT,
+		&&L_OP_INC,
+		&&L_OP_DEC,
+		&&L_OP_POSTINC,
+		&&L_OP_POSTDEC,
+		&&L_OP_MUL,
+		&&L_OP_DIV,
+		&&L_OP_MOD,
+		&&L_OP_ADD,
+		&&L_OP_SUB,
+		&&L_OP_SHL,
+		&&L_OP_SHR,
+		&&L_OP_USHR,
+		&&L_OP_LT,
+		&&L_OP_GT,
+		&&L_OP_LE,
+		&&L_OP_GE,
+		&&L_OP_EQ,
+		&&L_OP_NE,
+		&&L_OP_STRICTEQ,
+		&&L_OP_STRICTNE,
+		&&L_OP_JCASE,
+		&&L_OP_BITAND,
+		&&L_OP_BITXOR,
+		&&L_OP_BITOR,
+		&&L_OP_INSTANCEOF,
+		&&L_OP_THROW,
+		&&L_OP_TRY,
+		&&L_OP_ENDTRY,
+		&&L_OP_CATCH,
+		&&L_OP_ENDCATCH,
+		&&L_OP_WITH,
+		&&L_OP_ENDWITH,
+		&&L_OP_DEBUGGER,
+		&&L_OP_JUMP,
+		&&L_OP_JTRUE,
+		&&L_OP_JFALSE,
+		&&L_OP_RETURN,
+		&&L_OP_GETMETHOD_S,
+		&&L_OP_ADDLOCALS,
+		&&L_OP_JNLTLOCAL
+	};
+	/* while profiling, every instruction goes through L_PROFILE first */
+	static const void *proftab[sizeof optab / sizeof *optab];
+	/* volatile, VMPOLL may change it after js_trypc in OP_TRY */
+	const void *const *volatile dispatch = optab;
+#define VMCASE(op) L_##op
+#define VMDISPATCH() goto *dispatch[OPPROFILE(*pc++)]
+#define VMNEXT VMDISPATCH()
+#define VMPOLL() do { \
+		if (J->gccounter > J->gcthresh) \
+			jsG_step(J); \
+		dispatch = J->profiling ? proftab : optab; \
+	} while (0)
+	if (!proftab[0])
+		for (ix = 0; ix < (int)(sizeof proftab / sizeof *proftab); ++ix)
+			proftab[ix] = &&L_PROFILE;
+#else
+	int profiling;
+#define VMCASE(op) case op
+#define VMNEXT break
+#define VMPOLL() do { \
+		if (J->gccounter > J->gcthresh) \
+			jsG_step(J); \
+		profiling = J->profiling; \
+	} while (0)
+#endif
+
+	/* garbage is collected, and profiling switched on or off, on function entry and on jumps */
+	VMPOLL();
+
+#if defined(__GNUC__) && !defined(JS_NOTHREADING)
+	VMDISPATCH();
+	{
+		{
+		L_PROFILE:
+			jsR_profilestep(J, F);
+			goto *optab[pc[-1]];
+
+#else
 	while (1) {
-		if (J->gccounter > J->gcthresh)
-			js_gc(J, 0);
-
-		J->trace[J->tracetop].line = *pc++;
+		enum js_OpCode opcode = OPPROFILE(*pc++);
 
-		opcode = *pc++;
+		if (profiling)
+			jsR_profilestep(J, F);
 
 		switch (opcode) {
-		case OP_POP: js_pop(J, 1); break;
-		case OP_DUP: js_dup(J); break;
-		case OP_DUP2: js_dup2(J); break;
-		case OP_ROT2: js_rot2(J); break;
-		case OP_ROT3: js_rot3(J); break;
-		case OP_ROT4: js_rot4(J); break;
-
-		case OP_INTEGER:
+#endif
+		VMCASE(OP_POP): js_pop(J, 1); VMNEXT;
+		VMCASE(OP_DUP): js_dup(J); VMNEXT;
+		VMCASE(OP_DUP2): js_dup2(J); VMNEXT;
+		VMCASE(OP_ROT2): js_rot2(J); VMNEXT;
+		VMCASE(OP_ROT3): js_rot3(J); VMNEXT;
+		VMCASE(OP_ROT4): js_rot4(J); VMNEXT;
+
+		VMCASE(OP_INTEGER):
 			js_pushnumber(J, *pc++ - 32768);
-			break;
+			VMNEXT;
 
-		case OP_NUMBER:
+		VMCASE(OP_NUMBER):
 			memcpy(&x, pc, sizeof(x));
 			pc += sizeof(x) / sizeof(*pc);
 			js_pushnumber(J, x);
-			break;
+			VMNEXT;
 
-		case OP_STRING:
+		VMCASE(OP_STRING):
 			READSTRING();
 			js_pushliteral(J, str);
-			break;
+			VMNEXT;
 
-		case OP_CLOSURE: js_newfunction(J, FT[*pc++], J->E); break;
-		case OP_NEWOBJECT: js_newobject(J); break;
-		case OP_NEWARRAY: js_newarray(J); break;
-		case OP_NEWREGEXP:
+		VMCASE(OP_CLOSURE): js_newfunction(J, FT[*pc++], J->E); VMNEXT;
+		VMCASE(OP_NEWOBJECT): js_newobject(J); VMNEXT;
+		VMCASE(OP_NEWARRAY): js_newarray(J); VMNEXT;
+		VMCASE(OP_NEWREGEXP):
 			READSTRING();
 			js_newregexp(J, str, *pc++);
-			break;
+			VMNEXT;
 
-		case OP_UNDEF: js_pushundefined(J); break;
-		case OP_NULL: js_pushnull(J); break;
-		case OP_TRUE: js_pushboolean(J, 1); break;
-		case OP_FALSE: js_pushboolean(J, 0); break;
+		VMCASE(OP_UNDEF): js_pushundefined(J); VMNEXT;
+		VMCASE(OP_NULL): js_pushnull(J); VMNEXT;
+		VMCASE(OP_TRUE): js_pushboolean(J, 1); VMNEXT;
+		VMCASE(OP_FALSE): js_pushboolean(J, 0); VMNEXT;
 
-		case OP_THIS:
+		VMCASE(OP_THIS):
 			if (J->strict) {
 				js_copy(J, 0);
 			} else {
@@ -1460,153 +2032,201 @@ static void jsR_run(js_State *J, js_Function *F)
 				else
 					js_pushglobal(J);
 			}
-			break;
+			VMNEXT;
 
-		case OP_CURRENT:
+		VMCASE(OP_CURRENT):
 			js_currentfunction(J);
-			break;
+			VMNEXT;
 
-		case OP_GETLOCAL:
+		VMCASE(OP_GETLOCAL):
 			if (lightweight) {
 				CHECKSTACK(1);
 				STACK[TOP++] = STACK[BOT + *pc++];
+			} else if (slotted) {
+				CHECKSTACK(1);
+				STACK[TOP++] = J->E->slots[*pc++ - 1];
 			} else {
 				str = VT[*pc++];
 				if (!js_hasvar(J, str))
 					js_referenceerror(J, "'%s' is not defined", str);
 			}
-			break;
+			VMNEXT;
 
-		case OP_SETLOCAL:
+		VMCASE(OP_SETLOCAL):
 			if (lightweight) {
 				STACK[BOT + *pc++] = STACK[TOP-1];
+			} else if (slotted) {
+				jsG_writebarrier(J, &STACK[TOP-1]);
+				J->E->slots[*pc++ - 1] = STACK[TOP-1];
 			} else {
 				js_setvar(J, VT[*pc++]);
 			}
-			break;
+			VMNEXT;
 
-		case OP_DELLOCAL:
-			if (lightweight) {
+		VMCASE(OP_DELLOCAL):
+			if (lightweight || slotted) {
 				++pc;
 				js_pushboolean(J, 0);
 			} else {
 				b = js_delvar(J, VT[*pc++]);
 				js_pushboolean(J, b);
 			}
-			break;
-
-		case OP_GETVAR:
+			VMNEXT;
+
+		/* lightweight functions have no environment record of their own */
+		VMCASE(OP_GETUPVAR):
+			E = J->E;
+			for (ix = *pc++ - lightweight; ix > 0; --ix)
+				E = E->outer;
+			CHECKSTACK(1);
+			STACK[TOP++] = E->slots[*pc++ - 1];
+			VMNEXT;
+
+		VMCASE(OP_SETUPVAR):
+			E = J->E;
+			for (ix = *pc++ - lightweight; ix > 0; --ix)
+				E = E->outer;
+			jsG_writebarrier(J, &STACK[TOP-1]);
+			E->slots[*pc++ - 1] = STACK[TOP-1];
+			VMNEXT;
+
+		VMCASE(OP_GETVAR):
 			READSTRING();
 			if (!js_hasvar(J, str))
 				js_referenceerror(J, "'%s' is not defined", str);
-			break;
+			VMNEXT;
 
-		case OP_HASVAR:
+		VMCASE(OP_HASVAR):
 			READSTRING();
 			if (!js_hasvar(J, str))
 				js_pushundefined(J);
-			break;
+			VMNEXT;
 
-		case OP_SETVAR:
+		VMCASE(OP_SETVAR):
 			READSTRING();
 			js_setvar(J, str);
-			break;
+			VMNEXT;
 
-		case OP_DELVAR:
+		VMCASE(OP_DELVAR):
 			READSTRING();
 			b = js_delvar(J, str);
 			js_pushboolean(J, b);
-			break;
+			VMNEXT;
 
-		case OP_IN:
+		VMCASE(OP_IN):
 			str = js_tostring(J, -2);
 			if (!js_isobject(J, -1))
 				js_typeerror(J, "operand to 'in' is not an object");
 			b = js_hasproperty(J, -1, str);
 			js_pop(J, 2 + b);
 			js_pushboolean(J, b);
-			break;
+			VMNEXT;
 
-		case OP_INITARRAY:
+		VMCASE(OP_INITARRAY):
 			js_setindex(J, -2, js_getlength(J, -2));
-			break;
+			VMNEXT;
 
-		case OP_INITPROP:
+		VMCASE(OP_INITPROP):
 			obj = js_toobject(J, -3);
 			str = js_tostring(J, -2);
 			jsR_setproperty(J, obj, str, 0);
 			js_pop(J, 2);
-			break;
+			VMNEXT;
 
-		case OP_INITGETTER:
+		VMCASE(OP_INITGETTER):
 			obj = js_toobject(J, -3);
 			str = js_tostring(J, -2);
 			jsR_defproperty(J, obj, str, 0, NULL, jsR_tofunction(J, -1), NULL, 0);
 			js_pop(J, 2);
-			break;
+			VMNEXT;
 
-		case OP_INITSETTER:
+		VMCASE(OP_INITSETTER):
 			obj = js_toobject(J, -3);
 			str = js_tostring(J, -2);
 			jsR_defproperty(J, obj, str, 0, NULL, NULL, jsR_tofunction(J, -1), 0);
 			js_pop(J, 2);
-			break;
-
-		case OP_GETPROP:
+			VMNEXT;
+
+		VMCASE(OP_GETPROP):
+			if (js_isarray(J, -2) && (ix = jsR_valuetoindex(stackidx(J, -1))) >= 0) {
+				obj = js_toobject(J, -2);
+				if (!jsR_hasindex(J, obj, ix))
+					js_pushundefined(J);
+				js_rot3pop2(J);
+				VMNEXT;
+			}
+			if (js_isstring(J, -2) && (ix = jsR_valuetoindex(stackidx(J, -1))) >= 0) {
+				iy = jsV_runeat(J, stackidx(J, -2), ix);
+				if (iy >= 0) {
+					js_pop(J, 2);
+					js_pushrune(J, iy);
+					VMNEXT;
+				}
+			}
 			str = js_tostring(J, -1);
 			obj = js_toobject(J, -2);
 			jsR_getproperty(J, obj, str);
 			js_rot3pop2(J);
-			break;
+			VMNEXT;
 
-		case OP_GETPROP_S:
+		VMCASE(OP_GETPROP_S):
 			READSTRING();
+			if (js_isstring(J, -1) && jsR_getstringproperty(J, str, &CT[*pc])) {
+				pc++;
+				VMNEXT;
+			}
 			obj = js_toobject(J, -1);
-			jsR_getproperty(J, obj, str);
+			jsR_getcachedproperty(J, obj, str, &CT[*pc++]);
 			js_rot2pop1(J);
-			break;
-
-		case OP_SETPROP:
+			VMNEXT;
+
+		VMCASE(OP_SETPROP):
+			if (js_isarray(J, -3) && (ix = jsR_valuetoindex(stackidx(J, -2))) >= 0) {
+				obj = js_toobject(J, -3);
+				jsR_setindex(J, obj, ix, 0);
+				js_rot3pop2(J);
+				VMNEXT;
+			}
 			str = js_tostring(J, -2);
 			obj = js_toobject(J, -3);
 			transient = !js_isobject(J, -3);
 			jsR_setproperty(J, obj, str, transient);
 			js_rot3pop2(J);
-			break;
+			VMNEXT;
 
-		case OP_SETPROP_S:
+		VMCASE(OP_SETPROP_S):
 			READSTRING();
 			obj = js_toobject(J, -2);
 			transient = !js_isobject(J, -2);
-			jsR_setproperty(J, obj, str, transient);
+			jsR_setcachedproperty(J, obj, str, transient, &CT[*pc++]);
 			js_rot2pop1(J);
-			break;
+			VMNEXT;
 
-		case OP_DELPROP:
+		VMCASE(OP_DELPROP):
 			str = js_tostring(J, -1);
 			obj = js_toobject(J, -2);
 			b = jsR_delproperty(J, obj, str);
 			js_pop(J, 2);
 			js_pushboolean(J, b);
-			break;
+			VMNEXT;
 
-		case OP_DELPROP_S:
+		VMCASE(OP_DELPROP_S):
 			READSTRING();
 			obj = js_toobject(J, -1);
 			b = jsR_delproperty(J, obj, str);
 			js_pop(J, 1);
 			js_pushboolean(J, b);
-			break;
+			VMNEXT;
 
-		case OP_ITERATOR:
+		VMCASE(OP_ITERATOR):
 			if (js_iscoercible(J, -1)) {
 				obj = jsV_newiterator(J, js_toobject(J, -1), 0);
 				js_pop(J, 1);
 				js_pushobject(J, obj);
 			}
-			break;
+			VMNEXT;
 
-		case OP_NEXTITER:
+		VMCASE(OP_NEXTITER):
 			if (js_isobject(J, -1)) {
 				obj = js_toobject(J, -1);
 				str = jsV_nextiterator(J, obj);
@@ -1621,160 +2241,160 @@ static void jsR_run(js_State *J, js_Function *F)
 				js_pop(J, 1);
 				js_pushboolean(J, 0);
 			}
-			break;
+			VMNEXT;
 
 		/* Function calls */
 
-		case OP_EVAL:
+		VMCASE(OP_EVAL):
 			js_eval(J);
-			break;
+			VMNEXT;
 
-		case OP_CALL:
+		VMCASE(OP_CALL):
 			js_call(J, *pc++);
-			break;
+			VMNEXT;
 
-		case OP_NEW:
+		VMCASE(OP_NEW):
 			js_construct(J, *pc++);
-			break;
+			VMNEXT;
 
 		/* Unary operators */
 
-		case OP_TYPEOF:
+		VMCASE(OP_TYPEOF):
 			str = js_typeof(J, -1);
 			js_pop(J, 1);
 			js_pushliteral(J, str);
-			break;
+			VMNEXT;
 
-		case OP_POS:
+		VMCASE(OP_POS):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x);
-			break;
+			VMNEXT;
 
-		case OP_NEG:
+		VMCASE(OP_NEG):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, -x);
-			break;
+			VMNEXT;
 
-		case OP_BITNOT:
+		VMCASE(OP_BITNOT):
 			ix = js_toint32(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, ~ix);
-			break;
+			VMNEXT;
 
-		case OP_LOGNOT:
+		VMCASE(OP_LOGNOT):
 			b = js_toboolean(J, -1);
 			js_pop(J, 1);
 			js_pushboolean(J, !b);
-			break;
+			VMNEXT;
 
-		case OP_INC:
+		VMCASE(OP_INC):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x + 1);
-			break;
+			VMNEXT;
 
-		case OP_DEC:
+		VMCASE(OP_DEC):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x - 1);
-			break;
+			VMNEXT;
 
-		case OP_POSTINC:
+		VMCASE(OP_POSTINC):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x + 1);
 			js_pushnumber(J, x);
-			break;
+			VMNEXT;
 
-		case OP_POSTDEC:
+		VMCASE(OP_POSTDEC):
 			x = js_tonumber(J, -1);
 			js_pop(J, 1);
 			js_pushnumber(J, x - 1);
 			js_pushnumber(J, x);
-			break;
+			VMNEXT;
 
 		/* Multiplicative operators */
 
-		case OP_MUL:
+		VMCASE(OP_MUL):
 			x = js_tonumber(J, -2);
 			y = js_tonumber(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, x * y);
-			break;
+			VMNEXT;
 
-		case OP_DIV:
+		VMCASE(OP_DIV):
 			x = js_tonumber(J, -2);
 			y = js_tonumber(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, x / y);
-			break;
+			VMNEXT;
 
-		case OP_MOD:
+		VMCASE(OP_MOD):
 			x = js_tonumber(J, -2);
 			y = js_tonumber(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, fmod(x, y));
-			break;
+			VMNEXT;
 
 		/* Additive operators */
 
-		case OP_ADD:
+		VMCASE(OP_ADD):
 			js_concat(J);
-			break;
+			VMNEXT;
 
-		case OP_SUB:
+		VMCASE(OP_SUB):
 			x = js_tonumber(J, -2);
 			y = js_tonumber(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, x - y);
-			break;
+			VMNEXT;
 
 		/* Shift operators */
 
-		case OP_SHL:
+		VMCASE(OP_SHL):
 			ix = js_toint32(J, -2);
 			uy = js_touint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix << (uy & 0x1F));
-			break;
+			VMNEXT;
 
-		case OP_SHR:
+		VMCASE(OP_SHR):
 			ix = js_toint32(J, -2);
 			uy = js_touint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix >> (uy & 0x1F));
-			break;
+			VMNEXT;
 
-		case OP_USHR:
+		VMCASE(OP_USHR):
 			ux = js_touint32(J, -2);
 			uy = js_touint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ux >> (uy & 0x1F));
-			break;
+			VMNEXT;
 
 		/* Relational operators */
 
-		case OP_LT: b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b < 0); break;
-		case OP_GT: b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b > 0); break;
-		case OP_LE: b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b <= 0); break;
-		case OP_GE: b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b >= 0); break;
+		VMCASE(OP_LT): b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b < 0); VMNEXT;
+		VMCASE(OP_GT): b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b > 0); VMNEXT;
+		VMCASE(OP_LE): b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b <= 0); VMNEXT;
+		VMCASE(OP_GE): b = js_compare(J, &okay); js_pop(J, 2); js_pushboolean(J, okay && b >= 0); VMNEXT;
 
-		case OP_INSTANCEOF:
+		VMCASE(OP_INSTANCEOF):
 			b = js_instanceof(J);
 			js_pop(J, 2);
 			js_pushboolean(J, b);
-			break;
+			VMNEXT;
 
 		/* Equality */
 
-		case OP_EQ: b = js_equal(J); js_pop(J, 2); js_pushboolean(J, b); break;
-		case OP_NE: b = js_equal(J); js_pop(J, 2); js_pushboolean(J, !b); break;
-		case OP_STRICTEQ: b = js_strictequal(J); js_pop(J, 2); js_pushboolean(J, b); break;
-		case OP_STRICTNE: b = js_strictequal(J); js_pop(J, 2); js_pushboolean(J, !b); break;
+		VMCASE(OP_EQ): b = js_equal(J); js_pop(J, 2); js_pushboolean(J, b); VMNEXT;
+		VMCASE(OP_NE): b = js_equal(J); js_pop(J, 2); js_pushboolean(J, !b); VMNEXT;
+		VMCASE(OP_STRICTEQ): b = js_strictequal(J); js_pop(J, 2); js_pushboolean(J, b); VMNEXT;
+		VMCASE(OP_STRICTNE): b = js_strictequal(J); js_pop(J, 2); js_pushboolean(J, !b); VMNEXT;
 
-		case OP_JCASE:
+		VMCASE(OP_JCASE):
 			offset = *pc++;
 			b = js_strictequal(J);
 			if (b) {
@@ -1783,50 +2403,50 @@ static void jsR_run(js_State *J, js_Function *F)
 			} else {
 				js_pop(J, 1);
 			}
-			break;
+			VMNEXT;
 
 		/* Binary bitwise operators */
 
-		case OP_BITAND:
+		VMCASE(OP_BITAND):
 			ix = js_toint32(J, -2);
 			iy = js_toint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix & iy);
-			break;
+			VMNEXT;
 
-		case OP_BITXOR:
+		VMCASE(OP_BITXOR):
 			ix = js_toint32(J, -2);
 			iy = js_toint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix ^ iy);
-			break;
+			VMNEXT;
 
-		case OP_BITOR:
+		VMCASE(OP_BITOR):
 			ix = js_toint32(J, -2);
 			iy = js_toint32(J, -1);
 			js_pop(J, 2);
 			js_pushnumber(J, ix | iy);
-			break;
+			VMNEXT;
 
 		/* Try and Catch */
 
-		case OP_THROW:
+		VMCASE(OP_THROW):
 			js_throw(J);
 
-		case OP_TRY:
+		VMCASE(OP_TRY):
 			offset = *pc++;
 			if (js_trypc(J, pc)) {
 				pc = J->trybuf[J->trytop].pc;
 			} else {
 				pc = pcstart + offset;
 			}
-			break;
+			VMNEXT;
 
-		case OP_ENDTRY:
+		VMCASE(OP_ENDTRY):
 			js_endtry(J);
-			break;
+			VMNEXT;
 
-		case OP_CATCH:
+		VMCASE(OP_CATCH):
 			READSTRING();
 			obj = jsV_newobject(J, JS_COBJECT, NULL);
 			js_pushobject(J, obj);
@@ -1834,53 +2454,127 @@ static void jsR_run(js_State *J, js_Function *F)
 			js_setproperty(J, -2, str);
 			J->E = jsR_newenvironment(J, obj, J->E);
 			js_pop(J, 1);
-			break;
+			VMNEXT;
 
-		case OP_ENDCATCH:
+		VMCASE(OP_ENDCATCH):
 			J->E = J->E->outer;
-			break;
+			VMNEXT;
 
 		/* With */
 
-		case OP_WITH:
+		VMCASE(OP_WITH):
 			obj = js_toobject(J, -1);
 			J->E = jsR_newenvironment(J, obj, J->E);
 			js_pop(J, 1);
-			break;
+			VMNEXT;
 
-		case OP_ENDWITH:
+		VMCASE(OP_ENDWITH):
 			J->E = J->E->outer;
-			break;
+			VMNEXT;
 
 		/* Branching */
 
-		case OP_DEBUGGER:
+		VMCASE(OP_DEBUGGER):
 			js_trap(J, (int)(pc - pcstart) - 1);
-			break;
+			VMNEXT;
 
-		case OP_JUMP:
+		VMCASE(OP_JUMP):
 			pc = pcstart + *pc;
-			break;
+			VMPOLL();
+			VMNEXT;
 
-		case OP_JTRUE:
+		VMCASE(OP_JTRUE):
 			offset = *pc++;
 			b = js_toboolean(J, -1);
 			js_pop(J, 1);
-			if (b)
+			if (b) {
 				pc = pcstart + offset;
-			break;
+				VMPOLL();
+			}
+			VMNEXT;
 
-		case OP_JFALSE:
+		VMCASE(OP_JFALSE):
 			offset = *pc++;
 			b = js_toboolean(J, -1);
 			js_pop(J, 1);
-			if (!b)
+			if (!b) {
 				pc = pcstart + offset;
-			break;
+				VMPOLL();
+			}
+			VMNEXT;
 
-		case OP_RETURN:
+		VMCASE(OP_RETURN):
 			J->strict = savestrict;
 			return;
+
+		VMCASE(OP_GETMETHOD_S):
+			READSTRING();
+			js_dup(J);
+			if (js_isstring(J, -1) && jsR_getstringproperty(J, str, &CT[*pc])) {
+				pc++;
+			} else {
+				obj = js_toobject(J, -1);
+				jsR_getcachedproperty(J, obj, str, &CT[*pc++]);
+				js_rot2pop1(J);
+			}
+			js_rot2(J);
+			VMNEXT;
+
+		VMCASE(OP_ADDLOCALS):
+			if (lightweight || slotted) {
+				const js_Value *a = lightweight ? &STACK[BOT + pc[0]] : &J->E->slots[pc[0] - 1];
+				const js_Value *c = lightweight ? &STACK[BOT + pc[1]] : &J->E->slots[pc[1] - 1];
+				if (JSV_TYPE(a) == JS_TNUMBER && JSV_TYPE(c) == JS_TNUMBER) {
+					js_pushnumber(J, JSV_NUMBER(a) + JSV_NUMBER(c));
+				} else {
+					CHECKSTACK(2);
+					STACK[TOP++] = *a;
+					STACK[TOP++] = *c;
+					js_concat(J);
+				}
+			} else {
+				if (!js_hasvar(J, VT[pc[0]]))
+					js_referenceerror(J, "'%s' is not defined", VT[pc[0]]);
+				if (!js_hasvar(J, VT[pc[1]]))
+					js_referenceerror(J, "'%s' is not defined", VT[pc[1]]);
+				js_concat(J);
+			}
+			pc += 2;
+			VMNEXT;
+
+		VMCASE(OP_JNLTLOCAL):
+			if (lightweight || slotted) {
+				const js_Value *a = lightweight ? &STACK[BOT + pc[0]] : &J->E->slots[pc[0] - 1];
+				if (JSV_TYPE(a) == JS_TNUMBER) {
+					b = JSV_NUMBER(a) < pc[1] - 32768;
+				} else {
+					CHECKSTACK(1);
+					STACK[TOP++] = *a;
+					js_pushnumber(J, pc[1] - 32768);
+					b = js_compare(J, &okay);
+					js_pop(J, 2);
+					b = okay && b < 0;
+				}
+			} else {
+				if (!js_hasvar(J, VT[pc[0]]))
+					js_referenceerror(J, "'%s' is not defined", VT[pc[0]]);
+				js_pushnumber(J, pc[1] - 32768);
+				b = js_compare(J, &okay);
+				js_pop(J, 2);
+				b = okay && b < 0;
+			}
+			if (b) {
+				pc += 3;
+			} else {
+				pc = pcstart + pc[2];
+				VMPOLL();
+			}
+			VMNEXT;
 		}
 	}
+
+#undef VMCASE
+#undef VMNEXT
+#undef VMDISPATCH
+#undef VMPOLL
 }
@@ -2,14 +2,24 @@
 #define js_run_h
 
 js_Environment *jsR_newenvironment(js_State *J, js_Object *variables, js_Environment *outer);
+js_Environment *jsR_newslotenvironment(js_State *J, js_Function *function, js_Environment *outer);
+
+/*
+	An environment record either keeps its variables as properties of an
+	object (global code, with, catch, and functions using eval or with),
+	or in an array of slots indexed like the vartab of the function.
+*/
 
 struct js_Environment
 {
 	js_Environment *outer;
-	js_Object *variables;
+	js_Object *variables; /* NULL if the variables are in slots */
+	js_Function *function; /* slot names */
 
 	js_Environment *gcnext;
 	int gcmark;
+
+	js_Value slots[1];
 };
 
 #endif
@@ -0,0 +1,464 @@
+#include "jsi.h"
+#include "jscompile.h"
+#include "jsvalue.h"
+#include "jsrun.h"
+
+#include "regexp.h"
+
+/*
+	State snapshots.
+
+	Setting up the builtins and the native modules of an embedding takes
+	thousands of property definitions. js_newstatefrom skips all of that by
+	copying the object graph that is reachable from the globals and the
+	registry of a template state, which was set up the usual way once.
+
+	Copies share the interned strings of the template, so property names
+	and the string constants in bytecode are used as they are, and property
+	trees are copied node by node without comparing names or rebalancing.
+	Native data of userdata and C functions is shared as well and stays
+	owned by the template; the copies do not get its finalizers. The
+	template must outlive its copies and stay idle while they run.
+
+	Objects, environments, functions and ropes are allocated and entered in
+	a pointer map when first seen, and filled in from a work list, so that
+	long chains of objects do not recurse on the C stack.
+*/
+
+enum { CLONE_OBJECT, CLONE_ENVIRONMENT, CLONE_FUNCTION, CLONE_ROPE };
+
+typedef struct { const void *from; void *to; } js_CloneSlot;
+typedef struct { int kind; const void *from; void *to; } js_CloneWork;
+
+typedef struct
+{
+	js_Property *leaf; /* the empty property tree, shared by all objects */
+	unsigned int mapmask;
+	js_CloneSlot *map;
+	int worklen, workcap;
+	js_CloneWork *work;
+} js_Clone;
+
+static unsigned int clonehash(const void *p)
+{
+	uintptr_t h = (uintptr_t)p;
+	h ^= h >> 16;
+	h *= 0x45d9f3b;
+	h ^= h >> 16;
+	return (unsigned int)h;
+}
+
+static js_CloneSlot *clonefind(js_Clone *C, const void *from)
+{
+	unsigned int i = clonehash(from) & C->mapmask;
+	while (C->map[i].from && C->map[i].from != from)
+		i = (i + 1) & C->mapmask;
+	return &C->map[i];
+}
+
+static void clonequeue(js_State *J, js_Clone *C, int kind, const void *from, void *to)
+{
+	js_CloneSlot *slot = clonefind(C, from);
+	slot->from = from;
+	slot->to = to;
+	if (C->worklen == C->workcap) {
+		C->workcap = C->workcap ? C->workcap * 2 : 256;
+		C->work = js_realloc(J, C->work, C->workcap * sizeof *C->work);
+	}
+	C->work[C->worklen].kind = kind;
+	C->work[C->worklen].from = from;
+	C->work[C->worklen].to = to;
+	++C->worklen;
+}
+
+static js_String *clonestring(js_State *J, js_Clone *C, js_String *from)
+{
+	js_CloneSlot *slot = clonefind(C, from);
+	js_String *to;
+	if (slot->from)
+		return slot->to;
+	to = jsV_newmemstring(J, from->p, strlen(from->p));
+	to->length = from->length;
+	to->ascii = from->ascii;
+	slot->from = from;
+	slot->to = to;
+	return to;
+}
+
+static js_Rope *clonerope(js_State *J, js_Clone *C, js_Rope *from)
+{
+	js_CloneSlot *slot = clonefind(C, from);
+	js_Rope *to;
+	if (slot->from)
+		return slot->to;
+	to = js_malloc(J, sizeof *to);
+	*to = *from;
+	JSV_SETUNDEFINED(&to->left);
+	JSV_SETUNDEFINED(&to->right);
+	to->flat = NULL;
+	to->gcmark = 0;
+	to->gcnext = J->gcrope;
+	J->gcrope = to;
+	++J->gccounter;
+	clonequeue(J, C, CLONE_ROPE, from, to);
+	return to;
+}
+
+static js_Object *cloneobject(js_State *J, js_Clone *C, js_Object *from)
+{
+	js_CloneSlot *slot;
+	js_Object *to;
+
+	if (!from)
+		return NULL;
+	slot = clonefind(C, from);
+	if (slot->from)
+		return slot->to;
+
+	/* a shallow copy that is safe to free until it is filled in */
+	to = js_malloc(J, sizeof *to);
+	*to = *from;
+	to->properties = C->leaf;
+	to->prototype = NULL;
+	switch (to->type) {
+	default: break;
+	case JS_CARRAY:
+		to->u.a.array = NULL;
+		to->u.a.flat_length = to->u.a.flat_capacity = 0;
+		break;
+	case JS_CFUNCTION:
+	case JS_CSCRIPT:
+		to->u.f.function = NULL;
+		to->u.f.scope = NULL;
+		break;
+	case JS_CSTRING:
+		to->u.s.memstr = NULL;
+		break;
+	case JS_CREGEXP:
+		to->u.r.prog = NULL;
+		to->u.r.source = NULL;
+		break;
+	case JS_CITERATOR:
+		to->u.iter.target = NULL;
+		to->u.iter.head = NULL;
+		break;
+	case JS_CCFUNCTION:
+		to->u.c.finalize = NULL;
+		break;
+	case JS_CUSERDATA:
+		to->u.user.finalize = NULL;
+		break;
+	}
+	to->gcmark = 0;
+	to->gcroot = NULL;
+	to->gcnext = J->gcobj;
+	J->gcobj = to;
+	++J->gccounter;
+
+	clonequeue(J, C, CLONE_OBJECT, from, to);
+	return to;
+}
+
+static js_Function *clonefunction(js_State *J, js_Clone *C, js_Function *from)
+{
+	js_CloneSlot *slot = clonefind(C, from);
+	js_Function *to;
+	if (slot->from)
+		return slot->to;
+	to = js_malloc(J, sizeof *to);
+	*to = *from;
+	to->code = NULL;
+	to->linetab = NULL;
+	to->funtab = NULL;
+	to->vartab = NULL;
+	to->cachetab = NULL;
+	to->parent = NULL;
+	to->parentscope = to->scope = NULL;
+	to->opcount = 0;
+	to->gcmark = 0;
+	to->gcnext = J->gcfun;
+	J->gcfun = to;
+	++J->gccounter;
+	clonequeue(J, C, CLONE_FUNCTION, from, to);
+	return to;
+}
+
+static js_Environment *cloneenvironment(js_State *J, js_Clone *C, js_Environment *from)
+{
+	js_CloneSlot *slot;
+	js_Environment *to;
+	int i, size;
+
+	if (!from)
+		return NULL;
+	slot = clonefind(C, from);
+	if (slot->from)
+		return slot->to;
+
+	size = sizeof *to;
+	if (!from->variables)
+		size = soffsetof(js_Environment, slots) + from->function->varlen * sizeof(js_Value);
+	to = js_malloc(J, size);
+	to->outer = NULL;
+	to->variables = NULL;
+	to->function = NULL;
+	if (!from->variables)
+		for (i = 0; i < from->function->varlen; ++i)
+			JSV_SETUNDEFINED(&to->slots[i]);
+	to->gcmark = 0;
+	to->gcnext = J->gcenv;
+	J->gcenv = to;
+	++J->gccounter;
+	clonequeue(J, C, CLONE_ENVIRONMENT, from, to);
+	return to;
+}
+
+static void clonevalue(js_State *J, js_Clone *C, js_Value *to, const js_Value *from)
+{
+	switch (JSV_TYPE(from)) {
+	default: *to = *from; break;
+	case JS_TMEMSTR: JSV_SETMEMSTR(to, clonestring(J, C, JSV_MEMSTR(from))); break;
+	case JS_TROPE: JSV_SETROPE(to, clonerope(J, C, JSV_ROPE(from))); break;
+	case JS_TOBJECT: JSV_SETOBJECT(to, cloneobject(J, C, JSV_OBJECT(from))); break;
+	}
+}
+
+/* Each node is linked in before its children are copied, so a partial tree can be freed */
+static void cloneproperty(js_State *J, js_Clone *C, js_Property **link, js_Property *from)
+{
+	js_Property *to = js_malloc(J, sizeof *to);
+	*to = *from;
+	to->left = to->right = C->leaf;
+	JSV_SETUNDEFINED(&to->value);
+	to->getter = to->setter = NULL;
+	*link = to;
+
+	clonevalue(J, C, &to->value, &from->value);
+	to->getter = cloneobject(J, C, from->getter);
+	to->setter = cloneobject(J, C, from->setter);
+	if (from->left->level)
+		cloneproperty(J, C, &to->left, from->left);
+	if (from->right->level)
+		cloneproperty(J, C, &to->right, from->right);
+}
+
+static void clonefillobject(js_State *J, js_Clone *C, js_Object *to, const js_Object *from)
+{
+	js_Iterator *it, **tail;
+	const char *error;
+	int i, opts;
+
+	to->prototype = cloneobject(J, C, from->prototype);
+	if (from->properties->level)
+		cloneproperty(J, C, &to->properties, from->properties);
+
+	switch (from->type) {
+	default: break;
+	case JS_CARRAY:
+		if (from->u.a.simple && from->u.a.flat_capacity > 0) {
+			to->u.a.array = js_malloc(J, from->u.a.flat_capacity * sizeof(js_Value));
+			to->u.a.flat_capacity = from->u.a.flat_capacity;
+			for (i = 0; i < from->u.a.flat_length; ++i) {
+				clonevalue(J, C, &to->u.a.array[i], &from->u.a.array[i]);
+				to->u.a.flat_length = i + 1;
+			}
+		}
+		break;
+	case JS_CFUNCTION:
+	case JS_CSCRIPT:
+		to->u.f.function = from->u.f.function ? clonefunction(J, C, from->u.f.function) : NULL;
+		to->u.f.scope = cloneenvironment(J, C, from->u.f.scope);
+		break;
+	case JS_CSTRING:
+		if (from->u.s.memstr) {
+			to->u.s.memstr = clonestring(J, C, from->u.s.memstr);
+			to->u.s.string = to->u.s.memstr->p + (from->u.s.string - from->u.s.memstr->p);
+		}
+		break;
+	case JS_CREGEXP:
+		opts = 0;
+		if (from->u.r.flags & JS_REGEXP_I) opts |= REG_ICASE;
+		if (from->u.r.flags & JS_REGEXP_M) opts |= REG_NEWLINE;
+		to->u.r.source = js_strdup(J, from->u.r.source);
+		to->u.r.prog = js_regcompx(J->alloc, J->actx, from->u.r.source, opts, &error);
+		if (!to->u.r.prog)
+			js_syntaxerror(J, "regular expression: %s", error);
+		break;
+	case JS_CITERATOR:
+		to->u.iter.target = cloneobject(J, C, from->u.iter.target);
+		tail = &to->u.iter.head;
+		for (it = from->u.iter.head; it; it = it->next) {
+			*tail = js_malloc(J, sizeof **tail);
+			(*tail)->name = it->name;
+			(*tail)->next = NULL;
+			tail = &(*tail)->next;
+		}
+		break;
+	}
+}
+
+static void clonefillfunction(js_State *J, js_Clone *C, js_Function *to, const js_Function *from)
+{
+	int i;
+
+	to->code = js_malloc(J, from->codelen * sizeof *to->code);
+	memcpy(to->code, from->code, from->codelen * sizeof *to->code);
+	to->codecap = from->codelen;
+
+	if (from->linelen > 0) {
+		to->linetab = js_malloc(J, from->linelen * sizeof *to->linetab);
+		memcpy(to->linetab, from->linetab, from->linelen * sizeof *to->linetab);
+	}
+	to->linecap = from->linelen;
+
+	/* names are interned in the template, whose string table the copy shares */
+	if (from->varlen > 0) {
+		to->vartab = js_malloc(J, from->varlen * sizeof *to->vartab);
+		memcpy(to->vartab, from->vartab, from->varlen * sizeof *to->vartab);
+	}
+	to->varcap = from->varlen;
+
+	if (from->cachelen > 0) {
+		to->cachetab = js_malloc(J, from->cachelen * sizeof *to->cachetab);
+		memset(to->cachetab, 0, from->cachelen * sizeof *to->cachetab);
+	}
+
+	to->funlen = 0;
+	to->funcap = from->funlen;
+	if (from->funlen > 0) {
+		to->funtab = js_malloc(J, from->funlen * sizeof *to->funtab);
+		for (i = 0; i < from->funlen; ++i) {
+			to->funtab[i] = clonefunction(J, C, from->funtab[i]);
+			to->funlen = i + 1;
+		}
+	}
+}
+
+static void clonefillenvironment(js_State *J, js_Clone *C, js_Environment *to, const js_Environment *from)
+{
+	int i;
+	to->outer = cloneenvironment(J, C, from->outer);
+	to->variables = cloneobject(J, C, from->variables);
+	to->function = from->function ? clonefunction(J, C, from->function) : NULL;
+	if (!from->variables)
+		for (i = 0; i < from->function->varlen; ++i)
+			clonevalue(J, C, &to->slots[i], &from->slots[i]);
+}
+
+static void clonefillrope(js_State *J, js_Clone *C, js_Rope *to, const js_Rope *from)
+{
+	clonevalue(J, C, &to->left, &from->left);
+	clonevalue(J, C, &to->right, &from->right);
+	to->flat = from->flat ? clonestring(J, C, from->flat) : NULL;
+}
+
+static int clonecount(js_State *T)
+{
+	js_Environment *env;
+	js_Function *fun;
+	js_Object *obj;
+	js_String *str;
+	js_Rope *rope;
+	int n = 0;
+	for (env = T->gcenv; env; env = env->gcnext) ++n;
+	for (fun = T->gcfun; fun; fun = fun->gcnext) ++n;
+	for (obj = T->gcobj; obj; obj = obj->gcnext) ++n;
+	for (str = T->gcstr; str; str = str->gcnext) ++n;
+	for (rope = T->gcrope; rope; rope = rope->gcnext) ++n;
+	return n;
+}
+
+static void clonestate(js_State *J, js_Clone *C, js_State *T)
+{
+	unsigned int cap = 64;
+	int n = clonecount(T);
+
+	while (cap < (unsigned int)n * 2)
+		cap <<= 1;
+	C->map = js_malloc(J, cap * sizeof *C->map);
+	memset(C->map, 0, cap * sizeof *C->map);
+	C->mapmask = cap - 1;
+
+	C->leaf = T->G->properties;
+	while (C->leaf->level)
+		C->leaf = C->leaf->left;
+
+	J->Object_prototype = cloneobject(J, C, T->Object_prototype);
+	J->Array_prototype = cloneobject(J, C, T->Array_prototype);
+	J->Function_prototype = cloneobject(J, C, T->Function_prototype);
+	J->Boolean_prototype = cloneobject(J, C, T->Boolean_prototype);
+	J->Number_prototype = cloneobject(J, C, T->Number_prototype);
+	J->String_prototype = cloneobject(J, C, T->String_prototype);
+	J->RegExp_prototype = cloneobject(J, C, T->RegExp_prototype);
+	J->Date_prototype = cloneobject(J, C, T->Date_prototype);
+
+	J->Error_prototype = cloneobject(J, C, T->Error_prototype);
+	J->EvalError_prototype = cloneobject(J, C, T->EvalError_prototype);
+	J->RangeError_prototype = cloneobject(J, C, T->RangeError_prototype);
+	J->ReferenceError_prototype = cloneobject(J, C, T->ReferenceError_prototype);
+	J->SyntaxError_prototype = cloneobject(J, C, T->SyntaxError_prototype);
+	J->TypeError_prototype = cloneobject(J, C, T->TypeError_prototype);
+	J->URIError_prototype = cloneobject(J, C, T->URIError_prototype);
+
+	J->R = cloneobject(J, C, T->R);
+	J->G = cloneobject(J, C, T->G);
+	J->GE = J->E = cloneenvironment(J, C, T->GE);
+
+	while (C->worklen > 0) {
+		js_CloneWork w = C->work[--C->worklen];
+		switch (w.kind) {
+		case CLONE_OBJECT: clonefillobject(J, C, w.to, w.from); break;
+		case CLONE_ENVIRONMENT: clonefillenvironment(J, C, w.to, w.from); break;
+		case CLONE_FUNCTION: clonefillfunction(J, C, w.to, w.from); break;
+		case CLONE_ROPE: clonefillrope(J, C, w.to, w.from); break;
+		}
+	}
+
+	J->seed = T->seed;
+	J->shapeseq = T->shapeseq;
+	J->nextref = T->nextref;
+	J->uctx = T->uctx;
+	J->report = T->report;
+	J->panic = T->panic;
+}
+
+static void clonefree(js_State *J, js_Clone *C)
+{
+	js_free(J, C->map);
+	js_free(J, C->work);
+	js_free(J, C);
+}
+
+js_State *js_newstatefrom(js_State *T, js_Alloc alloc, void *actx, int flags)
+{
+	js_Clone *C;
+	js_State *J;
+
+	J = js_newemptystate(alloc, actx, flags);
+	if (!J)
+		return NULL;
+
+	/* not on the C stack, so that it is intact after an error longjmps here */
+	C = J->alloc(J->actx, NULL, sizeof *C);
+	if (!C) {
+		js_freestate(J);
+		return NULL;
+	}
+	memset(C, 0, sizeof *C);
+
+	J->snapshot = T;
+	++J->gcpause;
+
+	if (js_try(J)) {
+		clonefree(J, C);
+		js_freestate(J);
+		return NULL;
+	}
+
+	clonestate(J, C, T);
+
+	js_endtry(J);
+	clonefree(J, C);
+	--J->gcpause;
+	return J;
+}
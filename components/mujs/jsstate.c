@@ -10,8 +10,7 @@
 
 static int js_ptry(js_State *J) {
 	if (J->trytop == JS_TRYLIMIT) {
-		J->stack[J->top].type = JS_TLITSTR;
-		J->stack[J->top].u.litstr = "exception stack overflow";
+		JSV_SETLITSTR(&J->stack[J->top], "exception stack overflow");
 		++J->top;
 		return 1;
 	}
@@ -202,16 +201,20 @@ void js_loadfile(js_State *J, const char *filename)
 		js_throw(J);
 	}
 
-	/* skip first line if it starts with "#!" */
-	p = s;
-	if (p[0] == '#' && p[1] == '!') {
-		p += 2;
-		while (*p && *p != '\n')
-			++p;
+	if (js_isbytecode(s, n)) {
+		js_loadbytecode(J, filename, s, n);
+	} else {
+		/* skip first line if it starts with "#!" */
+		p = s;
+		if (p[0] == '#' && p[1] == '!') {
+			p += 2;
+			while (*p && *p != '\n')
+				++p;
+		}
+
+		js_loadstring(J, filename, p);
 	}
 
-	js_loadstring(J, filename, p);
-
 	js_free(J, s);
 	fclose(f);
 	js_endtry(J);
@@ -285,12 +288,17 @@ void *js_getcontext(js_State *J)
 	return J->uctx;
 }
 
-js_State *js_newstate(js_Alloc alloc, void *actx, int flags)
+/* A state with a stack but no objects yet */
+js_State *js_newemptystate(js_Alloc alloc, void *actx, int flags)
 {
 	js_State *J;
 
+#ifdef JS_NANBOX
+	assert(sizeof(js_Value) == 8);
+#else
 	assert(sizeof(js_Value) == 16);
 	assert(soffsetof(js_Value, type) == 15);
+#endif
 
 	if (!alloc)
 		alloc = js_defaultalloc;
@@ -304,10 +312,14 @@ js_State *js_newstate(js_Alloc alloc, void *actx, int flags)
 
 	if (flags & JS_STRICT)
 		J->strict = J->default_strict = 1;
+	if (flags & JS_GCINCREMENTAL)
+		J->gcincremental = 1;
+	J->gcstep = JS_GCSTEPSIZE;
 
 	J->trace[0].name = "-top-";
 	J->trace[0].file = "native";
 	J->trace[0].line = 0;
+	J->trace[0].function = NULL;
 
 	J->report = js_defaultreport;
 	J->panic = js_defaultpanic;
@@ -322,6 +334,17 @@ js_State *js_newstate(js_Alloc alloc, void *actx, int flags)
 	J->nextref = 0;
 	J->gcthresh = 0; /* reaches stability within ~ 2-5 GC cycles */
 
+	return J;
+}
+
+js_State *js_newstate(js_Alloc alloc, void *actx, int flags)
+{
+	js_State *J;
+
+	J = js_newemptystate(alloc, actx, flags);
+	if (!J)
+		return NULL;
+
 	if (js_try(J)) {
 		js_freestate(J);
 		return NULL;
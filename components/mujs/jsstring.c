@@ -63,6 +63,95 @@ int js_utfptrtoidx(const char *s, const char *p)
 	return i;
 }
 
+/*
+	Strings built at run time (js_String) measure themselves on first use.
+	Pure ASCII strings are then indexed directly, others through an index
+	holding the byte offset of every JS_UTFINDEXSTEP'th character, so that
+	s.charCodeAt(i) in a loop does not walk the string from the start.
+*/
+
+static void js_measurestring(js_String *str)
+{
+	const char *s = str->p;
+	int n = 0;
+	Rune rune;
+
+	while (*(unsigned char *)s && *(unsigned char *)s < Runeself)
+		++s;
+	n = s - str->p;
+	str->ascii = !*s;
+
+	while (*s) {
+		if (*(unsigned char *)s < Runeself)
+			++s;
+		else
+			s += chartorune(&rune, s);
+		++n;
+	}
+
+	str->length = n;
+}
+
+static void js_indexstring(js_State *J, js_String *str)
+{
+	int n = str->length / JS_UTFINDEXSTEP + 1;
+	int *index = js_malloc(J, n * sizeof *index);
+	const char *s = str->p;
+	Rune rune;
+	int i;
+
+	for (i = 0; ; ++i) {
+		if (i % JS_UTFINDEXSTEP == 0) {
+			index[i / JS_UTFINDEXSTEP] = s - str->p;
+			if (i / JS_UTFINDEXSTEP == n - 1)
+				break;
+		}
+		if (*(unsigned char *)s < Runeself)
+			++s;
+		else
+			s += chartorune(&rune, s);
+	}
+
+	str->index = index;
+}
+
+int js_stringlength(js_String *str)
+{
+	if (str->length < 0)
+		js_measurestring(str);
+	return str->length;
+}
+
+/* Pointer to character i (the terminator if i is the length), NULL if out of range */
+const char *js_stringidxtoptr(js_State *J, js_String *str, int i)
+{
+	int k;
+
+	if (i < 0 || i > js_stringlength(str))
+		return NULL;
+	if (str->ascii)
+		return str->p + i;
+	if (i < JS_UTFINDEXSTEP)
+		return js_utfidxtoptr(str->p, i);
+
+	if (!str->index)
+		js_indexstring(J, str);
+	k = i / JS_UTFINDEXSTEP;
+	return js_utfidxtoptr(str->p + str->index[k], i - k * JS_UTFINDEXSTEP);
+}
+
+int js_stringruneat(js_State *J, js_String *str, int i)
+{
+	Rune rune;
+
+	if (i < 0 || i >= js_stringlength(str))
+		return EOF;
+	if (str->ascii)
+		return *(unsigned char *)(str->p + i);
+	chartorune(&rune, js_stringidxtoptr(J, str, i));
+	return rune;
+}
+
 static void jsB_new_String(js_State *J)
 {
 	js_newstring(J, js_gettop(J) > 1 ? js_tostring(J, 1) : "");
@@ -73,26 +162,38 @@ static void jsB_String(js_State *J)
 	js_pushstring(J, js_gettop(J) > 1 ? js_tostring(J, 1) : "");
 }
 
+static void pushstringof(js_State *J, js_Object *self)
+{
+	if (self->u.s.memstr) {
+		js_Value v;
+		JSV_SETMEMSTR(&v, self->u.s.memstr);
+		js_pushvalue(J, v);
+	} else {
+		js_pushliteral(J, self->u.s.string);
+	}
+}
+
 static void Sp_toString(js_State *J)
 {
 	js_Object *self = js_toobject(J, 0);
 	if (self->type != JS_CSTRING) js_typeerror(J, "not a string");
-	js_pushliteral(J, self->u.s.string);
+	pushstringof(J, self);
 }
 
 static void Sp_valueOf(js_State *J)
 {
 	js_Object *self = js_toobject(J, 0);
 	if (self->type != JS_CSTRING) js_typeerror(J, "not a string");
-	js_pushliteral(J, self->u.s.string);
+	pushstringof(J, self);
 }
 
 static void Sp_charAt(js_State *J)
 {
 	char buf[UTFmax + 1];
-	const char *s = checkstring(J, 0);
-	int pos = js_tointeger(J, 1);
-	Rune rune = js_runeat(J, s, pos);
+	int pos, rune;
+	checkstring(J, 0);
+	pos = js_tointeger(J, 1);
+	rune = jsV_runeat(J, js_tovalue(J, 0), pos);
 	if (rune >= 0) {
 		buf[runetochar(buf, &rune)] = 0;
 		js_pushstring(J, buf);
@@ -103,9 +204,10 @@ static void Sp_charAt(js_State *J)
 
 static void Sp_charCodeAt(js_State *J)
 {
-	const char *s = checkstring(J, 0);
-	int pos = js_tointeger(J, 1);
-	Rune rune = js_runeat(J, s, pos);
+	int pos, rune;
+	checkstring(J, 0);
+	pos = js_tointeger(J, 1);
+	rune = jsV_runeat(J, js_tovalue(J, 0), pos);
 	if (rune >= 0)
 		js_pushnumber(J, rune);
 	else
@@ -194,11 +296,13 @@ static void Sp_localeCompare(js_State *J)
 
 static void Sp_slice(js_State *J)
 {
-	const char *str = checkstring(J, 0);
 	const char *ss, *ee;
-	int len = utflen(str);
-	int s = js_tointeger(J, 1);
-	int e = js_isdefined(J, 2) ? js_tointeger(J, 2) : len;
+	int len, s, e;
+
+	checkstring(J, 0);
+	len = jsV_stringlength(J, js_tovalue(J, 0));
+	s = js_tointeger(J, 1);
+	e = js_isdefined(J, 2) ? js_tointeger(J, 2) : len;
 
 	s = s < 0 ? s + len : s;
 	e = e < 0 ? e + len : e;
@@ -207,10 +311,10 @@ static void Sp_slice(js_State *J)
 	e = e < 0 ? 0 : e > len ? len : e;
 
 	if (s < e) {
-		ss = js_utfidxtoptr(str, s);
+		ss = jsV_utfidxtoptr(J, js_tovalue(J, 0), s);
 		ee = js_utfidxtoptr(ss, e - s);
 	} else {
-		ss = js_utfidxtoptr(str, e);
+		ss = jsV_utfidxtoptr(J, js_tovalue(J, 0), e);
 		ee = js_utfidxtoptr(ss, s - e);
 	}
 
@@ -219,20 +323,22 @@ static void Sp_slice(js_State *J)
 
 static void Sp_substring(js_State *J)
 {
-	const char *str = checkstring(J, 0);
 	const char *ss, *ee;
-	int len = utflen(str);
-	int s = js_tointeger(J, 1);
-	int e = js_isdefined(J, 2) ? js_tointeger(J, 2) : len;
+	int len, s, e;
+
+	checkstring(J, 0);
+	len = jsV_stringlength(J, js_tovalue(J, 0));
+	s = js_tointeger(J, 1);
+	e = js_isdefined(J, 2) ? js_tointeger(J, 2) : len;
 
 	s = s < 0 ? 0 : s > len ? len : s;
 	e = e < 0 ? 0 : e > len ? len : e;
 
 	if (s < e) {
-		ss = js_utfidxtoptr(str, s);
+		ss = jsV_utfidxtoptr(J, js_tovalue(J, 0), s);
 		ee = js_utfidxtoptr(ss, e - s);
 	} else {
-		ss = js_utfidxtoptr(str, e);
+		ss = jsV_utfidxtoptr(J, js_tovalue(J, 0), e);
 		ee = js_utfidxtoptr(ss, s - e);
 	}
 
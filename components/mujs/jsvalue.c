@@ -4,8 +4,9 @@
 #include "jsvalue.h"
 #include "utf.h"
 
-#define JSV_ISSTRING(v) (v->type==JS_TSHRSTR || v->type==JS_TMEMSTR || v->type==JS_TLITSTR)
-#define JSV_TOSTRING(v) (v->type==JS_TSHRSTR ? v->u.shrstr : v->type==JS_TLITSTR ? v->u.litstr : v->type==JS_TMEMSTR ? v->u.memstr->p : "")
+#define JSV_ISSTRING(v) (JSV_TYPE(v)==JS_TSHRSTR || JSV_TYPE(v)==JS_TMEMSTR || JSV_TYPE(v)==JS_TLITSTR || JSV_TYPE(v)==JS_TROPE)
+#define JSV_TOSTRING(v) (JSV_TYPE(v)==JS_TSHRSTR ? JSV_SHRSTR(v) : JSV_TYPE(v)==JS_TLITSTR ? JSV_LITSTR(v) : JSV_TYPE(v)==JS_TMEMSTR ? JSV_MEMSTR(v)->p : "")
+#define JSV_FLATTEN(J, v) (JSV_TYPE(v)==JS_TROPE ? (void)jsV_tostring(J, v) : (void)0)
 
 double js_strtol(const char *s, char **p, int base)
 {
@@ -121,10 +122,10 @@ void jsV_toprimitive(js_State *J, js_Value *v, int preferred)
 {
 	js_Object *obj;
 
-	if (v->type != JS_TOBJECT)
+	if (JSV_TYPE(v) != JS_TOBJECT)
 		return;
 
-	obj = v->u.object;
+	obj = JSV_OBJECT(v);
 
 	if (preferred == JS_HNONE)
 		preferred = obj->type == JS_CDATE ? JS_HSTRING : JS_HNUMBER;
@@ -146,23 +147,23 @@ void jsV_toprimitive(js_State *J, js_Value *v, int preferred)
 	if (J->strict)
 		js_typeerror(J, "cannot convert object to primitive");
 
-	v->type = JS_TLITSTR;
-	v->u.litstr = "[object]";
+	JSV_SETLITSTR(v, "[object]");
 	return;
 }
 
 /* ToBoolean() on a value */
 int jsV_toboolean(js_State *J, js_Value *v)
 {
-	switch (v->type) {
+	switch (JSV_TYPE(v)) {
 	default:
-	case JS_TSHRSTR: return v->u.shrstr[0] != 0;
+	case JS_TSHRSTR: return JSV_SHRSTR(v)[0] != 0;
 	case JS_TUNDEFINED: return 0;
 	case JS_TNULL: return 0;
-	case JS_TBOOLEAN: return v->u.boolean;
-	case JS_TNUMBER: return v->u.number != 0 && !isnan(v->u.number);
-	case JS_TLITSTR: return v->u.litstr[0] != 0;
-	case JS_TMEMSTR: return v->u.memstr->p[0] != 0;
+	case JS_TBOOLEAN: return JSV_BOOLEAN(v);
+	case JS_TNUMBER: return JSV_NUMBER(v) != 0 && !isnan(JSV_NUMBER(v));
+	case JS_TLITSTR: return JSV_LITSTR(v)[0] != 0;
+	case JS_TMEMSTR: return JSV_MEMSTR(v)->p[0] != 0;
+	case JS_TROPE: return JSV_ROPE(v)->length != 0;
 	case JS_TOBJECT: return 1;
 	}
 }
@@ -242,15 +243,16 @@ double jsV_stringtonumber(js_State *J, const char *s)
 /* ToNumber() on a value */
 double jsV_tonumber(js_State *J, js_Value *v)
 {
-	switch (v->type) {
+	switch (JSV_TYPE(v)) {
 	default:
-	case JS_TSHRSTR: return jsV_stringtonumber(J, v->u.shrstr);
+	case JS_TSHRSTR: return jsV_stringtonumber(J, JSV_SHRSTR(v));
 	case JS_TUNDEFINED: return NAN;
 	case JS_TNULL: return 0;
-	case JS_TBOOLEAN: return v->u.boolean;
-	case JS_TNUMBER: return v->u.number;
-	case JS_TLITSTR: return jsV_stringtonumber(J, v->u.litstr);
-	case JS_TMEMSTR: return jsV_stringtonumber(J, v->u.memstr->p);
+	case JS_TBOOLEAN: return JSV_BOOLEAN(v);
+	case JS_TNUMBER: return JSV_NUMBER(v);
+	case JS_TLITSTR: return jsV_stringtonumber(J, JSV_LITSTR(v));
+	case JS_TMEMSTR: return jsV_stringtonumber(J, JSV_MEMSTR(v)->p);
+	case JS_TROPE: return jsV_stringtonumber(J, jsV_tostring(J, v));
 	case JS_TOBJECT:
 		jsV_toprimitive(J, v, JS_HNUMBER);
 		return jsV_tonumber(J, v);
@@ -327,28 +329,30 @@ const char *jsV_tostring(js_State *J, js_Value *v)
 {
 	char buf[32];
 	const char *p;
-	switch (v->type) {
+	switch (JSV_TYPE(v)) {
 	default:
-	case JS_TSHRSTR: return v->u.shrstr;
+	case JS_TSHRSTR: return JSV_SHRSTR(v);
 	case JS_TUNDEFINED: return "undefined";
 	case JS_TNULL: return "null";
-	case JS_TBOOLEAN: return v->u.boolean ? "true" : "false";
-	case JS_TLITSTR: return v->u.litstr;
-	case JS_TMEMSTR: return v->u.memstr->p;
+	case JS_TBOOLEAN: return JSV_BOOLEAN(v) ? "true" : "false";
+	case JS_TLITSTR: return JSV_LITSTR(v);
+	case JS_TMEMSTR: return JSV_MEMSTR(v)->p;
+	case JS_TROPE:
+		JSV_SETMEMSTR(v, jsV_flattenrope(J, JSV_ROPE(v)));
+		return JSV_MEMSTR(v)->p;
 	case JS_TNUMBER:
-		p = jsV_numbertostring(J, buf, v->u.number);
+		p = jsV_numbertostring(J, buf, JSV_NUMBER(v));
 		if (p == buf) {
 			int n = strlen(p);
-			if (n <= soffsetof(js_Value, type)) {
-				char *s = v->u.shrstr;
+			if (n <= JS_SHRSTRMAX) {
+				char *s = JSV_SHRSTR(v);
 				while (n--) *s++ = *p++;
 				*s = 0;
-				v->type = JS_TSHRSTR;
-				return v->u.shrstr;
+				JSV_SETSHRSTR(v);
+				return JSV_SHRSTR(v);
 			} else {
-				v->u.memstr = jsV_newmemstring(J, p, n);
-				v->type = JS_TMEMSTR;
-				return v->u.memstr->p;
+				JSV_SETMEMSTR(v, jsV_newmemstring(J, p, n));
+				return JSV_MEMSTR(v)->p;
 			}
 		}
 		return p;
@@ -377,7 +381,25 @@ static js_Object *jsV_newnumber(js_State *J, double v)
 static js_Object *jsV_newstring(js_State *J, const char *v)
 {
 	js_Object *obj = jsV_newobject(J, JS_CSTRING, J->String_prototype);
-	obj->u.s.string = js_intern(J, v); /* TODO: js_String */
+	obj->u.s.string = js_intern(J, v);
+	obj->u.s.length = utflen(v);
+	return obj;
+}
+
+/* Wrap a run-time string without copying it, keeping its length and index */
+static js_Object *jsV_newmemstringobject(js_State *J, js_String *v)
+{
+	js_Object *obj = jsV_newobject(J, JS_CSTRING, J->String_prototype);
+	obj->u.s.string = v->p;
+	obj->u.s.memstr = v;
+	obj->u.s.length = js_stringlength(v);
+	return obj;
+}
+
+static js_Object *jsV_newliteralstring(js_State *J, const char *v)
+{
+	js_Object *obj = jsV_newobject(J, JS_CSTRING, J->String_prototype);
+	obj->u.s.string = v;
 	obj->u.s.length = utflen(v);
 	return obj;
 }
@@ -386,19 +408,19 @@ static js_Object *jsV_newstring(js_State *J, const char *v)
 js_Object *jsV_toobject(js_State *J, js_Value *v)
 {
 	js_Object *o;
-	switch (v->type) {
+	switch (JSV_TYPE(v)) {
 	default:
 	case JS_TUNDEFINED: js_typeerror(J, "cannot convert undefined to object");
 	case JS_TNULL: js_typeerror(J, "cannot convert null to object");
-	case JS_TOBJECT: return v->u.object;
-	case JS_TSHRSTR: o = jsV_newstring(J, v->u.shrstr); break;
-	case JS_TLITSTR: o = jsV_newstring(J, v->u.litstr); break;
-	case JS_TMEMSTR: o = jsV_newstring(J, v->u.memstr->p); break;
-	case JS_TBOOLEAN: o = jsV_newboolean(J, v->u.boolean); break;
-	case JS_TNUMBER: o = jsV_newnumber(J, v->u.number); break;
-	}
-	v->type = JS_TOBJECT;
-	v->u.object = o;
+	case JS_TOBJECT: return JSV_OBJECT(v);
+	case JS_TSHRSTR: o = jsV_newstring(J, JSV_SHRSTR(v)); break;
+	case JS_TLITSTR: o = jsV_newliteralstring(J, JSV_LITSTR(v)); break;
+	case JS_TMEMSTR: o = jsV_newmemstringobject(J, JSV_MEMSTR(v)); break;
+	case JS_TROPE: o = jsV_newmemstringobject(J, jsV_flattenrope(J, JSV_ROPE(v))); break;
+	case JS_TBOOLEAN: o = jsV_newboolean(J, JSV_BOOLEAN(v)); break;
+	case JS_TNUMBER: o = jsV_newnumber(J, JSV_NUMBER(v)); break;
+	}
+	JSV_SETOBJECT(v, o);
 	return o;
 }
 
@@ -590,27 +612,191 @@ int js_instanceof(js_State *J)
 	return 0;
 }
 
+/* Ropes */
+
+static int jsV_stringsize(js_Value *v)
+{
+	if (JSV_TYPE(v) == JS_TROPE)
+		return JSV_ROPE(v)->length;
+	return strlen(JSV_TOSTRING(v));
+}
+
+/* String length in characters; ropes know theirs without flattening */
+int jsV_stringlength(js_State *J, js_Value *v)
+{
+	if (JSV_TYPE(v) == JS_TROPE)
+		return JSV_ROPE(v)->count;
+	if (JSV_TYPE(v) == JS_TMEMSTR)
+		return js_stringlength(JSV_MEMSTR(v));
+	return utflen(jsV_tostring(J, v));
+}
+
+/* Character access on a string value; run-time strings use their index */
+int jsV_runeat(js_State *J, js_Value *v, int i)
+{
+	JSV_FLATTEN(J, v);
+	if (JSV_TYPE(v) == JS_TMEMSTR)
+		return js_stringruneat(J, JSV_MEMSTR(v), i);
+	return js_runeat(J, jsV_tostring(J, v), i);
+}
+
+const char *jsV_utfidxtoptr(js_State *J, js_Value *v, int i)
+{
+	JSV_FLATTEN(J, v);
+	if (JSV_TYPE(v) == JS_TMEMSTR)
+		return js_stringidxtoptr(J, JSV_MEMSTR(v), i);
+	return js_utfidxtoptr(jsV_tostring(J, v), i);
+}
+
+static js_Rope *jsV_newrope(js_State *J, js_Value *a, js_Value *b, int length)
+{
+	js_Rope *rope = js_malloc(J, sizeof *rope);
+	int da = JSV_TYPE(a) == JS_TROPE ? JSV_ROPE(a)->depth : 0;
+	int db = JSV_TYPE(b) == JS_TROPE ? JSV_ROPE(b)->depth + 1 : 0;
+	rope->depth = da > db ? da : db;
+	rope->length = length;
+	rope->count = jsV_stringlength(J, a) + jsV_stringlength(J, b);
+	rope->left = *a;
+	rope->right = *b;
+	rope->flat = NULL;
+	rope->gcmark = jsG_newmark(J);
+	rope->gcnext = J->gcrope;
+	J->gcrope = rope;
+	++J->gccounter;
+	return rope;
+}
+
+/* Write the rope backwards from end; recurse on the right, loop on the left. */
+static void jsV_fillrope(char *end, js_Rope *rope)
+{
+	for (;;) {
+		js_Value *v = &rope->right;
+		int n;
+
+		if (rope->flat) {
+			memcpy(end - rope->length, rope->flat->p, rope->length);
+			return;
+		}
+
+		if (JSV_TYPE(v) == JS_TROPE) {
+			jsV_fillrope(end, JSV_ROPE(v));
+			end -= JSV_ROPE(v)->length;
+		} else {
+			n = strlen(JSV_TOSTRING(v));
+			end -= n;
+			memcpy(end, JSV_TOSTRING(v), n);
+		}
+
+		v = &rope->left;
+		if (JSV_TYPE(v) != JS_TROPE) {
+			n = strlen(JSV_TOSTRING(v));
+			memcpy(end - n, JSV_TOSTRING(v), n);
+			return;
+		}
+		rope = JSV_ROPE(v);
+	}
+}
+
+js_String *jsV_flattenrope(js_State *J, js_Rope *rope)
+{
+	js_String *s;
+
+	if (rope->flat)
+		return rope->flat;
+
+	s = jsV_newmemstring(J, NULL, rope->length);
+	jsV_fillrope(s->p + rope->length, rope);
+	s->length = rope->count;
+	s->ascii = rope->count == rope->length;
+
+	/* a rope that is already marked must not point to a white string */
+	if (J->gcstate == JS_GCMARK && rope->gcmark == J->gcmark)
+		s->gcmark = J->gcmark;
+
+	rope->flat = s;
+	JSV_SETLITSTR(&rope->left, "");
+	JSV_SETLITSTR(&rope->right, "");
+	return s;
+}
+
+static void jsV_concatstring(js_State *J)
+{
+	js_Value *a = js_tovalue(J, -2);
+	js_Value *b = js_tovalue(J, -1);
+	int na = jsV_stringsize(a);
+	int nb = jsV_stringsize(b);
+	js_Rope *rope;
+	js_Value v;
+
+	if (na > JS_STRLIMIT - nb)
+		js_rangeerror(J, "invalid string length");
+
+	if (nb == 0) {
+		js_pop(J, 1);
+		return;
+	}
+	if (na == 0) {
+		js_rot2pop1(J);
+		return;
+	}
+
+	/* short results are copied at once (ropes are never this short) */
+	if (na + nb < JS_ROPEMIN) {
+		char buf[JS_ROPEMIN];
+		memcpy(buf, JSV_TOSTRING(a), na);
+		memcpy(buf + na, JSV_TOSTRING(b), nb);
+		js_pop(J, 2);
+		js_pushlstring(J, buf, na + nb);
+		return;
+	}
+
+	/* appending a short piece to a rope: merge it with the piece at the end, so s += x makes few nodes */
+	if (JSV_TYPE(a) == JS_TROPE && !JSV_ROPE(a)->flat && JSV_TYPE(b) != JS_TROPE && nb < JS_ROPELEAF) {
+		js_Value *end = &JSV_ROPE(a)->right;
+		if (JSV_TYPE(end) != JS_TROPE) {
+			int ne = strlen(JSV_TOSTRING(end));
+			if (ne + nb <= JS_ROPELEAF) {
+				js_Value leaf;
+				JSV_SETMEMSTR(&leaf, jsV_newmemstring(J, NULL, ne + nb));
+				memcpy(JSV_MEMSTR(&leaf)->p, JSV_TOSTRING(end), ne);
+				memcpy(JSV_MEMSTR(&leaf)->p + ne, JSV_TOSTRING(b), nb);
+				rope = jsV_newrope(J, &JSV_ROPE(a)->left, &leaf, na + nb);
+				goto push;
+			}
+		}
+	}
+
+	if (JSV_TYPE(b) == JS_TROPE && JSV_ROPE(b)->depth >= JS_ROPEDEPTH)
+		jsV_tostring(J, b);
+
+	rope = jsV_newrope(J, a, b, na + nb);
+
+push:
+	JSV_SETROPE(&v, rope);
+	js_pop(J, 2);
+	js_pushvalue(J, v);
+}
+
+/* ToString() in place, leaving ropes alone; other results are static strings */
+static void jsV_tostringvalue(js_State *J, js_Value *v)
+{
+	if (!JSV_ISSTRING(v)) {
+		const char *p = jsV_tostring(J, v);
+		if (!JSV_ISSTRING(v)) {
+			JSV_SETLITSTR(v, p);
+		}
+	}
+}
+
 void js_concat(js_State *J)
 {
 	js_toprimitive(J, -2, JS_HNONE);
 	js_toprimitive(J, -1, JS_HNONE);
 
 	if (js_isstring(J, -2) || js_isstring(J, -1)) {
-		const char *sa = js_tostring(J, -2);
-		const char *sb = js_tostring(J, -1);
-		char * volatile sab = NULL;
-		/* TODO: create js_String directly */
-		if (js_try(J)) {
-			js_free(J, sab);
-			js_throw(J);
-		}
-		sab = js_malloc(J, strlen(sa) + strlen(sb) + 1);
-		strcpy(sab, sa);
-		strcat(sab, sb);
-		js_pop(J, 2);
-		js_pushstring(J, sab);
-		js_endtry(J);
-		js_free(J, sab);
+		jsV_tostringvalue(J, js_tovalue(J, -2));
+		jsV_tostringvalue(J, js_tovalue(J, -1));
+		jsV_concatstring(J);
 	} else {
 		double x = js_tonumber(J, -2);
 		double y = js_tonumber(J, -1);
@@ -642,40 +828,40 @@ int js_equal(js_State *J)
 	js_Value *y = js_tovalue(J, -1);
 
 retry:
+	JSV_FLATTEN(J, x);
+	JSV_FLATTEN(J, y);
 	if (JSV_ISSTRING(x) && JSV_ISSTRING(y))
 		return !strcmp(JSV_TOSTRING(x), JSV_TOSTRING(y));
-	if (x->type == y->type) {
-		if (x->type == JS_TUNDEFINED) return 1;
-		if (x->type == JS_TNULL) return 1;
-		if (x->type == JS_TNUMBER) return x->u.number == y->u.number;
-		if (x->type == JS_TBOOLEAN) return x->u.boolean == y->u.boolean;
-		if (x->type == JS_TOBJECT) return x->u.object == y->u.object;
+	if (JSV_TYPE(x) == JSV_TYPE(y)) {
+		if (JSV_TYPE(x) == JS_TUNDEFINED) return 1;
+		if (JSV_TYPE(x) == JS_TNULL) return 1;
+		if (JSV_TYPE(x) == JS_TNUMBER) return JSV_NUMBER(x) == JSV_NUMBER(y);
+		if (JSV_TYPE(x) == JS_TBOOLEAN) return JSV_BOOLEAN(x) == JSV_BOOLEAN(y);
+		if (JSV_TYPE(x) == JS_TOBJECT) return JSV_OBJECT(x) == JSV_OBJECT(y);
 		return 0;
 	}
 
-	if (x->type == JS_TNULL && y->type == JS_TUNDEFINED) return 1;
-	if (x->type == JS_TUNDEFINED && y->type == JS_TNULL) return 1;
+	if (JSV_TYPE(x) == JS_TNULL && JSV_TYPE(y) == JS_TUNDEFINED) return 1;
+	if (JSV_TYPE(x) == JS_TUNDEFINED && JSV_TYPE(y) == JS_TNULL) return 1;
 
-	if (x->type == JS_TNUMBER && JSV_ISSTRING(y))
-		return x->u.number == jsV_tonumber(J, y);
-	if (JSV_ISSTRING(x) && y->type == JS_TNUMBER)
-		return jsV_tonumber(J, x) == y->u.number;
+	if (JSV_TYPE(x) == JS_TNUMBER && JSV_ISSTRING(y))
+		return JSV_NUMBER(x) == jsV_tonumber(J, y);
+	if (JSV_ISSTRING(x) && JSV_TYPE(y) == JS_TNUMBER)
+		return jsV_tonumber(J, x) == JSV_NUMBER(y);
 
-	if (x->type == JS_TBOOLEAN) {
-		x->type = JS_TNUMBER;
-		x->u.number = x->u.boolean ? 1 : 0;
+	if (JSV_TYPE(x) == JS_TBOOLEAN) {
+		JSV_SETNUMBER(x, JSV_BOOLEAN(x) ? 1 : 0);
 		goto retry;
 	}
-	if (y->type == JS_TBOOLEAN) {
-		y->type = JS_TNUMBER;
-		y->u.number = y->u.boolean ? 1 : 0;
+	if (JSV_TYPE(y) == JS_TBOOLEAN) {
+		JSV_SETNUMBER(y, JSV_BOOLEAN(y) ? 1 : 0);
 		goto retry;
 	}
-	if ((JSV_ISSTRING(x) || x->type == JS_TNUMBER) && y->type == JS_TOBJECT) {
+	if ((JSV_ISSTRING(x) || JSV_TYPE(x) == JS_TNUMBER) && JSV_TYPE(y) == JS_TOBJECT) {
 		jsV_toprimitive(J, y, JS_HNONE);
 		goto retry;
 	}
-	if (x->type == JS_TOBJECT && (JSV_ISSTRING(y) || y->type == JS_TNUMBER)) {
+	if (JSV_TYPE(x) == JS_TOBJECT && (JSV_ISSTRING(y) || JSV_TYPE(y) == JS_TNUMBER)) {
 		jsV_toprimitive(J, x, JS_HNONE);
 		goto retry;
 	}
@@ -688,14 +874,16 @@ int js_strictequal(js_State *J)
 	js_Value *x = js_tovalue(J, -2);
 	js_Value *y = js_tovalue(J, -1);
 
+	JSV_FLATTEN(J, x);
+	JSV_FLATTEN(J, y);
 	if (JSV_ISSTRING(x) && JSV_ISSTRING(y))
 		return !strcmp(JSV_TOSTRING(x), JSV_TOSTRING(y));
 
-	if (x->type != y->type) return 0;
-	if (x->type == JS_TUNDEFINED) return 1;
-	if (x->type == JS_TNULL) return 1;
-	if (x->type == JS_TNUMBER) return x->u.number == y->u.number;
-	if (x->type == JS_TBOOLEAN) return x->u.boolean == y->u.boolean;
-	if (x->type == JS_TOBJECT) return x->u.object == y->u.object;
+	if (JSV_TYPE(x) != JSV_TYPE(y)) return 0;
+	if (JSV_TYPE(x) == JS_TUNDEFINED) return 1;
+	if (JSV_TYPE(x) == JS_TNULL) return 1;
+	if (JSV_TYPE(x) == JS_TNUMBER) return JSV_NUMBER(x) == JSV_NUMBER(y);
+	if (JSV_TYPE(x) == JS_TBOOLEAN) return JSV_BOOLEAN(x) == JSV_BOOLEAN(y);
+	if (JSV_TYPE(x) == JS_TOBJECT) return JSV_OBJECT(x) == JSV_OBJECT(y);
 	return 0;
 }
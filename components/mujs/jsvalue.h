@@ -19,6 +19,7 @@ enum js_Type {
 	JS_TNUMBER,
 	JS_TLITSTR,
 	JS_TMEMSTR,
+	JS_TROPE,
 	JS_TOBJECT,
 };
 
@@ -41,6 +42,63 @@ enum js_Class {
 	JS_CUSERDATA,
 };
 
+/*
+	Values are read and written through the JSV_ macros below, so that the
+	layout can be chosen at compile time.
+*/
+
+#ifdef JS_NANBOX
+
+/*
+	NaN-boxing packs every value into 8 bytes. Numbers are stored as plain
+	doubles; the few NaNs that would look like tags are canonicalized.
+	Other values put 0xFFF1 + type in the top 16 bits and a pointer, boolean
+	or short string in the low 48 bits. Short strings hold up to 5 bytes and
+	their terminator in the low bytes of the value (little-endian only).
+*/
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "JS_NANBOX needs a little-endian target"
+#endif
+
+#define JSV_TAG(t) ((uint64_t)(0xFFF1 + (t)) << 48)
+#define JSV_PAYLOAD ((uint64_t)0xFFFFFFFFFFFF)
+#define JSV_QNAN ((uint64_t)0x7FF8000000000000)
+#define JSV_PTR(v, T) ((T)(uintptr_t)((v)->n.bits & JSV_PAYLOAD))
+#define JSV_SETPTR(v, t, p) ((v)->n.bits = JSV_TAG(t) | (uint64_t)(uintptr_t)(p))
+
+struct js_Value
+{
+	union {
+		uint64_t bits;
+		double number;
+	} n;
+};
+
+#define JS_SHRSTRMAX 5
+#define JSV_INIT_UNDEFINED { { JSV_TAG(JS_TUNDEFINED) } }
+
+#define JSV_TYPE(v) ((v)->n.bits < JSV_TAG(0) ? JS_TNUMBER : (enum js_Type)(((v)->n.bits >> 48) - 0xFFF1))
+#define JSV_NUMBER(v) ((v)->n.number)
+#define JSV_BOOLEAN(v) ((int)((v)->n.bits & 1))
+#define JSV_SHRSTR(v) ((char*)(v))
+#define JSV_LITSTR(v) JSV_PTR(v, const char*)
+#define JSV_MEMSTR(v) JSV_PTR(v, js_String*)
+#define JSV_ROPE(v) JSV_PTR(v, js_Rope*)
+#define JSV_OBJECT(v) JSV_PTR(v, js_Object*)
+
+#define JSV_SETUNDEFINED(v) ((v)->n.bits = JSV_TAG(JS_TUNDEFINED))
+#define JSV_SETNULL(v) ((v)->n.bits = JSV_TAG(JS_TNULL))
+#define JSV_SETBOOLEAN(v, x) ((v)->n.bits = JSV_TAG(JS_TBOOLEAN) | !!(x))
+#define JSV_SETNUMBER(v, x) ((v)->n.number = (x), (v)->n.bits >= JSV_TAG(0) ? (void)((v)->n.bits = JSV_QNAN) : (void)0)
+#define JSV_SETSHRSTR(v) ((v)->n.bits = ((v)->n.bits & JSV_PAYLOAD) | JSV_TAG(JS_TSHRSTR))
+#define JSV_SETLITSTR(v, x) JSV_SETPTR(v, JS_TLITSTR, x)
+#define JSV_SETMEMSTR(v, x) JSV_SETPTR(v, JS_TMEMSTR, x)
+#define JSV_SETROPE(v, x) JSV_SETPTR(v, JS_TROPE, x)
+#define JSV_SETOBJECT(v, x) JSV_SETPTR(v, JS_TOBJECT, x)
+
+#else
+
 /*
 	Short strings abuse the js_Value struct. By putting the type tag in the
 	last byte, and using 0 as the tag for short strings, we can use the
@@ -56,12 +114,37 @@ struct js_Value
 		char shrstr[8];
 		const char *litstr;
 		js_String *memstr;
+		js_Rope *rope;
 		js_Object *object;
 	} u;
 	char pad[7]; /* extra storage for shrstr */
 	char type; /* type tag and zero terminator for shrstr */
 };
 
+#define JS_SHRSTRMAX 15
+#define JSV_INIT_UNDEFINED { {0}, {0}, JS_TUNDEFINED }
+
+#define JSV_TYPE(v) ((enum js_Type)(v)->type)
+#define JSV_NUMBER(v) ((v)->u.number)
+#define JSV_BOOLEAN(v) ((v)->u.boolean)
+#define JSV_SHRSTR(v) ((v)->u.shrstr)
+#define JSV_LITSTR(v) ((v)->u.litstr)
+#define JSV_MEMSTR(v) ((v)->u.memstr)
+#define JSV_ROPE(v) ((v)->u.rope)
+#define JSV_OBJECT(v) ((v)->u.object)
+
+#define JSV_SETUNDEFINED(v) ((v)->type = JS_TUNDEFINED)
+#define JSV_SETNULL(v) ((v)->type = JS_TNULL)
+#define JSV_SETBOOLEAN(v, x) ((v)->type = JS_TBOOLEAN, (v)->u.boolean = !!(x))
+#define JSV_SETNUMBER(v, x) ((v)->type = JS_TNUMBER, (v)->u.number = (x))
+#define JSV_SETSHRSTR(v) ((v)->type = JS_TSHRSTR)
+#define JSV_SETLITSTR(v, x) ((v)->type = JS_TLITSTR, (v)->u.litstr = (x))
+#define JSV_SETMEMSTR(v, x) ((v)->type = JS_TMEMSTR, (v)->u.memstr = (x))
+#define JSV_SETROPE(v, x) ((v)->type = JS_TROPE, (v)->u.rope = (x))
+#define JSV_SETOBJECT(v, x) ((v)->type = JS_TOBJECT, (v)->u.object = (x))
+
+#endif
+
 /* evm native */
 typedef js_Value (*js_CNative)(js_State *J, js_Value pthis, int argc, js_Value *v);
 
@@ -69,9 +152,32 @@ struct js_String
 {
 	js_String *gcnext;
 	char gcmark;
+	char ascii; /* valid once length is known */
+	int length; /* in characters, -1 until needed */
+	int *index; /* byte offset of every JS_UTFINDEXSTEP'th character */
 	char p[1];
 };
 
+/*
+	Ropes are the lazy result of concatenating long strings, so that
+	building a string piece by piece does not copy it over and over.
+	A rope is flattened into a js_String the first time it is used as
+	a C string, after which its pieces are dropped. Ropes only nest on
+	the left without limit, so flattening and marking recurse at most
+	JS_ROPEDEPTH levels deep.
+*/
+
+struct js_Rope
+{
+	js_Rope *gcnext;
+	char gcmark;
+	unsigned char depth; /* nesting of ropes on the right */
+	int length; /* in bytes */
+	int count; /* in characters */
+	js_Value left, right;
+	js_String *flat;
+};
+
 struct js_Regexp
 {
 	void *prog;
@@ -86,6 +192,8 @@ struct js_Object
 	int extensible;
 	js_Property *properties;
 	int count; /* number of properties, for array sparseness check */
+	unsigned int shape; /* unique id of the current property layout, for inline caches */
+	int indexprops; /* a property named like an array index was ever added, see jsR_canappend */
 	js_Object *prototype;
 	union {
 		int boolean;
@@ -93,9 +201,14 @@ struct js_Object
 		struct {
 			const char *string;
 			int length;
+			js_String *memstr; /* owner of string; NULL for interned and literal strings */
 		} s;
 		struct {
 			int length;
+			int simple; /* elements live in array[] only, no sparse properties */
+			int flat_length;
+			int flat_capacity;
+			js_Value *array;
 		} a;
 		struct {
 			js_Function *function;
@@ -152,6 +265,10 @@ void js_newcnative(js_State *J, js_CNative cfun, const char *name, int length);
 
 /* jsrun.c */
 js_String *jsV_newmemstring(js_State *J, const char *s, int n);
+js_String *jsV_flattenrope(js_State *J, js_Rope *rope);
+int jsV_stringlength(js_State *J, js_Value *v);
+int jsV_runeat(js_State *J, js_Value *v, int i);
+const char *jsV_utfidxtoptr(js_State *J, js_Value *v, int i);
 js_Value *js_tovalue(js_State *J, int idx);
 void js_toprimitive(js_State *J, int idx, int hint);
 js_Object *js_toobject(js_State *J, int idx);
@@ -182,13 +299,16 @@ js_Property *jsV_getownproperty(js_State *J, js_Object *obj, const char *name);
 js_Property *jsV_getpropertyx(js_State *J, js_Object *obj, const char *name, int *own);
 js_Property *jsV_getproperty(js_State *J, js_Object *obj, const char *name);
 js_Property *jsV_setproperty(js_State *J, js_Object *obj, const char *name);
+js_Property *jsV_setinternedproperty(js_State *J, js_Object *obj, const char *name);
 js_Property *jsV_nextproperty(js_State *J, js_Object *obj, const char *name);
 void jsV_delproperty(js_State *J, js_Object *obj, const char *name);
 
 js_Object *jsV_newiterator(js_State *J, js_Object *obj, int own);
+js_Property *jsV_nextownproperty(js_State *J, js_Object *obj, const char *name);
 const char *jsV_nextiterator(js_State *J, js_Object *iter);
 
 void jsV_resizearray(js_State *J, js_Object *obj, int newlen);
+void jsV_unflattenarray(js_State *J, js_Object *obj);
 
 /* jsdump.c */
 void js_dumpobject(js_State *J, js_Object *obj);
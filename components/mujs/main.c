@@ -89,6 +89,38 @@ char *readline(const char *prompt)
 
 #define PS1 "> "
 
+/* Allocator that keeps track of the heap in use, for memstats() */
+
+static size_t heapbytes, heappeak;
+
+static void *heapalloc(void *actx, void *ptr, int size)
+{
+	size_t *p = ptr ? (size_t*)ptr - 2 : NULL;
+	if (p)
+		heapbytes -= p[0];
+	if (size == 0) {
+		free(p);
+		return NULL;
+	}
+	p = realloc(p, (size_t)size + 2 * sizeof(size_t));
+	if (!p)
+		return NULL;
+	p[0] = size;
+	heapbytes += size;
+	if (heapbytes > heappeak)
+		heappeak = heapbytes;
+	return p + 2;
+}
+
+static void jsB_memstats(js_State *J)
+{
+	js_newobject(J);
+	js_pushnumber(J, heapbytes);
+	js_setproperty(J, -2, "bytes");
+	js_pushnumber(J, heappeak);
+	js_setproperty(J, -2, "peak");
+}
+
 static void jsB_gc(js_State *J)
 {
 	int report = js_toboolean(J, 1);
@@ -96,6 +128,64 @@ static void jsB_gc(js_State *J)
 	js_pushundefined(J);
 }
 
+/* Growing text buffer for profile dumps */
+typedef struct { char *s; int n, m; } textbuf;
+
+static void write_text(void *data, const void *buf, int size)
+{
+	textbuf *tb = data;
+	if (tb->n + size > tb->m) {
+		char *s = realloc(tb->s, tb->m = (tb->n + size) * 2);
+		if (!s)
+			return;
+		tb->s = s;
+	}
+	memcpy(tb->s + tb->n, buf, size);
+	tb->n += size;
+}
+
+/* process.profile(interval, samples) starts; process.profile() stops and returns folded stacks;
+   process.profile("counts") returns instructions per function */
+static void jsB_profile(js_State *J)
+{
+	textbuf tb = { NULL, 0, 0 };
+	if (js_isnumber(J, 1)) {
+		js_profilestart(J, js_tointeger(J, 1), js_isdefined(J, 2) ? js_tointeger(J, 2) : 1024);
+		js_pushundefined(J);
+		return;
+	}
+	if (js_isstring(J, 1) && !strcmp(js_tostring(J, 1), "counts")) {
+		js_profiledump(J, JS_PROFILECOUNTS, write_text, &tb);
+	} else {
+		js_profilestop(J);
+		js_profiledump(J, JS_PROFILEFOLDED, write_text, &tb);
+	}
+	if (js_try(J)) {
+		free(tb.s);
+		js_throw(J);
+	}
+	js_pushlstring(J, tb.s ? tb.s : "", tb.n);
+	js_endtry(J);
+	free(tb.s);
+}
+
+static void jsB_gcstats(js_State *J)
+{
+	js_GCStats stats;
+	js_getgcstats(J, &stats);
+	js_newobject(J);
+	js_pushnumber(J, stats.cycles);
+	js_setproperty(J, -2, "cycles");
+	js_pushnumber(J, stats.steps);
+	js_setproperty(J, -2, "steps");
+	js_pushnumber(J, stats.lastpause);
+	js_setproperty(J, -2, "lastPause");
+	js_pushnumber(J, stats.maxpause);
+	js_setproperty(J, -2, "maxPause");
+	js_pushnumber(J, stats.totalpause);
+	js_setproperty(J, -2, "totalPause");
+}
+
 static void jsB_load(js_State *J)
 {
 	int i, n = js_gettop(J);
@@ -289,9 +379,44 @@ static void usage(void)
 	fprintf(stderr, "Usage: mujs [options] [script [scriptArgs*]]\n");
 	fprintf(stderr, "\t-i: Enter interactive prompt after running code.\n");
 	fprintf(stderr, "\t-s: Check strictness.\n");
+	fprintf(stderr, "\t-g: Collect garbage incrementally.\n");
+	fprintf(stderr, "\t-c output: Compile script to bytecode instead of running it.\n");
+	fprintf(stderr, "\t-p output: Profile the script and write folded stacks for flamegraph.pl.\n");
 	exit(1);
 }
 
+static void write_file(void *data, const void *buf, int size)
+{
+	fwrite(buf, 1, size, data);
+}
+
+static int compile_file(js_State *J, const char *filename, const char *output)
+{
+	FILE *f;
+
+	if (js_try(J)) {
+		fprintf(stderr, "%s\n", js_trystring(J, -1, "Error"));
+		js_pop(J, 1);
+		return 1;
+	}
+	js_loadfile(J, filename);
+	js_endtry(J);
+
+	f = fopen(output, "wb");
+	if (!f) {
+		fprintf(stderr, "cannot create file '%s': %s\n", output, strerror(errno));
+		js_pop(J, 1);
+		return 1;
+	}
+	js_savebytecode(J, -1, write_file, f);
+	js_pop(J, 1);
+	if (fclose(f)) {
+		fprintf(stderr, "cannot write file '%s': %s\n", output, strerror(errno));
+		return 1;
+	}
+	return 0;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -299,18 +424,28 @@ main(int argc, char **argv)
 	js_State *J;
 	int status = 0;
 	int strict = 0;
+	int incremental = 0;
 	int interactive = 0;
+	char *output = NULL;
+	char *profile = NULL;
+	FILE *f;
 	int i, c;
 
-	while ((c = xgetopt(argc, argv, "is")) != -1) {
+	while ((c = xgetopt(argc, argv, "igsc:p:")) != -1) {
 		switch (c) {
 		default: usage(); break;
 		case 'i': interactive = 1; break;
 		case 's': strict = 1; break;
+		case 'g': incremental = 1; break;
+		case 'c': output = xoptarg; break;
+		case 'p': profile = xoptarg; break;
 		}
 	}
 
-	J = js_newstate(NULL, NULL, strict ? JS_STRICT : 0);
+	if (output && xoptind == argc)
+		usage();
+
+	J = js_newstate(heapalloc, NULL, (strict ? JS_STRICT : 0) | (incremental ? JS_GCINCREMENTAL : 0));
 	if (!J) {
 		fprintf(stderr, "Could not initialize MuJS.\n");
 		exit(1);
@@ -319,6 +454,17 @@ main(int argc, char **argv)
 	js_newcfunction(J, jsB_gc, "gc", 0);
 	js_setglobal(J, "gc");
 
+	js_newcfunction(J, jsB_gcstats, "gcstats", 0);
+	js_setglobal(J, "gcstats");
+
+	js_newcfunction(J, jsB_memstats, "memstats", 0);
+	js_setglobal(J, "memstats");
+
+	js_newobject(J);
+	js_newcfunction(J, jsB_profile, "profile", 2);
+	js_setproperty(J, -2, "profile");
+	js_setglobal(J, "process");
+
 	js_newcfunction(J, jsB_load, "load", 1);
 	js_setglobal(J, "load");
 
@@ -347,7 +493,10 @@ main(int argc, char **argv)
 	js_dostring(J, stacktrace_js);
 	js_dostring(J, console_js);
 
-	if (xoptind == argc) {
+	if (output) {
+		status = compile_file(J, argv[xoptind], output);
+		interactive = 0;
+	} else if (xoptind == argc) {
 		interactive = 1;
 	} else {
 		c = xoptind++;
@@ -360,8 +509,26 @@ main(int argc, char **argv)
 		}
 		js_setglobal(J, "scriptArgs");
 
+		if (profile)
+			js_profilestart(J, 1000, 1 << 16);
+
 		if (js_dofile(J, argv[c]))
 			status = 1;
+
+		if (profile) {
+			js_profilestop(J);
+			f = fopen(profile, "wb");
+			if (!f) {
+				fprintf(stderr, "cannot create file '%s': %s\n", profile, strerror(errno));
+				status = 1;
+			} else {
+				js_profiledump(J, JS_PROFILEFOLDED, write_file, f);
+				if (fclose(f)) {
+					fprintf(stderr, "cannot write file '%s': %s\n", profile, strerror(errno));
+					status = 1;
+				}
+			}
+		}
 	}
 
 	if (interactive) {
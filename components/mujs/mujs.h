@@ -47,6 +47,16 @@ typedef int (*js_HasProperty)(js_State *J, void *p, const char *name);
 typedef int (*js_Put)(js_State *J, void *p, const char *name);
 typedef int (*js_Delete)(js_State *J, void *p, const char *name);
 typedef void (*js_Report)(js_State *J, const char *message);
+typedef void (*js_Writer)(void *data, const void *buf, int size);
+
+/* Garbage collector statistics; pause times are in milliseconds */
+typedef struct js_GCStats {
+	unsigned int cycles; /* completed collections */
+	unsigned int steps; /* incremental steps */
+	double lastpause;
+	double maxpause;
+	double totalpause;
+} js_GCStats;
 
 /* Basic functions */
 js_State *js_newstate(js_Alloc alloc, void *actx, int flags);
@@ -56,6 +66,21 @@ void js_setreport(js_State *J, js_Report report);
 js_Panic js_atpanic(js_State *J, js_Panic panic);
 void js_freestate(js_State *J);
 void js_gc(js_State *J, int report);
+int js_gcstep(js_State *J);
+void js_setgcstep(js_State *J, int work);
+void js_getgcstats(js_State *J, js_GCStats *stats);
+
+/* Snapshot: a new state starting from a copy of the globals and registry of template T */
+js_State *js_newstatefrom(js_State *T, js_Alloc alloc, void *actx, int flags);
+
+/* Profiler: the call stack is sampled every 'interval' instructions into a ring of 'size' samples */
+enum {
+	JS_PROFILEFOLDED, /* one line per distinct stack, root first, in flamegraph folded format */
+	JS_PROFILECOUNTS, /* instructions executed per function, most first */
+};
+void js_profilestart(js_State *J, int interval, int size);
+void js_profilestop(js_State *J);
+void js_profiledump(js_State *J, int what, js_Writer write, void *data);
 
 int js_dostring(js_State *J, const char *source);
 int js_dofile(js_State *J, const char *filename);
@@ -76,6 +101,7 @@ void js_endtry(js_State *J);
 /* State constructor flags */
 enum {
 	JS_STRICT = 1,
+	JS_GCINCREMENTAL = 2,
 };
 
 /* RegExp flags */
@@ -125,6 +151,10 @@ JS_NORETURN void js_throw(js_State *J);
 void js_loadstring(js_State *J, const char *filename, const char *source);
 void js_loadfile(js_State *J, const char *filename);
 
+int js_isbytecode(const void *data, int size);
+void js_loadbytecode(js_State *J, const char *filename, const void *data, int size);
+void js_savebytecode(js_State *J, int idx, js_Writer write, void *data);
+
 void js_eval(js_State *J);
 void js_call(js_State *J, int n);
 void js_construct(js_State *J, int n);
@@ -245,6 +275,10 @@ void js_repr(js_State *J, int idx);
 const char *js_torepr(js_State *J, int idx);
 const char *js_tryrepr(js_State *J, int idx, const char *error);
 
+/* JSON: parse pushes the value or throws a SyntaxError; stringify pushes the text, or undefined and returns 0 */
+void js_parsejson(js_State *J, const char *source);
+int js_stringifyjson(js_State *J, int idx, const char *gap);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,6 @@
 #include "jsarray.c"
 #include "jsboolean.c"
+#include "jsbytecode.c"
 #include "jsbuiltin.c"
 #include "jscompile.c"
 #include "jsdate.c"
@@ -15,10 +16,12 @@
 #include "jsobject.c"
 #include "json.c"
 #include "jsparse.c"
+#include "jsprofile.c"
 #include "jsproperty.c"
 #include "jsregexp.c"
 #include "jsrepr.c"
 #include "jsrun.c"
+#include "jssnapshot.c"
 #include "jsstate.c"
 #include "jsstring.c"
 #include "jsvalue.c"
@@ -20,6 +20,8 @@
 "getlocal",
 "setlocal",
 "dellocal",
+"getupvar",
+"setupvar",
 "hasvar",
 "getvar",
 "setvar",
@@ -82,3 +84,6 @@
 "jtrue",
 "jfalse",
 "return",
+"getmethod_s",
+"addlocals",
+"jnltlocal",
@@ -26,11 +26,17 @@
 #ifndef REG_MAXCLASS
 #define REG_MAXCLASS 16
 #endif
+#ifndef REG_MAXSTEPS
+#define REG_MAXSTEPS (16 << 10) /* backtracking splits before switching to the Pike VM */
+#endif
+#ifndef REG_MAXPREFIX
+#define REG_MAXPREFIX 16
+#endif
 
 typedef struct Reclass Reclass;
 typedef struct Renode Renode;
 typedef struct Reinst Reinst;
-typedef struct Rethread Rethread;
+typedef struct Repike Repike;
 
 struct Reclass {
 	Rune *end;
@@ -41,6 +47,13 @@ struct Reprog {
 	Reinst *start, *end;
 	int flags;
 	int nsub;
+	int backtrack; /* has back-references or lookahead, which only the backtracker can match */
+	int anchor; /* starts with ^ outside multiline mode, so can only match at the beginning */
+	int nprefix; /* every match starts with these bytes */
+	char prefix[REG_MAXPREFIX];
+	void *(*alloc)(void *ctx, void *p, int n);
+	void *ctx;
+	Repike *pike; /* Pike VM work space, allocated on first use */
 	Reclass cclass[REG_MAXCLASS];
 };
 
@@ -854,6 +867,35 @@ static void dumpprog(Reprog *prog)
 }
 #endif
 
+/* Choose the engine, and find what every match must start with for regexec to skip ahead to */
+static void analyze(Reprog *prog)
+{
+	Reinst *inst;
+
+	prog->backtrack = 0;
+	for (inst = prog->start; inst < prog->end; ++inst)
+		if (inst->opcode == I_REF || inst->opcode == I_PLA || inst->opcode == I_NLA)
+			prog->backtrack = 1;
+
+	/* skip the search loop in front of the LPAR of the whole match */
+	inst = prog->start + 3;
+	while (inst->opcode == I_LPAR || inst->opcode == I_RPAR)
+		++inst;
+
+	prog->anchor = inst->opcode == I_BOL && !(prog->flags & REG_NEWLINE);
+
+	prog->nprefix = 0;
+	if (prog->flags & REG_ICASE)
+		return;
+	for (; inst < prog->end; ++inst) {
+		if (inst->opcode == I_LPAR || inst->opcode == I_RPAR)
+			continue;
+		if (inst->opcode != I_CHAR || inst->c == 0 || prog->nprefix + UTFmax > REG_MAXPREFIX)
+			break;
+		prog->nprefix += runetochar(prog->prefix + prog->nprefix, &inst->c);
+	}
+}
+
 Reprog *regcompx(void *(*alloc)(void *ctx, void *p, int n), void *ctx,
 	const char *pattern, int cflags, const char **errorp)
 {
@@ -928,6 +970,11 @@ Reprog *regcompx(void *(*alloc)(void *ctx, void *p, int n), void *ctx,
 	dumpprog(g.prog);
 #endif
 
+	analyze(g.prog);
+	g.prog->alloc = alloc;
+	g.prog->ctx = ctx;
+	g.prog->pike = NULL;
+
 	alloc(ctx, g.pstart, 0);
 
 	if (errorp) *errorp = NULL;
@@ -937,6 +984,7 @@ Reprog *regcompx(void *(*alloc)(void *ctx, void *p, int n), void *ctx,
 void regfreex(void *(*alloc)(void *ctx, void *p, int n), void *ctx, Reprog *prog)
 {
 	if (prog) {
+		alloc(ctx, prog->pike, 0);
 		alloc(ctx, prog->start, 0);
 		alloc(ctx, prog, 0);
 	}
@@ -1011,7 +1059,7 @@ static int strncmpcanon(const char *a, const char *b, int n)
 	return 0;
 }
 
-static int match(Reinst *pc, const char *sp, const char *bol, int flags, Resub *out, int depth)
+static int match(Reinst *pc, const char *sp, const char *bol, int flags, Resub *out, int depth, int *steps)
 {
 	Resub scratch;
 	int result;
@@ -1030,8 +1078,11 @@ static int match(Reinst *pc, const char *sp, const char *bol, int flags, Resub *
 			pc = pc->x;
 			break;
 		case I_SPLIT:
+			/* too much backtracking */
+			if (--*steps < 0)
+				return -1;
 			scratch = *out;
-			result = match(pc->x, sp, bol, flags, &scratch, depth+1);
+			result = match(pc->x, sp, bol, flags, &scratch, depth+1, steps);
 			if (result == -1)
 				return -1;
 			if (result == 0) {
@@ -1042,7 +1093,7 @@ static int match(Reinst *pc, const char *sp, const char *bol, int flags, Resub *
 			break;
 
 		case I_PLA:
-			result = match(pc->x, sp, bol, flags, out, depth+1);
+			result = match(pc->x, sp, bol, flags, out, depth+1, steps);
 			if (result == -1)
 				return -1;
 			if (result == 1)
@@ -1051,7 +1102,7 @@ static int match(Reinst *pc, const char *sp, const char *bol, int flags, Resub *
 			break;
 		case I_NLA:
 			scratch = *out;
-			result = match(pc->x, sp, bol, flags, &scratch, depth+1);
+			result = match(pc->x, sp, bol, flags, &scratch, depth+1, steps);
 			if (result == -1)
 				return -1;
 			if (result == 0)
@@ -1171,10 +1222,251 @@ static int match(Reinst *pc, const char *sp, const char *bol, int flags, Resub *
 	}
 }
 
+/*
+	Pike VM: all threads run in lock step over the input, one character at
+	a time. A thread is an instruction and its captures; at most one thread
+	per instruction is kept at each position, the one with the highest
+	priority, which is the one the backtracker would have tried first. So
+	the result is the same, but the time is linear in the length of the
+	input. Back-references and lookahead cannot be matched this way.
+*/
+
+typedef struct Restack Restack;
+
+struct Restack {
+	Reinst *pc; /* instruction to follow, if slot < 0 */
+	int slot; /* capture to restore to old */
+	const char *old;
+};
+
+struct Repike {
+	int ninst, ncap;
+	int gen;
+	int *mark; /* generation in which each instruction was last added */
+	int len[2];
+	Reinst **pc[2]; /* thread lists, in priority order */
+	const char **cap[2]; /* and their captures, ncap per thread */
+	const char **cur; /* captures of the thread being added */
+	Restack *stack;
+};
+
+static Repike *newpike(Reprog *prog)
+{
+	int ninst = prog->end - prog->start;
+	int ncap = prog->nsub * 2;
+	Repike *P;
+	char *p;
+
+	if (prog->pike)
+		return prog->pike;
+
+	P = prog->alloc(prog->ctx, NULL, sizeof *P +
+		ninst * sizeof *P->mark +
+		2 * ninst * sizeof **P->pc +
+		(2 * ninst + 1) * ncap * sizeof **P->cap +
+		(ninst + 1) * sizeof *P->stack);
+	if (!P)
+		return NULL;
+
+	/* pointers first, so that everything stays aligned */
+	p = (char *)(P + 1);
+	P->pc[0] = (Reinst **)p; p += ninst * sizeof **P->pc;
+	P->pc[1] = (Reinst **)p; p += ninst * sizeof **P->pc;
+	P->cap[0] = (const char **)p; p += ninst * ncap * sizeof **P->cap;
+	P->cap[1] = (const char **)p; p += ninst * ncap * sizeof **P->cap;
+	P->cur = (const char **)p; p += ncap * sizeof **P->cap;
+	P->stack = (Restack *)p; p += (ninst + 1) * sizeof *P->stack;
+	P->mark = (int *)p;
+	P->ninst = ninst;
+	P->ncap = ncap;
+
+	prog->pike = P;
+	return P;
+}
+
+static int pikeassert(Reinst *pc, const char *sp, const char *bol, int flags)
+{
+	int i;
+	switch (pc->opcode) {
+	case I_BOL:
+		if (sp == bol && !(flags & REG_NOTBOL))
+			return 1;
+		return (flags & REG_NEWLINE) && sp > bol && isnewline(sp[-1]);
+	case I_EOL:
+		return *sp == 0 || ((flags & REG_NEWLINE) && isnewline(*sp));
+	case I_WORD:
+	case I_NWORD:
+		i = sp > bol && iswordchar(sp[-1]);
+		i ^= iswordchar(sp[0]);
+		return pc->opcode == I_WORD ? i : !i;
+	}
+	return 0;
+}
+
+static int pikechar(Reinst *pc, Rune c, int flags)
+{
+	switch (pc->opcode) {
+	case I_ANYNL:
+		return 1;
+	case I_ANY:
+		return !isnewline(c);
+	case I_CHAR:
+		return ((flags & REG_ICASE) ? canon(c) : c) == pc->c;
+	case I_CCLASS:
+		if (flags & REG_ICASE)
+			return incclasscanon(pc->cc, canon(c));
+		return incclass(pc->cc, c);
+	case I_NCCLASS:
+		if (flags & REG_ICASE)
+			return !incclasscanon(pc->cc, canon(c));
+		return !incclass(pc->cc, c);
+	}
+	return 0;
+}
+
+/* Follow jumps, splits, captures and assertions from pc, and add the threads that wait for a character (or END) to list l */
+static void addthread(Repike *P, Reinst *start, int l, Reinst *pc, const char **cur, const char *sp, const char *bol, int flags)
+{
+	Restack *top = P->stack;
+	int i, n;
+
+	top->pc = pc;
+	top->slot = -1;
+	++top;
+
+	while (top > P->stack) {
+		--top;
+		if (top->slot >= 0) {
+			cur[top->slot] = top->old;
+			continue;
+		}
+		pc = top->pc;
+		for (;;) {
+			if (P->mark[pc - start] == P->gen)
+				break;
+			P->mark[pc - start] = P->gen;
+			if (pc->opcode == I_JUMP) {
+				pc = pc->x;
+			} else if (pc->opcode == I_SPLIT) {
+				top->pc = pc->y;
+				top->slot = -1;
+				++top;
+				pc = pc->x;
+			} else if (pc->opcode == I_LPAR || pc->opcode == I_RPAR) {
+				i = pc->n * 2 + (pc->opcode == I_RPAR);
+				top->slot = i;
+				top->old = cur[i];
+				++top;
+				cur[i] = sp;
+				pc = pc + 1;
+			} else if (pc->opcode >= I_BOL) {
+				if (!pikeassert(pc, sp, bol, flags))
+					break;
+				pc = pc + 1;
+			} else {
+				n = P->len[l]++;
+				P->pc[l][n] = pc;
+				memcpy(P->cap[l] + n * P->ncap, cur, P->ncap * sizeof *cur);
+				break;
+			}
+		}
+	}
+}
+
+/* Find the first position from sp where a match can start */
+static const char *nextstart(Reprog *prog, const char *sp, const char *bol, int flags)
+{
+	if (prog->anchor)
+		return (sp == bol && !(flags & REG_NOTBOL)) ? sp : NULL;
+	if (prog->nprefix > 0) {
+		while ((sp = strchr(sp, prog->prefix[0])) != NULL) {
+			if (!strncmp(sp, prog->prefix, prog->nprefix))
+				return sp;
+			++sp;
+		}
+	}
+	return sp;
+}
+
+static int pike(Reprog *prog, const char *sp, const char *bol, int flags, Resub *out)
+{
+	Reinst *start = prog->start + 3; /* the LPAR of the whole match; nextstart does the searching */
+	Repike *P = newpike(prog);
+	const char *next, *cand;
+	int matched = 0;
+	int cl = 0, nl, i, k;
+	Rune r = 0;
+
+	if (!P)
+		return -1;
+
+	memset(P->mark, 0, P->ninst * sizeof *P->mark);
+	for (i = 0; i < P->ncap; ++i)
+		P->cur[i] = NULL;
+	P->gen = 1;
+	P->len[0] = 0;
+
+	cand = nextstart(prog, sp, bol, flags);
+	if (!cand)
+		return 1;
+	sp = cand;
+
+	for (;;) {
+		next = sp;
+		if (*sp)
+			next += chartorune(&r, sp);
+
+		if (!matched && cand == sp) {
+			addthread(P, prog->start, cl, start, P->cur, sp, bol, flags);
+			cand = *sp ? nextstart(prog, next, bol, flags) : NULL;
+		}
+
+		if (P->len[cl] == 0) {
+			if (matched || !cand)
+				break;
+			/* nothing running: skip to where the next match can start */
+			sp = cand;
+			++P->gen;
+			continue;
+		}
+
+		nl = cl ^ 1;
+		P->len[nl] = 0;
+		++P->gen;
+
+		for (i = 0; i < P->len[cl]; ++i) {
+			Reinst *pc = P->pc[cl][i];
+			const char **cap = P->cap[cl] + i * P->ncap;
+			if (pc->opcode == I_END) {
+				/* lower priority threads are cut off */
+				matched = 1;
+				for (k = 0; k < prog->nsub; ++k) {
+					out->sub[k].sp = cap[k * 2];
+					out->sub[k].ep = cap[k * 2 + 1];
+				}
+				break;
+			}
+			if (*sp && pikechar(pc, r, flags))
+				addthread(P, prog->start, nl, pc + 1, cap, next, bol, flags);
+		}
+
+		if (!*sp)
+			break;
+		sp = next;
+		cl = nl;
+	}
+
+	return matched ? 0 : 1;
+}
+
 int regexec(Reprog *prog, const char *sp, Resub *sub, int eflags)
 {
 	Resub scratch;
-	int i;
+	int flags = prog->flags | eflags;
+	int steps = prog->backtrack ? INT_MAX : REG_MAXSTEPS;
+	const char *bol = sp;
+	Rune r;
+	int i, result;
 
 	if (!sub)
 		sub = &scratch;
@@ -1183,7 +1475,23 @@ int regexec(Reprog *prog, const char *sp, Resub *sub, int eflags)
 	for (i = 0; i < REG_MAXSUB; ++i)
 		sub->sub[i].sp = sub->sub[i].ep = NULL;
 
-	return match(prog->start, sp, sp, prog->flags | eflags, sub, 0);
+	/* backtrack from each position where a match can start, until it takes too many steps */
+	while ((sp = nextstart(prog, sp, bol, flags)) != NULL) {
+		result = match(prog->start + 3, sp, bol, flags, sub, 0, &steps);
+		if (result == 0)
+			return 0;
+		for (i = 0; i < REG_MAXSUB; ++i)
+			sub->sub[i].sp = sub->sub[i].ep = NULL;
+		if (result < 0) {
+			if (prog->backtrack)
+				return -1;
+			return pike(prog, sp, bol, flags, sub);
+		}
+		if (!*sp)
+			break;
+		sp += chartorune(&r, sp);
+	}
+	return 1;
 }
 
 #ifdef TEST
@@ -0,0 +1,88 @@
+/* Host tests for the incremental collector driven from an idle loop */
+#include "mujs.h"
+#include <stdio.h>
+#include <string.h>
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+		failures++; \
+	} \
+} while (0)
+
+static const char *script =
+	"var objs = [];\n"
+	"for (var i = 0; i < 20000; i++) {\n"
+	"    var o = { id: i, name: 'item' + i, tags: [i, i * 2] };\n"
+	"    o['k' + (i % 50)] = function () { return this.id; };\n"
+	"    if (i % 3) objs.push(o);\n"
+	"}\n"
+	"var s = '';\n"
+	"for (var j = 0; j < 2000; j++) s += objs[j].name.charAt(0);\n"
+	"var r = objs.length + ':' + s.length + ':' + objs[100].k1();\n";
+
+/* Idle steps finish a cycle left in progress without a full collection */
+static void test_idle_step(void)
+{
+	js_GCStats before, after;
+	int calls = 0, steps = 0;
+
+	js_State *J = js_newstate(NULL, NULL, JS_STRICT | JS_GCINCREMENTAL);
+	CHECK(J != NULL);
+	js_setgcstep(J, 64);
+	CHECK(js_dostring(J, script) == 0);
+
+	/* small callbacks until one leaves a cycle in progress */
+	do {
+		CHECK(js_dostring(J, "var g = []; for (var i = 0; i < 20; i++) g.push({ i: i });") == 0);
+		js_getgcstats(J, &before);
+	} while (!js_gcstep(J) && ++calls < 10000);
+	CHECK(calls < 10000);
+
+	while (js_gcstep(J) && steps < 100000)
+		steps++;
+	js_getgcstats(J, &after);
+	CHECK(after.cycles == before.cycles + 1);
+	CHECK(after.steps > before.steps + (unsigned int) steps);
+
+	js_getglobal(J, "r");
+	CHECK(strcmp(js_tostring(J, -1), "13333:2000:151") == 0);
+	js_pop(J, 1);
+
+	js_freestate(J);
+}
+
+/* With no cycle in progress and no allocation debt an idle step is free */
+static void test_idle_no_work(void)
+{
+	js_GCStats before, after;
+
+	js_State *J = js_newstate(NULL, NULL, JS_STRICT | JS_GCINCREMENTAL);
+	CHECK(J != NULL);
+	CHECK(js_dostring(J, script) == 0);
+	js_gc(J, 0);
+
+	js_getgcstats(J, &before);
+	CHECK(js_gcstep(J) == 0);
+	CHECK(js_gcstep(J) == 0);
+	js_getgcstats(J, &after);
+	CHECK(after.steps == before.steps);
+	CHECK(after.cycles == before.cycles);
+
+	js_freestate(J);
+}
+
+int main(void)
+{
+	test_idle_step();
+	test_idle_no_work();
+
+	if (failures) {
+		printf("%d check(s) failed\n", failures);
+		return 1;
+	}
+	printf("all js_gc tests passed\n");
+	return 0;
+}